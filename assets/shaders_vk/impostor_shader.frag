@@ -0,0 +1,107 @@
+#version 450
+
+layout(location = 0) in vec2 fragQuadUV;
+layout(location = 1) in vec2 fragFrameGrid;
+layout(location = 2) flat in vec2 fragSlotOffset;
+layout(location = 3) in vec3 fragPosWorld;
+layout(location = 4) flat in vec2 fragRotation;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    mat4 uiOrthographicProjection;
+    
+    vec4 sunDirection;
+    // rgb + intensity in .w
+    vec4 sunColor;
+    
+    // camera position in world space
+    vec4 cameraPosition;
+} globalUbo;
+
+layout(set = 1, binding = 0) uniform sampler2D albedoAtlas;
+layout(set = 1, binding = 1) uniform sampler2D normalAtlas;
+
+layout(set = 1, binding = 2) uniform ImpostorUbo {
+    // x = frames per side, y = slot size in atlas uv, z = impostor distance, w = unused
+    vec4 atlasParams;
+    // x = ka, y = kd, zw = unused
+    vec4 lightingProperties;
+} impostorUbo;
+
+#define MAX_CASCADES 4
+
+layout(set = 2, binding = 0) uniform ShadowUbo {
+    mat4 cascadeViewProjection[MAX_CASCADES];
+    // view space far distance of each cascade
+    vec4 cascadeSplits;
+    // x: shadow map size, y: PCF samples, z: bias, w: shadow strength
+    vec4 shadowParams;
+    // x: cascade count
+    vec4 cascadeParams;
+} shadowUbo;
+
+layout(set = 2, binding = 1) uniform sampler2DArrayShadow shadowMap;
+
+layout(location = 0) out vec4 outColor;
+
+// impostors are far away, a single tap in the covering cascade is enough
+float calculateShadow(vec3 worldPos) {
+    float viewDepth = -(globalUbo.view * vec4(worldPos, 1.0)).z;
+    int cascadeCount = int(shadowUbo.cascadeParams.x);
+    int cascade = 0;
+    while (cascade < cascadeCount && viewDepth > shadowUbo.cascadeSplits[cascade]) {
+        cascade++;
+    }
+    if (cascade >= cascadeCount) {
+        return 1.0;
+    }
+
+    vec4 posLightSpace = shadowUbo.cascadeViewProjection[cascade] * vec4(worldPos, 1.0);
+    vec3 projCoords = posLightSpace.xyz / posLightSpace.w * 0.5 + 0.5;
+    if (any(lessThan(projCoords, vec3(0.0))) || any(greaterThan(projCoords, vec3(1.0)))) {
+        return 1.0;
+    }
+
+    float shadow = texture(shadowMap, vec4(projCoords.xy, cascade, projCoords.z - shadowUbo.shadowParams.z));
+    return 1.0 - (shadowUbo.shadowParams.w * (1.0 - shadow));
+}
+
+void main() {
+    float frames = impostorUbo.atlasParams.x;
+    float slotSize = impostorUbo.atlasParams.y;
+
+    // bilinear blend of the four frames around the view direction
+    vec2 frame0 = min(floor(fragFrameGrid), vec2(frames - 2.0));
+    vec2 blend = clamp(fragFrameGrid - frame0, 0.0, 1.0);
+
+    vec4 albedo = vec4(0.0);
+    vec3 normal = vec3(0.0);
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            vec2 frame = frame0 + vec2(x, y);
+            float weight = (x == 0 ? 1.0 - blend.x : blend.x) * (y == 0 ? 1.0 - blend.y : blend.y);
+            vec2 atlasUV = fragSlotOffset + (frame + fragQuadUV) / frames * slotSize;
+            albedo += texture(albedoAtlas, atlasUV) * weight;
+            normal += (texture(normalAtlas, atlasUV).xyz * 2.0 - 1.0) * weight;
+        }
+    }
+
+    if (albedo.a < 0.5) {
+        discard;
+    }
+
+    // premultiplied by coverage through the blend, undo it
+    vec3 diffuseColor = albedo.rgb / albedo.a;
+    vec3 N = length(normal) > 0.0 ? normalize(normal) : vec3(0.0, 1.0, 0.0);
+    // object to world space
+    float c = fragRotation.x;
+    float s = fragRotation.y;
+    N = vec3(c * N.x + s * N.z, N.y, -s * N.x + c * N.z);
+
+    vec3 light = diffuseColor * impostorUbo.lightingProperties.x;
+    float diffuse = max(dot(N, normalize(-globalUbo.sunDirection.xyz)), 0.0);
+    light += impostorUbo.lightingProperties.y * diffuseColor * globalUbo.sunColor.rgb * diffuse * calculateShadow(fragPosWorld);
+
+    outColor = vec4(light, 1.0);
+}
@@ -0,0 +1,90 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in vec2 uv;
+// ImpostorMaterial::Instance, per instance from the batch's instance buffer
+layout(location = 4) in vec4 instancePositionScale;
+layout(location = 5) in vec4 instanceCenterRadius;
+layout(location = 6) in vec4 instanceSlotOffset;
+
+layout(location = 0) out vec2 fragQuadUV;
+// view direction in frame grid coordinates, the fragment shader blends the four surrounding frames
+layout(location = 1) out vec2 fragFrameGrid;
+layout(location = 2) flat out vec2 fragSlotOffset;
+layout(location = 3) out vec3 fragPosWorld;
+// cos and sin of the instance yaw, atlas normals are in object space
+layout(location = 4) flat out vec2 fragRotation;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    mat4 uiOrthographicProjection;
+    
+    vec4 sunDirection;
+    // rgb + intensity in .w
+    vec4 sunColor;
+    
+    // camera position in world space
+    vec4 cameraPosition;
+} globalUbo;
+
+layout(set = 1, binding = 2) uniform ImpostorUbo {
+    // x = frames per side, y = slot size in atlas uv, z = impostor distance, w = unused
+    vec4 atlasParams;
+    // x = ka, y = kd, zw = unused
+    vec4 lightingProperties;
+} impostorUbo;
+
+struct Instance {
+    // xyz = base position, w = uniform scale
+    vec4 positionScale;
+    // xyz = bounding sphere center in object space, w = bounding sphere radius in object space
+    vec4 centerRadius;
+    // xy = top left corner of the atlas slot, z = cos(yaw), w = sin(yaw)
+    vec4 slotOffset;
+};
+
+// must match ImpostorAtlas::hemiOctahedronEncode
+vec2 hemiOctahedronEncode(vec3 d) {
+    d.y = max(d.y, 0.0);
+    d /= max(abs(d.x) + abs(d.y) + abs(d.z), 1e-6);
+    return vec2(d.x + d.z, d.x - d.z) * 0.5 + 0.5;
+}
+
+void main() {
+    Instance instance = Instance(instancePositionScale, instanceCenterRadius, instanceSlotOffset);
+    vec3 base = instance.positionScale.xyz;
+    float scale = instance.positionScale.w;
+
+    // closer trees are still drawn as meshes
+    vec3 toBase = base - globalUbo.cameraPosition.xyz;
+    if (dot(toBase, toBase) < impostorUbo.atlasParams.z * impostorUbo.atlasParams.z) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
+    float c = instance.slotOffset.z;
+    float s = instance.slotOffset.w;
+    vec3 localCenter = instance.centerRadius.xyz;
+    vec3 center = base + vec3(c * localCenter.x + s * localCenter.z, localCenter.y, -s * localCenter.x + c * localCenter.z) * scale;
+    float radius = instance.centerRadius.w * scale;
+
+    // frames were baked around the unrotated tree, look them up with the view direction in object space
+    vec3 viewDir = normalize(globalUbo.cameraPosition.xyz - center);
+    vec2 octUV = hemiOctahedronEncode(vec3(c * viewDir.x - s * viewDir.z, viewDir.y, s * viewDir.x + c * viewDir.z));
+
+    // same basis as the bake, a yaw does not change it
+    vec3 right = cross(vec3(0.0, 1.0, 0.0), viewDir);
+    right = length(right) < 1e-4 ? vec3(1.0, 0.0, 0.0) : normalize(right);
+    vec3 up = cross(viewDir, right);
+
+    fragPosWorld = center + (position.x * right + position.y * up) * radius;
+    fragQuadUV = vec2(position.x * 0.5 + 0.5, 0.5 - position.y * 0.5);
+    fragFrameGrid = octUV * (impostorUbo.atlasParams.x - 1.0);
+    fragSlotOffset = instance.slotOffset.xy;
+    fragRotation = vec2(c, s);
+
+    gl_Position = globalUbo.projection * globalUbo.view * vec4(fragPosWorld, 1.0);
+}
@@ -47,17 +47,34 @@ layout(set = 1, binding = 1) uniform sampler2D rockTexture;
 layout(set = 1, binding = 2) uniform sampler2D grassTexture;
 layout(set = 1, binding = 3) uniform sampler2D snowTexture;
 
+#define MAX_CASCADES 4
+
 layout(set = 2, binding = 0) uniform ShadowUbo {
-    mat4 lightViewMatrix;
-    mat4 lightProjectionMatrix;
+    mat4 cascadeViewProjection[MAX_CASCADES];
+    // view space far distance of each cascade
+    vec4 cascadeSplits;
     // x: shadow map size, y: PCF samples, z: bias, w: shadow strength
     vec4 shadowParams;
+    // x: cascade count
+    vec4 cascadeParams;
 } shadowUbo;
 
-layout(set = 2, binding = 1) uniform sampler2DShadow shadowMap;
+// one layer per cascade
+layout(set = 2, binding = 1) uniform sampler2DArrayShadow shadowMap;
 
 float calculateShadow(vec3 worldPos, vec3 normal) {
-    vec4 posLightSpace = shadowUbo.lightProjectionMatrix * shadowUbo.lightViewMatrix * vec4(worldPos, 1.0);
+    // pick the first cascade whose slice contains the fragment
+    float viewDepth = -(globalUbo.view * vec4(worldPos, 1.0)).z;
+    int cascadeCount = int(shadowUbo.cascadeParams.x);
+    int cascade = 0;
+    while (cascade < cascadeCount && viewDepth > shadowUbo.cascadeSplits[cascade]) {
+        cascade++;
+    }
+    if (cascade >= cascadeCount) {
+        return 1.0;
+    }
+
+    vec4 posLightSpace = shadowUbo.cascadeViewProjection[cascade] * vec4(worldPos, 1.0);
     
     vec3 projCoords = posLightSpace.xyz / posLightSpace.w;
     
@@ -84,7 +101,7 @@ float calculateShadow(vec3 worldPos, vec3 normal) {
     
     for (int x = -pcfSize/2; x <= pcfSize/2; x++) {
         for (int y = -pcfSize/2; y <= pcfSize/2; y++) {
-            float pcfDepth = texture(shadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, projCoords.z - normalBias));
+            float pcfDepth = texture(shadowMap, vec4(projCoords.xy + vec2(x, y) * texelSize, cascade, projCoords.z - normalBias));
             shadow += pcfDepth;
         }
     }
@@ -168,7 +185,7 @@ void main() {
     outColor = vec4(light, 1.0f);
 
     // debug shadows
-    // vec4 posLightSpace = shadowUbo.lightProjectionMatrix * shadowUbo.lightViewMatrix * vec4(fragPosWorld, 1.0);
+    // vec4 posLightSpace = shadowUbo.cascadeViewProjection[0] * vec4(fragPosWorld, 1.0);
     
     // vec3 projCoords = posLightSpace.xyz / posLightSpace.w;
     
@@ -5,6 +5,12 @@ layout(location = 1) in vec3 color;
 layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 uv;
 
+// per chunk, see TerrainQuadtree::Instance
+// xy = min corner in terrain local xz [-1, 1], z = chunk size, w = patch size
+layout(location = 4) in vec4 chunkRect;
+// x = morph start, y = morph end as camera distance
+layout(location = 5) in vec4 chunkMorph;
+
 layout(push_constant) uniform Push {
     mat4 modelMatrix;
     mat4 normalMatrix;
@@ -39,20 +45,55 @@ layout(set = 1, binding = 0) uniform Ubo {
     vec4 lightingProperties;
 } modelUbo;
 
+layout(set = 1, binding = 4) uniform sampler2D heightMap;
+
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragTexCoord;
 layout(location = 4) out vec2 rawUV;
+// grid coordinates before the morph, the tessellation control shader detects chunk borders with them
+layout(location = 5) out vec2 chunkGrid;
+
+vec3 flatWorldPosition(vec2 local) {
+    return (push.modelMatrix * vec4(local.x, 0.0, local.y, 1.0)).xyz;
+}
+
+// the first and last height sample sit exactly on the terrain edges, so neighbouring tiles and the physics heightfield line up
+vec2 heightMapUV(vec2 local) {
+    vec2 size = vec2(textureSize(heightMap, 0));
+    return ((local * 0.5 + 0.5) * (size - 1.0) + 0.5) / size;
+}
+
+float heightOffset(vec2 local) {
+    if (modelUbo.textureParams.w < 0.5) {
+        return 0.0;
+    }
+    return (textureLod(heightMap, heightMapUV(local), 0.0).r * 2.0 - 1.0) * modelUbo.tessParams.w;
+}
 
 void main() {
+    // position holds the grid coordinates inside the chunk
+    vec2 gridPos = position.xz;
+    chunkGrid = gridPos;
+    vec2 local = chunkRect.xy + gridPos * chunkRect.w;
+
+    // cdlod morph, odd grid vertices slide onto the coarser grid of the parent chunk with camera distance
+    vec3 worldPos = flatWorldPosition(local);
+    float cameraDistance = distance(worldPos + vec3(0.0, heightOffset(local), 0.0), globalUbo.cameraPosition.xyz);
+    float morph = clamp((cameraDistance - chunkMorph.x) / (chunkMorph.y - chunkMorph.x), 0.0, 1.0);
+    gridPos -= fract(gridPos * 0.5) * 2.0 * morph;
+    local = chunkRect.xy + gridPos * chunkRect.w;
+    vec2 terrainUV = local * 0.5 + 0.5;
+
+    // flat position, the height is displaced in the tessellation evaluation shader
     fragColor = color;
-    fragPosWorld = (push.modelMatrix * vec4(position, 1.0)).xyz;
+    fragPosWorld = flatWorldPosition(local);
     fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
     
     // tiling texture coordinates
-    fragTexCoord = uv * modelUbo.textureParams.xy;
-    rawUV = uv;
+    fragTexCoord = terrainUV * modelUbo.textureParams.xy;
+    rawUV = heightMapUV(local);
 
     gl_Position = globalUbo.projection * globalUbo.view * vec4(fragPosWorld, 1.0); // needed e.g. for shadow pass
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+// lighting of texture_shader.frag and texture_shader_bindless.frag, included after the material bindings
+// set 0 = global ubo, set 2 = cascaded shadows, set 1 belongs to the including shader
+
+layout(location = 0) in vec2 fragUV;
+layout(location = 1) in vec3 fragPosWorld;
+layout(location = 2) in vec3 fragNormalWorld;
+layout(location = 3) in vec3 fragColor;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    mat4 uiOrthographicProjection;
+    
+    vec4 sunDirection;
+    // rgb + intensity in .w
+    vec4 sunColor;
+    
+    // camera position in world space
+    vec4 cameraPosition;
+} globalUbo;
+
+#define MAX_CASCADES 4
+
+layout(set = 2, binding = 0) uniform ShadowUbo {
+    mat4 cascadeViewProjection[MAX_CASCADES];
+    // view space far distance of each cascade
+    vec4 cascadeSplits;
+    // x: shadow map size, y: PCF samples, z: bias, w: shadow strength
+    vec4 shadowParams;
+    // x: cascade count
+    vec4 cascadeParams;
+} shadowUbo;
+
+// one layer per cascade
+layout(set = 2, binding = 1) uniform sampler2DArrayShadow shadowMap;
+
+layout(location = 0) out vec4 outColor;
+
+float calculateShadow(vec3 worldPos, vec3 normal) {
+    // pick the first cascade whose slice contains the fragment
+    float viewDepth = -(globalUbo.view * vec4(worldPos, 1.0)).z;
+    int cascadeCount = int(shadowUbo.cascadeParams.x);
+    int cascade = 0;
+    while (cascade < cascadeCount && viewDepth > shadowUbo.cascadeSplits[cascade]) {
+        cascade++;
+    }
+    if (cascade >= cascadeCount) {
+        return 1.0;
+    }
+
+    vec4 posLightSpace = shadowUbo.cascadeViewProjection[cascade] * vec4(worldPos, 1.0);
+    
+    vec3 projCoords = posLightSpace.xyz / posLightSpace.w;
+    
+    // transform to [0,1]
+    projCoords = projCoords * 0.5 + 0.5;
+    
+    // outside of light view = no shadow
+    if (projCoords.x < 0.0 || projCoords.x > 1.0 ||
+        projCoords.y < 0.0 || projCoords.y > 1.0 ||
+        projCoords.z < 0.0 || projCoords.z > 1.0) {
+        return 1.0;
+    }
+    
+    // bias to avoid shadow acne
+    float bias = shadowUbo.shadowParams.z;
+    
+    // normal bias for surfaces at an angle to the light
+    vec3 lightDir = normalize(globalUbo.sunDirection.xyz);
+    float normalBias = max(bias * (1.0 - dot(normal, lightDir)), bias);
+    
+    float shadow = 0.0;
+    int pcfSize = int(shadowUbo.shadowParams.y);
+    float texelSize = 1.0 / shadowUbo.shadowParams.x;
+    
+    for (int x = -pcfSize/2; x <= pcfSize/2; x++) {
+        for (int y = -pcfSize/2; y <= pcfSize/2; y++) {
+            float pcfDepth = texture(shadowMap, vec4(projCoords.xy + vec2(x, y) * texelSize, cascade, projCoords.z - normalBias));
+            shadow += pcfDepth;
+        }
+    }
+    
+    shadow /= (pcfSize + 1) * (pcfSize + 1);
+    
+    // shadow strength in shadowUbo.shadowParams.w
+    return 1.0 - (shadowUbo.shadowParams.w * (1.0 - shadow));
+}
+
+vec3 phong( vec3 n, vec3 l, vec3 v,
+            vec3 diffuseC, float diffuseF,
+            vec3 specularC, float specularF,
+            float alpha, bool attenuate, vec3 attenuation)
+{
+    float d = length(l);
+    l = normalize(l);
+    float att = 1.0;
+    if (attenuate) {
+        att = 1.0 / (attenuation.x + d*attenuation.y + d*d*attenuation.z);
+    }
+
+    vec3 r = reflect(-l, n);
+    
+    return (diffuseF * diffuseC * max(0, dot(n, l)) + specularF * specularC * pow(max(0, dot(r, v)), alpha)) * att;
+}
+
+vec3 clampedReflect(vec3 I, vec3 N)
+{
+	return I - 2.0 * min(dot(N, I), 0.0) * N;
+}
+
+// ambient + phong sun light with cascaded shadows, shared by all texture shader variants
+// x = ka, y = kd, z = ks, w = alpha
+vec3 shadeFragment(vec3 diffuseColor, vec4 lightingProperties) {
+    vec3 N = normalize( fragNormalWorld );
+    vec3 V = normalize(fragPosWorld - globalUbo.cameraPosition.xyz);
+
+    vec3 light = diffuseColor * lightingProperties.x;
+
+    float shadowFactor = calculateShadow(fragPosWorld, N);
+    
+    vec3 phongLight = phong(
+        N, -globalUbo.sunDirection.xyz, -V,
+        diffuseColor * globalUbo.sunColor.rgb, lightingProperties.y,
+        globalUbo.sunColor.rgb, lightingProperties.z,
+        lightingProperties.w,
+        false, vec3(1.0)
+    );
+    
+    return light + phongLight * shadowFactor;
+}
@@ -9,6 +9,11 @@ layout(location = 0) out vec2 fragUV;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec3 fragColor;
+// only read by the bindless fragment shader
+layout(location = 4) flat out uint fragMaterialIndex;
+
+// the depth pre-pass and the main pass must produce bit-identical depth for the equal depth test
+invariant gl_Position;
 
 layout(set = 0, binding = 0) uniform GlobalUbo {
     mat4 projection;
@@ -25,7 +30,9 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
 
 layout(push_constant) uniform Push {
     mat4 modelMatrix;
-    mat4 normalMatrix;
+    mat3 normalMatrix;
+    // the bindless material slot needs a real integer member, small indices stored in a float are denormals that may be flushed to zero
+    uint materialIndex;
 } push;
 
 void main() {
@@ -33,5 +40,6 @@ void main() {
     fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
     fragUV = uv;
     fragColor = color;
+    fragMaterialIndex = push.materialIndex;
     gl_Position = globalUbo.projection * globalUbo.view * push.modelMatrix * vec4(position, 1.0);
 }
\ No newline at end of file
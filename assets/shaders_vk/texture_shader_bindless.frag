@@ -0,0 +1,35 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_GOOGLE_include_directive : require
+
+// bindless variant of texture_shader.frag: textures and material parameters come from shared tables
+
+layout(location = 4) flat in uint fragMaterialIndex;
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+struct MaterialParams {
+    // x = ka, y = kd, z = ks, w = alpha
+    vec4 lightingProperties;
+    // x = hasTexture, yzw = unused
+    vec4 flags;
+    // x = albedo texture slot
+    uvec4 textureIndices;
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer MaterialTable {
+    MaterialParams materials[];
+} materialTable;
+
+#include "texture_lighting.glsl"
+
+void main() {
+    MaterialParams modelUbo = materialTable.materials[fragMaterialIndex];
+
+    vec3 diffuseColor = fragColor;
+    if (modelUbo.flags.x == 1) {
+        diffuseColor = texture(textures[nonuniformEXT(modelUbo.textureIndices.x)], fragUV).rgb;
+    }
+
+    outColor = vec4(shadeFragment(diffuseColor, modelUbo.lightingProperties), 1.0f);
+}
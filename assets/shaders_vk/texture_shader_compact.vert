@@ -0,0 +1,56 @@
+#version 450
+
+// Model::CompactVertex, unpacked by the unorm / snorm attribute formats
+// position within the mesh bounds, push.modelMatrix decodes it
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 color;
+// octahedral encoded
+layout(location = 2) in vec2 normal;
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec2 fragUV;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec3 fragColor;
+// only read by the bindless fragment shader
+layout(location = 4) flat out uint fragMaterialIndex;
+
+// the depth pre-pass and the main pass must produce bit-identical depth for the equal depth test
+invariant gl_Position;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    mat4 uiOrthographicProjection;
+    
+    vec4 sunDirection;
+    // rgb + intensity in .w
+    vec4 sunColor;
+    
+    // camera position in world space
+    vec4 cameraPosition;
+} globalUbo;
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix;
+    mat3 normalMatrix;
+    // the bindless material slot needs a real integer member, small indices stored in a float are denormals that may be flushed to zero
+    uint materialIndex;
+} push;
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+void main() {
+    fragPosWorld = (push.modelMatrix * vec4(position.xyz, 1.0)).xyz;
+    fragNormalWorld = normalize(mat3(push.normalMatrix) * octDecode(normal));
+    fragUV = uv;
+    fragColor = color.rgb;
+    fragMaterialIndex = push.materialIndex;
+    gl_Position = globalUbo.projection * globalUbo.view * push.modelMatrix * vec4(position.xyz, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 450
+layout(location = 0) in vec2 fragUV;
+layout(location = 1) in vec3 fragColor;
+
+// ui atlas, untextured geometry samples a white texel
+layout(set = 1, binding = 0) uniform sampler2D atlasSampler;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = vec4(fragColor, 1.0) * texture(atlasSampler, fragUV);
+}
@@ -0,0 +1,27 @@
+#version 450
+// positions are already transformed to pixels on the cpu, see UIRenderSystem
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec2 uv;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    mat4 uiOrthographicProjection;
+    
+    vec4 sunDirection;
+    // rgb + intensity in .w
+    vec4 sunColor;
+    
+    // camera position in world space
+    vec4 cameraPosition;
+} ubo;
+
+layout(location = 0) out vec2 fragUV;
+layout(location = 1) out vec3 fragColor;
+
+void main() {
+    gl_Position = ubo.uiOrthographicProjection * vec4(position, 1.0);
+    fragUV = uv;
+    fragColor = color;
+}
@@ -0,0 +1,61 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in vec2 uv;
+
+// per instance, see VegetationBatch::Instance
+// xyz = base position, w = uniform scale
+layout(location = 4) in vec4 instancePositionScale;
+// x = cos(yaw), y = sin(yaw)
+layout(location = 5) in vec4 instanceRotation;
+
+layout(location = 0) out vec2 fragUV;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec3 fragColor;
+// only read by the bindless fragment shader
+layout(location = 4) flat out uint fragMaterialIndex;
+
+// the depth pre-pass and the main pass must produce bit-identical depth for the equal depth test
+invariant gl_Position;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    mat4 uiOrthographicProjection;
+    
+    vec4 sunDirection;
+    // rgb + intensity in .w
+    vec4 sunColor;
+    
+    // camera position in world space
+    vec4 cameraPosition;
+} globalUbo;
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix;
+    mat3 normalMatrix;
+    // the bindless material slot needs a real integer member, small indices stored in a float are denormals that may be flushed to zero
+    uint materialIndex;
+} push;
+
+void main() {
+    float c = instanceRotation.x;
+    float s = instanceRotation.y;
+    // rotation around the y axis (columns)
+    mat3 rotation = mat3(
+        c, 0.0, -s,
+        0.0, 1.0, 0.0,
+        s, 0.0, c
+    );
+
+    fragPosWorld = instancePositionScale.xyz + rotation * (position * instancePositionScale.w);
+    // uniform scale, the rotation alone transforms normals
+    fragNormalWorld = normalize(rotation * normal);
+    fragUV = uv;
+    fragColor = color;
+    fragMaterialIndex = push.materialIndex;
+    gl_Position = globalUbo.projection * globalUbo.view * vec4(fragPosWorld, 1.0);
+}
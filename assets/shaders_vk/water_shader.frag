@@ -25,7 +25,7 @@ layout(push_constant) uniform Push {
 
     mat4 modelMatrix;
     mat4 normalMatrix;
-    // x = patchCount, yzw = unused
+    // x = patchCount of one block, y = clipmap ring count, z = patch frustum culling enabled, w = unused
     vec4 gridInfo;
 } push;
 
@@ -36,7 +36,7 @@ layout(set = 1, binding = 1) uniform Ubo {
     // w = unused
     vec4 tessParams;
 
-    // xy = textureRepetition, how often the texture repeats across the whole tessellation object
+    // xy = textureRepetition, how often the texture repeats across one block of the finest clipmap ring
     // zw = unused
     vec4 textureParams;
 
@@ -46,7 +46,7 @@ layout(set = 1, binding = 1) uniform Ubo {
     // xyz = default color, w = transparency
     vec4 color;
 
-    // x = hasTexture, y = wave count, zw = unused
+    // x = hasTexture, y = wave count, z = summed wave amplitude, w = unused
     vec4 flags;
 
     // xy = direction, z = steepness in [0,1], w = wavelength
@@ -20,7 +20,7 @@ layout(set = 1, binding = 1) uniform Ubo {
     // w = unused
     vec4 tessParams;
 
-    // xy = textureRepetition, how often the texture repeats across the whole tessellation object
+    // xy = textureRepetition, how often the texture repeats across one block of the finest clipmap ring
     // zw = unused
     vec4 textureParams;
 
@@ -30,7 +30,7 @@ layout(set = 1, binding = 1) uniform Ubo {
     // xyz = default color, w = transparency
     vec4 color;
 
-    // x = hasTexture, y = wave count, zw = unused
+    // x = hasTexture, y = wave count, z = summed wave amplitude, w = unused
     vec4 flags;
 
     // xy = direction, z = steepness in [0,1], w = wavelength
@@ -43,11 +43,31 @@ layout(push_constant) uniform Push {
 
     mat4 modelMatrix;
     mat4 normalMatrix;
-    // x = patchCount, yzw = unused
+    // x = patchCount of one block, y = clipmap ring count, z = patch frustum culling enabled, w = unused
     vec4 gridInfo;
 } push;
 
 layout(location = 0) out vec2 uv;
+// xy = vertex position on the grid of its ring in patches, z = ring
+layout(location = 1) out ivec3 clipmapCoord;
+
+// ring 0 is a full square of 4 x 4 blocks, every further ring is the 4 x 4 border around the previous ring
+// with blocks twice as large, each instance draws one block of patches
+const int BLOCKS_PER_SIDE = 4;
+const int FIRST_RING_BLOCKS = 16;
+const int RING_BLOCKS = 12;
+
+ivec2 ringBlock(int block) {
+    if (block < 4) {
+        return ivec2(block, 0);
+    }
+    if (block < 8) {
+        return ivec2(block - 4, 3);
+    }
+    // left and right blocks of the two middle rows
+    int side = block - 8;
+    return ivec2((side % 2) * 3, 1 + side / 2);
+}
 
 void main() {
     int cornerID = gl_VertexIndex % 4;
@@ -62,14 +82,29 @@ void main() {
     int ox = (cornerID == 1 || cornerID == 3) ? 1 : 0;
     int oy = (cornerID == 2 || cornerID == 3) ? 1 : 0;
 
-    float step = 2.0 / gridSize;
-    float localX = -1.0 + float(px) * step + float(ox) * step;
-    float localZ = -1.0 + float(py) * step + float(oy) * step;
+    int ring = 0;
+    ivec2 block = ivec2(gl_InstanceIndex % BLOCKS_PER_SIDE, gl_InstanceIndex / BLOCKS_PER_SIDE);
+    if (gl_InstanceIndex >= FIRST_RING_BLOCKS) {
+        ring = 1 + (gl_InstanceIndex - FIRST_RING_BLOCKS) / RING_BLOCKS;
+        block = ringBlock((gl_InstanceIndex - FIRST_RING_BLOCKS) % RING_BLOCKS);
+    }
 
-    // [-1, 1] -> [0, 1]
-    vec2 normalizedXZ = (vec2(localX, localZ) + vec2(1.0)) * 0.5;
+    ivec2 gridPos = block * gridSize + ivec2(px + ox, py + oy);
+    clipmapCoord = ivec3(gridPos, ring);
 
-    uv = normalizedXZ * modelUbo.textureParams.xy;
+    // the clipmap follows the camera in steps of a patch of the outermost ring, so every ring stays on its world aligned grid
+    // and the waves do not swim, the model matrix scales one block to [-1, 1]
+    float blockSize = 2.0 * push.modelMatrix[0][0];
+    float ringScale = float(1 << ring);
+    float snapStep = blockSize * float(1 << (int(push.gridInfo.y) - 1)) / float(gridSize);
+    vec2 center = floor(globalUbo.cameraPosition.xz / snapStep + 0.5) * snapStep;
 
-    gl_Position = push.modelMatrix * vec4(localX, 0.0, localZ, 1.0);
-}
\ No newline at end of file
+    vec2 local = (vec2(gridPos) / float(gridSize) - 0.5 * BLOCKS_PER_SIDE) * 2.0 * ringScale;
+    vec4 worldPos = push.modelMatrix * vec4(local.x, 0.0, local.y, 1.0);
+    worldPos.xz += center;
+
+    // world anchored, so the texture does not slide with the clipmap
+    uv = worldPos.xz / blockSize * modelUbo.textureParams.xy;
+
+    gl_Position = worldPos;
+}
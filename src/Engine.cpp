@@ -11,8 +11,9 @@ namespace vk {
 
 		globalPool = DescriptorPool::Builder(device)
 			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
-			.setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
+			// one global set per frame plus one per shadow cascade and frame
+			.setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT * (1 + ShadowMap::MAX_CASCADES))
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT * (1 + ShadowMap::MAX_CASCADES))
 			.build();
 		
 		if (!destructionQueue) {
@@ -82,6 +83,24 @@ namespace vk {
 		}
 		// TODO create an additional binding with a uniform buffer for lighting information stored in sceneManager (updated every frame)
 
+		// every shadow cascade is rendered with its own light matrices, so each needs its own global ubo
+		std::vector<std::unique_ptr<Buffer>> cascadeUboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT * ShadowMap::MAX_CASCADES);
+		std::vector<VkDescriptorSet> cascadeDescriptorSets(cascadeUboBuffers.size());
+		for (int i = 0; i < cascadeUboBuffers.size(); i++) {
+			cascadeUboBuffers[i] = std::make_unique<Buffer>(
+				device,
+				sizeof(GlobalUbo),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			cascadeUboBuffers[i]->map();
+
+			auto bufferInfo = cascadeUboBuffers[i]->descriptorInfo();
+			DescriptorWriter(*globalSetLayout, *globalPool)
+				.writeBuffer(0, &bufferInfo)
+				.build(cascadeDescriptorSets[i]);
+		}
+
 		TextureRenderSystem textureRenderSystem{
 			device,
 			renderer,
@@ -100,12 +119,70 @@ namespace vk {
 			renderSystemSettings
 		};
 
+		VegetationRenderSystem vegetationRenderSystem{
+			device,
+			renderer,
+			renderSystemSettings
+		};
+
+		// coarse cpu depth buffer of the main camera, rebuilt every frame from the occluders
+		OcclusionCuller occlusionCuller;
+
+		// passes of a frame with the barriers between them, rebuilt every frame
+		RenderGraph renderGraph;
+
 		UIRenderSystem uiRenderSystem{
 			device,
 			renderer,
 			renderSystemSettings
 		};
 
+		// compile all pipeline variants of the loaded materials up front instead of hitching on first use
+		{
+			DescriptorSet globalSet{ globalDescriptorSets[0], globalSetLayout->getDescriptorSetLayout(), 0 };
+
+			PipelinePrewarmPass mainPass{};
+			mainPass.type = RenderPassType::DEFAULT_PASS;
+			mainPass.renderPass = renderer.getSwapChainRenderPass();
+			mainPass.systemDescriptorSets.push_back(globalSet);
+			if (engineSettings.useShadowMap) {
+				mainPass.systemDescriptorSets.push_back(shadowMap->getDescriptorSet(0));
+			}
+
+			// the main pass pipelines of opaque materials switch to an equal depth test behind a depth pre-pass
+			std::vector<PipelinePrewarmPass> mainPasses{ mainPass };
+			if (renderSystemSettings.enableDepthPrepass) {
+				PipelinePrewarmPass depthPrepass = mainPass;
+				depthPrepass.type = RenderPassType::DEPTH_PREPASS;
+				PipelinePrewarmPass shadedPass = mainPass;
+				shadedPass.depthPrepassed = true;
+				mainPasses = { depthPrepass, shadedPass };
+			}
+
+			std::vector<PipelinePrewarmPass> shadowedPasses = mainPasses;
+			if (engineSettings.useShadowMap) {
+				std::vector<VkRenderPass> shadowRenderPasses{ shadowMap->getRenderPass() };
+				if (shadowMap->cachesStaticCasters()) {
+					shadowRenderPasses = { shadowMap->getStaticRenderPass(), shadowMap->getDynamicRenderPass() };
+				}
+				for (VkRenderPass shadowRenderPass : shadowRenderPasses) {
+					PipelinePrewarmPass shadowPass{};
+					shadowPass.type = RenderPassType::SHADOW_PASS;
+					shadowPass.renderPass = shadowRenderPass;
+					shadowPass.systemDescriptorSets.push_back(globalSet);
+					shadowedPasses.push_back(shadowPass);
+				}
+			}
+
+			std::vector<VkPolygonMode> wireframeModes{ VK_POLYGON_MODE_FILL, VK_POLYGON_MODE_LINE };
+
+			textureRenderSystem.prewarmPipelines(shadowedPasses);
+			vegetationRenderSystem.prewarmPipelines(shadowedPasses);
+			terrainRenderSystem.prewarmPipelines(shadowedPasses, wireframeModes);
+			waterRenderSystem.prewarmPipelines(mainPasses, wireframeModes);
+			uiRenderSystem.prewarmPipelines({ mainPass });
+		}
+
 		startTime = std::chrono::high_resolution_clock::now();
 		auto currentTime = startTime;
 		float physicsTimeAccumulator = 0.0f;
@@ -173,10 +250,18 @@ namespace vk {
 			if (auto commandBuffer = renderer.beginFrame()) {
 
 				int frameIndex = renderer.getFrameIndex();
+
+				// the fence of this frame was waited on, slots it released can be reused now
+				if (BindlessRegistry* bindlessRegistry = BindlessRegistry::get()) {
+					bindlessRegistry->beginFrame(frameIndex);
+				}
+				vegetationRenderSystem.beginFrame(frameIndex);
+				terrainRenderSystem.beginFrame(frameIndex);
 				
 				FrameInfo frameInfo{};
 				frameInfo.frameTime = deltaTime;
 				frameInfo.commandBuffer = commandBuffer;
+				frameInfo.cameraPosition = sceneManager.getPlayer()->getCameraPosition();
 
 				GlobalUbo ubo{};
 				ubo.uiOrthographicProjection = getOrthographicProjection(0, window.getWidth(), window.getHeight(), 0, 0.1f, 500.0f);
@@ -184,54 +269,145 @@ namespace vk {
 				ubo.sunColor = glm::vec4(sceneManager.getSun()->getColor(), 1.0f);
 				ubo.cameraPosition = glm::vec4(sceneManager.getPlayer()->getCameraPosition(), 1.0f);
 				
-				// shadow map render pass
+				glm::mat4 cameraProjection = sceneManager.getPlayer()->getProjMat();
+				glm::mat4 cameraView = sceneManager.getPlayer()->calculateViewMat();
+				// the camera looks along -z in view space
+				frameInfo.cameraForward = -glm::vec3(cameraView[0][2], cameraView[1][2], cameraView[2][2]);
+				frameInfo.lodProjectionScale = std::abs(cameraProjection[1][1]);
+				
+				renderGraph.reset();
+
+				// shadow map render passes, one per cascade
+				std::array<RenderGraph::ResourceHandle, ShadowMap::MAX_CASCADES> cascadeLayers{};
+				std::array<Frustum, ShadowMap::MAX_CASCADES> cascadeFrusta{};
 				if (engineSettings.useShadowMap) { // TODO parse setting from shaders in the engine init step
-					frameInfo.renderPassType = RenderPassType::SHADOW_PASS;
+					shadowMap->updateCascades(frameIndex, cameraView, cameraProjection);
+
+					std::vector<VkClearValue> shadowClearValues = shadowMap->getClearValues();
+
+					// render with the light's perspective of the cascade
+					auto beginShadowPass = [&](uint32_t cascadeIndex, ShadowCasters shadowCasters) {
+						frameInfo.renderPassType = RenderPassType::SHADOW_PASS;
+						frameInfo.shadowCasters = shadowCasters;
+						frameInfo.minCasterRadius = shadowMap->getCascade(cascadeIndex).minCasterRadius;
+						frameInfo.systemDescriptorSets.clear();
+						frameInfo.systemDescriptorSets.push_back({
+							cascadeDescriptorSets[frameIndex * ShadowMap::MAX_CASCADES + cascadeIndex],
+							globalSetLayout->getDescriptorSetLayout(),
+							0
+						});
+					};
+
+					for (uint32_t cascadeIndex = 0; cascadeIndex < shadowMap->getCascadeCount(); cascadeIndex++) {
+						const ShadowMap::Cascade& cascade = shadowMap->getCascade(cascadeIndex);
+
+						GlobalUbo cascadeUbo = ubo;
+						cascadeUbo.projection = cascade.lightProjectionMatrix;
+						cascadeUbo.view = cascade.lightViewMatrix;
+						cascadeUbo.lodParams.x = cascade.tessellationScale;
+
+						Buffer& cascadeUboBuffer = *cascadeUboBuffers[frameIndex * ShadowMap::MAX_CASCADES + cascadeIndex];
+						cascadeUboBuffer.writeToBuffer(&cascadeUbo);
+						cascadeUboBuffer.flush();
+
+						cascadeFrusta[cascadeIndex] = Frustum::fromMatrix(cascadeUbo.projection * cascadeUbo.view);
+
+						VkImageSubresourceRange layerRange = shadowMap->getCascadeRange(cascadeIndex);
+						cascadeLayers[cascadeIndex] = renderGraph.importImage("shadow_cascade", shadowMap->getImage(), layerRange);
+
+						if (!shadowMap->cachesStaticCasters()) {
+							renderGraph.addPass("shadow_cascade", [&, cascadeIndex](VkCommandBuffer commandBuffer) {
+								beginShadowPass(cascadeIndex, ShadowCasters::ALL);
+								renderer.beginRenderPass(
+									commandBuffer,
+									shadowMap->getRenderPass(),
+									shadowMap->getFramebuffer(cascadeIndex),
+									shadowMap->getExtent(),
+									shadowClearValues
+								);
+
+								textureRenderSystem.renderGameObjects(frameInfo, cascadeFrusta[cascadeIndex]);
+								vegetationRenderSystem.renderGameObjects(frameInfo, cascadeFrusta[cascadeIndex]);
+								terrainRenderSystem.renderGameObjects(frameInfo, cascadeFrusta[cascadeIndex]);
+
+								renderer.endRenderPass(commandBuffer);
+							}).write(cascadeLayers[cascadeIndex], RenderGraph::Usage::DEPTH_ATTACHMENT, true);
+							continue;
+						}
+
+						RenderGraph::ResourceHandle staticLayer = renderGraph.importImage("shadow_static_cache", shadowMap->getStaticImage(), layerRange);
+
+						// terrain and static objects only when the cached placement changed
+						if (cascade.refreshStatic) {
+							renderGraph.addPass("shadow_static", [&, cascadeIndex](VkCommandBuffer commandBuffer) {
+								beginShadowPass(cascadeIndex, ShadowCasters::STATIC_ONLY);
+								renderer.beginRenderPass(
+									commandBuffer,
+									shadowMap->getStaticRenderPass(),
+									shadowMap->getStaticFramebuffer(cascadeIndex),
+									shadowMap->getExtent(),
+									shadowClearValues
+								);
+
+								textureRenderSystem.renderGameObjects(frameInfo, cascadeFrusta[cascadeIndex]);
+								vegetationRenderSystem.renderGameObjects(frameInfo, cascadeFrusta[cascadeIndex]);
+								terrainRenderSystem.renderGameObjects(frameInfo, cascadeFrusta[cascadeIndex]);
+
+								renderer.endRenderPass(commandBuffer);
+							}).write(staticLayer, RenderGraph::Usage::DEPTH_ATTACHMENT, true);
+						}
+
+						renderGraph.addPass("shadow_static_copy", [&, cascadeIndex](VkCommandBuffer commandBuffer) {
+							shadowMap->copyStaticCache(commandBuffer, cascadeIndex);
+						})
+							.read(staticLayer, RenderGraph::Usage::TRANSFER_SRC)
+							.write(cascadeLayers[cascadeIndex], RenderGraph::Usage::TRANSFER_DST, true);
+
+						renderGraph.addPass("shadow_dynamic", [&, cascadeIndex](VkCommandBuffer commandBuffer) {
+							beginShadowPass(cascadeIndex, ShadowCasters::DYNAMIC_ONLY);
+							renderer.beginRenderPass(
+								commandBuffer,
+								shadowMap->getDynamicRenderPass(),
+								shadowMap->getFramebuffer(cascadeIndex),
+								shadowMap->getExtent(),
+								shadowClearValues
+							);
+
+							textureRenderSystem.renderGameObjects(frameInfo, cascadeFrusta[cascadeIndex]);
+
+							renderer.endRenderPass(commandBuffer);
+						}).write(cascadeLayers[cascadeIndex], RenderGraph::Usage::DEPTH_ATTACHMENT);
+					}
+				}
+				
+				// images added to the ui atlas are copied in before the main render pass samples it
+				VkImageSubresourceRange atlasRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+				RenderGraph::ResourceHandle uiAtlas = renderGraph.importImage("ui_atlas", uiRenderSystem.getAtlasImage(), atlasRange);
+				if (uiRenderSystem.hasAtlasUpdates()) {
+					renderGraph.addPass("ui_atlas_upload", [&](VkCommandBuffer commandBuffer) {
+						uiRenderSystem.recordAtlasUpdates(commandBuffer);
+					}).write(uiAtlas, RenderGraph::Usage::TRANSFER_DST);
+				}
 
-					shadowMap->updateShadowUbo(frameIndex);
-					
-					// temporarily set projection and view with light's perspective
-					const ShadowMap::ShadowUbo& shadowUbo = shadowMap->getShadowUbo();
-					ubo.projection = shadowUbo.lightProjectionMatrix;
-					ubo.view = shadowUbo.lightViewMatrix;
+				// main render pass
+				RenderGraph::PassBuilder mainPass = renderGraph.addPass("main", [&](VkCommandBuffer commandBuffer) {
+					frameInfo.renderPassType = RenderPassType::DEFAULT_PASS;
+					frameInfo.minCasterRadius = 0.0f;
+					frameInfo.shadowCasters = ShadowCasters::ALL;
 
-					Frustum frustum = Frustum::fromMatrix(ubo.projection * ubo.view);
-					
+					ubo.projection = cameraProjection;
+					ubo.view = cameraView;
 					uboBuffers[frameIndex]->writeToBuffer(&ubo);
 					uboBuffers[frameIndex]->flush();
 
+					Frustum frustum = Frustum::fromMatrix(ubo.projection * ubo.view);
+
 					frameInfo.systemDescriptorSets.clear();
 					frameInfo.systemDescriptorSets.push_back({
 						globalDescriptorSets[frameIndex],
 						globalSetLayout->getDescriptorSetLayout(),
 						0
 					});
-					
-					std::vector<VkClearValue> clearValues = shadowMap->getClearValues();
-					renderer.beginRenderPass(
-						commandBuffer,
-						shadowMap->getRenderPass(),
-						shadowMap->getFramebuffer(),
-						shadowMap->getExtent(),
-						clearValues
-					);
-					
-					textureRenderSystem.renderGameObjects(frameInfo, frustum);
-					terrainRenderSystem.renderGameObjects(frameInfo, frustum);
-					
-					renderer.endRenderPass(commandBuffer);
-				}
-				
-				// main render pass
-				{
-					frameInfo.renderPassType = RenderPassType::DEFAULT_PASS;
-
-					ubo.projection = sceneManager.getPlayer()->getProjMat();
-					ubo.view = sceneManager.getPlayer()->calculateViewMat();
-					uboBuffers[frameIndex]->writeToBuffer(&ubo);
-					uboBuffers[frameIndex]->flush();
-
-					Frustum frustum = Frustum::fromMatrix(ubo.projection * ubo.view);
 
 					if (engineSettings.useShadowMap) {
 						// specified to be on set binding 2 in shadow map class
@@ -251,10 +427,36 @@ namespace vk {
 						clearValues
 					);
 
+					if (renderSystemSettings.enableOcclusionCulling) {
+						occlusionCuller.beginFrame(ubo.projection * ubo.view);
+						for (auto& weakOccluder : sceneManager.getOccluders()) {
+							if (auto occluder = weakOccluder.lock()) {
+								occlusionCuller.rasterize(*occluder->getOccluder(), occluder->computeModelMatrix());
+							}
+						}
+						occlusionCuller.finish();
+						frameInfo.occlusionCuller = &occlusionCuller;
+					}
+
+					// opaque depth first, the shading below then runs once per pixel with an equal depth test
+					// water is blended and keeps its own depth test
+					if (renderSystemSettings.enableDepthPrepass) {
+						frameInfo.renderPassType = RenderPassType::DEPTH_PREPASS;
+						textureRenderSystem.renderGameObjects(frameInfo, frustum);
+						vegetationRenderSystem.renderGameObjects(frameInfo, frustum);
+						terrainRenderSystem.renderGameObjects(frameInfo, frustum);
+
+						frameInfo.renderPassType = RenderPassType::DEFAULT_PASS;
+						frameInfo.depthPrepassed = true;
+					}
+
 					// render main scene
 					renderedGameObjects += textureRenderSystem.renderGameObjects(frameInfo, frustum);
+					renderedGameObjects += vegetationRenderSystem.renderGameObjects(frameInfo, frustum);
 					renderedGameObjects += terrainRenderSystem.renderGameObjects(frameInfo, frustum);
 					renderedGameObjects += waterRenderSystem.renderGameObjects(frameInfo, frustum);
+					frameInfo.occlusionCuller = nullptr;
+					frameInfo.depthPrepassed = false;
 
 					VkClearAttachment clearAttachment{};
 					clearAttachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
@@ -267,7 +469,7 @@ namespace vk {
 					clearRect.baseArrayLayer = 0;
 					clearRect.layerCount = 1;
 
-					// write values directly into color/depth attachments for ui drawing
+					// the ui depth tests only against itself, not against the scene
 					vkCmdClearAttachments(
 						frameInfo.commandBuffer,
 						1,
@@ -275,11 +477,21 @@ namespace vk {
 						1,
 						&clearRect);
 
-					renderedGameObjects += uiRenderSystem.renderGameObjects(frameInfo, frustum);
+					renderedGameObjects += uiRenderSystem.renderGameObjects(frameInfo);
 
 					renderer.endRenderPass(commandBuffer);
+				});
+				// presents, the swap chain render pass handles its attachments itself
+				mainPass.setSideEffects();
+				mainPass.read(uiAtlas, RenderGraph::Usage::SAMPLED);
+				if (engineSettings.useShadowMap) {
+					for (uint32_t cascadeIndex = 0; cascadeIndex < shadowMap->getCascadeCount(); cascadeIndex++) {
+						mainPass.read(cascadeLayers[cascadeIndex], RenderGraph::Usage::DEPTH_SAMPLED);
+					}
 				}
 
+				renderGraph.execute(commandBuffer);
+
 				renderer.endFrame();
 			}
 
@@ -296,6 +508,12 @@ namespace vk {
 					bufPtr.reset();
 				}
 			}
+			for (auto& bufPtr : cascadeUboBuffers) {
+				if (bufPtr) {
+					bufPtr->scheduleDestroy(*destructionQueue);
+					bufPtr.reset();
+				}
+			}
 		}
 	}
 
@@ -15,8 +15,12 @@
 #include "rendering/render_systems/UIRenderSystem.h"
 #include "rendering/render_systems/TerrainRenderSystem.h"
 #include "rendering/render_systems/WaterRenderSystem.h"
+#include "rendering/render_systems/VegetationRenderSystem.h"
 
 #include "rendering/ShadowMap.h"
+#include "rendering/RenderGraph.h"
+#include "rendering/structures/OcclusionCuller.h"
+#include "rendering/materials/BindlessRegistry.h"
 
 #include "scene/SceneManager.h"
 #include "logical_systems/input/InputManager.h"
@@ -3,11 +3,14 @@
 #include "vk/vk_model.h"
 
 #include <functional>
+#include <limits>
 
 namespace vk {
 
 	using id_t = unsigned int;
 
+	struct OccluderMesh;
+
 	constexpr id_t INVALID_OBJECT_ID = 0;
 
 	class GameObject {
@@ -43,6 +46,22 @@ namespace vk {
 
 		virtual bool enableFrustumCulling() const { return true; }
 
+		// camera stand-ins like impostor billboards would cast wrongly oriented shadows
+		virtual bool castsShadows() const { return true; }
+
+		// not drawn in the main pass beyond this camera distance (e.g. replaced by an impostor)
+		virtual float getMaxDrawDistance() const { return std::numeric_limits<float>::max(); }
+
+		// model space triangles that hide what is behind them in the software occlusion culling, nullptr if the object is not solid
+		virtual const OccluderMesh* getOccluder() const { return nullptr; }
+
+		// > 1 for objects that draw many copies of their model in one instanced draw
+		virtual uint32_t getInstanceCount() const { return 1; }
+
+		// level of detail the object was drawn with last, render systems need it for hysteresis
+		uint32_t getLod() const { return lod; }
+		void setLod(uint32_t newLod) { lod = newLod; }
+
 		/**
 		 * The object is added to a queue of objects to destroy in the scene manager - it is still alive for now, but gets removed in the cleanup phase.
 		 * Doesn't destroy player or sun.
@@ -55,5 +74,8 @@ namespace vk {
 		GameObject() : id(nextID++) {}
 
 		const id_t id;
+
+	   private:
+		uint32_t lod = 0;
 	};
 }
\ No newline at end of file
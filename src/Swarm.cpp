@@ -5,6 +5,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "procedural/VegetationSharedResources.h"
 
+#include <Jolt/Physics/Body/BodyLock.h>
+
 #include <fmt/format.h>
 #include <random>
 
@@ -183,7 +185,7 @@ void Swarm::onPlayerDeath() {
 	// Create background
 	UIComponentCreationSettings hudSettings{};
 	hudSettings.window = window.getGLFWWindow();
-	hudSettings.model = Model::createModelFromFile(device, "models:quad.glb", true);
+	hudSettings.modelPath = "models:quad.glb";
 	hudSettings.name = "you_died_quad";
 	hudSettings.controllable = false;
 	hudSettings.anchorRight = false;
@@ -196,7 +198,6 @@ void Swarm::onPlayerDeath() {
 	// Create "You died" text
 	Font font;
 	TextComponent* deathText = new TextComponent(
-		device,
 		font,
 		"You died",
 		"you_died_text",
@@ -213,7 +214,6 @@ void Swarm::onPlayerDeath() {
 
 	// Create "Time: <time>" text
 	TextComponent* deathTime = new TextComponent(
-		device,
 		font,
 		time,
 		"you_died_time",
@@ -286,97 +286,39 @@ void Swarm::init() {
 		sceneManager.setSun(make_unique<lighting::Sun>(sunPos, baseSunDirection, glm::vec3(1.0f, 1.0f, 1.0f)));
 	}
 
-	// TODO terrain generation and sync of collider and model is way too complicated here
-	// Terrain
-	int samplesPerSide = 100;
+	// Terrain and vegetation, streamed in tiles around the player
 	{
-		float noiseScale = 5.0f;  // Controls the "frequency" of the noise
-
-		TessellationMaterial::MaterialCreationData terrainCreationData = {};
-		terrainCreationData.textureRepetition = glm::vec2(samplesPerSide / 20.0f, samplesPerSide / 20.0f);
-		terrainCreationData.heightScale = maxTerrainHeight; // offset in gpu
-
-		// Generate terrain model with heightmap
-		auto result = vk::Model::createTerrainModel(
-			device,
-			samplesPerSide,
-			"textures:ground/dirt.png",	 // Tile texture path
-			noiseScale,
-			/* loadHeightTexture */ false,
-			/* heightTexturePath */ "none",
-			/* seed */ -1, // if -1: use random
-			/* useTessellation */ true,
-			terrainCreationData
-		);
-
-		// Store heightfield data for vegetation and parameter tuning
-		if (result.second.size() >= samplesPerSide * samplesPerSide) {
-			heightfieldData = result.second;  // Copy the heightfield data
-		}
-		else {
-			// Create flat heightfield if result doesn't have enough data
-			heightfieldData.resize(samplesPerSide * samplesPerSide, 0.0f);
-		}
-
-		// Store terrain parameters for regeneration
-		terrainSamplesPerSide = samplesPerSide;
-		terrainScale = glm::vec3{ 100.0f, maxTerrainHeight, 100.0f };
-		terrainPosition = glm::vec3{ 0.0, -2.0, 0.0 };
+		procedural::WorldStreamer::Settings worldSettings{};
+		worldSettings.samplesPerTile = 100;
+		worldSettings.tileSize = 200.0f;
+		worldSettings.noiseScale = 5.0f;  // Controls the "frequency" of the noise
 
-		// create terrain with procedural heightmap using perlin noise
-		// create terrain with the generated heightmap data
-		auto terrain = std::make_unique<physics::Terrain>(
-			physicsSimulation.getPhysicsSystem(),
-			std::move(result.first),
-			glm::vec3{ 0.0, -2.0, 0.0 },	// position slightly below origin to prevent falling through
-			terrainScale, // physics model scale
-			std::move(result.second));
-
-		sceneManager.addTerrainObject(std::move(terrain));
-
-		// Create shared vegetation resources to avoid descriptor pool exhaustion
-		auto sharedResources = std::make_shared<procedural::VegetationSharedResources>(device);
-	}
+		// one random world per start, tiles stay consistent with each other through the shared seed
+		std::random_device rd;
+		worldSettings.seed = static_cast<int>(rd() & 0xffff);
 
-	// Vegetation (L-Systems) - moved inside terrain block to access heightfield data
-	{
-		procedural::VegetationIntegrator vegetationIntegrator(device);
+		worldSettings.heightScale = maxTerrainHeight; // offset in gpu
+		worldSettings.baseHeight = -2.0f;  // slightly below origin to prevent falling through
+		worldSettings.loadRadius = 1;
 
-		procedural::VegetationIntegrator::VegetationSettings vegSettings;
-		vegSettings.terrainMin = glm::vec2(-70.0f, -70.0f);
-		vegSettings.terrainMax = glm::vec2(70.0f, 70.0f);
+		worldSettings.terrainMaterial.textureRepetition = glm::vec2(worldSettings.samplesPerTile / 20.0f, worldSettings.samplesPerTile / 20.0f);
+		worldSettings.terrainMaterial.heightScale = maxTerrainHeight;
 
-		vegSettings.treeDensity = 0.002f;
+		worldSettings.vegetation.treeDensity = 0.002f;
 
 		// Slope constraints for realistic placement
-		vegSettings.maxTreeSlope = 30.0f;
+		worldSettings.vegetation.maxTreeSlope = 30.0f;
 
 		// Scale variation for much larger, more impressive trees
-		vegSettings.treeScaleRange = glm::vec2(1.2f, 2.5f);
-
-		// Use random seed for deterministic vegetation
-		vegSettings.placementSeed = 12345;
+		worldSettings.vegetation.treeScaleRange = glm::vec2(1.2f, 2.5f);
 
-		try {
-			// Generate enhanced vegetation on terrain using the heightfield data
-			vegetationIntegrator.generateEnhancedVegetationOnTerrain(
-				vegSettings,
-				heightfieldData,
-				samplesPerSide,
-				glm::vec3(100.0f, maxTerrainHeight, 100.0f),
-				glm::vec3(0.0, -2.0, 0.0));
+		// base seed, every tile derives its own from it
+		worldSettings.vegetation.placementSeed = 12345;
 
-			// Add generated enhanced vegetation to scene
-			vegetationIntegrator.addEnhancedVegetationToScene(sceneManager);
+		worldStreamer = std::make_unique<procedural::WorldStreamer>(device, physicsSimulation.getPhysicsSystem(), worldSettings);
 
-			// Report statistics
-			auto stats = vegetationIntegrator.getVegetationStats();
-			printf("Added enhanced L-System vegetation: %d trees\n", stats.treeCount);
-
-		}
-		catch (const std::exception& e) {
-			printf("Error generating vegetation: %s\n", e.what());
-		}
+		// the tiles around the spawn have to exist before the player starts falling
+		worldStreamer->loadAround(sceneManager.getPlayer()->getPosition());
 	}
 
 	// Skybox
@@ -439,9 +381,6 @@ void Swarm::init() {
 	{
 		int samplesPerSidePatch = 10;
 		
-		float patchSize = 50.0f;
-		int patchesPerSide = 40;
-		
 		auto waterMaterial = std::make_shared<WaterMaterial>(device, "textures:water.png");
 
 		CreateWaterData waterData{};
@@ -456,20 +395,18 @@ void Swarm::init() {
 		waves.push_back(glm::vec4{ 1.0f, 0.6f, 0.25f, 31.0f });
 		waves.push_back(glm::vec4{ 1.0f, 1.3f, 0.25f, 18.0f });
 		waterMaterial->setWaves(waves);
+		waterSurface = std::make_unique<physics::WaterSurface>(WATER_LEVEL, waves);
 
 		std::shared_ptr<Model> waterModel = std::shared_ptr<Model>(Model::createWaterModel(device, samplesPerSidePatch, waves));
 		
 		waterModel->setMaterial(waterMaterial);
 
+		// blocks of 100 units around the camera, 5 rings reach 3200 units
 		WaterObject::WaterCreationSettings waterCreationSettings = {};
-
-		for (int i = -patchesPerSide / 2; i < patchesPerSide / 2; i++) {
-			for (int j = -patchesPerSide / 2; j < patchesPerSide / 2; j++) {
-				waterCreationSettings.position = glm::vec3{ i*patchSize*2, -20.0f, j*patchSize*2 };
-				waterCreationSettings.waterScale = patchSize;
-				sceneManager.addWaterObject(std::make_unique<WaterObject>(waterModel, waterCreationSettings));
-			}
-		}
+		waterCreationSettings.position = glm::vec3{ 0.0f, WATER_LEVEL, 0.0f };
+		waterCreationSettings.waterScale = 50.0f;
+		waterCreationSettings.rings = 5;
+		sceneManager.addWaterObject(std::make_unique<WaterObject>(waterModel, waterCreationSettings));
 	}
 
 	// UI
@@ -479,7 +416,7 @@ void Swarm::init() {
 		hudSettings.window = window.getGLFWWindow();
 
 		// Standard Debug quad
-		hudSettings.model = Model::createModelFromFile(device, "models:quad.glb", true);
+		hudSettings.modelPath = "models:quad.glb";
 		hudSettings.name = "debug_quad_standard";
 		hudSettings.controllable = false;
 		hudSettings.anchorRight = true;
@@ -490,7 +427,7 @@ void Swarm::init() {
 		sceneManager.addUIObject(std::make_unique<UIComponent>(hudSettings));
 
 		// Debug quad
-		hudSettings.model = Model::createModelFromFile(device, "models:quad.glb", true);
+		hudSettings.modelPath = "models:quad.glb";
 		hudSettings.name = "debug_quad";
 		hudSettings.controllable = false;
 		hudSettings.anchorRight = true;
@@ -502,7 +439,6 @@ void Swarm::init() {
 
 		// F1: Toggle HUD
 		TextComponent* debug_text_f1 = new TextComponent(
-			device,
 			font,
 			"F1: Toggle HUD",
 			"debug_text_toggle_hud",
@@ -519,7 +455,6 @@ void Swarm::init() {
 
 		// F8: Toggle Culling
 		TextComponent* debug_text_f8 = new TextComponent(
-			device,
 			font,
 			"F8: Toggle \n Culling",
 			"debug_text_toggle_culling",
@@ -536,7 +471,6 @@ void Swarm::init() {
 
 		// F9: Toggle Wireframe terrain
 		TextComponent* debug_text_f9 = new TextComponent(
-			device,
 			font,
 			"F9: Toggle \n Wireframe Terrain",
 			"debug_text_toggle_menu",
@@ -553,7 +487,6 @@ void Swarm::init() {
 
 		// F10: Toggle Debug Mode
 		TextComponent* debug_text_f10 = new TextComponent(
-			device,
 			font,
 			"F10: Toggle \n Debug Mode",
 			"debug_text_toggle_menu",
@@ -570,7 +503,6 @@ void Swarm::init() {
 
 		// F11: Toggle Fullscreen
 		TextComponent* debug_text_f11 = new TextComponent(
-			device,
 			font,
 			"F11: Toggle \n Fullscreen",
 			"debug_text_toggle_fullscreen",
@@ -586,7 +518,7 @@ void Swarm::init() {
 		sceneManager.addUIObject(std::unique_ptr<UIComponent>(debug_text_f11));
 
 		// Clock quad
-		hudSettings.model = Model::createModelFromFile(device, "models:quad.glb", true);
+		hudSettings.modelPath = "models:quad.glb";
 		hudSettings.name = "clock_quad";
 		hudSettings.controllable = false;
 		hudSettings.anchorRight = false;
@@ -597,7 +529,7 @@ void Swarm::init() {
 		sceneManager.addUIObject(std::make_unique<UIComponent>(hudSettings));
 
 		// Health quad
-		hudSettings.model = Model::createModelFromFile(device, "models:quad.glb", true);
+		hudSettings.modelPath = "models:quad.glb";
 		hudSettings.name = "health_quad";
 		hudSettings.controllable = false;
 		hudSettings.anchorRight = false;
@@ -609,7 +541,6 @@ void Swarm::init() {
 
 		// Health text
 		TextComponent* healthText = new TextComponent(
-			device,
 			font,
 			"Health: 100%",
 			"health_text",
@@ -627,7 +558,6 @@ void Swarm::init() {
 
 		// Clock
 		TextComponent* gameTimeText = new TextComponent(
-			device,
 			font,
 			"Time: 00:00",
 			"clock",
@@ -645,7 +575,6 @@ void Swarm::init() {
 
 		// rendered objects
 		TextComponent* renderedObjectsText = new TextComponent(
-			device,
 			font,
 			"0",
 			"rendered_objects",
@@ -662,7 +591,7 @@ void Swarm::init() {
 			std::unique_ptr<UIComponent>(renderedObjectsText));
 
 		// USPS
-		hudSettings.model = Model::createModelFromFile(device, "models:USPS.glb", true);
+		hudSettings.modelPath = "models:USPS.glb";
 		hudSettings.name = "usps";
 		hudSettings.controllable = false;
 		hudSettings.anchorRight = true;
@@ -673,7 +602,7 @@ void Swarm::init() {
 		sceneManager.addUIObject(std::make_unique<UIComponent>(hudSettings));
 
 		// Crosshair
-		hudSettings.model = Model::createModelFromFile(device, "models:crosshair.glb", true);
+		hudSettings.modelPath = "models:crosshair.glb";
 		hudSettings.name = "crosshair";
 		hudSettings.controllable = false;
 		hudSettings.anchorRight = false;
@@ -755,6 +684,11 @@ void Swarm::gameActiveUpdate(float deltaTime) {
 	sceneManager.updateEnemyVisuals(deltaTime);
 	
 	auto player = sceneManager.getPlayer();
+
+	if (worldStreamer && player) {
+		worldStreamer->update(player->getPosition());
+	}
+
 	auto sun = sceneManager.getSun();
 
 	// rotate sun direction around Y axis
@@ -810,6 +744,90 @@ void Swarm::prePhysicsUpdate() {
 	// TODO hook an event manager and call update on all methods that are registered (objects register methods like with input polling but in a separate event manager -> also updates timers stored in sceneManager every frame)
 	sceneManager.updateEnemyPhysics(physicsSimulation.cPhysicsDeltaTime);
 	sceneManager.updatePhysicsEntities(physicsSimulation.cPhysicsDeltaTime);
+
+	updateWater(physicsSimulation.cPhysicsDeltaTime);
+}
+
+void Swarm::updateWater(float cPhysicsDeltaTime) {
+	if (!waterSurface) {
+		return;
+	}
+
+	SceneManager& sceneManager = SceneManager::getInstance();
+	JPH::PhysicsSystem& physicsSystem = physicsSimulation.getPhysicsSystem();
+	JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+
+	// only objects below the highest possible crest go into the batch query
+	float crestHeight = waterSurface->getWaterLevel() + waterSurface->getMaxAmplitude();
+
+	std::vector<std::shared_ptr<physics::Enemy>> wetEnemies;
+	std::vector<JPH::BodyID> wetBodies;
+	waterQueryPositions.clear();
+
+	for (auto& weakEnemy : sceneManager.getActiveEnemies()) {
+		auto enemy = weakEnemy.lock();
+		if (!enemy || enemy->getCurrentHealth() <= 0.0f) {
+			continue;
+		}
+		glm::vec3 position = enemy->getPosition();
+		if (position.y + ENEMY_DROWN_DEPTH < crestHeight) {
+			wetEnemies.push_back(std::move(enemy));
+			waterQueryPositions.emplace_back(position.x, position.z);
+		}
+	}
+
+	for (auto& weakEntity : sceneManager.getActivePhysicsEntities()) {
+		auto entity = weakEntity.lock();
+		if (!entity) {
+			continue;
+		}
+		JPH::BodyID bodyID = entity->getBodyID();
+		if (bodyID.IsInvalid() || bodyInterface.GetMotionType(bodyID) != JPH::EMotionType::Dynamic) {
+			continue;
+		}
+		glm::vec3 position = RVec3ToGLM(bodyInterface.GetCenterOfMassPosition(bodyID));
+		if (position.y < crestHeight) {
+			wetBodies.push_back(bodyID);
+			waterQueryPositions.emplace_back(position.x, position.z);
+		}
+	}
+
+	if (waterQueryPositions.empty()) {
+		return;
+	}
+
+	// the shader animates the waves with the game time as well
+	waterHeights.resize(waterQueryPositions.size());
+	waterNormals.resize(waterQueryPositions.size());
+	waterSurface->sampleHeights(waterQueryPositions.data(), waterQueryPositions.size(), sceneManager.gameTime, waterHeights.data(), waterNormals.data());
+
+	for (size_t i = 0; i < wetEnemies.size(); i++) {
+		if (wetEnemies[i]->getPosition().y + ENEMY_DROWN_DEPTH < waterHeights[i]) {
+			wetEnemies[i]->takeDamage(DROWN_DAMAGE_PER_SECOND * cPhysicsDeltaTime);
+		}
+	}
+
+	const JPH::BodyLockInterface& lockInterface = physicsSystem.GetBodyLockInterface();
+	for (size_t i = 0; i < wetBodies.size(); i++) {
+		size_t query = wetEnemies.size() + i;
+
+		JPH::BodyLockWrite lock(lockInterface, wetBodies[i]);
+		if (!lock.Succeeded() || !lock.GetBody().IsActive()) {
+			continue;
+		}
+
+		// jolt computes the submerged volume from the shape below the surface plane
+		JPH::RVec3 surfacePosition(waterQueryPositions[query].x, waterHeights[query], waterQueryPositions[query].y);
+		lock.GetBody().ApplyBuoyancyImpulse(
+			surfacePosition,
+			JPH::Vec3(waterNormals[query].x, waterNormals[query].y, waterNormals[query].z),
+			BUOYANCY,
+			WATER_LINEAR_DRAG,
+			WATER_ANGULAR_DRAG,
+			JPH::Vec3::sZero(),
+			physicsSystem.GetGravity(),
+			cPhysicsDeltaTime);
+	}
 }
 
 void Swarm::postPhysicsUpdate() {}
@@ -834,6 +852,7 @@ void Swarm::postRenderingUpdate(EngineStats engineStats, float deltaTime) {
 
 void Swarm::toggleCulling() {
 	this->renderSystemSettings.enableFrustumCulling = !this->renderSystemSettings.enableFrustumCulling;
+	this->renderSystemSettings.enableOcclusionCulling = this->renderSystemSettings.enableFrustumCulling;
 	
 	if (this->renderSystemSettings.enableFrustumCulling) {
 		std::cout << "Culling enabled" << std::endl;
@@ -10,6 +10,7 @@
 #include "simulation/objects/static/Terrain.h"
 #include "simulation/objects/actors/enemies/Sprinter.h"
 #include "simulation/PhysicsSimulation.h"
+#include "simulation/WaterSurface.h"
 
 #include "asset_utils/AssetManager.h"
 #include "AudioSystem.h"
@@ -23,6 +24,8 @@
 #include "rendering/materials/TessellationMaterial.h"
 #include "rendering/materials/WaterMaterial.h"
 
+#include "procedural/WorldStreamer.h"
+
 #include "rendering/structures/Skybox.h"
 #include "rendering/structures/WaterObject.h"
 
@@ -75,6 +78,9 @@ class Swarm : public GameBase {
 	void toggleDebug();
 	void toggleCulling();
 
+	// enemies below the surface drown, dynamic physics objects float
+	void updateWater(float cPhysicsDeltaTime);
+
 	id_t gameTimeTextID;
 	id_t gameHealthTextID;
 	id_t renderedObjectsTextID;
@@ -96,10 +102,24 @@ class Swarm : public GameBase {
 
 	physics::PhysicsPlayer::PlayerCreationSettings originalPlayerSettings;
 
-	std::vector<float> heightfieldData; // heightfield for regeneration
-	int terrainSamplesPerSide = 100;
-	glm::vec3 terrainScale{100.0f, 15.0f, 100.0f};
-	glm::vec3 terrainPosition{0.0f, -2.0f, 0.0f};
+	// terrain tiles and their vegetation around the player
+	std::unique_ptr<procedural::WorldStreamer> worldStreamer;
+
+	// same waves as the water material, for gameplay queries
+	std::unique_ptr<physics::WaterSurface> waterSurface;
+	// scratch of updateWater, capacities are kept between steps
+	std::vector<glm::vec2> waterQueryPositions;
+	std::vector<float> waterHeights;
+	std::vector<glm::vec3> waterNormals;
+
+	static constexpr float WATER_LEVEL = -20.0f;
+	// enemy feet this far below the surface count as drowning
+	static constexpr float ENEMY_DROWN_DEPTH = 1.8f;
+	static constexpr float DROWN_DAMAGE_PER_SECOND = 25.0f;
+	// relative to the density of the water, > 1 floats
+	static constexpr float BUOYANCY = 1.5f;
+	static constexpr float WATER_LINEAR_DRAG = 0.5f;
+	static constexpr float WATER_ANGULAR_DRAG = 0.05f;
 
 	float sunRotationAngle = 0.0f;
 	glm::vec3 baseSunDirection = glm::normalize(glm::vec3(0.5f, -1.0f, 0.3f));
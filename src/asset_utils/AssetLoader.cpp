@@ -337,4 +337,47 @@ namespace vk {
 		return resolvedPath;
 	}
 
+	std::string AssetLoader::saveBinaryFile(const std::string& filename, const std::vector<char>& data) {
+		std::string filePath = "generated:" + filename;
+		std::string resolvedPath = resolvePath(filePath, true);
+
+		fs::path dirPath = fs::path(resolvedPath).parent_path();
+		if (!fs::exists(dirPath)) {
+			try {
+				fs::create_directories(dirPath);
+			} catch (const std::exception& e) {
+				std::cerr << "AssetLoader: Error creating directory: " << e.what() << std::endl;
+				return "";
+			}
+		}
+
+		// write to a temporary file first so a crash never leaves a truncated blob behind
+		std::string tmpPath = resolvedPath + ".tmp";
+		{
+			std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) {
+				std::cerr << "AssetLoader: Failed to save binary file: " << resolvedPath << std::endl;
+				return "";
+			}
+			file.write(data.data(), static_cast<std::streamsize>(data.size()));
+			if (!file) {
+				std::cerr << "AssetLoader: Failed to write binary file: " << resolvedPath << std::endl;
+				return "";
+			}
+		}
+
+		std::error_code ec;
+		fs::rename(tmpPath, resolvedPath, ec);
+		if (ec) {
+			std::cerr << "AssetLoader: Failed to move binary file into place: " << ec.message() << std::endl;
+			fs::remove(tmpPath, ec);
+			return "";
+		}
+
+		if (debugText)
+			std::cout << "AssetLoader: Successfully saved binary file: " << resolvedPath << " (" << data.size() << " bytes)" << std::endl;
+
+		return resolvedPath;
+	}
+
 }
\ No newline at end of file
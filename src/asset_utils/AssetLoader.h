@@ -64,6 +64,10 @@ namespace vk {
 		std::string saveTxtFile(const std::string& filename, const std::string& content);
 		std::string readTxtFile(const std::string& filepath);
 
+		// save a binary blob to the generated directory
+		// returns the resolved path or an empty string on failure
+		std::string saveBinaryFile(const std::string& filename, const std::vector<char>& data);
+
 	private:
 		AssetLoader() = default;
 		~AssetLoader() = default;
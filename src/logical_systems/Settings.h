@@ -6,4 +6,8 @@ struct EngineStats {
 
 struct RenderSystemSettings {
 	bool enableFrustumCulling = false;
+	// software occlusion culling of the main pass against terrain and other occluders
+	bool enableOcclusionCulling = false;
+	// draws opaque geometry depth only first, so the main pass shades every pixel once
+	bool enableDepthPrepass = true;
 };
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "GenerationCache.h"
+#include "../asset_utils/AssetLoader.h"
+
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace procedural {
+
+	namespace {
+
+		constexpr char BLOB_MAGIC[4] = { 'P', 'G', 'E', 'N' };
+
+		struct BlobHeader {
+			char magic[4];
+			uint32_t formatVersion;
+			uint64_t key;
+			uint64_t payloadSize;
+		};
+	}
+
+	GenerationCache::Key& GenerationCache::Key::add(const void* data, size_t size) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return *this;
+	}
+
+	GenerationCache::Key& GenerationCache::Key::add(const std::string& text) {
+		add(static_cast<uint64_t>(text.size()));
+		return add(text.data(), text.size());
+	}
+
+	void GenerationCache::Writer::append(const void* data, size_t size) {
+		const char* bytes = static_cast<const char*>(data);
+		buffer.insert(buffer.end(), bytes, bytes + size);
+	}
+
+	GenerationCache::Blob::~Blob() {
+#ifdef _WIN32
+		if (view) {
+			UnmapViewOfFile(view);
+		}
+		if (mappingHandle) {
+			CloseHandle(mappingHandle);
+		}
+		if (fileHandle) {
+			CloseHandle(fileHandle);
+		}
+#else
+		if (view) {
+			munmap(view, viewSize);
+		}
+#endif
+	}
+
+	bool GenerationCache::Blob::map(const std::string& path) {
+#ifdef _WIN32
+		HANDLE file = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		fileHandle = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+			return false;
+		}
+
+		mappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mappingHandle) {
+			return false;
+		}
+
+		view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (!view) {
+			return false;
+		}
+		viewSize = static_cast<size_t>(size.QuadPart);
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0) {
+			return false;
+		}
+
+		struct stat info {};
+		if (fstat(file, &info) != 0 || info.st_size <= 0) {
+			close(file);
+			return false;
+		}
+
+		// the mapping keeps its own reference to the file
+		void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (mapped == MAP_FAILED) {
+			return false;
+		}
+		view = mapped;
+		viewSize = static_cast<size_t>(info.st_size);
+#endif
+		return true;
+	}
+
+	bool GenerationCache::Blob::readBytes(void* out, size_t size) {
+		if (size > payloadSize - cursor) {
+			return false;
+		}
+		if (size > 0) {
+			std::memcpy(out, payload + cursor, size);
+		}
+		cursor += size;
+		return true;
+	}
+
+	std::unique_ptr<GenerationCache::Blob> GenerationCache::load(const std::string& name, uint64_t key) {
+		std::string path = vk::AssetLoader::getInstance().resolvePath("generated:" + blobFile(name), true);
+		std::error_code ec;
+		if (!std::filesystem::exists(path, ec)) {
+			return nullptr;
+		}
+
+		std::unique_ptr<Blob> blob(new Blob());
+		if (!blob->map(path) || blob->viewSize < sizeof(BlobHeader)) {
+			std::cerr << "GenerationCache: Could not map " << path << std::endl;
+			return nullptr;
+		}
+
+		BlobHeader header{};
+		std::memcpy(&header, blob->view, sizeof(BlobHeader));
+		if (std::memcmp(header.magic, BLOB_MAGIC, sizeof(BLOB_MAGIC)) != 0 || header.formatVersion != FORMAT_VERSION || header.key != key ||
+			header.payloadSize != blob->viewSize - sizeof(BlobHeader)) {
+			return nullptr;
+		}
+
+		blob->payload = static_cast<const char*>(blob->view) + sizeof(BlobHeader);
+		blob->payloadSize = static_cast<size_t>(header.payloadSize);
+		return blob;
+	}
+
+	void GenerationCache::store(const std::string& name, uint64_t key, const Writer& payload) {
+		BlobHeader header{};
+		std::memcpy(header.magic, BLOB_MAGIC, sizeof(BLOB_MAGIC));
+		header.formatVersion = FORMAT_VERSION;
+		header.key = key;
+		header.payloadSize = payload.data().size();
+
+		std::vector<char> data(sizeof(BlobHeader) + payload.data().size());
+		std::memcpy(data.data(), &header, sizeof(BlobHeader));
+		if (!payload.data().empty()) {
+			std::memcpy(data.data() + sizeof(BlobHeader), payload.data().data(), payload.data().size());
+		}
+
+		vk::AssetLoader::getInstance().saveBinaryFile(blobFile(name), data);
+	}
+
+	std::string GenerationCache::blobFile(const std::string& name) {
+		return "cache/" + name + ".bin";
+	}
+
+}  // namespace procedural
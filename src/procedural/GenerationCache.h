@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace procedural {
+
+	// versioned binary blobs of procedural content under generated:cache/, one file per name
+	// each blob stores the hash of the inputs it was generated from, warm starts map it read only and copy the content out
+	class GenerationCache {
+	   public:
+		// layout of the blob header, the content layout is versioned through the keys
+		static constexpr uint32_t FORMAT_VERSION = 1;
+
+		// fnv-1a over the generation inputs, add everything that changes the output including a content version
+		class Key {
+		   public:
+			Key& add(const void* data, size_t size);
+			Key& add(const std::string& text);
+
+			template <typename T>
+			Key& add(const T& value) {
+				static_assert(std::is_trivially_copyable<T>::value, "only plain values can be hashed bytewise");
+				return add(&value, sizeof(T));
+			}
+
+			template <typename T>
+			Key& add(const std::vector<T>& values) {
+				static_assert(std::is_trivially_copyable<T>::value, "only plain values can be hashed bytewise");
+				add(static_cast<uint64_t>(values.size()));
+				return add(values.data(), values.size() * sizeof(T));
+			}
+
+			uint64_t value() const {
+				return hash;
+			}
+
+		   private:
+			uint64_t hash = 0xcbf29ce484222325ull;
+		};
+
+		// payload of a blob, plain values and size prefixed vectors back to back
+		class Writer {
+		   public:
+			template <typename T>
+			void write(const T& value) {
+				static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written bytewise");
+				append(&value, sizeof(T));
+			}
+
+			template <typename T>
+			void write(const std::vector<T>& values) {
+				static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written bytewise");
+				write(static_cast<uint64_t>(values.size()));
+				append(values.data(), values.size() * sizeof(T));
+			}
+
+			const std::vector<char>& data() const {
+				return buffer;
+			}
+
+		   private:
+			void append(const void* data, size_t size);
+
+			std::vector<char> buffer;
+		};
+
+		// read only view of a cached payload, the file stays mapped while the blob lives
+		// reads mirror the writes, every read fails once the payload is exhausted
+		class Blob {
+		   public:
+			~Blob();
+
+			Blob(const Blob&) = delete;
+			Blob& operator=(const Blob&) = delete;
+
+			template <typename T>
+			bool read(T& value) {
+				static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read bytewise");
+				return readBytes(&value, sizeof(T));
+			}
+
+			template <typename T>
+			bool read(std::vector<T>& values) {
+				static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read bytewise");
+				uint64_t count = 0;
+				if (!read(count) || count > (payloadSize - cursor) / sizeof(T)) {
+					return false;
+				}
+				values.resize(static_cast<size_t>(count));
+				return readBytes(values.data(), values.size() * sizeof(T));
+			}
+
+			// true once the whole payload was read, a blob with trailing bytes does not match its reader
+			bool atEnd() const {
+				return cursor == payloadSize;
+			}
+
+		   private:
+			friend class GenerationCache;
+			Blob() = default;
+
+			bool map(const std::string& path);
+			bool readBytes(void* out, size_t size);
+
+			const char* payload = nullptr;
+			size_t payloadSize = 0;
+			size_t cursor = 0;
+
+			void* view = nullptr;
+			size_t viewSize = 0;
+			// windows only, the file and mapping handles
+			void* fileHandle = nullptr;
+			void* mappingHandle = nullptr;
+		};
+
+		// @returns nullptr if there is no blob for name or it was generated from different inputs
+		static std::unique_ptr<Blob> load(const std::string& name, uint64_t key);
+
+		// replaces the blob of name, a failed write only costs the next start another generation
+		static void store(const std::string& name, uint64_t key, const Writer& payload);
+
+	   private:
+		static std::string blobFile(const std::string& name);
+	};
+
+}  // namespace procedural
@@ -0,0 +1,219 @@
+#include "HeightmapGenerator.h"
+#include "GenerationCache.h"
+#include "ParallelFor.h"
+#include "../asset_utils/AssetLoader.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/noise.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace procedural {
+
+#if defined(__AVX__)
+	namespace {
+
+		// 8 lane port of glm::perlin(vec3), same operations in the same order so both paths agree
+		// only needs avx float ops, jolt's build flags enable avx2 for the whole project anyway
+		inline __m256 set1(float v) { return _mm256_set1_ps(v); }
+		inline __m256 add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+		inline __m256 sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+		inline __m256 mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+		inline __m256 floor8(__m256 x) { return _mm256_floor_ps(x); }
+		inline __m256 fract8(__m256 x) { return sub(x, floor8(x)); }
+		inline __m256 abs8(__m256 x) { return _mm256_andnot_ps(set1(-0.0f), x); }
+		// glm::step(edge, x), 0 if x < edge else 1
+		inline __m256 step8(__m256 edge, __m256 x) { return _mm256_and_ps(_mm256_cmp_ps(x, edge, _CMP_GE_OQ), set1(1.0f)); }
+		// glm::mix with a float weight, x * (1 - a) + y * a
+		inline __m256 mix8(__m256 x, __m256 y, __m256 a) { return add(mul(x, sub(set1(1.0f), a)), mul(y, a)); }
+
+		inline __m256 mod289(__m256 x) {
+			return sub(x, mul(floor8(mul(x, set1(1.0f / 289.0f))), set1(289.0f)));
+		}
+
+		inline __m256 permute(__m256 x) {
+			return mod289(mul(add(mul(x, set1(34.0f)), set1(1.0f)), x));
+		}
+
+		inline __m256 fade(__m256 t) {
+			return mul(mul(mul(t, t), t), add(mul(t, sub(mul(t, set1(6.0f)), set1(15.0f))), set1(10.0f)));
+		}
+
+		// gradient of one lattice corner, scaled by taylorInvSqrt of its squared length
+		inline void gradient(__m256 hash, __m256& gx, __m256& gy, __m256& gz) {
+			gx = mul(hash, set1(1.0f / 7.0f));
+			gy = sub(fract8(mul(floor8(gx), set1(1.0f / 7.0f))), set1(0.5f));
+			gx = fract8(gx);
+			gz = sub(sub(set1(0.5f), abs8(gx)), abs8(gy));
+			__m256 sz = step8(gz, _mm256_setzero_ps());
+			gx = sub(gx, mul(sz, sub(step8(_mm256_setzero_ps(), gx), set1(0.5f))));
+			gy = sub(gy, mul(sz, sub(step8(_mm256_setzero_ps(), gy), set1(0.5f))));
+
+			__m256 lengthSquared = add(add(mul(gx, gx), mul(gy, gy)), mul(gz, gz));
+			__m256 norm = sub(set1(1.79284291400159f), mul(set1(0.85373472095314f), lengthSquared));
+			gx = mul(gx, norm);
+			gy = mul(gy, norm);
+			gz = mul(gz, norm);
+		}
+
+		__m256 perlin8(__m256 px, __m256 py, __m256 pz) {
+			__m256 pi0x = floor8(px), pi0y = floor8(py), pi0z = floor8(pz);
+			__m256 pi1x = add(pi0x, set1(1.0f)), pi1y = add(pi0y, set1(1.0f)), pi1z = add(pi0z, set1(1.0f));
+			pi0x = mod289(pi0x);
+			pi0y = mod289(pi0y);
+			pi0z = mod289(pi0z);
+			pi1x = mod289(pi1x);
+			pi1y = mod289(pi1y);
+			pi1z = mod289(pi1z);
+
+			__m256 pf0x = fract8(px), pf0y = fract8(py), pf0z = fract8(pz);
+			__m256 pf1x = sub(pf0x, set1(1.0f)), pf1y = sub(pf0y, set1(1.0f)), pf1z = sub(pf0z, set1(1.0f));
+
+			// corners in glm's order: (x0, y0), (x1, y0), (x0, y1), (x1, y1), once for z0 and once for z1
+			const __m256 ix[4] = { pi0x, pi1x, pi0x, pi1x };
+			const __m256 iy[4] = { pi0y, pi0y, pi1y, pi1y };
+			const __m256 fx[4] = { pf0x, pf1x, pf0x, pf1x };
+			const __m256 fy[4] = { pf0y, pf0y, pf1y, pf1y };
+
+			__m256 n0[4], n1[4];
+			for (int c = 0; c < 4; c++) {
+				__m256 ixy = permute(add(permute(ix[c]), iy[c]));
+
+				__m256 gx, gy, gz;
+				gradient(permute(add(ixy, pi0z)), gx, gy, gz);
+				n0[c] = add(add(mul(gx, fx[c]), mul(gy, fy[c])), mul(gz, pf0z));
+
+				gradient(permute(add(ixy, pi1z)), gx, gy, gz);
+				n1[c] = add(add(mul(gx, fx[c]), mul(gy, fy[c])), mul(gz, pf1z));
+			}
+
+			__m256 fadeX = fade(pf0x), fadeY = fade(pf0y), fadeZ = fade(pf0z);
+			__m256 nz[4];
+			for (int c = 0; c < 4; c++) {
+				nz[c] = mix8(n0[c], n1[c], fadeZ);
+			}
+			__m256 nyz0 = mix8(nz[0], nz[2], fadeY);
+			__m256 nyz1 = mix8(nz[1], nz[3], fadeY);
+			return mul(set1(2.2f), mix8(nyz0, nyz1, fadeX));
+		}
+	}
+#endif
+
+	std::vector<float> HeightmapGenerator::generate(int gridSize, float noiseScale, int seed, int octaves) {
+		if (gridSize < 1) {
+			throw std::runtime_error("Heightmap grid size must be positive");
+		}
+
+		std::vector<float> heights(size_t(gridSize) * gridSize);
+		float seedOffset = static_cast<float>(seed);
+		parallelFor(size_t(gridSize), [&](size_t z) {
+			generateRow(heights.data() + z * gridSize, 0, int(z), gridSize, noiseScale, seedOffset, octaves);
+		});
+		return heights;
+	}
+
+	std::vector<float> HeightmapGenerator::generateTile(int gridSize, float noiseScale, int seed, int tileX, int tileZ, int octaves) {
+		if (gridSize < 2) {
+			throw std::runtime_error("Heightmap tiles need at least 2 samples per side");
+		}
+
+		// gridSize - 1 cells per tile, the last row and column are the first ones of the next tile
+		int originX = tileX * (gridSize - 1);
+		int originZ = tileZ * (gridSize - 1);
+
+		std::vector<float> heights(size_t(gridSize) * gridSize);
+		float seedOffset = static_cast<float>(seed);
+		parallelFor(size_t(gridSize), [&](size_t z) {
+			generateRow(heights.data() + z * gridSize, originX, originZ + int(z), gridSize, noiseScale, seedOffset, octaves);
+		});
+		return heights;
+	}
+
+	std::vector<float> HeightmapGenerator::generateCached(int gridSize, float noiseScale, int seed, int octaves) {
+		// bump when the noise above changes
+		const uint32_t contentVersion = 1;
+		uint64_t key = GenerationCache::Key().add(contentVersion).add(gridSize).add(noiseScale).add(seed).add(octaves).value();
+
+		if (auto blob = GenerationCache::load("terrain_heights", key)) {
+			std::vector<float> heights;
+			if (blob->read(heights) && blob->atEnd() && heights.size() == size_t(gridSize) * gridSize) {
+				return heights;
+			}
+		}
+
+		std::vector<float> heights = generate(gridSize, noiseScale, seed, octaves);
+
+		GenerationCache::Writer payload;
+		payload.write(heights);
+		GenerationCache::store("terrain_heights", key, payload);
+		return heights;
+	}
+
+	void HeightmapGenerator::generateRow(float* row, int originX, int z, int gridSize, float noiseScale, float seed, int octaves) {
+		float maxValue = 0.0f;
+		float amplitude = 1.0f;
+		for (int i = 0; i < octaves; i++) {
+			maxValue += amplitude;
+			amplitude *= 0.5f;
+		}
+
+		float nz = z * noiseScale / gridSize;
+		int x = 0;
+
+#if defined(__AVX__)
+		for (; x + 8 <= gridSize; x += 8) {
+			alignas(32) float nxLanes[8];
+			for (int lane = 0; lane < 8; lane++) {
+				nxLanes[lane] = (originX + x + lane) * noiseScale / gridSize;
+			}
+			__m256 nx = _mm256_load_ps(nxLanes);
+
+			__m256 h = _mm256_setzero_ps();
+			float octaveAmplitude = 1.0f;
+			float frequency = 1.0f;
+			for (int i = 0; i < octaves; i++) {
+				__m256 sample = perlin8(mul(nx, set1(frequency)), set1(nz * frequency), set1(seed));
+				h = add(h, mul(sample, set1(octaveAmplitude)));
+				octaveAmplitude *= 0.5f;
+				frequency *= 2.0f;
+			}
+
+			// normalize to [-1, 1]
+			_mm256_storeu_ps(row + x, _mm256_div_ps(h, set1(maxValue)));
+		}
+#endif
+
+		// scalar tail, and everything when avx is not available
+		for (; x < gridSize; x++) {
+			float nx = (originX + x) * noiseScale / gridSize;
+
+			float h = 0.0f;
+			float octaveAmplitude = 1.0f;
+			float frequency = 1.0f;
+			for (int i = 0; i < octaves; i++) {
+				h += glm::perlin(glm::vec3(nx * frequency, nz * frequency, seed)) * octaveAmplitude;
+				octaveAmplitude *= 0.5f;
+				frequency *= 2.0f;
+			}
+
+			row[x] = h / maxValue;
+		}
+	}
+
+	std::string HeightmapGenerator::exportPng(const std::vector<float>& heights, int gridSize, const std::string& filename) {
+		std::vector<unsigned char> imageData(size_t(gridSize) * gridSize * 4);
+		for (size_t i = 0; i < heights.size() && i * 4 < imageData.size(); i++) {
+			unsigned char value = static_cast<unsigned char>(glm::clamp(heights[i] * 0.5f + 0.5f, 0.0f, 1.0f) * 255);
+			imageData[i * 4] = value;
+			imageData[i * 4 + 1] = value;
+			imageData[i * 4 + 2] = value;
+			imageData[i * 4 + 3] = 255;
+		}
+		return vk::AssetLoader::getInstance().saveTexture(filename, imageData.data(), gridSize, gridSize, 4);
+	}
+
+}  // namespace procedural
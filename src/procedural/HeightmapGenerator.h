@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace procedural {
+
+	// fractal perlin heightmaps for the terrain, rows are generated on worker threads and 8 samples at a time with avx
+	// the result feeds both the gpu height texture and the physics heightfield
+	class HeightmapGenerator {
+	   public:
+		static constexpr int DEFAULT_OCTAVES = 4;
+
+		// @returns gridSize x gridSize heights in [-1, 1], row major with z as the row
+		static std::vector<float> generate(int gridSize, float noiseScale, int seed, int octaves = DEFAULT_OCTAVES);
+
+		// same heights, read from the generation cache when this grid size, scale, seed and octave count were generated before
+		static std::vector<float> generateCached(int gridSize, float noiseScale, int seed, int octaves = DEFAULT_OCTAVES);
+
+		// one tile of an unbounded heightmap, tile (0, 0) matches generate and neighbouring tiles share their edge samples
+		// noiseScale is the noise frequency per tile like it is per grid for generate
+		static std::vector<float> generateTile(int gridSize, float noiseScale, int seed, int tileX, int tileZ, int octaves = DEFAULT_OCTAVES);
+
+		// debug only, writes the heights as grayscale png through the asset loader
+		// @returns the saved path or an empty string on failure
+		static std::string exportPng(const std::vector<float>& heights, int gridSize, const std::string& filename);
+
+	   private:
+		// originX / originZ offset the sample indices, the noise frequency stays noiseScale / gridSize per sample
+		static void generateRow(float* row, int originX, int z, int gridSize, float noiseScale, float seed, int octaves);
+	};
+
+}  // namespace procedural
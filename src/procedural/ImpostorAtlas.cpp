@@ -0,0 +1,188 @@
+#include "ImpostorAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace procedural {
+
+	ImpostorAtlas::ImpostorAtlas()
+		: albedo(size_t(ATLAS_SIZE) * ATLAS_SIZE * 4, 0), normals(size_t(ATLAS_SIZE) * ATLAS_SIZE * 4, 0) {
+	}
+
+	glm::vec2 ImpostorAtlas::hemiOctahedronEncode(const glm::vec3& direction) {
+		glm::vec3 d = direction;
+		// views from below the horizon use the horizon frames
+		d.y = std::max(d.y, 0.0f);
+		d /= std::max(std::abs(d.x) + std::abs(d.y) + std::abs(d.z), 1e-6f);
+		return glm::vec2(d.x + d.z, d.x - d.z) * 0.5f + 0.5f;
+	}
+
+	glm::vec3 ImpostorAtlas::hemiOctahedronDecode(const glm::vec2& uv) {
+		glm::vec2 e = uv * 2.0f - 1.0f;
+		glm::vec3 d((e.x + e.y) * 0.5f, 0.0f, (e.x - e.y) * 0.5f);
+		d.y = 1.0f - std::abs(d.x) - std::abs(d.z);
+		return glm::normalize(d);
+	}
+
+	uint32_t ImpostorAtlas::bake(const TreeGeometry& treeGeometry, const glm::vec3& barkColor, const glm::vec3& leafColor) {
+		if (slots.size() >= MAX_SLOTS) {
+			return INVALID_SLOT;
+		}
+
+		// both parts in one list, colors match what the textured materials look like from far away
+		std::vector<BakeVertex> vertices;
+		std::vector<uint32_t> indices;
+		vertices.reserve(treeGeometry.bark.vertices.size() + treeGeometry.leaves.vertices.size());
+		indices.reserve(treeGeometry.bark.indices.size() + treeGeometry.leaves.indices.size());
+
+		auto append = [&](const TreeGeometry::MaterialGeometry& part, const glm::vec3& color) {
+			uint32_t base = uint32_t(vertices.size());
+			for (const auto& vertex : part.vertices) {
+				vertices.push_back({ vertex.position, vertex.normal, color });
+			}
+			for (uint32_t index : part.indices) {
+				indices.push_back(base + index);
+			}
+		};
+		append(treeGeometry.bark, barkColor);
+		append(treeGeometry.leaves, leafColor);
+
+		if (vertices.empty() || indices.size() < 3) {
+			return INVALID_SLOT;
+		}
+
+		glm::vec3 mn{ std::numeric_limits<float>::max() };
+		glm::vec3 mx{ -std::numeric_limits<float>::max() };
+		for (const auto& vertex : vertices) {
+			mn = glm::min(mn, vertex.position);
+			mx = glm::max(mx, vertex.position);
+		}
+
+		uint32_t slotIndex = uint32_t(slots.size());
+		Slot slot;
+		slot.center = 0.5f * (mn + mx);
+		for (const auto& vertex : vertices) {
+			slot.radius = std::max(slot.radius, glm::length(vertex.position - slot.center));
+		}
+		slot.radius = std::max(slot.radius, 1e-4f);
+		slot.uvOffset = glm::vec2(float(slotIndex % SLOTS_PER_SIDE), float(slotIndex / SLOTS_PER_SIDE)) * (float(SLOT_SIZE) / float(ATLAS_SIZE));
+		slots.push_back(slot);
+
+		// frames write disjoint atlas regions, one row of frames per thread
+		uint32_t threadCount = std::max(1u, std::min(FRAMES_PER_SIDE, std::thread::hardware_concurrency()));
+		std::vector<std::thread> workers;
+		for (uint32_t t = 0; t < threadCount; t++) {
+			workers.emplace_back([&, t]() {
+				for (uint32_t frameY = t; frameY < FRAMES_PER_SIDE; frameY += threadCount) {
+					for (uint32_t frameX = 0; frameX < FRAMES_PER_SIDE; frameX++) {
+						bakeFrame(vertices, indices, slot, slotIndex, frameX, frameY);
+					}
+				}
+			});
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+
+		return slotIndex;
+	}
+
+	void ImpostorAtlas::bakeFrame(const std::vector<BakeVertex>& vertices, const std::vector<uint32_t>& indices, const Slot& slot, uint32_t slotIndex, uint32_t frameX, uint32_t frameY) {
+		// frame centers sit on the grid corners so the shader can blend between neighbours up to the border
+		glm::vec3 viewDir = hemiOctahedronDecode(glm::vec2(float(frameX), float(frameY)) / float(FRAMES_PER_SIDE - 1));
+
+		// same basis as the billboard in impostor_shader.vert
+		glm::vec3 right = glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), viewDir);
+		right = glm::length(right) < 1e-4f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::normalize(right);
+		glm::vec3 up = glm::cross(viewDir, right);
+
+		const float size = float(FRAME_SIZE);
+		std::vector<glm::vec3> projected(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++) {
+			glm::vec3 p = (vertices[i].position - slot.center) / slot.radius;
+			projected[i] = glm::vec3(
+				(glm::dot(p, right) * 0.5f + 0.5f) * size,
+				(0.5f - glm::dot(p, up) * 0.5f) * size,
+				// larger is closer to the viewer
+				glm::dot(p, viewDir));
+		}
+
+		std::vector<float> depth(FRAME_SIZE * FRAME_SIZE, -std::numeric_limits<float>::max());
+		std::vector<glm::vec3> frameColor(FRAME_SIZE * FRAME_SIZE, glm::vec3(0.0f));
+		std::vector<glm::vec3> frameNormal(FRAME_SIZE * FRAME_SIZE, glm::vec3(0.0f));
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			const glm::vec3& a = projected[indices[i]];
+			const glm::vec3& b = projected[indices[i + 1]];
+			const glm::vec3& c = projected[indices[i + 2]];
+
+			float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			if (std::abs(area) < 1e-8f) {
+				continue;
+			}
+
+			int minX = std::max(0, int(std::floor(std::min({ a.x, b.x, c.x }))));
+			int maxX = std::min(int(FRAME_SIZE) - 1, int(std::ceil(std::max({ a.x, b.x, c.x }))));
+			int minY = std::max(0, int(std::floor(std::min({ a.y, b.y, c.y }))));
+			int maxY = std::min(int(FRAME_SIZE) - 1, int(std::ceil(std::max({ a.y, b.y, c.y }))));
+
+			const BakeVertex& va = vertices[indices[i]];
+			const BakeVertex& vb = vertices[indices[i + 1]];
+			const BakeVertex& vc = vertices[indices[i + 2]];
+
+			// no culling, leaves are two sided and bark is closed anyway
+			for (int y = minY; y <= maxY; y++) {
+				for (int x = minX; x <= maxX; x++) {
+					float px = float(x) + 0.5f;
+					float py = float(y) + 0.5f;
+					float w0 = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) / area;
+					float w1 = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) / area;
+					float w2 = 1.0f - w0 - w1;
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+						continue;
+					}
+
+					float z = w0 * a.z + w1 * b.z + w2 * c.z;
+					size_t pixel = size_t(y) * FRAME_SIZE + x;
+					if (z <= depth[pixel]) {
+						continue;
+					}
+					depth[pixel] = z;
+
+					glm::vec3 n = w0 * va.normal + w1 * vb.normal + w2 * vc.normal;
+					if (glm::dot(n, viewDir) < 0.0f) {
+						n = -n;
+					}
+					frameNormal[pixel] = glm::length(n) > 0.0f ? glm::normalize(n) : viewDir;
+					frameColor[pixel] = w0 * va.color + w1 * vb.color + w2 * vc.color;
+				}
+			}
+		}
+
+		size_t originX = size_t(slotIndex % SLOTS_PER_SIDE) * SLOT_SIZE + size_t(frameX) * FRAME_SIZE;
+		size_t originY = size_t(slotIndex / SLOTS_PER_SIDE) * SLOT_SIZE + size_t(frameY) * FRAME_SIZE;
+
+		for (uint32_t y = 0; y < FRAME_SIZE; y++) {
+			for (uint32_t x = 0; x < FRAME_SIZE; x++) {
+				size_t pixel = size_t(y) * FRAME_SIZE + x;
+				size_t texel = ((originY + y) * ATLAS_SIZE + originX + x) * 4;
+				bool covered = depth[pixel] > -std::numeric_limits<float>::max();
+
+				glm::vec3 color = glm::clamp(frameColor[pixel], 0.0f, 1.0f);
+				albedo[texel + 0] = static_cast<unsigned char>(color.r * 255.0f);
+				albedo[texel + 1] = static_cast<unsigned char>(color.g * 255.0f);
+				albedo[texel + 2] = static_cast<unsigned char>(color.b * 255.0f);
+				albedo[texel + 3] = covered ? 255 : 0;
+
+				glm::vec3 n = frameNormal[pixel] * 0.5f + 0.5f;
+				normals[texel + 0] = static_cast<unsigned char>(n.x * 255.0f);
+				normals[texel + 1] = static_cast<unsigned char>(n.y * 255.0f);
+				normals[texel + 2] = static_cast<unsigned char>(n.z * 255.0f);
+				normals[texel + 3] = 255;
+			}
+		}
+	}
+
+}  // namespace procedural
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "TreeMaterial.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace procedural {
+
+	// cpu side octahedral impostor atlas, every tree gets a slot with FRAMES_PER_SIDE x FRAMES_PER_SIDE views
+	// frames are laid out on a hemi-octahedron (views from the horizon up to straight above the tree),
+	// impostor_shader.vert picks and blends the frames closest to the current view direction
+	class ImpostorAtlas {
+	   public:
+		static constexpr uint32_t FRAMES_PER_SIDE = 8;
+		static constexpr uint32_t FRAME_SIZE = 32;
+		static constexpr uint32_t SLOT_SIZE = FRAMES_PER_SIDE * FRAME_SIZE;
+		static constexpr uint32_t ATLAS_SIZE = 2048;
+		static constexpr uint32_t SLOTS_PER_SIDE = ATLAS_SIZE / SLOT_SIZE;
+		static constexpr uint32_t MAX_SLOTS = SLOTS_PER_SIDE * SLOTS_PER_SIDE;
+		static constexpr uint32_t INVALID_SLOT = ~0u;
+
+		struct Slot {
+			// bounding sphere of the tree in object space, the impostor quad covers it from every direction
+			glm::vec3 center{ 0.0f };
+			float radius = 0.0f;
+			// top left corner of the slot in atlas uv
+			glm::vec2 uvOffset{ 0.0f };
+		};
+
+		ImpostorAtlas();
+
+		// rasterizes all views of the tree into the next free slot
+		// @returns the slot index or INVALID_SLOT if the atlas is full (the tree is then always drawn as mesh)
+		uint32_t bake(const TreeGeometry& treeGeometry, const glm::vec3& barkColor, const glm::vec3& leafColor);
+
+		const Slot& getSlot(uint32_t slot) const { return slots[slot]; }
+		uint32_t getSlotCount() const { return uint32_t(slots.size()); }
+
+		// rgba8 srgb, alpha is coverage
+		const std::vector<unsigned char>& getAlbedo() const { return albedo; }
+		// rgba8 unorm, world space normal in rgb, alpha is unused
+		const std::vector<unsigned char>& getNormals() const { return normals; }
+
+		// shared with impostor_shader.vert
+		static glm::vec2 hemiOctahedronEncode(const glm::vec3& direction);
+		static glm::vec3 hemiOctahedronDecode(const glm::vec2& uv);
+
+	   private:
+		struct BakeVertex {
+			glm::vec3 position;
+			glm::vec3 normal;
+			glm::vec3 color;
+		};
+
+		void bakeFrame(const std::vector<BakeVertex>& vertices, const std::vector<uint32_t>& indices, const Slot& slot, uint32_t slotIndex, uint32_t frameX, uint32_t frameY);
+
+		std::vector<unsigned char> albedo;
+		std::vector<unsigned char> normals;
+		std::vector<Slot> slots;
+	};
+
+}  // namespace procedural
@@ -4,6 +4,9 @@
 #include <cmath>
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <stdexcept>
 
 namespace procedural {
 
@@ -18,7 +21,11 @@ namespace procedural {
 	}
 
 	void LSystem::addRule(char symbol, const std::string& replacement, float probability) {
-		rules[symbol].emplace_back(symbol, replacement, probability);
+		auto& symbolRules = ruleTable[static_cast<unsigned char>(symbol)];
+		float cumulative = symbolRules.empty() ? 0.0f : symbolRules.back().cumulativeProbability;
+
+		symbolRules.push_back({ static_cast<uint32_t>(ruleText.size()), static_cast<uint32_t>(replacement.size()), cumulative + probability });
+		ruleText += replacement;
 	}
 
 	void LSystem::setAxiom(const std::string& axiom) {
@@ -26,46 +33,68 @@ namespace procedural {
 	}
 
 	std::string LSystem::generate(int iterations) const {
+		return generate(iterations, rng);
+	}
+
+	std::string LSystem::generate(int iterations, std::mt19937& random) const {
 		std::string current = axiom;
+		std::string next;
+		// rule picked for every symbol of the current string, stochastic choices are made once in the sizing pass
+		std::vector<uint32_t> choices;
 
 		for (int i = 0; i < iterations; ++i) {
-			std::string next = "";
-			for (char c : current) {
-				next += applyRules(c);
+			choices.resize(current.size());
+
+			// pass 1: choose rules and compute the exact output size
+			size_t outputSize = 0;
+			for (size_t c = 0; c < current.size(); ++c) {
+				unsigned char symbol = static_cast<unsigned char>(current[c]);
+				const auto& symbolRules = ruleTable[symbol];
+				if (symbolRules.empty()) {
+					outputSize += 1;
+					continue;
+				}
+				choices[c] = chooseRule(symbol, random);
+				outputSize += symbolRules[choices[c]].length;
 			}
-			current = next;
-		}
 
-		return current;
-	}
+			// pass 2: copy replacements into the second buffer, its capacity is kept between iterations
+			next.resize(outputSize);
+			char* out = next.data();
+			for (size_t c = 0; c < current.size(); ++c) {
+				unsigned char symbol = static_cast<unsigned char>(current[c]);
+				const auto& symbolRules = ruleTable[symbol];
+				if (symbolRules.empty()) {
+					*out++ = current[c];
+					continue;
+				}
+				const CompiledRule& rule = symbolRules[choices[c]];
+				std::memcpy(out, ruleText.data() + rule.offset, rule.length);
+				out += rule.length;
+			}
 
-	std::string LSystem::applyRules(char symbol) const {
-		auto it = rules.find(symbol);
-		if (it == rules.end()) {
-			return std::string(1, symbol);
+			std::swap(current, next);
 		}
 
-		const auto& symbolRules = it->second;
-		if (symbolRules.empty()) {
-			return std::string(1, symbol);
-		}
+		return current;
+	}
 
+	uint32_t LSystem::chooseRule(unsigned char symbol, std::mt19937& random) const {
+		const auto& symbolRules = ruleTable[symbol];
 		if (symbolRules.size() == 1) {
-			return symbolRules[0].replacement;
+			return 0;
 		}
 
 		std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-		float random = dist(rng);
-		float cumulative = 0.0f;
+		float r = dist(random);
 
-		for (const auto& rule : symbolRules) {
-			cumulative += rule.probability;
-			if (random <= cumulative) {
-				return rule.replacement;
-			}
+		// first rule whose cumulative probability reaches r, the last rule takes any rounding leftovers
+		auto it = std::lower_bound(symbolRules.begin(), symbolRules.end(), r,
+			[](const CompiledRule& rule, float value) { return rule.cumulativeProbability < value; });
+		if (it == symbolRules.end()) {
+			return static_cast<uint32_t>(symbolRules.size() - 1);
 		}
-
-		return symbolRules.back().replacement;
+		return static_cast<uint32_t>(it - symbolRules.begin());
 	}
 
 	LSystemGeometry LSystem::interpretToGeometry(const std::string& lSystemString,
@@ -283,301 +312,310 @@ namespace procedural {
 		}
 	}
 
-	TreeGeometry LSystem::interpretToTreeGeometry(const std::string& lSystemString,
-		const TurtleParameters& params,
-		const glm::vec3& startPosition,
-		unsigned int seed) const {
-		TreeGeometry treeGeometry;
-		std::stack<TurtleState> stateStack;
-
-		TurtleState state;
-		state.position = startPosition;
-		state.heading = glm::vec3(0.0f, 1.0f, 0.0f);
-		state.left = glm::vec3(-1.0f, 0.0f, 0.0f);
-		state.up = glm::vec3(0.0f, 0.0f, 1.0f);
-		state.radius = params.initialRadius;
-		state.stepLength = params.stepLength;
-		state.depth = 0;
-
-		rng.seed(seed);
-
-		for (char symbol : lSystemString) {
-			processSymbolForTree(symbol, state, treeGeometry, stateStack, params);
+	namespace {
+
+		constexpr int CYLINDER_SEGMENTS = 8;
+		constexpr int LEAVES_PER_CLUSTER = 5;
+		// branches are nested once per iteration at most, real trees stay far below this
+		constexpr size_t MAX_TURTLE_DEPTH = 64;
+
+		constexpr float MIN_SEGMENT_LENGTH = 0.01f;
+		constexpr float MIN_SEGMENT_RADIUS = 0.01f;
+		// 'F' segments thinner than this end in a leaf cluster
+		constexpr float LEAF_BRANCH_RADIUS = 0.03f;
+		constexpr float LEAF_TILT = 0.3f;
+
+		const glm::vec3 BARK_COLOR(0.4f, 0.2f, 0.1f);
+		const glm::vec3 LEAF_COLOR(0.2f, 0.8f, 0.3f);
+
+		// cos/sin around a cylinder, the last entry repeats the first for the uv seam
+		const std::array<glm::vec2, CYLINDER_SEGMENTS + 1>& cylinderRing() {
+			static const std::array<glm::vec2, CYLINDER_SEGMENTS + 1> ring = [] {
+				std::array<glm::vec2, CYLINDER_SEGMENTS + 1> r;
+				for (int i = 0; i <= CYLINDER_SEGMENTS; i++) {
+					float angle = 2.0f * glm::pi<float>() * float(i) / float(CYLINDER_SEGMENTS);
+					r[i] = glm::vec2(std::cos(angle), std::sin(angle));
+				}
+				return r;
+			}();
+			return ring;
 		}
 
-		return treeGeometry;
-	}
-
-	void LSystem::processSymbolForTree(char symbol, TurtleState& state,
-		TreeGeometry& treeGeometry,
-		std::stack<TurtleState>& stateStack,
-		const TurtleParameters& params) const {
-		switch (symbol) {
-			case 'T': {	 // Trunk segment: Use bark material
-				glm::vec3 newPosition = state.position + state.heading * state.stepLength;
-				float endRadius = state.radius * params.radiusDecay;
+		// cos/sin of the leaves fanned around a branch tip
+		const std::array<glm::vec2, LEAVES_PER_CLUSTER>& leafRing() {
+			static const std::array<glm::vec2, LEAVES_PER_CLUSTER> ring = [] {
+				std::array<glm::vec2, LEAVES_PER_CLUSTER> r;
+				for (int i = 0; i < LEAVES_PER_CLUSTER; i++) {
+					float angle = 2.0f * glm::pi<float>() * float(i) / float(LEAVES_PER_CLUSTER);
+					r[i] = glm::vec2(std::cos(angle), std::sin(angle));
+				}
+				return r;
+			}();
+			return ring;
+		}
 
-				generateCylinderForMaterial(state.position, newPosition,
-					state.radius, endRadius,
-					treeGeometry.bark, MaterialType::BARK);
+		// rotation of v around the unit axis k, same result as glm::rotate without building a matrix
+		inline glm::vec3 rotateAround(const glm::vec3& v, const glm::vec3& k, float c, float s) {
+			return v * c + glm::cross(k, v) * s + k * (glm::dot(k, v) * (1.0f - c));
+		}
 
-				state.radius = endRadius;
-				state.position = newPosition;
-				state.stepLength *= params.lengthDecay;
-				break;
+		// any unit vector perpendicular to the unit vector direction
+		inline glm::vec3 perpendicular(const glm::vec3& direction) {
+			glm::vec3 right = glm::cross(direction, glm::vec3(0.0f, 1.0f, 0.0f));
+			if (glm::dot(right, right) < 1e-12f) {
+				right = glm::cross(direction, glm::vec3(1.0f, 0.0f, 0.0f));
 			}
-			case 'F': {	 // Branch segment: Always use bark material for branches
-				glm::vec3 newPosition = state.position + state.heading * state.stepLength;
-				float endRadius = state.radius * params.radiusDecay;
+			return glm::normalize(right);
+		}
 
-				// All branches use bark material, regardless of thickness
-				generateCylinderForMaterial(state.position, newPosition,
-					state.radius, endRadius,
-					treeGeometry.bark, MaterialType::BARK);
-
-				// Add actual leaf geometry at the end of very thin branches
-				if (endRadius < 0.03f) {
-					// std::cout << "Thin branch detected (radius " << endRadius << ") - adding leaf geometry" << std::endl;
-					float leafSize = endRadius * 4.0f;
-					generateLeafGeometry(newPosition, state.heading, leafSize,
-						treeGeometry.leaves, 5);  // Increased leaf count
+		// exact number of cylinders and leaf clusters the turtle will emit, only radius and step length matter for that
+		struct TreeGeometryCounts {
+			size_t cylinders = 0;
+			size_t leafClusters = 0;
+			size_t maxDepth = 0;
+		};
+
+		TreeGeometryCounts countTreeGeometry(const std::string& lSystemString, const TurtleParameters& params) {
+			struct Segment {
+				float radius;
+				float stepLength;
+			};
+			std::vector<Segment> stack;
+			Segment segment{ params.initialRadius, params.stepLength };
+			TreeGeometryCounts counts;
+
+			for (char symbol : lSystemString) {
+				switch (symbol) {
+					case 'T':
+					case 'F':
+					case 'G': {
+						float endRadius = segment.radius * params.radiusDecay;
+						counts.cylinders += segment.stepLength >= MIN_SEGMENT_LENGTH;
+						counts.leafClusters += symbol == 'F' && endRadius < LEAF_BRANCH_RADIUS;
+						segment.radius = endRadius;
+						segment.stepLength *= params.lengthDecay;
+						break;
+					}
+					case 'f':
+						segment.stepLength *= params.lengthDecay;
+						break;
+					case 'L':
+						counts.leafClusters++;
+						break;
+					case '[':
+						stack.push_back(segment);
+						counts.maxDepth = std::max(counts.maxDepth, stack.size());
+						break;
+					case ']':
+						if (!stack.empty()) {
+							segment = stack.back();
+							stack.pop_back();
+						}
+						break;
+					default:
+						break;
 				}
-
-				state.radius = endRadius;
-				state.position = newPosition;
-				state.stepLength *= params.lengthDecay;
-				break;
 			}
-			case 'G': {	 // Generic segment: Use bark material
-				glm::vec3 newPosition = state.position + state.heading * state.stepLength;
-				float endRadius = state.radius * params.radiusDecay;
-
-				generateCylinderForMaterial(state.position, newPosition,
-					state.radius, endRadius,
-					treeGeometry.bark, MaterialType::BARK);
+			return counts;
+		}
 
-				state.radius = endRadius;
-				state.position = newPosition;
-				state.stepLength *= params.lengthDecay;
-				break;
+		// appends into storage that was sized from the counts, so the turtle never reallocates
+		struct GeometryWriter {
+			MaterialGeometry& geometry;
+			TreeGeometry::Vertex* vertices;
+			uint32_t* indices;
+			uint32_t vertexCount = 0;
+
+			GeometryWriter(MaterialGeometry& geometry, size_t vertexCapacity, size_t indexCapacity)
+				: geometry(geometry) {
+				geometry.vertices.resize(vertexCapacity);
+				geometry.indices.resize(indexCapacity);
+				vertices = geometry.vertices.data();
+				indices = geometry.indices.data();
 			}
-			case 'f': {	 // Move forward without drawing
-				glm::vec3 newPosition = state.position + state.heading * state.stepLength;
-				state.position = newPosition;
-				state.stepLength *= params.lengthDecay;
-				break;
-			}
-
-			case '+':  // Turn left (yaw)
-				state.heading = glm::normalize(
-					state.heading * std::cos(glm::radians(params.angleIncrement)) +
-					state.left * std::sin(glm::radians(params.angleIncrement)));
-				state.left = glm::normalize(glm::cross(state.up, state.heading));
-				break;
-
-			case '-':  // Turn right (yaw)
-				state.heading = glm::normalize(
-					state.heading * std::cos(glm::radians(-params.angleIncrement)) +
-					state.left * std::sin(glm::radians(-params.angleIncrement)));
-				state.left = glm::normalize(glm::cross(state.up, state.heading));
-				break;
-
-			case '&':  // Pitch down
-				state.heading = glm::normalize(
-					state.heading * std::cos(glm::radians(params.angleIncrement)) +
-					state.up * std::sin(glm::radians(params.angleIncrement)));
-				state.up = glm::normalize(glm::cross(state.heading, state.left));
-				break;
-
-			case '^':  // Pitch up
-				state.heading = glm::normalize(
-					state.heading * std::cos(glm::radians(-params.angleIncrement)) +
-					state.up * std::sin(glm::radians(-params.angleIncrement)));
-				state.up = glm::normalize(glm::cross(state.heading, state.left));
-				break;
-
-			case '\\':	// Roll left
-				state.left = glm::normalize(
-					state.left * std::cos(glm::radians(params.angleIncrement)) +
-					state.up * std::sin(glm::radians(params.angleIncrement)));
-				state.up = glm::normalize(glm::cross(state.heading, state.left));
-				break;
 
-			case '/':  // Roll right
-				state.left = glm::normalize(
-					state.left * std::cos(glm::radians(-params.angleIncrement)) +
-					state.up * std::sin(glm::radians(-params.angleIncrement)));
-				state.up = glm::normalize(glm::cross(state.heading, state.left));
-				break;
-
-			case '[':  // Push state
-				stateStack.push(state);
-				state.depth++;
-				break;
-
-			case ']':  // Pop state
-				if (!stateStack.empty()) {
-					state = stateStack.top();
-					stateStack.pop();
-				}
-				break;
-
-			case 'L':  // Leaf/branch end - use leaf geometry instead of cylinder
-			{
-				// std::cout << "Processing 'L' symbol - generating leaf geometry" << std::endl;
-				// Generate actual leaf quads at the branch end
-				float leafSize = state.radius * 3.0f;  // Scale leaf size with branch radius
-				generateLeafGeometry(state.position, state.heading, leafSize,
-					treeGeometry.leaves, 5);  // Increased leaf count
-			} break;
-
-			case '|':  // Turn around
-				state.heading = -state.heading;
-				state.left = -state.left;
-				break;
+			void vertex(const glm::vec3& position, const glm::vec3& color, const glm::vec3& normal, const glm::vec2& uv) {
+				*vertices++ = { position, color, normal, uv };
+				geometry.boundsMin = glm::min(geometry.boundsMin, position);
+				geometry.boundsMax = glm::max(geometry.boundsMax, position);
+				vertexCount++;
+			}
 
-			default:
-				break;
-		}
-	}
+			void quad(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+				indices[0] = a;
+				indices[1] = b;
+				indices[2] = c;
+				indices[3] = a;
+				indices[4] = c;
+				indices[5] = d;
+				indices += 6;
+			}
 
-	void LSystem::generateCylinderForMaterial(const glm::vec3& start, const glm::vec3& end,
-		float radiusStart, float radiusEnd,
-		MaterialGeometry& geometry, MaterialType materialType,
-		int segments) const {
-		float minRadius = 0.01f;
-		float actualRadiusStart = std::max(radiusStart, minRadius);
-		float actualRadiusEnd = std::max(radiusEnd, minRadius);
+			bool full() const {
+				return vertices == geometry.vertices.data() + geometry.vertices.size() &&
+					   indices == geometry.indices.data() + geometry.indices.size();
+			}
+		};
+
+		void writeCylinder(GeometryWriter& out, const glm::vec3& start, const glm::vec3& end,
+			const glm::vec3& direction, float radiusStart, float radiusEnd) {
+			radiusStart = std::max(radiusStart, MIN_SEGMENT_RADIUS);
+			radiusEnd = std::max(radiusEnd, MIN_SEGMENT_RADIUS);
+
+			glm::vec3 right = perpendicular(direction);
+			glm::vec3 up = glm::cross(right, direction);
+
+			const auto& ring = cylinderRing();
+			uint32_t base = out.vertexCount;
+			for (int i = 0; i <= CYLINDER_SEGMENTS; i++) {
+				glm::vec3 normal = right * ring[i].x + up * ring[i].y;
+				float u = float(i) / float(CYLINDER_SEGMENTS);
+				out.vertex(start + normal * radiusStart, BARK_COLOR, normal, glm::vec2(u, 0.0f));
+				out.vertex(end + normal * radiusEnd, BARK_COLOR, normal, glm::vec2(u, 1.0f));
+			}
 
-		if (glm::distance(start, end) < 0.01f) {
-			return;	 // Too short to be visible
+			for (uint32_t i = 0; i < CYLINDER_SEGMENTS; i++) {
+				uint32_t bottomLeft = base + i * 2;
+				uint32_t bottomRight = bottomLeft + 2;
+				// two triangles per quad, same winding as bottomLeft, topLeft, bottomRight / bottomRight, topLeft, topRight
+				out.quad(bottomRight, bottomLeft, bottomLeft + 1, bottomRight + 1);
+			}
 		}
 
-		glm::vec3 direction = glm::normalize(end - start);
-		glm::vec3 cylinder_axis_right;
-		glm::vec3 cylinder_axis_up;
-
-		glm::vec3 temp_calc_right = glm::cross(direction, glm::vec3(0.0f, 1.0f, 0.0f));	 // Try Y-axis as helper
-		if (glm::dot(temp_calc_right, temp_calc_right) < 1e-12f) {						 // If direction is parallel to Y-axis
-			temp_calc_right = glm::cross(direction, glm::vec3(1.0f, 0.0f, 0.0f));
+		// leaf quads fanned around the unit direction and tilted away from it
+		void writeLeafCluster(GeometryWriter& out, const glm::vec3& position, const glm::vec3& direction, float size) {
+			glm::vec3 baseRight = perpendicular(direction);
+			glm::vec3 baseForward = glm::cross(baseRight, direction);
+
+			static const float tiltCos = std::cos(LEAF_TILT);
+			static const float tiltSin = std::sin(LEAF_TILT);
+
+			for (const glm::vec2& rotation : leafRing()) {
+				glm::vec3 leafRight = rotateAround(baseRight, direction, rotation.x, rotation.y);
+				glm::vec3 leafForward = rotateAround(baseForward, direction, rotation.x, rotation.y);
+				leafForward = rotateAround(leafForward, leafRight, tiltCos, tiltSin);
+				glm::vec3 leafUp = rotateAround(direction, leafRight, tiltCos, tiltSin);
+
+				glm::vec3 normal = glm::normalize(leafForward);
+				glm::vec3 halfRight = leafRight * size * 0.5f;
+				// leaves are slightly elongated
+				glm::vec3 halfUp = leafUp * size * 0.8f;
+
+				uint32_t base = out.vertexCount;
+				out.vertex(position - halfRight, LEAF_COLOR, normal, glm::vec2(0.0f, 0.0f));
+				out.vertex(position + halfRight, LEAF_COLOR, normal, glm::vec2(1.0f, 0.0f));
+				out.vertex(position + halfRight + halfUp, LEAF_COLOR, normal, glm::vec2(1.0f, 1.0f));
+				out.vertex(position - halfRight + halfUp, LEAF_COLOR, normal, glm::vec2(0.0f, 1.0f));
+				out.quad(base, base + 1, base + 2, base + 3);
+			}
 		}
-		cylinder_axis_right = glm::normalize(temp_calc_right);
-		cylinder_axis_up = glm::normalize(glm::cross(cylinder_axis_right, direction));
+	}
 
-		uint32_t startVertexIndex = geometry.vertices.size();
+	TreeGeometry LSystem::interpretToTreeGeometry(const std::string& lSystemString,
+		const TurtleParameters& params,
+		const glm::vec3& startPosition,
+		unsigned int seed) const {
+		rng.seed(seed);
 
-		// Set color based on material type
-		glm::vec3 color;
-		switch (materialType) {
-			case MaterialType::BARK:
-				color = glm::vec3(0.4f, 0.2f, 0.1f);  // Brown bark color
-				break;
-			case MaterialType::LEAF:
-				color = glm::vec3(0.2f, 0.6f, 0.2f);  // Green leaf color
-				break;
+		// first pass sizes the buffers exactly, the second writes every vertex once in its final format
+		TreeGeometryCounts counts = countTreeGeometry(lSystemString, params);
+		if (counts.maxDepth > MAX_TURTLE_DEPTH) {
+			throw std::runtime_error("L-system string nests branches deeper than the turtle stack");
 		}
 
-		// Generate vertices
-		for (int i = 0; i <= segments; ++i) {
-			float angle = 2.0f * glm::pi<float>() * static_cast<float>(i) / static_cast<float>(segments);
-			float cosAngle = std::cos(angle);
-			float sinAngle = std::sin(angle);
-
-			// Start circle
-			glm::vec3 offsetStart = (cylinder_axis_right * cosAngle + cylinder_axis_up * sinAngle) * actualRadiusStart;
-
-			geometry.vertices.push_back({start + offsetStart,
-				color,
-				glm::normalize(offsetStart),
-				glm::vec2(static_cast<float>(i) / segments, 0.0f)});
+		TreeGeometry treeGeometry;
+		GeometryWriter bark(treeGeometry.bark,
+			counts.cylinders * (CYLINDER_SEGMENTS + 1) * 2,
+			counts.cylinders * CYLINDER_SEGMENTS * 6);
+		GeometryWriter leaves(treeGeometry.leaves,
+			counts.leafClusters * LEAVES_PER_CLUSTER * 4,
+			counts.leafClusters * LEAVES_PER_CLUSTER * 6);
 
-			// End circle
-			glm::vec3 offsetEnd = (cylinder_axis_right * cosAngle + cylinder_axis_up * sinAngle) * actualRadiusEnd;
-			geometry.vertices.push_back({end + offsetEnd,
-				color,
-				glm::normalize(offsetEnd),
-				glm::vec2(static_cast<float>(i) / segments, 1.0f)});
-		}
+		std::array<TurtleState, MAX_TURTLE_DEPTH> stateStack;
+		size_t stackSize = 0;
 
-		// Generate indices
-		for (int i = 0; i < segments; ++i) {
-			uint32_t bottomLeft = startVertexIndex + i * 2;
-			uint32_t bottomRight = startVertexIndex + (i + 1) * 2;
-			uint32_t topLeft = bottomLeft + 1;
-			uint32_t topRight = bottomRight + 1;
+		TurtleState state;
+		state.position = startPosition;
+		state.heading = glm::vec3(0.0f, 1.0f, 0.0f);
+		state.left = glm::vec3(-1.0f, 0.0f, 0.0f);
+		state.up = glm::vec3(0.0f, 0.0f, 1.0f);
+		state.radius = params.initialRadius;
+		state.stepLength = params.stepLength;
+		state.depth = 0;
 
-			// Two triangles per quad
-			geometry.indices.insert(geometry.indices.end(), {bottomLeft, topLeft, bottomRight,
-																bottomRight, topLeft, topRight});
-		}
-	}
+		const float turnCos = std::cos(glm::radians(params.angleIncrement));
+		const float turnSin = std::sin(glm::radians(params.angleIncrement));
 
-	void LSystem::generateLeafGeometry(const glm::vec3& position, const glm::vec3& direction,
-		float size, MaterialGeometry& geometry,
-		int leafCount) const {
-		// Generate multiple leaf quads around the branch end
-		for (int leafIndex = 0; leafIndex < leafCount; ++leafIndex) {
-			// Create rotation around the branch axis for each leaf
-			float rotationAngle = (2.0f * glm::pi<float>() * leafIndex) / leafCount;
-			float tiltAngle = 0.3f;	 // Slight random tilt
-
-			// Create a coordinate system for the leaf
-			glm::vec3 leafUp = direction;
-			glm::vec3 leafRight = glm::normalize(glm::cross(direction, glm::vec3(0.0f, 1.0f, 0.0f)));
-			if (glm::length(leafRight) < 0.1f) {
-				// Handle case where direction is parallel to Y axis
-				leafRight = glm::normalize(glm::cross(direction, glm::vec3(1.0f, 0.0f, 0.0f)));
+		for (char symbol : lSystemString) {
+			switch (symbol) {
+				case 'T':  // trunk segment
+				case 'F':  // branch segment, thin ones end in leaves
+				case 'G': {	 // generic segment
+					glm::vec3 newPosition = state.position + state.heading * state.stepLength;
+					float endRadius = state.radius * params.radiusDecay;
+
+					if (state.stepLength >= MIN_SEGMENT_LENGTH) {
+						writeCylinder(bark, state.position, newPosition, state.heading, state.radius, endRadius);
+					}
+					if (symbol == 'F' && endRadius < LEAF_BRANCH_RADIUS) {
+						writeLeafCluster(leaves, newPosition, state.heading, endRadius * 4.0f);
+					}
+
+					state.radius = endRadius;
+					state.position = newPosition;
+					state.stepLength *= params.lengthDecay;
+					break;
+				}
+				case 'f':  // move forward without drawing
+					state.position += state.heading * state.stepLength;
+					state.stepLength *= params.lengthDecay;
+					break;
+
+				case '+':  // turn left (yaw)
+				case '-':  // turn right (yaw)
+					state.heading = glm::normalize(state.heading * turnCos + state.left * (symbol == '+' ? turnSin : -turnSin));
+					state.left = glm::normalize(glm::cross(state.up, state.heading));
+					break;
+
+				case '&':  // pitch down
+				case '^':  // pitch up
+					state.heading = glm::normalize(state.heading * turnCos + state.up * (symbol == '&' ? turnSin : -turnSin));
+					state.up = glm::normalize(glm::cross(state.heading, state.left));
+					break;
+
+				case '\\':	// roll left
+				case '/':	// roll right
+					state.left = glm::normalize(state.left * turnCos + state.up * (symbol == '\\' ? turnSin : -turnSin));
+					state.up = glm::normalize(glm::cross(state.heading, state.left));
+					break;
+
+				case '[':
+					stateStack[stackSize++] = state;
+					state.depth++;
+					break;
+
+				case ']':
+					if (stackSize > 0) {
+						state = stateStack[--stackSize];
+					}
+					break;
+
+				case 'L':  // leaf cluster at the current branch end
+					writeLeafCluster(leaves, state.position, state.heading, state.radius * 3.0f);
+					break;
+
+				case '|':  // turn around
+					state.heading = -state.heading;
+					state.left = -state.left;
+					break;
+
+				default:
+					break;
 			}
-			glm::vec3 leafForward = glm::normalize(glm::cross(leafRight, leafUp));
-
-			// Apply rotation around the branch axis
-			glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), rotationAngle, direction);
-			leafRight = glm::vec3(rotation * glm::vec4(leafRight, 0.0f));
-			leafForward = glm::vec3(rotation * glm::vec4(leafForward, 0.0f));
-
-			// Apply slight tilt for more natural look
-			glm::mat4 tilt = glm::rotate(glm::mat4(1.0f), tiltAngle, leafRight);
-			leafForward = glm::vec3(tilt * glm::vec4(leafForward, 0.0f));
-			leafUp = glm::vec3(tilt * glm::vec4(leafUp, 0.0f));
-
-			// Create leaf quad vertices
-			glm::vec3 leafColor = glm::vec3(0.2f, 0.8f, 0.3f);
-			glm::vec3 leafNormal = glm::normalize(leafForward);
-
-			uint32_t startIndex = geometry.vertices.size();
-
-			// Leaf quad corners (positioned at branch end)
-			glm::vec3 halfRight = leafRight * size * 0.5f;
-			glm::vec3 halfUp = leafUp * size * 0.8f;  // Make leaves slightly elongated
-
-			// Bottom-left
-			geometry.vertices.push_back({position - halfRight,
-				leafColor,
-				leafNormal,
-				glm::vec2(0.0f, 0.0f)});
-
-			// Bottom-right
-			geometry.vertices.push_back({position + halfRight,
-				leafColor,
-				leafNormal,
-				glm::vec2(1.0f, 0.0f)});
-
-			// Top-right
-			geometry.vertices.push_back({position + halfRight + halfUp,
-				leafColor,
-				leafNormal,
-				glm::vec2(1.0f, 1.0f)});
-
-			// Top-left
-			geometry.vertices.push_back({position - halfRight + halfUp,
-				leafColor,
-				leafNormal,
-				glm::vec2(0.0f, 1.0f)});
-
-			// Create two triangles for the quad
-			geometry.indices.insert(geometry.indices.end(), {startIndex, startIndex + 1, startIndex + 2,
-																startIndex, startIndex + 2, startIndex + 3});
 		}
+
+		assert(bark.full() && leaves.full() && "turtle counts and written geometry diverged");
+		return treeGeometry;
 	}
 
 	LSystem LSystem::createTree(unsigned int seed) {
@@ -605,6 +643,12 @@ namespace procedural {
 		// Branch with roll right and pitch up, and leaves
 		tree.addRule('F', "FL", 0.1f);	// Simple branch with a leaf
 
+		tree.setTurtleParameters(treeTurtleParameters());
+
+		return tree;
+	}
+
+	TurtleParameters LSystem::treeTurtleParameters() {
 		TurtleParameters params;
 		params.stepLength = 1.0f;
 		params.angleIncrement = 25.0f;
@@ -613,9 +657,7 @@ namespace procedural {
 		params.initialRadius = 0.3f;
 		params.initialColor = glm::vec3(0.15f, 0.8f, 0.2f);	 // Set to leafColor
 		params.leafColor = glm::vec3(0.15f, 0.8f, 0.2f);
-		tree.setTurtleParameters(params);
-
-		return tree;
+		return params;
 	}
 
 }  // namespace procedural
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <array>
+#include <cstdint>
 #include <unordered_map>
 #include <vector>
 #include <memory>
@@ -78,6 +80,9 @@ namespace procedural {
 		// Generate string after n iterations
 		std::string generate(int iterations) const;
 
+		// same expansion with a caller owned rng, safe to call from several threads on one LSystem
+		std::string generate(int iterations, std::mt19937& random) const;
+
 		LSystemGeometry interpretToGeometry(const std::string& lSystemString,
 			const TurtleParameters& params,
 			const glm::vec3& startPosition = glm::vec3(0.0f),
@@ -91,6 +96,9 @@ namespace procedural {
 
 		static LSystem createTree(unsigned int seed = 0);
 
+		// turtle parameters every createTree system starts with
+		static TurtleParameters treeTurtleParameters();
+
 		void setTurtleParameters(const TurtleParameters& params) {
 			turtleParams = params;
 		}
@@ -99,37 +107,33 @@ namespace procedural {
 		}
 
 	   private:
+		// one production of a symbol, the replacement lives in ruleText
+		struct CompiledRule {
+			uint32_t offset;
+			uint32_t length;
+			// running sum of the probabilities of this symbol's rules up to and including this one
+			float cumulativeProbability;
+		};
+
 		std::string axiom;
-		std::unordered_map<char, std::vector<LSystemRule>> rules;
+		// indexed by the symbol byte, symbols without rules are copied unchanged
+		std::array<std::vector<CompiledRule>, 256> ruleTable;
+		std::string ruleText;
 		TurtleParameters turtleParams;
 		mutable std::mt19937 rng;
 
-		std::string applyRules(char symbol) const;
+		// index of the rule that rewrites symbol, draws from random only for stochastic symbols
+		uint32_t chooseRule(unsigned char symbol, std::mt19937& random) const;
 
 		void processSymbol(char symbol, TurtleState& state,
 			LSystemGeometry& geometry,
 			std::stack<TurtleState>& stateStack,
 			const TurtleParameters& params) const;
 
-		void processSymbolForTree(char symbol, TurtleState& state,
-			TreeGeometry& treeGeometry,
-			std::stack<TurtleState>& stateStack,
-			const TurtleParameters& params) const;
-
 		void generateCylinder(const glm::vec3& start, const glm::vec3& end,
 			float radiusStart, float radiusEnd,
 			const glm::vec3& color, LSystemGeometry& geometry,
 			int segments = 8) const;
-
-		void generateCylinderForMaterial(const glm::vec3& start, const glm::vec3& end,
-			float radiusStart, float radiusEnd,
-			MaterialGeometry& geometry, MaterialType materialType,
-			int segments = 8) const;
-
-		// Generate leaf geometry - creates leaf quads at branch ends
-		void generateLeafGeometry(const glm::vec3& position, const glm::vec3& direction,
-			float size, MaterialGeometry& geometry,
-			int leafCount = 3) const;
 	};
 
 }  // namespace procedural
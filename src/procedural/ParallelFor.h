@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace procedural {
+
+	namespace detail {
+		// set on threads whose parallelFor calls run inline
+		inline thread_local bool parallelForSerial = false;
+	}
+
+	// while alive, parallelFor on this thread runs inline instead of spawning workers,
+	// for jobs that already run next to other jobs on their own thread, e.g. the streamed terrain tiles
+	class SerialParallelForScope {
+	   public:
+		SerialParallelForScope() : previous(detail::parallelForSerial) {
+			detail::parallelForSerial = true;
+		}
+		~SerialParallelForScope() {
+			detail::parallelForSerial = previous;
+		}
+
+		SerialParallelForScope(const SerialParallelForScope&) = delete;
+		SerialParallelForScope& operator=(const SerialParallelForScope&) = delete;
+
+	   private:
+		bool previous;
+	};
+
+	// runs fn(i) for every i in [0, count) on worker threads (the calling thread helps), indices are handed out one at a time
+	// fn must only touch data owned by index i, the first exception is rethrown on the calling thread
+	// nested calls from inside fn run inline on the calling worker, so the thread count stays at hardware_concurrency
+	template <typename Fn>
+	void parallelFor(size_t count, Fn&& fn) {
+		if (count == 0) {
+			return;
+		}
+
+		if (detail::parallelForSerial) {
+			for (size_t i = 0; i < count; i++) {
+				fn(i);
+			}
+			return;
+		}
+
+		size_t threadCount = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+		std::atomic<size_t> next{ 0 };
+		std::exception_ptr error;
+		std::mutex errorMutex;
+
+		auto worker = [&]() {
+			SerialParallelForScope serial;
+			for (size_t i = next++; i < count; i = next++) {
+				try {
+					fn(i);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(errorMutex);
+					if (!error) {
+						error = std::current_exception();
+					}
+					next = count;
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+		for (size_t t = 1; t < threadCount; t++) {
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+}  // namespace procedural
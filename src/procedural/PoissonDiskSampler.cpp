@@ -0,0 +1,182 @@
+#include "PoissonDiskSampler.h"
+#include "ParallelFor.h"
+
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace procedural {
+
+	PlacementMask::PlacementMask(const glm::vec2& areaMin, const glm::vec2& areaMax, float cellSize)
+		: areaMin(areaMin), cellSize(cellSize) {
+		if (!(cellSize > 0.0f)) {
+			throw std::runtime_error("Placement mask cell size must be positive");
+		}
+		glm::vec2 size = glm::max(areaMax - areaMin, glm::vec2(0.0f));
+		width = std::max(1u, static_cast<uint32_t>(std::ceil(size.x / cellSize)));
+		height = std::max(1u, static_cast<uint32_t>(std::ceil(size.y / cellSize)));
+		cells.assign(size_t(width) * height, 0);
+	}
+
+	glm::vec2 PlacementMask::getCellCenter(uint32_t x, uint32_t y) const {
+		return areaMin + (glm::vec2(float(x), float(y)) + 0.5f) * cellSize;
+	}
+
+	void PlacementMask::setSuitable(uint32_t x, uint32_t y, bool suitable) {
+		cells[size_t(y) * width + x] = suitable ? 1 : 0;
+	}
+
+	bool PlacementMask::isSuitable(const glm::vec2& position) const {
+		glm::vec2 local = (position - areaMin) / cellSize;
+		if (local.x < 0.0f || local.y < 0.0f || local.x >= float(width) || local.y >= float(height)) {
+			return false;
+		}
+		return cells[size_t(local.y) * width + size_t(local.x)] != 0;
+	}
+
+	PoissonDiskSampler::PoissonDiskSampler(const glm::vec2& areaMin, const glm::vec2& areaMax, const std::vector<float>& speciesSpacing)
+		: areaMin(areaMin), areaMax(glm::max(areaMin, areaMax)), spacing(speciesSpacing) {
+		if (spacing.empty()) {
+			throw std::runtime_error("Poisson disk sampling needs at least one species");
+		}
+		for (float s : spacing) {
+			if (!(s > 0.0f)) {
+				throw std::runtime_error("Poisson disk spacing must be positive");
+			}
+		}
+
+		float minSpacing = *std::min_element(spacing.begin(), spacing.end());
+		float maxSpacing = *std::max_element(spacing.begin(), spacing.end());
+
+		cellSize = minSpacing / std::sqrt(2.0f);
+		glm::vec2 size = this->areaMax - this->areaMin;
+		gridWidth = std::max(1u, static_cast<uint32_t>(std::ceil(size.x / cellSize)));
+		gridHeight = std::max(1u, static_cast<uint32_t>(std::ceil(size.y / cellSize)));
+
+		searchCells = static_cast<int>(std::ceil(maxSpacing / cellSize));
+		// a tile only reads cells up to searchCells outside itself, so same phase tiles one tile apart never overlap
+		tileCells = std::max<uint32_t>(32, 4 * static_cast<uint32_t>(searchCells));
+		tilesX = (gridWidth + tileCells - 1) / tileCells;
+		tilesY = (gridHeight + tileCells - 1) / tileCells;
+	}
+
+	std::vector<PoissonDiskSampler::Sample> PoissonDiskSampler::sample(const PlacementMask& mask, uint32_t seed) const {
+		std::vector<Cell> grid(size_t(gridWidth) * gridHeight, Cell{ glm::vec2(0.0f), -1 });
+
+		// widest spacing first, denser species fill the gaps around the larger ones
+		std::vector<uint32_t> order(spacing.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return spacing[a] > spacing[b]; });
+
+		std::vector<Sample> samples;
+		for (uint32_t species : order) {
+			std::vector<std::vector<Sample>> tileSamples(size_t(tilesX) * tilesY);
+
+			// 2x2 coloring of the tiles, each phase runs its tiles in parallel
+			for (uint32_t phase = 0; phase < 4; phase++) {
+				std::vector<uint32_t> tiles;
+				for (uint32_t tileY = phase >> 1; tileY < tilesY; tileY += 2) {
+					for (uint32_t tileX = phase & 1; tileX < tilesX; tileX += 2) {
+						tiles.push_back(tileY * tilesX + tileX);
+					}
+				}
+
+				parallelFor(tiles.size(), [&](size_t i) {
+					uint32_t tile = tiles[i];
+					sampleTile(species, tile % tilesX, tile / tilesX, mask, seed, grid, tileSamples[tile]);
+				});
+			}
+
+			for (const auto& tile : tileSamples) {
+				samples.insert(samples.end(), tile.begin(), tile.end());
+			}
+		}
+
+		return samples;
+	}
+
+	void PoissonDiskSampler::sampleTile(uint32_t species, uint32_t tileX, uint32_t tileY, const PlacementMask& mask, uint32_t seed,
+		std::vector<Cell>& grid, std::vector<Sample>& out) const {
+		std::seed_seq seedSequence{ seed, species, tileX, tileY };
+		std::mt19937 rng(seedSequence);
+		std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+		const float radius = spacing[species];
+		const glm::vec2 tileMin = areaMin + glm::vec2(float(tileX), float(tileY)) * (float(tileCells) * cellSize);
+		const glm::vec2 tileMax = glm::min(tileMin + glm::vec2(float(tileCells) * cellSize), areaMax);
+
+		auto cellOf = [&](const glm::vec2& p) {
+			glm::ivec2 cell = glm::ivec2(glm::floor((p - areaMin) / cellSize));
+			return glm::clamp(cell, glm::ivec2(0), glm::ivec2(int(gridWidth) - 1, int(gridHeight) - 1));
+		};
+
+		auto accept = [&](const glm::vec2& p) {
+			if (p.x < tileMin.x || p.y < tileMin.y || p.x >= tileMax.x || p.y >= tileMax.y || !mask.isSuitable(p)) {
+				return false;
+			}
+
+			glm::ivec2 cell = cellOf(p);
+			int x0 = std::max(cell.x - searchCells, 0);
+			int x1 = std::min(cell.x + searchCells, int(gridWidth) - 1);
+			int y0 = std::max(cell.y - searchCells, 0);
+			int y1 = std::min(cell.y + searchCells, int(gridHeight) - 1);
+			for (int y = y0; y <= y1; y++) {
+				for (int x = x0; x <= x1; x++) {
+					const Cell& other = grid[size_t(y) * gridWidth + x];
+					if (other.species < 0) {
+						continue;
+					}
+					float minDistance = std::max(radius, spacing[other.species]);
+					glm::vec2 d = other.position - p;
+					if (glm::dot(d, d) < minDistance * minDistance) {
+						return false;
+					}
+				}
+			}
+			return true;
+		};
+
+		std::vector<glm::vec2> active;
+		auto insert = [&](const glm::vec2& p) {
+			glm::ivec2 cell = cellOf(p);
+			grid[size_t(cell.y) * gridWidth + cell.x] = Cell{ p, int32_t(species) };
+			out.push_back({ p, species });
+			active.push_back(p);
+		};
+
+		for (int attempt = 0; attempt < SEED_ATTEMPTS_PER_TILE; attempt++) {
+			glm::vec2 start = tileMin + glm::vec2(dist(rng), dist(rng)) * (tileMax - tileMin);
+			if (!accept(start)) {
+				continue;
+			}
+			insert(start);
+
+			while (!active.empty()) {
+				size_t index = static_cast<size_t>(dist(rng) * float(active.size())) % active.size();
+				glm::vec2 center = active[index];
+
+				bool found = false;
+				for (int k = 0; k < CANDIDATES_PER_SAMPLE; k++) {
+					// uniform in the annulus between radius and twice the radius
+					float angle = dist(rng) * glm::two_pi<float>();
+					float distance = radius * std::sqrt(1.0f + 3.0f * dist(rng));
+					glm::vec2 candidate = center + distance * glm::vec2(std::cos(angle), std::sin(angle));
+					if (accept(candidate)) {
+						insert(candidate);
+						found = true;
+						break;
+					}
+				}
+
+				if (!found) {
+					active[index] = active.back();
+					active.pop_back();
+				}
+			}
+		}
+	}
+
+}  // namespace procedural
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace procedural {
+
+	// regular grid over the vegetation area marking where trees may grow, evaluated once from the heightfield
+	class PlacementMask {
+	   public:
+		PlacementMask(const glm::vec2& areaMin, const glm::vec2& areaMax, float cellSize);
+
+		uint32_t getWidth() const { return width; }
+		uint32_t getHeight() const { return height; }
+
+		glm::vec2 getCellCenter(uint32_t x, uint32_t y) const;
+		void setSuitable(uint32_t x, uint32_t y, bool suitable);
+
+		// nearest cell, positions outside the area are never suitable
+		bool isSuitable(const glm::vec2& position) const;
+
+	   private:
+		glm::vec2 areaMin;
+		float cellSize;
+		uint32_t width;
+		uint32_t height;
+		std::vector<uint8_t> cells;
+	};
+
+	// Bridson poisson disk sampling accelerated by a background grid
+	// species are sampled from the widest spacing down, two samples are always at least the larger of their spacings apart
+	// the area is split into tiles that are sampled in parallel, tiles of one phase never touch each other's grid cells
+	class PoissonDiskSampler {
+	   public:
+		struct Sample {
+			glm::vec2 position;
+			// index into the spacing list
+			uint32_t species;
+		};
+
+		// candidates tried around an active sample before it is retired
+		static constexpr int CANDIDATES_PER_SAMPLE = 30;
+		// random starting points per tile, picks up suitable patches the growth from the first start can not reach
+		static constexpr int SEED_ATTEMPTS_PER_TILE = 30;
+
+		PoissonDiskSampler(const glm::vec2& areaMin, const glm::vec2& areaMax, const std::vector<float>& speciesSpacing);
+
+		// deterministic for a seed, independent of the thread count
+		std::vector<Sample> sample(const PlacementMask& mask, uint32_t seed) const;
+
+	   private:
+		struct Cell {
+			glm::vec2 position;
+			// -1 while the cell is empty, a cell holds at most one sample because its diagonal is the smallest spacing
+			int32_t species;
+		};
+
+		void sampleTile(uint32_t species, uint32_t tileX, uint32_t tileY, const PlacementMask& mask, uint32_t seed,
+			std::vector<Cell>& grid, std::vector<Sample>& out) const;
+
+		glm::vec2 areaMin;
+		glm::vec2 areaMax;
+		std::vector<float> spacing;
+		float cellSize = 1.0f;
+		uint32_t gridWidth = 0;
+		uint32_t gridHeight = 0;
+		// cells around a sample that can hold a conflicting one
+		int searchCells = 0;
+		uint32_t tileCells = 0;
+		uint32_t tilesX = 0;
+		uint32_t tilesY = 0;
+	};
+
+}  // namespace procedural
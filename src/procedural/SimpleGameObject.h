@@ -2,6 +2,7 @@
 
 #include "../GameObject.h"
 #include "../vk/vk_model.h"
+#include <limits>
 #include <memory>
 #include <glm/glm.hpp>
 
@@ -13,8 +14,9 @@ namespace procedural {
 		SimpleGameObject(
 			std::shared_ptr<vk::Model> model,
 			const glm::vec3& position = glm::vec3(0.0f),
-			const glm::vec3& scale = glm::vec3(1.0f))
-			: model_(model), position_(position), scale_(scale) {}
+			const glm::vec3& scale = glm::vec3(1.0f),
+			float maxDrawDistance = std::numeric_limits<float>::max())
+			: model_(model), position_(position), scale_(scale), maxDrawDistance_(maxDrawDistance) {}
 
 		virtual ~SimpleGameObject() = default;
 
@@ -38,10 +40,15 @@ namespace procedural {
 			return model_;
 		}
 
+		float getMaxDrawDistance() const override {
+			return maxDrawDistance_;
+		}
+
 	   private:
 		std::shared_ptr<vk::Model> model_;
 		glm::vec3 position_{0.0f};
 		glm::vec3 scale_{1.0f};
+		float maxDrawDistance_;
 	};
 
 }  // namespace procedural
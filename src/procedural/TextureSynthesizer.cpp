@@ -0,0 +1,106 @@
+#include "TextureSynthesizer.h"
+#include "GenerationCache.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace procedural {
+
+	namespace {
+		// layout of the cached rgba8 chain, the generators are versioned by the caller
+		constexpr uint32_t CHAIN_CACHE_VERSION = 1;
+	}
+
+	TextureSynthesizer::MipChain TextureSynthesizer::synthesize(const std::string& name, uint32_t width, uint32_t height, uint32_t version, const PixelFunction& pixel) {
+		MipChain chain;
+		chain.width = std::max(1u, width);
+		chain.height = std::max(1u, height);
+		layoutLevels(chain);
+
+		uint64_t key = GenerationCache::Key().add(CHAIN_CACHE_VERSION).add(name).add(chain.width).add(chain.height).add(version).value();
+		std::string cacheName = "texture_" + name;
+		if (auto blob = GenerationCache::load(cacheName, key)) {
+			std::vector<unsigned char> pixels;
+			if (blob->read(pixels) && blob->atEnd() && pixels.size() == chain.pixels.size()) {
+				chain.pixels = std::move(pixels);
+				return chain;
+			}
+		}
+
+		generateLevel0(chain, pixel);
+		for (uint32_t level = 1; level < chain.mipLevels; level++) {
+			downsample(chain, level);
+		}
+
+		GenerationCache::Writer payload;
+		payload.write(chain.pixels);
+		GenerationCache::store(cacheName, key, payload);
+		return chain;
+	}
+
+	void TextureSynthesizer::layoutLevels(MipChain& chain) {
+		chain.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(chain.width, chain.height)))) + 1;
+		chain.levelOffsets.resize(chain.mipLevels);
+
+		size_t offset = 0;
+		for (uint32_t level = 0; level < chain.mipLevels; level++) {
+			chain.levelOffsets[level] = offset;
+			offset += size_t(std::max(1u, chain.width >> level)) * std::max(1u, chain.height >> level) * 4;
+		}
+		chain.pixels.resize(offset);
+	}
+
+	void TextureSynthesizer::generateLevel0(MipChain& chain, const PixelFunction& pixel) {
+		uint32_t tilesX = (chain.width + TILE_SIZE - 1) / TILE_SIZE;
+		uint32_t tilesY = (chain.height + TILE_SIZE - 1) / TILE_SIZE;
+
+		parallelFor(size_t(tilesX) * tilesY, [&](size_t tile) {
+			uint32_t x0 = uint32_t(tile % tilesX) * TILE_SIZE;
+			uint32_t y0 = uint32_t(tile / tilesX) * TILE_SIZE;
+			uint32_t x1 = std::min(x0 + TILE_SIZE, chain.width);
+			uint32_t y1 = std::min(y0 + TILE_SIZE, chain.height);
+
+			for (uint32_t y = y0; y < y1; y++) {
+				unsigned char* row = chain.pixels.data() + size_t(y) * chain.width * 4;
+				for (uint32_t x = x0; x < x1; x++) {
+					glm::vec2 uv(static_cast<float>(x) / chain.width, static_cast<float>(y) / chain.height);
+					glm::vec3 color = glm::clamp(pixel(uv), 0.0f, 1.0f);
+
+					unsigned char* texel = row + size_t(x) * 4;
+					texel[0] = static_cast<unsigned char>(color.r * 255);
+					texel[1] = static_cast<unsigned char>(color.g * 255);
+					texel[2] = static_cast<unsigned char>(color.b * 255);
+					texel[3] = 255;
+				}
+			}
+		});
+	}
+
+	void TextureSynthesizer::downsample(MipChain& chain, uint32_t level) {
+		uint32_t srcWidth = std::max(1u, chain.width >> (level - 1));
+		uint32_t srcHeight = std::max(1u, chain.height >> (level - 1));
+		uint32_t dstWidth = std::max(1u, chain.width >> level);
+		uint32_t dstHeight = std::max(1u, chain.height >> level);
+
+		const unsigned char* src = chain.pixels.data() + chain.levelOffsets[level - 1];
+		unsigned char* dst = chain.pixels.data() + chain.levelOffsets[level];
+
+		// 2x2 box filter, plain byte loops the compiler vectorizes, odd sizes clamp to the last row / column
+		parallelFor(dstHeight, [&](size_t y) {
+			const unsigned char* row0 = src + std::min<size_t>(y * 2, srcHeight - 1) * srcWidth * 4;
+			const unsigned char* row1 = src + std::min<size_t>(y * 2 + 1, srcHeight - 1) * srcWidth * 4;
+			unsigned char* out = dst + y * dstWidth * 4;
+
+			for (uint32_t x = 0; x < dstWidth; x++) {
+				size_t left = std::min<size_t>(x * 2, srcWidth - 1) * 4;
+				size_t right = std::min<size_t>(x * 2 + 1, srcWidth - 1) * 4;
+				for (int c = 0; c < 4; c++) {
+					uint32_t sum = uint32_t(row0[left + c]) + row0[right + c] + row1[left + c] + row1[right + c];
+					out[x * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		});
+	}
+
+}  // namespace procedural
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace procedural {
+
+	// cpu synthesis of procedural rgba8 textures including their full mip chain
+	// level 0 is generated in tiles on worker threads, the mips are box filtered right after in the same call
+	// results go through the GenerationCache keyed by name, size and generator version, so unchanged textures load instead of being generated
+	class TextureSynthesizer {
+	   public:
+		static constexpr uint32_t TILE_SIZE = 32;
+
+		struct MipChain {
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t mipLevels = 0;
+			// byte offset of each level in pixels
+			std::vector<size_t> levelOffsets;
+			std::vector<unsigned char> pixels;
+		};
+
+		// color of the texel at uv in [0, 1), called concurrently from several threads
+		using PixelFunction = std::function<glm::vec3(const glm::vec2& uv)>;
+
+		// @param version bump whenever the pixel function of this name changes, it is part of the cache key
+		static MipChain synthesize(const std::string& name, uint32_t width, uint32_t height, uint32_t version, const PixelFunction& pixel);
+
+	   private:
+		static void layoutLevels(MipChain& chain);
+		static void generateLevel0(MipChain& chain, const PixelFunction& pixel);
+		static void downsample(MipChain& chain, uint32_t level);
+	};
+
+}  // namespace procedural
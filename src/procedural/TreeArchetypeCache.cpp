@@ -0,0 +1,104 @@
+#include "TreeArchetypeCache.h"
+#include "ParallelFor.h"
+
+#include <string>
+#include <vector>
+
+namespace procedural {
+
+	TreeArchetypeCache::TreeArchetypeCache(vk::Device& device, bool useImpostors) : device(device) {
+		if (useImpostors) {
+			impostorAtlas = std::make_unique<ImpostorAtlas>();
+		}
+	}
+
+	void TreeArchetypeCache::prepare(const TreeMaterial& treeMaterial, int speciesSeed, uint32_t bucketCount) {
+		std::vector<uint32_t> missing;
+		for (uint32_t bucket = 0; bucket < bucketCount; bucket++) {
+			if (!archetypes.count(std::make_pair(speciesSeed, bucket))) {
+				missing.push_back(bucket);
+			}
+		}
+
+		std::vector<TreeGeometry> geometries = generateGeometries(speciesSeed, missing);
+
+		// buffer uploads and impostor bakes stay on this thread
+		for (size_t i = 0; i < missing.size(); i++) {
+			auto archetype = VegetationObject::createEnhancedTree(device, treeMaterial, geometries[i], glm::vec3(0.0f), glm::vec3(1.0f), impostorAtlas.get());
+			archetypes.emplace(std::make_pair(speciesSeed, missing[i]), std::move(archetype));
+		}
+	}
+
+	std::vector<TreeGeometry> TreeArchetypeCache::generateGeometries(int speciesSeed, const std::vector<uint32_t>& buckets) {
+		std::vector<TreeGeometry> geometries(buckets.size());
+		if (buckets.empty()) {
+			return geometries;
+		}
+
+		// bump when the tree grammar or the turtle output changes
+		const uint32_t contentVersion = 1;
+		uint64_t key = GenerationCache::Key()
+						   .add(contentVersion)
+						   .add(speciesSeed)
+						   .add(buckets)
+						   .add(VegetationObject::TREE_ITERATIONS)
+						   .add(LSystem::treeTurtleParameters())
+						   .value();
+		std::string cacheName = "tree_archetypes_" + std::to_string(speciesSeed);
+
+		if (auto blob = GenerationCache::load(cacheName, key)) {
+			bool complete = true;
+			for (auto& geometry : geometries) {
+				complete = complete && readPart(*blob, geometry.bark) && readPart(*blob, geometry.leaves);
+			}
+			if (complete && blob->atEnd()) {
+				return geometries;
+			}
+		}
+
+		parallelFor(buckets.size(), [&](size_t i) {
+			geometries[i] = VegetationObject::generateEnhancedTreeGeometry(archetypeSeed(speciesSeed, buckets[i]));
+		});
+
+		GenerationCache::Writer payload;
+		for (const auto& geometry : geometries) {
+			for (const auto* part : { &geometry.bark, &geometry.leaves }) {
+				payload.write(part->vertices);
+				payload.write(part->indices);
+				payload.write(part->boundsMin);
+				payload.write(part->boundsMax);
+			}
+		}
+		GenerationCache::store(cacheName, key, payload);
+		return geometries;
+	}
+
+	bool TreeArchetypeCache::readPart(GenerationCache::Blob& blob, TreeGeometry::MaterialGeometry& part) {
+		return blob.read(part.vertices) && blob.read(part.indices) && blob.read(part.boundsMin) && blob.read(part.boundsMax);
+	}
+
+	const VegetationObject& TreeArchetypeCache::getArchetype(const TreeMaterial& treeMaterial, int speciesSeed, uint32_t bucket) {
+		auto key = std::make_pair(speciesSeed, bucket);
+		auto it = archetypes.find(key);
+		if (it != archetypes.end()) {
+			return *it->second;
+		}
+
+		auto archetype = VegetationObject::createEnhancedTree(device, treeMaterial, glm::vec3(0.0f), glm::vec3(1.0f),
+			archetypeSeed(speciesSeed, bucket), impostorAtlas.get());
+
+		return *archetypes.emplace(key, std::move(archetype)).first->second;
+	}
+
+	int TreeArchetypeCache::archetypeSeed(int speciesSeed, uint32_t bucket) {
+		// murmur3 finalizer, neighbouring buckets get unrelated seeds
+		uint32_t h = static_cast<uint32_t>(speciesSeed) * 0x9e3779b1u + bucket;
+		h ^= h >> 16;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35u;
+		h ^= h >> 16;
+		return static_cast<int>(h & 0x7fffffffu);
+	}
+
+}  // namespace procedural
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "VegetationObject.h"
+#include "ImpostorAtlas.h"
+#include "GenerationCache.h"
+#include "TreeMaterial.h"
+#include "../vk/vk_device.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace procedural {
+
+	// a bounded set of generated trees (archetypes) that placements share as instances
+	// archetypes are keyed by species seed and bucket, so regenerating vegetation reuses meshes and impostor slots
+	class TreeArchetypeCache {
+	   public:
+		// @param useImpostors bakes every new archetype into the impostor atlas
+		TreeArchetypeCache(vk::Device& device, bool useImpostors);
+
+		// generates the missing archetypes of buckets [0, bucketCount) with the l-system work spread over worker threads
+		void prepare(const TreeMaterial& treeMaterial, int speciesSeed, uint32_t bucketCount);
+
+		// generates the archetype on first use, its models stay at the origin with unit scale
+		const VegetationObject& getArchetype(const TreeMaterial& treeMaterial, int speciesSeed, uint32_t bucket);
+
+		// nullptr if impostors are disabled
+		const ImpostorAtlas* getImpostorAtlas() const { return impostorAtlas.get(); }
+
+		size_t size() const { return archetypes.size(); }
+
+	   private:
+		// l-system seed of an archetype, stable for the same species seed and bucket
+		static int archetypeSeed(int speciesSeed, uint32_t bucket);
+
+		// geometry of the given buckets on worker threads, or from the generation cache when the same set was generated before
+		static std::vector<TreeGeometry> generateGeometries(int speciesSeed, const std::vector<uint32_t>& buckets);
+		static bool readPart(GenerationCache::Blob& blob, TreeGeometry::MaterialGeometry& part);
+
+		vk::Device& device;
+		std::map<std::pair<int, uint32_t>, std::unique_ptr<VegetationObject>> archetypes;
+		std::unique_ptr<ImpostorAtlas> impostorAtlas;
+	};
+
+}  // namespace procedural
@@ -1,4 +1,8 @@
 #include "TreeMaterial.h"
+#include "../asset_utils/AssetLoader.h"
+
+#include "stb_image.h"
+
 #include <iostream>
 
 namespace procedural {
@@ -25,6 +29,7 @@ namespace procedural {
 	void TreeMaterial::createBarkMaterial(const std::string& barkTexturePath) {
 		try {
 			barkMaterial = std::make_shared<vk::StandardMaterial>(device, barkTexturePath);
+			barkColor = averageTextureColor(barkTexturePath, barkColor);
 
 			barkMaterial->getPipelineConfigRef().rasterizationInfo.cullMode = VK_CULL_MODE_BACK_BIT;
 
@@ -39,6 +44,7 @@ namespace procedural {
 	void TreeMaterial::createLeafMaterial(const std::string& leafTexturePath) {
 		try {
 			leafMaterial = std::make_shared<vk::StandardMaterial>(device, leafTexturePath);
+			leafColor = averageTextureColor(leafTexturePath, leafColor);
 
 			leafMaterial->getPipelineConfigRef().rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
 
@@ -49,6 +55,24 @@ namespace procedural {
 		}
 	}
 
+	glm::vec3 TreeMaterial::averageTextureColor(const std::string& texturePath, const glm::vec3& fallback) {
+		int width, height, channels;
+		std::string resolvedPath = vk::AssetLoader::getInstance().resolvePath(texturePath);
+		stbi_uc* pixels = stbi_load(resolvedPath.c_str(), &width, &height, &channels, STBI_rgb);
+		if (!pixels) {
+			return fallback;
+		}
+
+		glm::dvec3 sum{ 0.0 };
+		size_t pixelCount = size_t(width) * size_t(height);
+		for (size_t i = 0; i < pixelCount; i++) {
+			sum += glm::dvec3(pixels[i * 3], pixels[i * 3 + 1], pixels[i * 3 + 2]);
+		}
+		stbi_image_free(pixels);
+
+		return pixelCount > 0 ? glm::vec3(sum / (double(pixelCount) * 255.0)) : fallback;
+	}
+
 	void TreeMaterial::createBarkMaterialSolid(const glm::vec3& barkColor) {
 		// Create a 1x1 bark color texture
 		std::vector<unsigned char> barkPixel = {
@@ -59,6 +83,7 @@ namespace procedural {
 		};
 
 		barkMaterial = std::make_shared<vk::StandardMaterial>(device, barkPixel, 1, 1, 4);
+		this->barkColor = barkColor;
 		barkMaterial->getPipelineConfigRef().rasterizationInfo.cullMode = VK_CULL_MODE_BACK_BIT;
 	}
 
@@ -72,6 +97,7 @@ namespace procedural {
 		};
 
 		leafMaterial = std::make_shared<vk::StandardMaterial>(device, leafPixel, 1, 1, 4);
+		this->leafColor = leafColor;
 		leafMaterial->getPipelineConfigRef().rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
 	}
 
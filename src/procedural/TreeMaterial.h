@@ -2,7 +2,10 @@
 
 #include "../rendering/materials/StandardMaterial.h"
 #include "../vk/vk_device.h"
+#include "../vk/vk_model.h"
+#include <limits>
 #include <memory>
+#include <vector>
 #include <glm/glm.hpp>
 
 namespace procedural {
@@ -29,6 +32,14 @@ namespace procedural {
 			return leafMaterial;
 		}
 
+		// average color of each part, used where the texture is too small to matter (impostors)
+		glm::vec3 getBarkColor() const {
+			return barkColor;
+		}
+		glm::vec3 getLeafColor() const {
+			return leafColor;
+		}
+
 		// Material type enumeration for geometry generation
 		enum MaterialType {
 			BARK = 0,
@@ -39,21 +50,25 @@ namespace procedural {
 		vk::Device& device;
 		std::shared_ptr<vk::Material> barkMaterial;
 		std::shared_ptr<vk::Material> leafMaterial;
+		glm::vec3 barkColor{ 0.4f, 0.2f, 0.1f };
+		glm::vec3 leafColor{ 0.2f, 0.6f, 0.2f };
+
+		// @returns fallback if the texture can not be read
+		static glm::vec3 averageTextureColor(const std::string& texturePath, const glm::vec3& fallback);
 	};
 
 	// Enhanced geometry structure with material information
 	struct TreeGeometry {
-		struct Vertex {
-			glm::vec3 position;
-			glm::vec3 color;
-			glm::vec3 normal;
-			glm::vec2 uv;
-		};
+		// final model vertex format, the turtle writes it directly so nothing is converted before the upload
+		using Vertex = vk::Model::Vertex;
 
 		// Separate geometry by material type
 		struct MaterialGeometry {
 			std::vector<Vertex> vertices;
 			std::vector<uint32_t> indices;
+			// object space bounds, tracked while the vertices are written
+			glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+			glm::vec3 boundsMax{ -std::numeric_limits<float>::max() };
 		};
 
 		MaterialGeometry bark;	  // Trunk and branch geometry
@@ -1,7 +1,15 @@
 #include "VegetationIntegrator.h"
-#include "SimpleGameObject.h"
+#include "GenerationCache.h"
+#include "ParallelFor.h"
+#include "PoissonDiskSampler.h"
+#include "../rendering/materials/ImpostorMaterial.h"
+#include "../rendering/structures/ImpostorBatch.h"
+#include "../rendering/structures/VegetationBatch.h"
 #include <iostream>
 #include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <glm/gtc/constants.hpp>
 
 namespace procedural {
 
@@ -19,44 +27,36 @@ namespace procedural {
 		clearVegetation();
 
 		std::mt19937 rng(settings.placementSeed);
-		std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-
-		// Calculate terrain area
-		float terrainWidth = settings.terrainMax.x - settings.terrainMin.x;
-		float terrainDepth = settings.terrainMax.y - settings.terrainMin.y;
-		float terrainArea = terrainWidth * terrainDepth;
 
-		int numTrees = static_cast<int>(terrainArea * settings.treeDensity);
+		std::vector<PlacementSample> samples = samplePlacementsCached(settings, { treeSpacing(settings) }, heightfieldData, gridSize, terrainScale, terrainPosition);
 
-		std::cout << "Generating vegetation: " << numTrees << " trees" << std::endl;
+		std::cout << "Generating vegetation: " << samples.size() << " trees" << std::endl;
 
 		// Create shared resources to reuse materials
 		auto resources = std::make_shared<VegetationSharedResources>(device);
 
-		// Generate trees
-		for (int i = 0; i < numTrees; ++i) {
-			glm::vec2 pos2D(
-				settings.terrainMin.x + dist(rng) * terrainWidth,
-				settings.terrainMin.y + dist(rng) * terrainDepth);
+		std::vector<SeededPlacement> placements;
+		placements.reserve(samples.size());
+
+		for (const auto& sample : samples) {
+			float scale = getRandomScale(settings.treeScaleRange, rng);
 
-			float height = sampleHeightAt(pos2D, heightfieldData, gridSize, terrainScale, terrainPosition);
-			float slope = calculateSlope(pos2D, heightfieldData, gridSize, terrainScale, terrainPosition);
+			// Generate unique seed for each tree for variety
+			int treeSeed = rng();
 
-			if (isSuitableForVegetation(pos2D, height, slope, settings)) {
-				// Ensure tree is properly grounded - place it slightly below terrain surface
-				glm::vec3 position(pos2D.x, height - 0.1f, pos2D.y);
-				float scale = getRandomScale(settings.treeScaleRange, rng);
+			placements.push_back({ sample.position, scale, treeSeed });
+		}
 
-				// Generate unique seed for each tree for variety
-				int treeSeed = rng();
+		// l-system work of all trees on worker threads, one rng per tree
+		std::vector<LSystemGeometry> geometries = generateTreeGeometries(placements, VegetationObject::TREE_ITERATIONS, "", LSystem::treeTurtleParameters());
 
-				auto tree = VegetationObject::createTree(device, position, glm::vec3(scale), treeSeed);
+		for (size_t i = 0; i < placements.size(); ++i) {
+			auto tree = std::make_unique<VegetationObject>(device, geometries[i], placements[i].position, glm::vec3(placements[i].scale));
 
-				// Apply shared material
-				tree->getModel()->setMaterial(resources->getMaterial());
+			// Apply shared material
+			tree->getModel()->setMaterial(resources->getMaterial());
 
-				vegetation.push_back(std::move(tree));
-			}
+			vegetation.push_back(std::move(tree));
 		}
 
 		std::cout << "Generated " << vegetation.size() << " vegetation objects" << std::endl;
@@ -74,48 +74,37 @@ namespace procedural {
 		clearVegetation();
 
 		std::mt19937 rng(settings.placementSeed);
-		std::uniform_real_distribution<float> dist(0.0f, 1.0f);
 
-		// Calculate terrain area
-		float terrainWidth = settings.terrainMax.x - settings.terrainMin.x;
-		float terrainDepth = settings.terrainMax.y - settings.terrainMin.y;
-		float terrainArea = terrainWidth * terrainDepth;
+		std::vector<PlacementSample> samples = samplePlacementsCached(settings, { treeSpacing(settings) }, heightfieldData, gridSize, terrainScale, terrainPosition);
 
-		// Calculate number of trees to place
-		int numTrees = static_cast<int>(terrainArea * settings.treeDensity);
-
-		std::cout << "Generating vegetation with custom parameters: " << numTrees << " trees" << std::endl;
+		std::cout << "Generating vegetation with custom parameters: " << samples.size() << " trees" << std::endl;
 		std::cout << "  Iterations: " << lsystemIterations << ", Axiom: " << axiom << std::endl;
 
 		// Create shared resources to reuse materials
 		auto resources = std::make_shared<VegetationSharedResources>(device);
 
-		// Generate trees with custom parameters
-		for (int i = 0; i < numTrees; ++i) {
-			glm::vec2 pos2D(
-				settings.terrainMin.x + dist(rng) * terrainWidth,
-				settings.terrainMin.y + dist(rng) * terrainDepth);
+		std::vector<SeededPlacement> placements;
+		placements.reserve(samples.size());
 
-			float height = sampleHeightAt(pos2D, heightfieldData, gridSize, terrainScale, terrainPosition);
-			float slope = calculateSlope(pos2D, heightfieldData, gridSize, terrainScale, terrainPosition);
+		for (const auto& sample : samples) {
+			float scale = getRandomScale(settings.treeScaleRange, rng);
 
-			if (isSuitableForVegetation(pos2D, height, slope, settings)) {
-				// Ensure tree is properly grounded
-				glm::vec3 position(pos2D.x, height - 0.1f, pos2D.y);
-				float scale = getRandomScale(settings.treeScaleRange, rng);
+			// Generate unique seed for each tree for variety
+			int treeSeed = rng();
 
-				// Generate unique seed for each tree for variety
-				int treeSeed = rng();
+			placements.push_back({ sample.position, scale, treeSeed });
+		}
 
-				// Create tree with custom parameters
-				auto tree = VegetationObject::createTree(device, position, glm::vec3(scale),
-					treeSeed, lsystemIterations, axiom, turtleParams);
+		// Create trees with custom parameters, l-system work on worker threads
+		std::vector<LSystemGeometry> geometries = generateTreeGeometries(placements, lsystemIterations, axiom, turtleParams);
 
-				// Apply shared material
-				tree->getModel()->setMaterial(resources->getMaterial());
+		for (size_t i = 0; i < placements.size(); ++i) {
+			auto tree = std::make_unique<VegetationObject>(device, geometries[i], placements[i].position, glm::vec3(placements[i].scale));
 
-				vegetation.push_back(std::move(tree));
-			}
+			// Apply shared material
+			tree->getModel()->setMaterial(resources->getMaterial());
+
+			vegetation.push_back(std::move(tree));
 		}
 
 		std::cout << "Generated " << vegetation.size() << " vegetation objects with custom parameters" << std::endl;
@@ -130,46 +119,83 @@ namespace procedural {
 		// Clear existing vegetation
 		clearVegetation();
 
-		std::mt19937 rng(settings.placementSeed);
-		std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+		std::vector<Species> species = resolveSpecies(settings);
+		std::vector<PlacementSample> samples = samplePlacementsCached(settings, resolveSpacing(settings, species), heightfieldData, gridSize, terrainScale, terrainPosition);
 
-		// Calculate terrain area
-		float terrainWidth = settings.terrainMax.x - settings.terrainMin.x;
-		float terrainDepth = settings.terrainMax.y - settings.terrainMin.y;
-		float terrainArea = terrainWidth * terrainDepth;
+		std::cout << "Generating enhanced vegetation: " << samples.size() << " trees of " << species.size() << " species with separate bark/leaf materials" << std::endl;
 
-		int numTrees = static_cast<int>(terrainArea * settings.treeDensity);
+		createEnhancedPlacements(settings, species, samples);
 
-		std::cout << "Generating enhanced vegetation: " << numTrees << " trees with separate bark/leaf materials" << std::endl;
+		std::cout << "Generated " << enhancedPlacements.size() << " enhanced vegetation instances of "
+				  << archetypeCache->size() << " archetypes" << std::endl;
+	}
 
-		// Create shared resources to reuse materials
-		auto resources = std::make_shared<VegetationSharedResources>(device);
+	std::vector<VegetationIntegrator::PlacementSample> VegetationIntegrator::placeTrees(
+		const VegetationSettings& settings,
+		const std::vector<float>& heightfieldData,
+		int gridSize,
+		const glm::vec3& terrainScale,
+		const glm::vec3& terrainPosition) const {
+		return samplePlacements(settings, resolveSpacing(settings, resolveSpecies(settings)), heightfieldData, gridSize, terrainScale, terrainPosition);
+	}
+
+	void VegetationIntegrator::addTreesToScene(const VegetationSettings& settings, const std::vector<PlacementSample>& samples, SceneManager& sceneManager, std::vector<vk::id_t>& ids) {
+		clearVegetation();
+		if (samples.empty()) {
+			return;
+		}
 
-		// Generate enhanced trees with separate bark and leaf materials
-		for (int i = 0; i < numTrees; ++i) {
-			glm::vec2 pos2D(
-				settings.terrainMin.x + dist(rng) * terrainWidth,
-				settings.terrainMin.y + dist(rng) * terrainDepth);
+		createEnhancedPlacements(settings, resolveSpecies(settings), samples);
+		addEnhancedVegetationToScene(sceneManager, ids);
+	}
 
-			float height = sampleHeightAt(pos2D, heightfieldData, gridSize, terrainScale, terrainPosition);
-			float slope = calculateSlope(pos2D, heightfieldData, gridSize, terrainScale, terrainPosition);
+	std::vector<VegetationIntegrator::Species> VegetationIntegrator::resolveSpecies(const VegetationSettings& settings) {
+		std::vector<Species> species = settings.species;
+		if (species.empty()) {
+			species.push_back({ settings.speciesSeed, 0.0f });
+		}
+		return species;
+	}
 
-			if (isSuitableForVegetation(pos2D, height, slope, settings)) {
-				// Ensure tree is properly grounded - place it slightly below terrain surface
-				glm::vec3 position(pos2D.x, height - 0.1f, pos2D.y);
-				float scale = getRandomScale(settings.treeScaleRange, rng);
+	std::vector<float> VegetationIntegrator::resolveSpacing(const VegetationSettings& settings, const std::vector<Species>& species) {
+		std::vector<float> spacing;
+		for (const Species& s : species) {
+			spacing.push_back(s.minSpacing > 0.0f ? s.minSpacing : treeSpacing(settings));
+		}
+		return spacing;
+	}
 
-				// Generate unique seed for each tree for variety
-				int treeSeed = rng();
+	void VegetationIntegrator::createEnhancedPlacements(const VegetationSettings& settings, const std::vector<Species>& species, const std::vector<PlacementSample>& samples) {
+		std::mt19937 rng(settings.placementSeed);
+		std::uniform_real_distribution<float> dist(0.0f, 1.0f);
 
-				auto tree = VegetationObject::createEnhancedTree(device, resources->getTreeMaterial(),
-					position, glm::vec3(scale), treeSeed);
+		// Create shared resources to reuse materials
+		if (!sharedResources) {
+			sharedResources = std::make_shared<VegetationSharedResources>(device);
+		}
 
-				enhancedVegetation.push_back(std::move(tree));
-			}
+		// archetypes (and their impostor slots) survive regeneration unless impostors were toggled
+		bool cacheHasImpostors = archetypeCache && archetypeCache->getImpostorAtlas();
+		if (!archetypeCache || cacheHasImpostors != settings.useImpostors) {
+			archetypeCache = std::make_unique<TreeArchetypeCache>(device, settings.useImpostors);
+		}
+		impostorDistance = settings.impostorDistance;
+		uint32_t archetypeCount = static_cast<uint32_t>(std::max(1, settings.archetypesPerSpecies));
+		for (const Species& s : species) {
+			archetypeCache->prepare(sharedResources->getTreeMaterial(), s.seed, archetypeCount);
 		}
 
-		std::cout << "Generated " << enhancedVegetation.size() << " enhanced vegetation objects" << std::endl;
+		enhancedPlacements.reserve(samples.size());
+		for (const auto& sample : samples) {
+			float scale = getRandomScale(settings.treeScaleRange, rng);
+
+			// variety comes from the archetype bucket plus a random yaw instead of a unique mesh per tree
+			uint32_t bucket = static_cast<uint32_t>(rng()) % archetypeCount;
+			float yaw = dist(rng) * glm::two_pi<float>();
+
+			const VegetationObject& archetype = archetypeCache->getArchetype(sharedResources->getTreeMaterial(), species[sample.species].seed, bucket);
+			enhancedPlacements.push_back({ &archetype, sample.position, scale, yaw });
+		}
 	}
 
 	void VegetationIntegrator::addVegetationToScene(SceneManager& sceneManager) {
@@ -180,39 +206,79 @@ namespace procedural {
 		vegetation.clear();
 	}
 
-	void VegetationIntegrator::addEnhancedVegetationToScene(SceneManager& sceneManager) {
-		for (auto& vegObject : enhancedVegetation) {
-			// For enhanced trees, we need to add both bark and leaf models as separate game objects
-			if (vegObject->hasMultipleMaterials()) {
-				// Add bark model as a separate game object
-				if (vegObject->getBarkModel()) {
-					auto barkGameObject = std::make_unique<SimpleGameObject>(
-						vegObject->getBarkModel(),
-						vegObject->getPosition(),
-						vegObject->getScale());
-					sceneManager.addSpectralObject(std::move(barkGameObject));
-				}
+	void VegetationIntegrator::addEnhancedVegetationToScene(SceneManager& sceneManager, std::vector<vk::id_t>& ids) {
+		const ImpostorAtlas* impostorAtlas = archetypeCache ? archetypeCache->getImpostorAtlas() : nullptr;
+
+		// one batch per archetype and material, in order of first use
+		std::vector<const VegetationObject*> archetypeOrder;
+		std::unordered_map<const VegetationObject*, std::vector<vk::VegetationBatch::Instance>> archetypeInstances;
+		std::vector<vk::ImpostorMaterial::Instance> impostorInstances;
+
+		for (const auto& placement : enhancedPlacements) {
+			auto [it, inserted] = archetypeInstances.try_emplace(placement.archetype);
+			if (inserted) {
+				archetypeOrder.push_back(placement.archetype);
+			}
+
+			glm::vec4 rotation(std::cos(placement.yaw), std::sin(placement.yaw), 0.0f, 0.0f);
+			it->second.push_back({ glm::vec4(placement.position, placement.scale), rotation });
+
+			uint32_t slotIndex = placement.archetype->getImpostorSlot();
+			if (impostorAtlas && slotIndex != ImpostorAtlas::INVALID_SLOT) {
+				const ImpostorAtlas::Slot& slot = impostorAtlas->getSlot(slotIndex);
+				vk::ImpostorMaterial::Instance instance{};
+				instance.positionScale = glm::vec4(placement.position, placement.scale);
+				instance.centerRadius = glm::vec4(slot.center, slot.radius);
+				instance.slotOffset = glm::vec4(slot.uvOffset, rotation.x, rotation.y);
+				impostorInstances.push_back(instance);
+			}
+		}
+
+		size_t batchCount = 0;
+		for (const VegetationObject* archetype : archetypeOrder) {
+			// trees with an impostor hand over to it beyond the impostor distance
+			float maxInstanceDistance = std::numeric_limits<float>::max();
+			if (impostorAtlas && archetype->getImpostorSlot() != ImpostorAtlas::INVALID_SLOT) {
+				maxInstanceDistance = impostorDistance;
+			}
 
-				// Add leaf model as a separate game object
-				if (vegObject->getLeafModel()) {
-					auto leafGameObject = std::make_unique<SimpleGameObject>(
-						vegObject->getLeafModel(),
-						vegObject->getPosition(),
-						vegObject->getScale());
-					sceneManager.addSpectralObject(std::move(leafGameObject));
+			const auto& instances = archetypeInstances[archetype];
+			for (const auto& model : { archetype->getBarkModel(), archetype->getLeafModel() }) {
+				if (model) {
+					ids.push_back(sceneManager.addVegetationObject(std::make_unique<vk::VegetationBatch>(model, instances, maxInstanceDistance)));
+					batchCount++;
 				}
-			} else {
-				// Legacy single-material tree
-				std::unique_ptr<vk::GameObject> gameObject = std::move(vegObject);
-				sceneManager.addSpectralObject(std::move(gameObject));
 			}
 		}
-		enhancedVegetation.clear();
+
+		std::cout << "Added " << enhancedPlacements.size() << " trees in " << batchCount << " instanced vegetation batches" << std::endl;
+		enhancedPlacements.clear();
+
+		if (!impostorInstances.empty()) {
+			// the atlas only changes when new archetypes were baked, every other call reuses the uploaded one
+			if (!impostorMaterial || impostorMaterialSlots != impostorAtlas->getSlotCount() || impostorMaterialDistance != impostorDistance) {
+				vk::ImpostorMaterial::AtlasCreationData atlasData{};
+				atlasData.albedo = &impostorAtlas->getAlbedo();
+				atlasData.normals = &impostorAtlas->getNormals();
+				atlasData.atlasSize = ImpostorAtlas::ATLAS_SIZE;
+				atlasData.framesPerSide = ImpostorAtlas::FRAMES_PER_SIDE;
+				atlasData.slotSize = ImpostorAtlas::SLOT_SIZE;
+				atlasData.impostorDistance = impostorDistance;
+
+				impostorMaterial = std::make_shared<vk::ImpostorMaterial>(device, atlasData);
+				impostorMaterialSlots = impostorAtlas->getSlotCount();
+				impostorMaterialDistance = impostorDistance;
+			}
+
+			ids.push_back(sceneManager.addSpectralObject(std::make_unique<vk::ImpostorBatch>(device, impostorMaterial, impostorInstances)));
+
+			std::cout << "Added " << impostorInstances.size() << " tree impostors (" << impostorAtlas->getSlotCount() << " atlas slots)" << std::endl;
+		}
 	}
 
 	void VegetationIntegrator::clearVegetation() {
 		vegetation.clear();
-		enhancedVegetation.clear();
+		enhancedPlacements.clear();
 	}
 
 	VegetationIntegrator::VegetationStats VegetationIntegrator::getVegetationStats() const {
@@ -225,6 +291,126 @@ namespace procedural {
 		return stats;
 	}
 
+	std::vector<VegetationIntegrator::PlacementSample> VegetationIntegrator::samplePlacementsCached(
+		const VegetationSettings& settings,
+		const std::vector<float>& speciesSpacing,
+		const std::vector<float>& heightfieldData,
+		int gridSize,
+		const glm::vec3& terrainScale,
+		const glm::vec3& terrainPosition) const {
+		// everything the mask and the sampler read, bump the version when either changes
+		const uint32_t contentVersion = 1;
+		GenerationCache::Key key;
+		key.add(contentVersion)
+			.add(settings.treeDensity)
+			.add(settings.maxTreeSlope)
+			.add(settings.minTreeHeight)
+			.add(settings.maxTreeHeight)
+			.add(settings.terrainMin)
+			.add(settings.terrainMax)
+			.add(settings.placementSeed)
+			.add(speciesSpacing)
+			.add(heightfieldData)
+			.add(gridSize)
+			.add(terrainScale)
+			.add(terrainPosition);
+
+		if (auto blob = GenerationCache::load("vegetation_placements", key.value())) {
+			std::vector<PlacementSample> cached;
+			if (blob->read(cached) && blob->atEnd()) {
+				return cached;
+			}
+		}
+
+		std::vector<PlacementSample> placements = samplePlacements(settings, speciesSpacing, heightfieldData, gridSize, terrainScale, terrainPosition);
+
+		GenerationCache::Writer payload;
+		payload.write(placements);
+		GenerationCache::store("vegetation_placements", key.value(), payload);
+		return placements;
+	}
+
+	std::vector<VegetationIntegrator::PlacementSample> VegetationIntegrator::samplePlacements(
+		const VegetationSettings& settings,
+		const std::vector<float>& speciesSpacing,
+		const std::vector<float>& heightfieldData,
+		int gridSize,
+		const glm::vec3& terrainScale,
+		const glm::vec3& terrainPosition) const {
+		// one mask cell per heightfield cell, capped so huge areas do not allocate huge masks
+		glm::vec2 areaSize = settings.terrainMax - settings.terrainMin;
+		float heightfieldCell = 2.0f * std::min(terrainScale.x, terrainScale.z) / static_cast<float>(std::max(gridSize - 1, 1));
+		float maskCell = std::max(heightfieldCell, std::max(areaSize.x, areaSize.y) / 4096.0f);
+
+		PlacementMask mask(settings.terrainMin, settings.terrainMax, maskCell);
+		parallelFor(mask.getHeight(), [&](size_t y) {
+			for (uint32_t x = 0; x < mask.getWidth(); x++) {
+				glm::vec2 center = mask.getCellCenter(x, uint32_t(y));
+				float height = sampleHeightAt(center, heightfieldData, gridSize, terrainScale, terrainPosition);
+				float slope = calculateSlope(center, heightfieldData, gridSize, terrainScale, terrainPosition);
+				mask.setSuitable(x, uint32_t(y), isSuitableForVegetation(center, height, slope, settings));
+			}
+		});
+
+		PoissonDiskSampler sampler(settings.terrainMin, settings.terrainMax, speciesSpacing);
+		std::vector<PoissonDiskSampler::Sample> samples = sampler.sample(mask, static_cast<uint32_t>(settings.placementSeed));
+
+		std::vector<PlacementSample> placements;
+		placements.reserve(samples.size());
+		for (const auto& sample : samples) {
+			// Ensure tree is properly grounded - place it slightly below terrain surface
+			float height = sampleHeightAt(sample.position, heightfieldData, gridSize, terrainScale, terrainPosition);
+			placements.push_back({ glm::vec3(sample.position.x, height - 0.1f, sample.position.y), sample.species });
+		}
+		return placements;
+	}
+
+	std::vector<LSystemGeometry> VegetationIntegrator::generateTreeGeometries(
+		const std::vector<SeededPlacement>& placements,
+		int iterations,
+		const std::string& axiom,
+		const TurtleParameters& turtleParams) const {
+		// the seeds come from the placement rng, so they stand in for the placements
+		const uint32_t contentVersion = 1;
+		std::vector<int> seeds;
+		seeds.reserve(placements.size());
+		for (const auto& placement : placements) {
+			seeds.push_back(placement.seed);
+		}
+		uint64_t key = GenerationCache::Key().add(contentVersion).add(iterations).add(axiom).add(turtleParams).add(seeds).value();
+
+		std::vector<LSystemGeometry> geometries(placements.size());
+		if (auto blob = GenerationCache::load("vegetation_trees", key)) {
+			bool complete = true;
+			for (auto& geometry : geometries) {
+				complete = complete && blob->read(geometry.vertices) && blob->read(geometry.indices);
+			}
+			if (complete && blob->atEnd()) {
+				return geometries;
+			}
+		}
+
+		parallelFor(placements.size(), [&](size_t i) {
+			geometries[i] = VegetationObject::generateTreeGeometry(placements[i].seed, iterations, axiom, turtleParams);
+		});
+
+		GenerationCache::Writer payload;
+		for (const auto& geometry : geometries) {
+			payload.write(geometry.vertices);
+			payload.write(geometry.indices);
+		}
+		GenerationCache::store("vegetation_trees", key, payload);
+		return geometries;
+	}
+
+	float VegetationIntegrator::treeSpacing(const VegetationSettings& settings) {
+		if (settings.minTreeSpacing > 0.0f) {
+			return settings.minTreeSpacing;
+		}
+		// a maximal poisson disk set holds about 0.7 / spacing^2 samples per square unit
+		return std::sqrt(0.7f / std::max(settings.treeDensity, 1e-6f));
+	}
+
 	float VegetationIntegrator::sampleHeightAt(
 		const glm::vec2& worldPos,
 		const std::vector<float>& heightfieldData,
@@ -296,7 +482,7 @@ namespace procedural {
 		float height,
 		float slope,
 		const VegetationSettings& settings) const {
-		return slope <= settings.maxTreeSlope;
+		return slope <= settings.maxTreeSlope && height >= settings.minTreeHeight && height <= settings.maxTreeHeight;
 	}
 
 	float VegetationIntegrator::getRandomScale(const glm::vec2& scaleRange, std::mt19937& rng) const {
@@ -3,20 +3,34 @@
 #include "LSystem.h"
 #include "VegetationObject.h"
 #include "VegetationSharedResources.h"
+#include "TreeArchetypeCache.h"
 #include "../vk/vk_device.h"
 #include "../scene/SceneManager.h"
+#include "../rendering/materials/ImpostorMaterial.h"
 #include <vector>
 #include <memory>
 #include <random>
+#include <limits>
 
 namespace procedural {
 
 	class VegetationIntegrator {
 	   public:
+		// one kind of enhanced tree, its archetypes come from seed
+		struct Species {
+			int seed = 0;
+			// minimum distance to any other tree, 0 derives it from treeDensity
+			float minSpacing = 0.0f;
+		};
+
 		struct VegetationSettings {
+			// trees per square unit, the poisson disk spacing is derived from it unless minTreeSpacing is set
 			float treeDensity = 0.05f;
+			float minTreeSpacing = 0.0f;
 
 			float maxTreeSlope = 35.0f;
+			float minTreeHeight = -std::numeric_limits<float>::max();
+			float maxTreeHeight = std::numeric_limits<float>::max();
 
 			glm::vec2 treeScaleRange = glm::vec2(0.5f, 1.0f);
 
@@ -24,6 +38,23 @@ namespace procedural {
 			glm::vec2 terrainMax = glm::vec2(100.0f, 100.0f);
 
 			int placementSeed = 12345;
+
+			// trees are instances of a bounded set of generated archetypes per species
+			int archetypesPerSpecies = 8;
+			// l-system variation family, archetypes are cached per species seed and bucket
+			int speciesSeed = 0;
+			// enhanced trees only, empty means a single species from speciesSeed
+			std::vector<Species> species;
+
+			// enhanced trees further away than impostorDistance are drawn as octahedral impostors
+			bool useImpostors = true;
+			float impostorDistance = 60.0f;
+		};
+
+		// poisson disk position of one tree, grounded on the terrain
+		struct PlacementSample {
+			glm::vec3 position;
+			uint32_t species;
 		};
 
 		VegetationIntegrator(vk::Device& device);
@@ -56,11 +87,26 @@ namespace procedural {
 			const glm::vec3& terrainScale,
 			const glm::vec3& terrainPosition);
 
+		// enhanced tree positions inside settings.terrainMin / terrainMax, not cached
+		// reads no integrator state, so streamed tiles call it on worker threads
+		std::vector<PlacementSample> placeTrees(
+			const VegetationSettings& settings,
+			const std::vector<float>& heightfieldData,
+			int gridSize,
+			const glm::vec3& terrainScale,
+			const glm::vec3& terrainPosition) const;
+
+		// enhanced trees at samples from placeTrees, added to the scene right away
+		// @param ids receives the id of every batch as soon as it is added, e.g. to remove them again with the tile they belong to,
+		// so they are complete even if adding a later batch throws
+		void addTreesToScene(const VegetationSettings& settings, const std::vector<PlacementSample>& samples, SceneManager& sceneManager, std::vector<vk::id_t>& ids);
+
 		// Add individual vegetation objects to the scene
 		void addVegetationToScene(SceneManager& sceneManager);
 
 		// Add enhanced vegetation objects to the scene
-		void addEnhancedVegetationToScene(SceneManager& sceneManager);
+		// @param ids receives the ids of the added vegetation and impostor batches as they are added
+		void addEnhancedVegetationToScene(SceneManager& sceneManager, std::vector<vk::id_t>& ids);
 
 		// Clear all generated vegetation
 		void clearVegetation();
@@ -75,7 +121,69 @@ namespace procedural {
 	   private:
 		vk::Device& device;
 		std::vector<std::unique_ptr<VegetationObject>> vegetation;
-		std::vector<std::unique_ptr<VegetationObject>> enhancedVegetation;
+
+		// placement of one legacy tree, its geometry is generated from the seed on a worker thread
+		struct SeededPlacement {
+			glm::vec3 position;
+			float scale;
+			int seed;
+		};
+
+		// placement of one enhanced tree, the archetype is owned by archetypeCache
+		struct TreePlacement {
+			const VegetationObject* archetype;
+			glm::vec3 position;
+			float scale;
+			float yaw;
+		};
+		std::vector<TreePlacement> enhancedPlacements;
+
+		// archetype meshes and the impostor atlas, kept across regeneration
+		std::unique_ptr<TreeArchetypeCache> archetypeCache;
+		float impostorDistance = 0.0f;
+
+		// atlas upload shared by the impostor batches of every call, recreated when the atlas gained slots
+		// batches added before keep the previous material alive
+		std::shared_ptr<vk::ImpostorMaterial> impostorMaterial;
+		uint32_t impostorMaterialSlots = 0;
+		float impostorMaterialDistance = 0.0f;
+
+		// tree material the archetypes are built with, shared by every call
+		std::shared_ptr<VegetationSharedResources> sharedResources;
+
+		// settings.species, or a single species from speciesSeed
+		static std::vector<Species> resolveSpecies(const VegetationSettings& settings);
+		static std::vector<float> resolveSpacing(const VegetationSettings& settings, const std::vector<Species>& species);
+
+		// picks archetype, scale and yaw of every sample into enhancedPlacements
+		void createEnhancedPlacements(const VegetationSettings& settings, const std::vector<Species>& species, const std::vector<PlacementSample>& samples);
+
+		// samplePlacements from the generation cache keyed by the placement settings and the heightfield
+		std::vector<PlacementSample> samplePlacementsCached(
+			const VegetationSettings& settings,
+			const std::vector<float>& speciesSpacing,
+			const std::vector<float>& heightfieldData,
+			int gridSize,
+			const glm::vec3& terrainScale,
+			const glm::vec3& terrainPosition) const;
+
+		// evaluates slope and height once per mask cell, then samples all species at their spacing
+		std::vector<PlacementSample> samplePlacements(
+			const VegetationSettings& settings,
+			const std::vector<float>& speciesSpacing,
+			const std::vector<float>& heightfieldData,
+			int gridSize,
+			const glm::vec3& terrainScale,
+			const glm::vec3& terrainPosition) const;
+
+		static float treeSpacing(const VegetationSettings& settings);
+
+		// l-system geometry of every placement on worker threads, or from the generation cache for the same seeds and parameters
+		std::vector<LSystemGeometry> generateTreeGeometries(
+			const std::vector<SeededPlacement>& placements,
+			int iterations,
+			const std::string& axiom,
+			const TurtleParameters& turtleParams) const;
 
 		// Height sampling from heightfield data
 		float sampleHeightAt(
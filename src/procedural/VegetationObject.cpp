@@ -41,20 +41,7 @@ namespace procedural {
 		const glm::vec3& position,
 		const glm::vec3& scale,
 		int seed) {
-		LSystem lsystem = LSystem::createTree(seed);
-
-		std::string lsystemString = lsystem.generate(3);
-
-		// Get the default turtle parameters
-		TurtleParameters params = lsystem.getTurtleParameters();
-
-		// Generate geometry with customized parameters, starting from origin
-		LSystemGeometry geometry = lsystem.interpretToGeometry(lsystemString, params, glm::vec3(0.0f, 0.0f, 0.0f), seed);
-
-		// Create the vegetation object
-		auto treeObject = std::make_unique<VegetationObject>(device, geometry, position, scale);
-
-		return treeObject;
+		return std::make_unique<VegetationObject>(device, generateTreeGeometry(seed), position, scale);
 	}
 
 	std::unique_ptr<VegetationObject> VegetationObject::createTree(
@@ -65,6 +52,41 @@ namespace procedural {
 		int iterations,
 		const std::string& axiom,
 		const TurtleParameters& turtleParams) {
+		return std::make_unique<VegetationObject>(device, generateTreeGeometry(seed, iterations, axiom, turtleParams), position, scale);
+	}
+
+	std::unique_ptr<VegetationObject> VegetationObject::createEnhancedTree(
+		vk::Device& device,
+		const TreeMaterial& treeMaterial,
+		const glm::vec3& position,
+		const glm::vec3& scale,
+		int seed,
+		ImpostorAtlas* impostorAtlas) {
+		return createEnhancedTree(device, treeMaterial, generateEnhancedTreeGeometry(seed), position, scale, impostorAtlas);
+	}
+
+	std::unique_ptr<VegetationObject> VegetationObject::createEnhancedTree(
+		vk::Device& device,
+		const TreeMaterial& treeMaterial,
+		const TreeGeometry& treeGeometry,
+		const glm::vec3& position,
+		const glm::vec3& scale,
+		ImpostorAtlas* impostorAtlas) {
+		// Create the enhanced vegetation object
+		auto treeObject = std::make_unique<VegetationObject>(device, treeGeometry, treeMaterial, position, scale);
+
+		if (impostorAtlas) {
+			treeObject->setImpostorSlot(impostorAtlas->bake(treeGeometry, treeMaterial.getBarkColor(), treeMaterial.getLeafColor()));
+		}
+
+		return treeObject;
+	}
+
+	LSystemGeometry VegetationObject::generateTreeGeometry(int seed) {
+		return generateTreeGeometry(seed, TREE_ITERATIONS, "", LSystem::treeTurtleParameters());
+	}
+
+	LSystemGeometry VegetationObject::generateTreeGeometry(int seed, int iterations, const std::string& axiom, const TurtleParameters& turtleParams) {
 		LSystem lsystem = LSystem::createTree(seed);
 
 		if (!axiom.empty()) {
@@ -73,40 +95,27 @@ namespace procedural {
 
 		std::string lsystemString = lsystem.generate(iterations);
 
-		LSystemGeometry geometry = lsystem.interpretToGeometry(lsystemString, turtleParams, glm::vec3(0.0f, 0.0f, 0.0f), seed);
-
-		// Create the vegetation object
-		auto treeObject = std::make_unique<VegetationObject>(device, geometry, position, scale);
-
-		return treeObject;
+		return lsystem.interpretToGeometry(lsystemString, turtleParams, glm::vec3(0.0f, 0.0f, 0.0f), seed);
 	}
 
-	std::unique_ptr<VegetationObject> VegetationObject::createEnhancedTree(
-		vk::Device& device,
-		const TreeMaterial& treeMaterial,
-		const glm::vec3& position,
-		const glm::vec3& scale,
-		int seed) {
+	TreeGeometry VegetationObject::generateEnhancedTreeGeometry(int seed) {
 		LSystem lsystem = LSystem::createTree(seed);
 
-		std::string lsystemString = lsystem.generate(3);
+		std::string lsystemString = lsystem.generate(TREE_ITERATIONS);
 
 		// Get the default turtle parameters
 		TurtleParameters params = lsystem.getTurtleParameters();
 
 		// Generate tree geometry with separate bark and leaf materials
-		TreeGeometry treeGeometry = lsystem.interpretToTreeGeometry(lsystemString, params, glm::vec3(0.0f, 0.0f, 0.0f), seed);
-
-		// Create the enhanced vegetation object
-		auto treeObject = std::make_unique<VegetationObject>(device, treeGeometry, treeMaterial, position, scale);
-
-		return treeObject;
+		return lsystem.interpretToTreeGeometry(lsystemString, params, glm::vec3(0.0f, 0.0f, 0.0f), seed);
 	}
 
 	std::shared_ptr<vk::Model> VegetationObject::createModelFromGeometry(
 		vk::Device& device,
 		const LSystemGeometry& geometry) {
 		vk::Model::Builder builder{};
+		builder.generateLods = true;
+		builder.compactVertices = true;
 
 		// Add vertices
 		for (const auto& vertex : geometry.vertices) {
@@ -179,73 +188,24 @@ namespace procedural {
 	VegetationObject::createModelsFromTreeGeometry(
 		vk::Device& device,
 		const TreeGeometry& treeGeometry) {
-		// Create bark model
-		std::shared_ptr<vk::Model> barkModel;
-		if (!treeGeometry.bark.vertices.empty()) {
-			vk::Model::Builder barkBuilder{};
-
-			// Add bark vertices
-			for (const auto& vertex : treeGeometry.bark.vertices) {
-				vk::Model::Vertex modelVertex{};
-				modelVertex.position = vertex.position;
-				modelVertex.color = vertex.color;
-				modelVertex.normal = vertex.normal;
-				modelVertex.uv = vertex.uv;
-				barkBuilder.vertices.push_back(modelVertex);
-			}
-
-			if (!barkBuilder.vertices.empty()) {
-				auto mn = barkBuilder.vertices[0].position;
-				auto mx = mn;
-				for (size_t i = 1; i < barkBuilder.vertices.size(); ++i) {
-					mn = glm::min(mn, barkBuilder.vertices[i].position);
-					mx = glm::max(mx, barkBuilder.vertices[i].position);
-				}
-				barkBuilder.boundsMin = mn;
-				barkBuilder.boundsMax = mx;
+		auto createPart = [&device](const TreeGeometry::MaterialGeometry& part) -> std::shared_ptr<vk::Model> {
+			if (part.vertices.empty()) {
+				return nullptr;
 			}
 
-			// Add bark indices
-			for (const auto& index : treeGeometry.bark.indices) {
-				barkBuilder.indices.push_back(index);
-			}
-
-			barkModel = std::make_shared<vk::Model>(device, barkBuilder);
-		}
-
-		// Create leaf model
-		std::shared_ptr<vk::Model> leafModel;
-		if (!treeGeometry.leaves.vertices.empty()) {
-			vk::Model::Builder leafBuilder{};
-
-			// Add leaf vertices
-			for (const auto& vertex : treeGeometry.leaves.vertices) {
-				vk::Model::Vertex modelVertex{};
-				modelVertex.position = vertex.position;
-				modelVertex.color = vertex.color;
-				modelVertex.normal = vertex.normal;
-				modelVertex.uv = vertex.uv;
-				leafBuilder.vertices.push_back(modelVertex);
-			}
-
-			if (!leafBuilder.vertices.empty()) {
-				auto mn = leafBuilder.vertices[0].position;
-				auto mx = mn;
-				for (size_t i = 1; i < leafBuilder.vertices.size(); ++i) {
-					mn = glm::min(mn, leafBuilder.vertices[i].position);
-					mx = glm::max(mx, leafBuilder.vertices[i].position);
-				}
-				leafBuilder.boundsMin = mn;
-				leafBuilder.boundsMax = mx;
-			}
-
-			// Add leaf indices
-			for (const auto& index : treeGeometry.leaves.indices) {
-				leafBuilder.indices.push_back(index);
-			}
-
-			leafModel = std::make_shared<vk::Model>(device, leafBuilder);
-		}
+			// the interpreter already wrote the model vertex format and the bounds, so this is a plain bulk copy
+			vk::Model::Builder builder{};
+			builder.generateLods = true;
+			builder.compactVertices = true;
+			builder.vertices = part.vertices;
+			builder.indices = part.indices;
+			builder.boundsMin = part.boundsMin;
+			builder.boundsMax = part.boundsMax;
+			return std::make_shared<vk::Model>(device, builder);
+		};
+
+		std::shared_ptr<vk::Model> barkModel = createPart(treeGeometry.bark);
+		std::shared_ptr<vk::Model> leafModel = createPart(treeGeometry.leaves);
 
 		return std::make_pair(barkModel, leafModel);
 	}
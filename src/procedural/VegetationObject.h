@@ -4,6 +4,7 @@
 #include "../vk/vk_model.h"
 #include "LSystem.h"
 #include "TreeMaterial.h"
+#include "ImpostorAtlas.h"
 #include <memory>
 #include <glm/glm.hpp>
 
@@ -40,6 +41,10 @@ namespace procedural {
 		bool hasMultipleMaterials() const;
 		glm::vec3 getScale() const;
 
+		// slot in the impostor atlas or ImpostorAtlas::INVALID_SLOT if the tree is always drawn as mesh
+		uint32_t getImpostorSlot() const { return impostorSlot; }
+		void setImpostorSlot(uint32_t slot) { impostorSlot = slot; }
+
 		// Static factory method for tree vegetation (legacy)
 		static std::unique_ptr<VegetationObject> createTree(
 			vk::Device& device,
@@ -47,13 +52,14 @@ namespace procedural {
 			const glm::vec3& scale = glm::vec3(1.0f),
 			int seed = 0);
 
-		// Static factory method for enhanced tree with materials
+		// Static factory method for enhanced tree with materials, also bakes its impostor if an atlas is given
 		static std::unique_ptr<VegetationObject> createEnhancedTree(
 			vk::Device& device,
 			const TreeMaterial& treeMaterial,
 			const glm::vec3& position,
 			const glm::vec3& scale = glm::vec3(1.0f),
-			int seed = 0);
+			int seed = 0,
+			ImpostorAtlas* impostorAtlas = nullptr);
 
 		// Static factory method for tree vegetation with custom parameters
 		static std::unique_ptr<VegetationObject> createTree(
@@ -65,6 +71,23 @@ namespace procedural {
 			const std::string& axiom,
 			const TurtleParameters& turtleParams);
 
+		// Enhanced tree from already generated geometry, bakes its impostor if an atlas is given
+		static std::unique_ptr<VegetationObject> createEnhancedTree(
+			vk::Device& device,
+			const TreeMaterial& treeMaterial,
+			const TreeGeometry& treeGeometry,
+			const glm::vec3& position,
+			const glm::vec3& scale,
+			ImpostorAtlas* impostorAtlas);
+
+		// l-system iterations of the default trees, part of the generation cache keys
+		static constexpr int TREE_ITERATIONS = 3;
+
+		// l-system expansion and interpretation only (no gpu work), every call has its own rng so worker threads can generate trees in parallel
+		static LSystemGeometry generateTreeGeometry(int seed);
+		static LSystemGeometry generateTreeGeometry(int seed, int iterations, const std::string& axiom, const TurtleParameters& turtleParams);
+		static TreeGeometry generateEnhancedTreeGeometry(int seed);
+
 	   private:
 		std::shared_ptr<vk::Model> model;
 		std::shared_ptr<vk::Model> barkModel;
@@ -72,6 +95,7 @@ namespace procedural {
 		bool multipleMaterials = false;
 		glm::vec3 position{0.0f};
 		glm::vec3 scale{1.0f};
+		uint32_t impostorSlot = ImpostorAtlas::INVALID_SLOT;
 
 		// Create a model from L-System geometry
 		static std::shared_ptr<vk::Model> createModelFromGeometry(
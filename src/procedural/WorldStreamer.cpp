@@ -0,0 +1,224 @@
+#include "WorldStreamer.h"
+#include "HeightmapGenerator.h"
+#include "ParallelFor.h"
+#include "../simulation/objects/static/Terrain.h"
+#include "../vk/vk_model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace procedural {
+
+	WorldStreamer::WorldStreamer(vk::Device& device, JPH::PhysicsSystem& physicsSystem, const Settings& settings)
+		: device(device), physicsSystem(physicsSystem), settings(settings), vegetationIntegrator(device) {
+		this->settings.samplesPerTile = std::max(this->settings.samplesPerTile, 2);
+		this->settings.loadRadius = std::max(this->settings.loadRadius, 0);
+		this->settings.maxPendingTiles = std::max(this->settings.maxPendingTiles, 1);
+		this->settings.maxUploadsPerUpdate = std::max(this->settings.maxUploadsPerUpdate, 1);
+	}
+
+	WorldStreamer::~WorldStreamer() {
+		// workers only touch their own tile data and the const vegetation placement, let them finish before the members go away
+		for (auto& [key, pending] : pendingTiles) {
+			if (pending.valid()) {
+				pending.wait();
+			}
+		}
+	}
+
+	void WorldStreamer::loadAround(const glm::vec3& position) {
+		glm::ivec2 center = tileAt(position);
+		queueTiles(center, true);
+		uploadTiles(center, pendingTiles.size(), true);
+	}
+
+	void WorldStreamer::update(const glm::vec3& position) {
+		glm::ivec2 center = tileAt(position);
+		uploadTiles(center, size_t(settings.maxUploadsPerUpdate), false);
+		evictTiles(center);
+		queueTiles(center, false);
+	}
+
+	uint64_t WorldStreamer::tileKey(int x, int z) {
+		return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(z));
+	}
+
+	glm::ivec2 WorldStreamer::tileAt(const glm::vec3& position) const {
+		// tile (0, 0) is centered on the origin
+		return glm::ivec2(
+			static_cast<int>(std::floor(position.x / settings.tileSize + 0.5f)),
+			static_cast<int>(std::floor(position.z / settings.tileSize + 0.5f)));
+	}
+
+	glm::vec3 WorldStreamer::tileCenter(int x, int z) const {
+		return glm::vec3(x * settings.tileSize, settings.baseHeight, z * settings.tileSize);
+	}
+
+	int WorldStreamer::ringDistance(const glm::ivec2& a, int x, int z) {
+		return std::max(std::abs(x - a.x), std::abs(z - a.y));
+	}
+
+	VegetationIntegrator::VegetationSettings WorldStreamer::tileVegetationSettings(int x, int z) const {
+		VegetationIntegrator::VegetationSettings vegetation = settings.vegetation;
+
+		glm::vec3 center = tileCenter(x, z);
+		float halfSize = 0.5f * settings.tileSize;
+		vegetation.terrainMin = glm::vec2(center.x - halfSize, center.z - halfSize);
+		vegetation.terrainMax = glm::vec2(center.x + halfSize, center.z + halfSize);
+
+		// every tile gets its own but reproducible trees
+		vegetation.placementSeed = settings.vegetation.placementSeed ^ (x * 73856093) ^ (z * 19349663);
+		return vegetation;
+	}
+
+	WorldStreamer::TileData WorldStreamer::generateTile(int x, int z) const {
+		TileData tile;
+		tile.x = x;
+		tile.z = z;
+		tile.heights = HeightmapGenerator::generateTile(settings.samplesPerTile, settings.noiseScale, settings.seed, x, z);
+
+		float halfSize = 0.5f * settings.tileSize;
+		tile.shape = physics::Terrain::createHeightfieldShape(tile.heights, glm::vec3(halfSize, settings.heightScale, halfSize));
+
+		if (settings.generateVegetation) {
+			tile.trees = vegetationIntegrator.placeTrees(
+				tileVegetationSettings(x, z),
+				tile.heights,
+				settings.samplesPerTile,
+				glm::vec3(halfSize, settings.heightScale, halfSize),
+				tileCenter(x, z));
+		}
+		return tile;
+	}
+
+	void WorldStreamer::queueTiles(const glm::ivec2& center, bool unbounded) {
+		std::vector<glm::ivec2> missing;
+		for (int z = center.y - settings.loadRadius; z <= center.y + settings.loadRadius; z++) {
+			for (int x = center.x - settings.loadRadius; x <= center.x + settings.loadRadius; x++) {
+				uint64_t key = tileKey(x, z);
+				if (loadedTiles.count(key) == 0 && pendingTiles.count(key) == 0) {
+					missing.emplace_back(x, z);
+				}
+			}
+		}
+
+		// the tile under the player first, then outwards
+		std::sort(missing.begin(), missing.end(), [&](const glm::ivec2& a, const glm::ivec2& b) {
+			glm::ivec2 da = a - center;
+			glm::ivec2 db = b - center;
+			return da.x * da.x + da.y * da.y < db.x * db.x + db.y * db.y;
+		});
+
+		for (const glm::ivec2& tile : missing) {
+			if (!unbounded && pendingTiles.size() >= size_t(settings.maxPendingTiles)) {
+				break;
+			}
+			pendingTiles.emplace(tileKey(tile.x, tile.y), std::async(std::launch::async, [this, tile]() {
+				// up to maxPendingTiles tiles generate at once, each one stays on its own thread
+				SerialParallelForScope serial;
+				return generateTile(tile.x, tile.y);
+			}));
+		}
+	}
+
+	void WorldStreamer::uploadTiles(const glm::ivec2& center, size_t maxUploads, bool wait) {
+		std::vector<TileData> finished;
+		for (auto it = pendingTiles.begin(); it != pendingTiles.end() && finished.size() < maxUploads;) {
+			if (!wait && it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				++it;
+				continue;
+			}
+
+			try {
+				TileData tile = it->second.get();
+				// the player moved on while the tile was generated
+				if (ringDistance(center, tile.x, tile.z) <= settings.loadRadius + 1) {
+					finished.push_back(std::move(tile));
+				}
+			} catch (const std::exception& e) {
+				std::cerr << "WorldStreamer: Could not generate tile: " << e.what() << std::endl;
+			}
+			it = pendingTiles.erase(it);
+		}
+
+		if (finished.empty()) {
+			return;
+		}
+
+		float halfSize = 0.5f * settings.tileSize;
+		glm::vec3 scale(halfSize, settings.heightScale, halfSize);
+
+		std::vector<std::unique_ptr<physics::ManagedPhysicsEntity>> terrains;
+		terrains.reserve(finished.size());
+		for (TileData& tile : finished) {
+			std::shared_ptr<vk::Model> model = vk::Model::createTerrainModel(
+				device, tile.heights, settings.samplesPerTile, settings.tileTexturePath, true, settings.terrainMaterial);
+
+			terrains.push_back(std::make_unique<physics::Terrain>(
+				physicsSystem, model, tileCenter(tile.x, tile.z), scale, std::move(tile.heights), tile.shape));
+		}
+
+		// all bodies of this update go into the broad phase at once
+		SceneManager& sceneManager = SceneManager::getInstance();
+		std::vector<vk::id_t> terrainIds = sceneManager.addTerrainObjects(std::move(terrains), physicsSystem.GetBodyInterface());
+
+		for (size_t i = 0; i < finished.size(); i++) {
+			const TileData& tile = finished[i];
+
+			LoadedTile loaded;
+			loaded.x = tile.x;
+			loaded.z = tile.z;
+			loaded.terrainId = terrainIds[i];
+			if (settings.generateVegetation) {
+				try {
+					vegetationIntegrator.addTreesToScene(tileVegetationSettings(tile.x, tile.z), tile.trees, sceneManager, loaded.vegetationIds);
+				} catch (const std::exception& e) {
+					// the tile stays walkable without the rest of its trees, the batches added before the failure are evicted with it
+					std::cerr << "WorldStreamer: Could not add vegetation of tile " << tile.x << ", " << tile.z << ": " << e.what() << std::endl;
+				}
+			}
+			loadedTiles[tileKey(tile.x, tile.z)] = std::move(loaded);
+		}
+
+		std::cout << "WorldStreamer: Uploaded " << finished.size() << " tiles, " << loadedTiles.size() << " loaded" << std::endl;
+	}
+
+	void WorldStreamer::evictTiles(const glm::ivec2& center) {
+		SceneManager& sceneManager = SceneManager::getInstance();
+
+		// after a jump across several tiles the old ones stay until a new one arrived,
+		// the last terrain material would take the shared terrain descriptor pool and layout with it
+		bool anyTileKept = false;
+		for (const auto& [key, tile] : loadedTiles) {
+			if (ringDistance(center, tile.x, tile.z) <= settings.loadRadius + 1) {
+				anyTileKept = true;
+				break;
+			}
+		}
+		if (!anyTileKept) {
+			return;
+		}
+
+		for (auto it = loadedTiles.begin(); it != loadedTiles.end();) {
+			const LoadedTile& tile = it->second;
+			if (ringDistance(center, tile.x, tile.z) <= settings.loadRadius + 1) {
+				++it;
+				continue;
+			}
+
+			// the removed objects release their bodies on destruction and their gpu resources through the destruction queue
+			if (tile.terrainId != vk::INVALID_OBJECT_ID) {
+				sceneManager.removeGameObject(tile.terrainId);
+			}
+			for (vk::id_t id : tile.vegetationIds) {
+				if (id != vk::INVALID_OBJECT_ID) {
+					sceneManager.removeGameObject(id);
+				}
+			}
+			it = loadedTiles.erase(it);
+		}
+	}
+
+}  // namespace procedural
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "VegetationIntegrator.h"
+#include "../rendering/materials/TessellationMaterial.h"
+#include "../scene/SceneManager.h"
+#include "../vk/vk_device.h"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace procedural {
+
+	// square terrain tiles with their trees, loaded in a ring around the player and evicted once they are far behind
+	// heights, the jolt heightfield shape and the tree placement of a tile are generated on a worker thread,
+	// the main thread uploads a bounded number of finished tiles per update and adds their bodies in one batch
+	class WorldStreamer {
+	   public:
+		struct Settings {
+			// heightfield resolution of one tile, neighbouring tiles share their edge samples
+			int samplesPerTile = 100;
+			// world units per tile side
+			float tileSize = 200.0f;
+			// noise frequency per tile, see HeightmapGenerator::generateTile
+			float noiseScale = 5.0f;
+			int seed = 0;
+
+			// height from the tile center to the highest peak / lowest valley
+			float heightScale = 15.0f;
+			float baseHeight = 0.0f;
+
+			// tiles up to loadRadius tiles away from the player tile are loaded,
+			// they are evicted beyond loadRadius + 1 so walking along a tile border does not reload tiles
+			int loadRadius = 1;
+			// tiles generated on worker threads at the same time
+			int maxPendingTiles = 4;
+			// finished tiles uploaded per update, bounds the gpu upload and body insertion hitch per frame
+			int maxUploadsPerUpdate = 1;
+
+			std::string tileTexturePath = "textures:ground/dirt.png";
+			vk::TessellationMaterial::MaterialCreationData terrainMaterial{};
+
+			bool generateVegetation = true;
+			// terrainMin / terrainMax and placementSeed are derived per tile
+			VegetationIntegrator::VegetationSettings vegetation{};
+		};
+
+		WorldStreamer(vk::Device& device, JPH::PhysicsSystem& physicsSystem, const Settings& settings);
+		~WorldStreamer();
+
+		WorldStreamer(const WorldStreamer&) = delete;
+		WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+		// generates and uploads the whole ring around position before returning, call before the first physics step
+		void loadAround(const glm::vec3& position);
+
+		// call once per frame from the main thread: queues tiles entering the ring, uploads finished ones and evicts the ones that left
+		void update(const glm::vec3& position);
+
+		size_t getLoadedTileCount() const {
+			return loadedTiles.size();
+		}
+
+	   private:
+		// cpu side of one tile, produced on a worker thread
+		struct TileData {
+			int x = 0;
+			int z = 0;
+			std::vector<float> heights;
+			JPH::ShapeRefC shape;
+			std::vector<VegetationIntegrator::PlacementSample> trees;
+		};
+
+		// scene objects of an uploaded tile
+		struct LoadedTile {
+			int x = 0;
+			int z = 0;
+			vk::id_t terrainId = vk::INVALID_OBJECT_ID;
+			std::vector<vk::id_t> vegetationIds;
+		};
+
+		static uint64_t tileKey(int x, int z);
+
+		glm::ivec2 tileAt(const glm::vec3& position) const;
+		glm::vec3 tileCenter(int x, int z) const;
+		VegetationIntegrator::VegetationSettings tileVegetationSettings(int x, int z) const;
+
+		// worker thread
+		TileData generateTile(int x, int z) const;
+
+		// queues the missing tiles of the ring nearest first, at most maxPendingTiles unless unbounded
+		void queueTiles(const glm::ivec2& center, bool unbounded);
+
+		// uploads at most maxUploads finished tiles, waits for them if wait is set
+		void uploadTiles(const glm::ivec2& center, size_t maxUploads, bool wait);
+
+		void evictTiles(const glm::ivec2& center);
+
+		static int ringDistance(const glm::ivec2& a, int x, int z);
+
+		vk::Device& device;
+		JPH::PhysicsSystem& physicsSystem;
+		Settings settings;
+
+		VegetationIntegrator vegetationIntegrator;
+
+		std::unordered_map<uint64_t, std::future<TileData>> pendingTiles;
+		std::unordered_map<uint64_t, LoadedTile> loadedTiles;
+	};
+
+}  // namespace procedural
@@ -0,0 +1,211 @@
+#include "RenderGraph.h"
+
+#include <set>
+#include <stdexcept>
+
+namespace vk {
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(ResourceHandle resource, Usage usage) {
+        graph.passes[pass].accesses.push_back({ resource, usage, false, false });
+        return *this;
+    }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(ResourceHandle resource, Usage usage, bool discard) {
+        graph.passes[pass].accesses.push_back({ resource, usage, true, discard });
+        return *this;
+    }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::setSideEffects() {
+        graph.passes[pass].sideEffects = true;
+        return *this;
+    }
+
+    void RenderGraph::reset() {
+        passes.clear();
+        resources.clear();
+    }
+
+    RenderGraph::ResourceHandle RenderGraph::importImage(const std::string& name, VkImage image, const VkImageSubresourceRange& range) {
+        Resource resource{};
+        resource.name = name;
+        resource.image = image;
+        resource.range = range;
+
+        auto it = importedStates.find({ image, range.baseMipLevel, range.baseArrayLayer });
+        if (it != importedStates.end()) {
+            resource.state = it->second;
+        }
+
+        resources.push_back(resource);
+        return ResourceHandle(resources.size() - 1);
+    }
+
+    RenderGraph::PassBuilder RenderGraph::addPass(const std::string& name, std::function<void(VkCommandBuffer)> execute) {
+        Pass pass{};
+        pass.name = name;
+        pass.execute = std::move(execute);
+        passes.push_back(std::move(pass));
+        return PassBuilder(*this, uint32_t(passes.size() - 1));
+    }
+
+    void RenderGraph::execute(VkCommandBuffer commandBuffer) {
+        cullPasses();
+
+        for (const Pass& pass : passes) {
+            if (pass.culled) {
+                continue;
+            }
+            recordBarriers(commandBuffer, pass);
+            pass.execute(commandBuffer);
+        }
+
+        for (const Resource& resource : resources) {
+            importedStates[{ resource.image, resource.range.baseMipLevel, resource.range.baseArrayLayer }] = resource.state;
+        }
+    }
+
+    RenderGraph::UsageInfo RenderGraph::getUsageInfo(Usage usage) {
+        switch (usage) {
+            case Usage::COLOR_ATTACHMENT:
+                return {
+                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
+                    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+            case Usage::DEPTH_ATTACHMENT:
+                return {
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+            case Usage::DEPTH_SAMPLED:
+                return {
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    0 };
+            case Usage::SAMPLED:
+                return {
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    0 };
+            case Usage::TRANSFER_SRC:
+                return {
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_READ_BIT,
+                    0 };
+            case Usage::TRANSFER_DST:
+                return {
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0,
+                    VK_ACCESS_TRANSFER_WRITE_BIT };
+        }
+        throw std::runtime_error("RenderGraph: Unknown image usage");
+    }
+
+    void RenderGraph::cullPasses() {
+        // walk backwards and keep a pass if it has side effects or writes something a kept pass reads later
+        std::set<ResourceHandle> needed;
+        for (int i = int(passes.size()) - 1; i >= 0; i--) {
+            Pass& pass = passes[i];
+
+            bool used = pass.sideEffects;
+            for (const Access& access : pass.accesses) {
+                if (access.write && needed.count(access.resource)) {
+                    used = true;
+                }
+            }
+            pass.culled = !used;
+            if (pass.culled) {
+                continue;
+            }
+
+            // a discarding write defines the whole image, earlier writers are only needed for what this pass reads
+            for (const Access& access : pass.accesses) {
+                if (access.write && access.discard) {
+                    needed.erase(access.resource);
+                }
+            }
+            for (const Access& access : pass.accesses) {
+                if (!access.write || !access.discard) {
+                    needed.insert(access.resource);
+                }
+            }
+        }
+    }
+
+    void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const Pass& pass) {
+        std::vector<VkImageMemoryBarrier> barriers;
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+
+        for (const Access& access : pass.accesses) {
+            Resource& resource = resources[access.resource];
+            ImageState& state = resource.state;
+            UsageInfo usage = getUsageInfo(access.usage);
+
+            bool transition = state.layout != usage.layout;
+            bool needsBarrier;
+            if (access.write) {
+                // read after write, write after write and write after read
+                needsBarrier = transition || state.writeStages != 0 || state.readStages != 0;
+            } else {
+                // only stages that have not seen the last write yet
+                needsBarrier = transition || (state.writeStages != 0 && (usage.stages & ~state.readStages) != 0);
+            }
+
+            if (needsBarrier) {
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = resource.image;
+                barrier.subresourceRange = resource.range;
+                barrier.oldLayout = access.discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+                barrier.newLayout = usage.layout;
+                barrier.srcAccessMask = state.writeAccess;
+                barrier.dstAccessMask = usage.readAccess | usage.writeAccess;
+                barriers.push_back(barrier);
+
+                // a transition or a write also has to wait for the readers of the old contents
+                VkPipelineStageFlags waitStages = state.writeStages;
+                if (transition || access.write) {
+                    waitStages |= state.readStages;
+                }
+                srcStages |= waitStages;
+                dstStages |= usage.stages;
+            }
+
+            if (access.write) {
+                state.writeStages = usage.stages;
+                state.writeAccess = usage.writeAccess;
+                state.readStages = 0;
+            } else if (transition) {
+                // later readers in other stages have to wait for the transition
+                state.writeStages = usage.stages;
+                state.writeAccess = 0;
+                state.readStages = usage.stages;
+            } else {
+                state.readStages |= usage.stages;
+            }
+            state.layout = usage.layout;
+        }
+
+        if (barriers.empty()) {
+            return;
+        }
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            dstStages,
+            0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(barriers.size()), barriers.data());
+    }
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace vk {
+
+// the passes of one frame declare which images they read and write
+// the graph culls passes whose results nobody consumes and records the barriers and layout transitions in between
+// all images are imported, frame-local images aliased in shared memory are not supported yet
+// render passes and framebuffers stay with their owners, their attachments have to start and end in the layout of the declared usage
+class RenderGraph {
+public:
+    using ResourceHandle = uint32_t;
+
+    enum class Usage {
+        COLOR_ATTACHMENT,
+        DEPTH_ATTACHMENT,
+        // depth sampled read-only in fragment shaders, e.g. the shadow cascades
+        DEPTH_SAMPLED,
+        SAMPLED,
+        TRANSFER_SRC,
+        TRANSFER_DST
+    };
+
+    class PassBuilder {
+    public:
+        PassBuilder& read(ResourceHandle resource, Usage usage);
+        // @param discard the previous contents are not needed, e.g. cleared attachments or complete copies
+        PassBuilder& write(ResourceHandle resource, Usage usage, bool discard = false);
+        // never culled, e.g. the pass drawing into the swap chain
+        PassBuilder& setSideEffects();
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, uint32_t pass) : graph(graph), pass(pass) {}
+
+        RenderGraph& graph;
+        uint32_t pass;
+    };
+
+    RenderGraph() = default;
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // drops the passes and resources of the last frame, the layouts of imported images are remembered
+    void reset();
+
+    // image owned outside of the graph, its state carries over between frames
+    ResourceHandle importImage(const std::string& name, VkImage image, const VkImageSubresourceRange& range);
+
+    // passes execute in the order they were added
+    PassBuilder addPass(const std::string& name, std::function<void(VkCommandBuffer)> execute);
+
+    // culls and records all remaining passes with their barriers
+    void execute(VkCommandBuffer commandBuffer);
+
+private:
+    struct ImageState {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // last write, the layout transition counts as one
+        VkPipelineStageFlags writeStages = 0;
+        VkAccessFlags writeAccess = 0;
+        // stages that already saw the last write
+        VkPipelineStageFlags readStages = 0;
+    };
+
+    struct Access {
+        ResourceHandle resource;
+        Usage usage;
+        bool write;
+        bool discard;
+    };
+
+    struct Pass {
+        std::string name;
+        std::function<void(VkCommandBuffer)> execute;
+        std::vector<Access> accesses;
+        bool sideEffects = false;
+        bool culled = false;
+    };
+
+    struct Resource {
+        std::string name;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageSubresourceRange range{};
+        ImageState state;
+    };
+
+    // layout, stages and access masks an image is used with
+    struct UsageInfo {
+        VkImageLayout layout;
+        VkPipelineStageFlags stages;
+        VkAccessFlags readAccess;
+        VkAccessFlags writeAccess;
+    };
+    static UsageInfo getUsageInfo(Usage usage);
+
+    void cullPasses();
+    void recordBarriers(VkCommandBuffer commandBuffer, const Pass& pass);
+
+    std::vector<Pass> passes;
+    std::vector<Resource> resources;
+
+    // state of imported images at the end of the last frame, per image, mip and layer
+    std::map<std::tuple<VkImage, uint32_t, uint32_t>, ImageState> importedStates;
+};
+
+}
@@ -4,8 +4,13 @@
 #include "../Engine.h"
 #include "../camera/CameraUtils.h"
 
+#include <glm/gtc/matrix_transform.hpp>
+
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 namespace vk {
 
@@ -17,11 +22,13 @@ namespace vk {
         : device(device), settings(settings) {
         
         instanceCount++;
+
+        this->settings.cascadeCount = std::clamp(settings.cascadeCount, 1u, MAX_CASCADES);
         
         createDescriptorSetLayoutIfNeeded(device);
         createDepthResources();
         createRenderPass();
-        createFramebuffer();
+        createFramebuffers();
         createShadowUboBuffers();
         createDescriptorSets();
         
@@ -31,6 +38,7 @@ namespace vk {
             settings.bias,
             settings.shadowStrength
         );
+        shadowUbo.cascadeParams = glm::vec4(static_cast<float>(this->settings.cascadeCount), 0.0f, 0.0f, 0.0f);
     }
     
     ShadowMap::~ShadowMap() {
@@ -59,21 +67,42 @@ namespace vk {
                 destructionQueue->pushImageView(depthImageView);
                 depthImageView = VK_NULL_HANDLE;
             }
+
+            for (auto* views : { &cascadeImageViews, &staticImageViews }) {
+                for (auto& view : *views) {
+                    if (view != VK_NULL_HANDLE) {
+                        destructionQueue->pushImageView(view);
+                        view = VK_NULL_HANDLE;
+                    }
+                }
+            }
             
             if (depthImage != VK_NULL_HANDLE && depthImageMemory != VK_NULL_HANDLE) {
                 destructionQueue->pushImage(depthImage, depthImageMemory);
                 depthImage = VK_NULL_HANDLE;
                 depthImageMemory = VK_NULL_HANDLE;
             }
+
+            if (staticImage != VK_NULL_HANDLE && staticImageMemory != VK_NULL_HANDLE) {
+                destructionQueue->pushImage(staticImage, staticImageMemory);
+                staticImage = VK_NULL_HANDLE;
+                staticImageMemory = VK_NULL_HANDLE;
+            }
             
-            if (framebuffer != VK_NULL_HANDLE) {
-                destructionQueue->pushFramebuffer(framebuffer);
-                framebuffer = VK_NULL_HANDLE;
+            for (auto* buffers : { &framebuffers, &staticFramebuffers }) {
+                for (auto& framebuffer : *buffers) {
+                    if (framebuffer != VK_NULL_HANDLE) {
+                        destructionQueue->pushFramebuffer(framebuffer);
+                        framebuffer = VK_NULL_HANDLE;
+                    }
+                }
             }
             
-            if (renderPass != VK_NULL_HANDLE) {
-                destructionQueue->pushRenderPass(renderPass);
-                renderPass = VK_NULL_HANDLE;
+            for (auto* pass : { &renderPass, &staticRenderPass, &dynamicRenderPass }) {
+                if (*pass != VK_NULL_HANDLE) {
+                    destructionQueue->pushRenderPass(*pass);
+                    *pass = VK_NULL_HANDLE;
+                }
             }
         } else {
             cleanup();
@@ -87,14 +116,20 @@ namespace vk {
     }
     
     void ShadowMap::cleanup() {
-        if (framebuffer != VK_NULL_HANDLE) {
-            vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
-            framebuffer = VK_NULL_HANDLE;
+        for (auto* buffers : { &framebuffers, &staticFramebuffers }) {
+            for (auto& framebuffer : *buffers) {
+                if (framebuffer != VK_NULL_HANDLE) {
+                    vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+                    framebuffer = VK_NULL_HANDLE;
+                }
+            }
         }
         
-        if (renderPass != VK_NULL_HANDLE) {
-            vkDestroyRenderPass(device.device(), renderPass, nullptr);
-            renderPass = VK_NULL_HANDLE;
+        for (auto* pass : { &renderPass, &staticRenderPass, &dynamicRenderPass }) {
+            if (*pass != VK_NULL_HANDLE) {
+                vkDestroyRenderPass(device.device(), *pass, nullptr);
+                *pass = VK_NULL_HANDLE;
+            }
         }
         
         if (depthSampler != VK_NULL_HANDLE) {
@@ -106,15 +141,26 @@ namespace vk {
             vkDestroyImageView(device.device(), depthImageView, nullptr);
             depthImageView = VK_NULL_HANDLE;
         }
-        
-        if (depthImage != VK_NULL_HANDLE) {
-            vkDestroyImage(device.device(), depthImage, nullptr);
-            depthImage = VK_NULL_HANDLE;
+
+        for (auto* views : { &cascadeImageViews, &staticImageViews }) {
+            for (auto& view : *views) {
+                if (view != VK_NULL_HANDLE) {
+                    vkDestroyImageView(device.device(), view, nullptr);
+                    view = VK_NULL_HANDLE;
+                }
+            }
         }
         
-        if (depthImageMemory != VK_NULL_HANDLE) {
-            vkFreeMemory(device.device(), depthImageMemory, nullptr);
-            depthImageMemory = VK_NULL_HANDLE;
+        for (auto [image, memory] : { std::make_pair(&depthImage, &depthImageMemory), std::make_pair(&staticImage, &staticImageMemory) }) {
+            if (*image != VK_NULL_HANDLE) {
+                vkDestroyImage(device.device(), *image, nullptr);
+                *image = VK_NULL_HANDLE;
+            }
+            
+            if (*memory != VK_NULL_HANDLE) {
+                vkFreeMemory(device.device(), *memory, nullptr);
+                *memory = VK_NULL_HANDLE;
+            }
         }
     }
     
@@ -135,12 +181,7 @@ namespace vk {
         }
     }
     
-    void ShadowMap::createDepthResources() {
-        VkFormat depthFormat = device.findSupportedFormat(
-            {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-        
+    void ShadowMap::createLayeredDepthImage(VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory, std::array<VkImageView, MAX_CASCADES>& layerViews) {
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -148,30 +189,64 @@ namespace vk {
         imageInfo.extent.height = settings.height;
         imageInfo.extent.depth = 1;
         imageInfo.mipLevels = 1;
-        imageInfo.arrayLayers = 1;
+        imageInfo.arrayLayers = settings.cascadeCount;
         imageInfo.format = depthFormat;
         imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
         imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.usage = usage;
         imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         
         device.createImageWithInfo(
             imageInfo,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            depthImage,
-            depthImageMemory);
+            image,
+            memory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = depthFormat;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        for (uint32_t i = 0; i < settings.cascadeCount; i++) {
+            viewInfo.subresourceRange.baseArrayLayer = i;
+
+            if (vkCreateImageView(device.device(), &viewInfo, nullptr, &layerViews[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create shadow cascade image view");
+            }
+        }
+    }
+    
+    void ShadowMap::createDepthResources() {
+        depthFormat = device.findSupportedFormat(
+            {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        if (settings.cacheStaticCasters) {
+            usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            createLayeredDepthImage(
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                staticImage, staticImageMemory, staticImageViews);
+        }
+        createLayeredDepthImage(usage, depthImage, depthImageMemory, cascadeImageViews);
         
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         viewInfo.image = depthImage;
-        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
         viewInfo.format = depthFormat;
         viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
         viewInfo.subresourceRange.baseMipLevel = 0;
         viewInfo.subresourceRange.levelCount = 1;
         viewInfo.subresourceRange.baseArrayLayer = 0;
-        viewInfo.subresourceRange.layerCount = 1;
+        viewInfo.subresourceRange.layerCount = settings.cascadeCount;
         
         if (vkCreateImageView(device.device(), &viewInfo, nullptr, &depthImageView) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create shadow map depth image view");
@@ -198,30 +273,21 @@ namespace vk {
         if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &depthSampler) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create shadow map sampler");
         }
-        
-        // transition to a layout suitable for attachment
-        device.transitionImageLayout(
-            depthImage,
-            depthFormat,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+        // no initial transition here, the render graph moves the layers into their first layout
     }
     
-    void ShadowMap::createRenderPass() {
-        VkFormat depthFormat = device.findSupportedFormat(
-            {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-        
+    VkRenderPass ShadowMap::createDepthRenderPass(VkAttachmentLoadOp loadOp) const {
+        // starts and ends as an attachment, the render graph transitions the layers for copies and sampling
         VkAttachmentDescription depthAttachment{};
         depthAttachment.format = depthFormat;
         depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.loadOp = loadOp;
         depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
         
         VkAttachmentReference depthAttachmentRef{};
         depthAttachmentRef.attachment = 0;
@@ -232,42 +298,81 @@ namespace vk {
         subpass.colorAttachmentCount = 0;
         subpass.pDepthStencilAttachment = &depthAttachmentRef;
         
-        VkSubpassDependency dependency{};
-        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-        dependency.dstSubpass = 0;
-        dependency.srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        dependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-        dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-        
         VkRenderPassCreateInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
         renderPassInfo.attachmentCount = 1;
         renderPassInfo.pAttachments = &depthAttachment;
         renderPassInfo.subpassCount = 1;
         renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
         
-        if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        VkRenderPass pass;
+        if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &pass) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create shadow map render pass");
         }
+        return pass;
     }
     
-    void ShadowMap::createFramebuffer() {
+    void ShadowMap::createRenderPass() {
+        renderPass = createDepthRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR);
+
+        if (!settings.cacheStaticCasters) {
+            return;
+        }
+
+        staticRenderPass = createDepthRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR);
+
+        // keeps the copied static depth and adds dynamic casters on top
+        dynamicRenderPass = createDepthRenderPass(VK_ATTACHMENT_LOAD_OP_LOAD);
+    }
+    
+    void ShadowMap::createFramebuffers() {
         VkFramebufferCreateInfo framebufferInfo{};
         framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = renderPass;
         framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = &depthImageView;
         framebufferInfo.width = settings.width;
         framebufferInfo.height = settings.height;
         framebufferInfo.layers = 1;
-        
-        if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create shadow map framebuffer");
+
+        // the dynamic pass is compatible with renderPass, so the same framebuffers are used for both
+        for (uint32_t i = 0; i < settings.cascadeCount; i++) {
+            framebufferInfo.renderPass = renderPass;
+            framebufferInfo.pAttachments = &cascadeImageViews[i];
+            
+            if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create shadow map framebuffer");
+            }
+
+            if (settings.cacheStaticCasters) {
+                framebufferInfo.renderPass = staticRenderPass;
+                framebufferInfo.pAttachments = &staticImageViews[i];
+
+                if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &staticFramebuffers[i]) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to create shadow cache framebuffer");
+                }
+            }
+        }
+    }
+
+    VkImageSubresourceRange ShadowMap::getCascadeRange(uint32_t cascade) const {
+        // layout transitions of combined depth stencil formats have to include both aspects
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || depthFormat == VK_FORMAT_D24_UNORM_S8_UINT) {
+            aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
         }
+        return { aspect, 0, 1, cascade, 1 };
+    }
+
+    void ShadowMap::copyStaticCache(VkCommandBuffer commandBuffer, uint32_t cascade) const {
+        VkImageCopy region{};
+        region.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, cascade, 1 };
+        region.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, cascade, 1 };
+        region.extent = { settings.width, settings.height, 1 };
+
+        vkCmdCopyImage(
+            commandBuffer,
+            staticImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            depthImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &region);
     }
     
     void ShadowMap::createShadowUboBuffers() {
@@ -317,28 +422,126 @@ namespace vk {
         return descriptorInfo;
     }
     
-    void ShadowMap::updateShadowUbo(int frameIndex) {
-        SceneManager& sceneManager = SceneManager::getInstance();
-        
-        auto sun = sceneManager.getSun();
-        auto player = sceneManager.getPlayer();
-        
-        if (!sun || !player) {
+    void ShadowMap::updateCascades(int frameIndex, const glm::mat4& cameraView, const glm::mat4& cameraProjection) {
+        auto sun = SceneManager::getInstance().getSun();
+        if (!sun) {
             return;
         }
-        
-        glm::vec3 playerPos = player->getPosition();
-        
-        shadowUbo.lightViewMatrix = sun->computeLightViewMatrix();
 
-        float sunToPlayerDistance = glm::length(sun->getPosition() - playerPos);
-        float effectiveFarPlane = sunToPlayerDistance * 1.5f;
-        
-        shadowUbo.lightProjectionMatrix = getOrthographicProjection(
-            -settings.orthoSize, settings.orthoSize,
-            -settings.orthoSize, settings.orthoSize,
-            settings.nearPlane, effectiveFarPlane
-        );
+        // frustum corners in world space, near plane at ndc z = 0 and far plane at z = 1
+        glm::mat4 invViewProj = glm::inverse(cameraProjection * cameraView);
+        glm::vec3 nearCorners[4];
+        glm::vec3 farCorners[4];
+        const glm::vec2 ndc[4] = { {-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f} };
+        for (int i = 0; i < 4; i++) {
+            glm::vec4 n = invViewProj * glm::vec4(ndc[i], 0.0f, 1.0f);
+            glm::vec4 f = invViewProj * glm::vec4(ndc[i], 1.0f, 1.0f);
+            nearCorners[i] = glm::vec3(n) / n.w;
+            farCorners[i] = glm::vec3(f) / f.w;
+        }
+
+        // view space depth of the camera planes, the view looks down -z
+        float cameraNear = -(cameraView * glm::vec4(nearCorners[0], 1.0f)).z;
+        float cameraFar = -(cameraView * glm::vec4(farCorners[0], 1.0f)).z;
+        float shadowFar = std::min(settings.shadowDistance, cameraFar);
+
+        bool cacheEnabled = settings.cacheStaticCasters;
+
+        // small sun rotations keep the fitted light direction so cached cascades stay valid
+        glm::vec3 sunDir = glm::normalize(sun->getDirection());
+        if (!cacheEnabled || glm::dot(sunDir, cachedLightDir) < std::cos(settings.cacheLightAngleThreshold)) {
+            cachedLightDir = sunDir;
+        }
+
+        // static casters were added or removed
+        uint64_t staticSceneVersion = SceneManager::getInstance().getStaticSceneVersion();
+        if (staticSceneVersion != cachedStaticSceneVersion) {
+            cachedStaticSceneVersion = staticSceneVersion;
+            for (auto& cascade : cascades) {
+                cascade.staticValid = false;
+            }
+        }
+
+        // rotation only, cascades are placed in light space so identical placements give identical matrices
+        glm::vec3 up = glm::abs(cachedLightDir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), cachedLightDir, up);
+
+        uint32_t refreshBudget = settings.maxStaticRefreshesPerFrame;
+
+        float splitNear = cameraNear;
+        for (uint32_t c = 0; c < settings.cascadeCount; c++) {
+            // practical split scheme, blend of logarithmic and uniform splits
+            float p = static_cast<float>(c + 1) / static_cast<float>(settings.cascadeCount);
+            float logSplit = cameraNear * std::pow(shadowFar / cameraNear, p);
+            float uniformSplit = cameraNear + (shadowFar - cameraNear) * p;
+            float splitFar = settings.splitLambda * logSplit + (1.0f - settings.splitLambda) * uniformSplit;
+
+            // depth is linear along each corner ray
+            float t0 = (splitNear - cameraNear) / (cameraFar - cameraNear);
+            float t1 = (splitFar - cameraNear) / (cameraFar - cameraNear);
+
+            glm::vec3 sliceCorners[8];
+            glm::vec3 center{0.0f};
+            for (int i = 0; i < 4; i++) {
+                sliceCorners[i] = glm::mix(nearCorners[i], farCorners[i], t0);
+                sliceCorners[i + 4] = glm::mix(nearCorners[i], farCorners[i], t1);
+                center += sliceCorners[i] + sliceCorners[i + 4];
+            }
+            center /= 8.0f;
+
+            // bounding sphere keeps the projection size constant while the camera rotates
+            float radius = 0.0f;
+            for (const auto& corner : sliceCorners) {
+                radius = std::max(radius, glm::length(corner - center));
+            }
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            // cached cascades get a margin, so the slice stays covered while the camera moves less than one step
+            float margin = cacheEnabled ? settings.cacheMargin * radius : 0.0f;
+            float extent = radius + margin;
+            float texelSize = 2.0f * extent / static_cast<float>(settings.width);
+            float step = std::max(texelSize, std::floor(margin / texelSize) * texelSize);
+
+            // snapping to whole texels keeps shadows from shimmering, whole steps keep the cache valid
+            glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+            lightCenter = glm::floor(lightCenter / step + 0.5f) * step;
+
+            // the projection flips y and z of the light view space
+            float depthCenter = -lightCenter.z;
+            glm::mat4 lightProjection = getOrthographicProjection(
+                lightCenter.x - extent, lightCenter.x + extent,
+                -lightCenter.y - extent, -lightCenter.y + extent,
+                depthCenter - extent - settings.casterDistance, depthCenter + extent
+            );
+
+            Cascade& cascade = cascades[c];
+            cascade.refreshStatic = false;
+
+            bool placementChanged = cascade.lightViewMatrix != lightView || cascade.lightProjectionMatrix != lightProjection;
+            if (!cacheEnabled || !cascade.staticValid || placementChanged) {
+                // an outdated but valid cache keeps its old placement until its refresh slot comes up
+                bool refreshNow = !cacheEnabled || !cascade.staticValid || refreshBudget > 0;
+                if (refreshNow) {
+                    if (cacheEnabled && cascade.staticValid) {
+                        refreshBudget--;
+                    }
+                    cascade.lightViewMatrix = lightView;
+                    cascade.lightProjectionMatrix = lightProjection;
+                    cascade.refreshStatic = cacheEnabled;
+                    cascade.staticValid = cacheEnabled;
+                }
+            }
+
+            cascade.splitFar = splitFar;
+            cascade.texelSize = texelSize;
+            cascade.minCasterRadius = (c == 0) ? 0.0f : settings.minCasterTexels * cascade.texelSize;
+            cascade.tessellationScale = std::pow(settings.tessellationFalloff, static_cast<float>(c));
+
+            shadowUbo.cascadeViewProjection[c] = cascade.lightProjectionMatrix * cascade.lightViewMatrix;
+            shadowUbo.cascadeSplits[c] = splitFar;
+
+            splitNear = splitFar;
+        }
         
         shadowUboBuffers[frameIndex]->writeToBuffer(&shadowUbo);
         shadowUboBuffers[frameIndex]->flush();
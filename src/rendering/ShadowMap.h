@@ -8,26 +8,58 @@
 #include <memory>
 #include <glm/glm.hpp>
 #include <vector>
+#include <array>
 
 namespace vk {
 
 class ShadowMap {
 public:
+    static constexpr uint32_t MAX_CASCADES = 4;
+
+    // must match ShadowUbo in the shaders sampling the shadow map
     struct ShadowUbo {
-        glm::mat4 lightViewMatrix{1.0f};
-        glm::mat4 lightProjectionMatrix{1.0f};
+        glm::mat4 cascadeViewProjection[MAX_CASCADES];
+        // view space far distance of each cascade
+        glm::vec4 cascadeSplits{0.0f};
         // x: shadow map size, y: PCF samples, z: bias, w: shadow strength
         glm::vec4 shadowParams{0.0f};
+        // x: cascade count, yzw = unused
+        glm::vec4 cascadeParams{0.0f};
+    };
+
+    // cpu side data used to render one cascade
+    struct Cascade {
+        glm::mat4 lightViewMatrix{1.0f};
+        glm::mat4 lightProjectionMatrix{1.0f};
+        float splitFar = 0.0f;
+        // world space size of one shadow map texel
+        float texelSize = 0.0f;
+        // casters with a smaller bounding radius are skipped in this cascade
+        float minCasterRadius = 0.0f;
+        // scales max terrain tessellation while rendering this cascade
+        float tessellationScale = 1.0f;
+        // static casters have to be rendered into the cache layer this frame
+        bool refreshStatic = false;
+        // cache layer holds the static casters for the matrices above
+        bool staticValid = false;
     };
 
     struct ShadowMapSettings {
-        uint32_t width = 2048;
+        uint32_t width = 2048; // per cascade
         uint32_t height = 2048;
         float bias = 0.005f; // prevent shadow acne
         int pcfSamples = 3; // antialiasing for shadows (1 = no PCF, 2 = 2x2, 3 = 3x3, etc.)
         float shadowStrength = 0.9f;  // [0,1]
-        float orthoSize = 50.0f; // size of the orthographic projection (left/right/top/bottom)
-        float nearPlane = 1.0f;
+        uint32_t cascadeCount = MAX_CASCADES;
+        float shadowDistance = 250.0f; // view distance covered by the last cascade
+        float splitLambda = 0.75f; // 0 = uniform splits, 1 = logarithmic splits
+        float casterDistance = 150.0f; // extra depth towards the sun so casters outside the view still throw shadows
+        float minCasterTexels = 2.0f; // casters covering fewer texels are skipped, not applied to the first cascade
+        float tessellationFalloff = 0.5f; // terrain tessellation multiplier per cascade step
+        bool cacheStaticCasters = true; // keep static casters in a cache layer that is only re-rendered when needed
+        float cacheLightAngleThreshold = 0.01f; // radians the sun may rotate before the cache is rebuilt
+        float cacheMargin = 0.25f; // fraction of the cascade radius the camera may move before the cache is rebuilt
+        uint32_t maxStaticRefreshesPerFrame = 1; // outdated (but valid) cache layers rebuilt per frame
     };
 
     ShadowMap(Device& device, ShadowMapSettings settings = {});
@@ -36,9 +68,36 @@ public:
     ShadowMap(const ShadowMap&) = delete;
     ShadowMap& operator=(const ShadowMap&) = delete;
     
+    // clears the cascade, used when static casters are not cached
     VkRenderPass getRenderPass() const { return renderPass; }
+
+    bool cachesStaticCasters() const { return settings.cacheStaticCasters; }
+
+    // renders static casters into the cache layer of a cascade
+    VkRenderPass getStaticRenderPass() const { return staticRenderPass; }
+
+    VkFramebuffer getStaticFramebuffer(uint32_t cascade) const { return staticFramebuffers[cascade]; }
+
+    // renders dynamic casters on top of the copied cache layer
+    VkRenderPass getDynamicRenderPass() const { return dynamicRenderPass; }
+
+    // records the copy of the cache layer into the sampled layer, call outside of a render pass
+    // expects the cache layer in TRANSFER_SRC_OPTIMAL and the sampled layer in TRANSFER_DST_OPTIMAL
+    void copyStaticCache(VkCommandBuffer commandBuffer, uint32_t cascade) const;
+
+    // sampled by the main pass, one layer per cascade
+    VkImage getImage() const { return depthImage; }
+
+    VkImage getStaticImage() const { return staticImage; }
+
+    // the same layer of the sampled and the cache image
+    VkImageSubresourceRange getCascadeRange(uint32_t cascade) const;
     
-    VkFramebuffer getFramebuffer() const { return framebuffer; }
+    VkFramebuffer getFramebuffer(uint32_t cascade) const { return framebuffers[cascade]; }
+
+    uint32_t getCascadeCount() const { return settings.cascadeCount; }
+
+    const Cascade& getCascade(uint32_t cascade) const { return cascades[cascade]; }
     
     VkExtent2D getExtent() const { return {settings.width, settings.height}; }
     
@@ -46,7 +105,8 @@ public:
     
     VkDescriptorImageInfo getDescriptorInfo() const;
     
-    void updateShadowUbo(int frameIndex);
+    // fits one stable, texel snapped orthographic projection per slice of the camera frustum
+    void updateCascades(int frameIndex, const glm::mat4& cameraView, const glm::mat4& cameraProjection);
     
     const ShadowUbo& getShadowUbo() const { return shadowUbo; }
     
@@ -57,7 +117,9 @@ public:
 private:
     void createDepthResources();
     void createRenderPass();
-    void createFramebuffer();
+    VkRenderPass createDepthRenderPass(VkAttachmentLoadOp loadOp) const;
+    void createLayeredDepthImage(VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory, std::array<VkImageView, MAX_CASCADES>& layerViews);
+    void createFramebuffers();
     void cleanup();
     
     void createDescriptorSetLayoutIfNeeded(Device& device);
@@ -68,6 +130,11 @@ private:
     Device& device;
     ShadowMapSettings settings;
     ShadowUbo shadowUbo;
+    std::array<Cascade, MAX_CASCADES> cascades;
+
+    // light direction the cascades were fitted to, follows the sun in steps of cacheLightAngleThreshold
+    glm::vec3 cachedLightDir{0.0f};
+    uint64_t cachedStaticSceneVersion = ~0ull;
     
     std::vector<std::unique_ptr<Buffer>> shadowUboBuffers;
     std::vector<VkDescriptorSet> shadowDescriptorSets;
@@ -78,11 +145,23 @@ private:
 
     VkImage depthImage{VK_NULL_HANDLE};
     VkDeviceMemory depthImageMemory{VK_NULL_HANDLE};
+    // array view for sampling, one view per layer for rendering
     VkImageView depthImageView{VK_NULL_HANDLE};
+    std::array<VkImageView, MAX_CASCADES> cascadeImageViews{};
     VkSampler depthSampler{VK_NULL_HANDLE};
+    VkFormat depthFormat{VK_FORMAT_UNDEFINED};
+
+    // static caster cache, one layer per cascade, only read by copies
+    VkImage staticImage{VK_NULL_HANDLE};
+    VkDeviceMemory staticImageMemory{VK_NULL_HANDLE};
+    std::array<VkImageView, MAX_CASCADES> staticImageViews{};
 
     VkRenderPass renderPass{VK_NULL_HANDLE};
-    VkFramebuffer framebuffer{VK_NULL_HANDLE};
+    std::array<VkFramebuffer, MAX_CASCADES> framebuffers{};
+
+    VkRenderPass staticRenderPass{VK_NULL_HANDLE};
+    VkRenderPass dynamicRenderPass{VK_NULL_HANDLE};
+    std::array<VkFramebuffer, MAX_CASCADES> staticFramebuffers{};
 };
 
 }
\ No newline at end of file
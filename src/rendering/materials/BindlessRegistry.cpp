@@ -0,0 +1,223 @@
+#include "BindlessRegistry.h"
+#include "../../Engine.h"
+
+#include <stdexcept>
+#include <iostream>
+
+namespace vk {
+
+	std::unique_ptr<BindlessRegistry> BindlessRegistry::instance;
+	int BindlessRegistry::refCount = 0;
+
+	BindlessRegistry& BindlessRegistry::acquire(Device& device) {
+		if (!instance) {
+			std::cout << "BindlessRegistry: Creating texture and material tables" << std::endl;
+			instance = std::make_unique<BindlessRegistry>(device);
+		}
+		refCount++;
+		return *instance;
+	}
+
+	void BindlessRegistry::release() {
+		refCount--;
+		if (refCount == 0 && instance) {
+			std::cout << "BindlessRegistry: Last user released, cleaning up" << std::endl;
+			instance.reset();
+		}
+	}
+
+	BindlessRegistry::BindlessRegistry(Device& device) : device(device) {
+		if (!device.supportsBindless()) {
+			throw std::runtime_error("BindlessRegistry: device does not support descriptor indexing");
+		}
+		createDescriptorResources();
+	}
+
+	BindlessRegistry::~BindlessRegistry() {
+		scheduleDestroy();
+	}
+
+	void BindlessRegistry::createDescriptorResources() {
+		std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+		bindings[0].binding = 0;
+		bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindings[0].descriptorCount = MAX_TEXTURES;
+		bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		bindings[1].binding = 1;
+		bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[1].descriptorCount = 1;
+		bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		// texture slots are filled in while earlier frames are still in flight
+		std::array<VkDescriptorBindingFlags, 2> bindingFlags{
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT,
+			0
+		};
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &bindingFlagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		if (vkCreateDescriptorSetLayout(device.device(), &layoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create bindless descriptor set layout!");
+		}
+
+		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		poolSizes[0] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURES * SwapChain::MAX_FRAMES_IN_FLIGHT };
+		poolSizes[1] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT };
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = SwapChain::MAX_FRAMES_IN_FLIGHT;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+
+		if (vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create bindless descriptor pool!");
+		}
+
+		for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+			VkDescriptorSetAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorPool = pool;
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.pSetLayouts = &setLayout;
+
+			if (vkAllocateDescriptorSets(device.device(), &allocInfo, &sets[i]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate bindless descriptor set!");
+			}
+
+			materialBuffers[i] = std::make_unique<Buffer>(device,
+				sizeof(MaterialParams),
+				MAX_MATERIALS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			materialBuffers[i]->map();
+
+			VkDescriptorBufferInfo bufferInfo = materialBuffers[i]->descriptorInfo();
+
+			VkWriteDescriptorSet write{};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = sets[i];
+			write.dstBinding = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.descriptorCount = 1;
+			write.pBufferInfo = &bufferInfo;
+			vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+		}
+	}
+
+	void BindlessRegistry::scheduleDestroy() {
+		auto* destructionQueue = Engine::getDestructionQueue();
+
+		for (auto& buffer : materialBuffers) {
+			if (buffer && destructionQueue) {
+				buffer->scheduleDestroy(*destructionQueue);
+			}
+			buffer.reset();
+		}
+
+		// sets are freed together with their pool
+		if (destructionQueue) {
+			destructionQueue->pushDescriptorPool(pool);
+			destructionQueue->pushDescriptorSetLayout(setLayout);
+		} else {
+			vkDestroyDescriptorPool(device.device(), pool, nullptr);
+			vkDestroyDescriptorSetLayout(device.device(), setLayout, nullptr);
+		}
+		pool = VK_NULL_HANDLE;
+		setLayout = VK_NULL_HANDLE;
+		sets.fill(VK_NULL_HANDLE);
+	}
+
+	uint32_t BindlessRegistry::registerTexture(VkImageView imageView, VkSampler sampler) {
+		uint32_t textureIndex;
+		if (!freeTextures.empty()) {
+			textureIndex = freeTextures.back();
+			freeTextures.pop_back();
+		} else if (nextTexture < MAX_TEXTURES) {
+			textureIndex = nextTexture++;
+		} else {
+			throw std::runtime_error("BindlessRegistry: out of texture slots");
+		}
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = imageView;
+		imageInfo.sampler = sampler;
+
+		// the slot is unused by every pending frame, so all sets can be written right away
+		std::array<VkWriteDescriptorSet, SwapChain::MAX_FRAMES_IN_FLIGHT> writes{};
+		for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = sets[i];
+			writes[i].dstBinding = 0;
+			writes[i].dstArrayElement = textureIndex;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			writes[i].descriptorCount = 1;
+			writes[i].pImageInfo = &imageInfo;
+		}
+		vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+		return textureIndex;
+	}
+
+	void BindlessRegistry::releaseTexture(uint32_t textureIndex) {
+		if (textureIndex != INVALID_INDEX) {
+			pendingFreeTextures[currentFrame].push_back(textureIndex);
+		}
+	}
+
+	uint32_t BindlessRegistry::allocateMaterial() {
+		if (!freeMaterials.empty()) {
+			uint32_t materialIndex = freeMaterials.back();
+			freeMaterials.pop_back();
+			return materialIndex;
+		}
+		if (nextMaterial >= MAX_MATERIALS) {
+			throw std::runtime_error("BindlessRegistry: out of material slots");
+		}
+		return nextMaterial++;
+	}
+
+	void BindlessRegistry::releaseMaterial(uint32_t materialIndex) {
+		if (materialIndex != INVALID_INDEX) {
+			pendingFreeMaterials[currentFrame].push_back(materialIndex);
+		}
+	}
+
+	void BindlessRegistry::writeMaterial(int frameIndex, uint32_t materialIndex, const MaterialParams& params) {
+		// host coherent, no flush needed
+		materialBuffers[frameIndex]->writeToIndex(const_cast<MaterialParams*>(&params), static_cast<int>(materialIndex));
+	}
+
+	DescriptorSet BindlessRegistry::getDescriptorSet(int frameIndex) const {
+		DescriptorSet descriptorSet{};
+		descriptorSet.binding = 1;
+		descriptorSet.handle = sets[frameIndex];
+		descriptorSet.layout = setLayout;
+		return descriptorSet;
+	}
+
+	void BindlessRegistry::beginFrame(int frameIndex) {
+		currentFrame = frameIndex;
+
+		auto& textures = pendingFreeTextures[frameIndex];
+		freeTextures.insert(freeTextures.end(), textures.begin(), textures.end());
+		textures.clear();
+
+		auto& materials = pendingFreeMaterials[frameIndex];
+		freeMaterials.insert(freeMaterials.end(), materials.begin(), materials.end());
+		materials.clear();
+	}
+}
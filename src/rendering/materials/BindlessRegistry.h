@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../../vk/vk_device.h"
+#include "../../vk/vk_buffer.h"
+#include "../../vk/vk_descriptors.h"
+#include "../../vk/vk_swap_chain.h"
+
+#include <glm/glm.hpp>
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace vk {
+
+	// one descriptor set (per frame in flight) shared by all bindless materials
+	// binding 0: sampler2D textures[MAX_TEXTURES], indexed by texture slot
+	// binding 1: storage buffer with MaterialParams[MAX_MATERIALS], indexed by material slot
+	// materials only differ by the index carried in the push constants, so descriptor binds stay constant per frame
+	class BindlessRegistry {
+	   public:
+		static constexpr uint32_t MAX_TEXTURES = 4096;
+		static constexpr uint32_t MAX_MATERIALS = 4096;
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+
+		// std430 layout, must match MaterialParams in texture_shader_bindless.frag
+		struct MaterialParams {
+			// x = ka, y = kd, z = ks, w = alpha
+			glm::vec4 lightingProperties{ 0.15f, 0.6f, 0.25f, 10.0f };
+			// x = hasTexture, yzw = unused
+			glm::vec4 flags{ 0.0f };
+			// x = albedo texture slot, yzw = unused
+			glm::uvec4 textureIndices{ INVALID_INDEX };
+		};
+
+		// refcounted like the static material resources, the registry lives while any bindless material exists
+		static BindlessRegistry& acquire(Device& device);
+		static void release();
+		// nullptr if no bindless material was created yet
+		static BindlessRegistry* get() { return instance.get(); }
+
+		BindlessRegistry(Device& device);
+		~BindlessRegistry();
+
+		BindlessRegistry(const BindlessRegistry&) = delete;
+		BindlessRegistry& operator=(const BindlessRegistry&) = delete;
+
+		uint32_t registerTexture(VkImageView imageView, VkSampler sampler);
+		void releaseTexture(uint32_t textureIndex);
+
+		uint32_t allocateMaterial();
+		void releaseMaterial(uint32_t materialIndex);
+		void writeMaterial(int frameIndex, uint32_t materialIndex, const MaterialParams& params);
+
+		// same binding as the per-material sets it replaces
+		DescriptorSet getDescriptorSet(int frameIndex) const;
+
+		// recycles slots released while frameIndex was last recorded, call after that frame's fence was waited on
+		void beginFrame(int frameIndex);
+
+	   private:
+		void createDescriptorResources();
+		void scheduleDestroy();
+
+		static std::unique_ptr<BindlessRegistry> instance;
+		static int refCount;
+
+		Device& device;
+
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		std::array<VkDescriptorSet, SwapChain::MAX_FRAMES_IN_FLIGHT> sets{};
+		std::array<std::unique_ptr<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> materialBuffers;
+
+		uint32_t nextTexture = 0;
+		uint32_t nextMaterial = 0;
+		std::vector<uint32_t> freeTextures;
+		std::vector<uint32_t> freeMaterials;
+
+		// slots may still be referenced by frames in flight, so they are only reused one full cycle later
+		int currentFrame = 0;
+		std::array<std::vector<uint32_t>, SwapChain::MAX_FRAMES_IN_FLIGHT> pendingFreeTextures;
+		std::array<std::vector<uint32_t>, SwapChain::MAX_FRAMES_IN_FLIGHT> pendingFreeMaterials;
+	};
+}
@@ -0,0 +1,280 @@
+#include "ImpostorMaterial.h"
+#include "../../Engine.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <cstddef>
+#include <cstring>
+
+namespace vk {
+
+	std::unique_ptr<DescriptorPool> ImpostorMaterial::descriptorPool = nullptr;
+	std::unique_ptr<DescriptorSetLayout> ImpostorMaterial::descriptorSetLayout = nullptr;
+	int ImpostorMaterial::instanceCount = 0;
+
+    ImpostorMaterial::ImpostorMaterial(Device& device, const AtlasCreationData& creationData)
+        : Material(device) {
+        if (!creationData.albedo || !creationData.normals) {
+            throw std::runtime_error("ImpostorMaterial needs an atlas");
+        }
+
+        instanceCount++;
+
+        createDescriptorSetLayoutIfNeeded(device);
+
+        // no mip maps, lower levels would bleed neighbouring frames into each other
+        createAtlasImage(*creationData.albedo, creationData.atlasSize, VK_FORMAT_R8G8B8A8_SRGB, albedoImage, albedoImageMemory);
+        albedoImageView = device.createImageView(albedoImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
+        createAtlasImage(*creationData.normals, creationData.atlasSize, VK_FORMAT_R8G8B8A8_UNORM, normalImage, normalImageMemory);
+        normalImageView = device.createImageView(normalImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+        createTextureSampler();
+
+        impostorData.atlasParams = glm::vec4(
+            float(creationData.framesPerSide),
+            float(creationData.slotSize) / float(creationData.atlasSize),
+            creationData.impostorDistance,
+            0.0f);
+
+        createDescriptorSets();
+
+        VkVertexInputBindingDescription instanceBinding{};
+        instanceBinding.binding = 1;
+        instanceBinding.stride = sizeof(Instance);
+        instanceBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        pipelineConfig.bindingDescriptions.push_back(instanceBinding);
+
+        pipelineConfig.attributeDescriptions.push_back({ 4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Instance, positionScale) });
+        pipelineConfig.attributeDescriptions.push_back({ 5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Instance, centerRadius) });
+        pipelineConfig.attributeDescriptions.push_back({ 6, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Instance, slotOffset) });
+
+        pipelineConfig.vertShaderPath = "impostor_shader.vert";
+        pipelineConfig.fragShaderPath = "impostor_shader.frag";
+        // billboards always face the camera
+        pipelineConfig.rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+    }
+
+    ImpostorMaterial::~ImpostorMaterial() {
+        auto* destructionQueue = Engine::getDestructionQueue();
+        if (destructionQueue) {
+            for (int i = 0; i < descriptorSets.size(); i++) {
+                if (descriptorSets[i] != VK_NULL_HANDLE && descriptorPool) {
+                    destructionQueue->pushDescriptorSet(descriptorSets[i], descriptorPool->getPool());
+                    descriptorSets[i] = VK_NULL_HANDLE;
+                }
+            }
+
+            if (textureSampler != VK_NULL_HANDLE) {
+                destructionQueue->pushSampler(textureSampler);
+                textureSampler = VK_NULL_HANDLE;
+            }
+
+            for (VkImageView* view : { &albedoImageView, &normalImageView }) {
+                if (*view != VK_NULL_HANDLE) {
+                    destructionQueue->pushImageView(*view);
+                    *view = VK_NULL_HANDLE;
+                }
+            }
+
+            if (albedoImage != VK_NULL_HANDLE && albedoImageMemory != VK_NULL_HANDLE) {
+                destructionQueue->pushImage(albedoImage, albedoImageMemory);
+                albedoImage = VK_NULL_HANDLE;
+                albedoImageMemory = VK_NULL_HANDLE;
+            }
+            if (normalImage != VK_NULL_HANDLE && normalImageMemory != VK_NULL_HANDLE) {
+                destructionQueue->pushImage(normalImage, normalImageMemory);
+                normalImage = VK_NULL_HANDLE;
+                normalImageMemory = VK_NULL_HANDLE;
+            }
+
+            if (paramsBuffer) {
+                paramsBuffer->scheduleDestroy(*destructionQueue);
+            }
+        } else {
+            // fallback to immediate destruction if queue is not available
+            if (textureSampler != VK_NULL_HANDLE) {
+                vkDestroySampler(device.device(), textureSampler, nullptr);
+            }
+            for (VkImageView view : { albedoImageView, normalImageView }) {
+                if (view != VK_NULL_HANDLE) {
+                    vkDestroyImageView(device.device(), view, nullptr);
+                }
+            }
+            for (VkImage image : { albedoImage, normalImage }) {
+                if (image != VK_NULL_HANDLE) {
+                    vkDestroyImage(device.device(), image, nullptr);
+                }
+            }
+            for (VkDeviceMemory memory : { albedoImageMemory, normalImageMemory }) {
+                if (memory != VK_NULL_HANDLE) {
+                    vkFreeMemory(device.device(), memory, nullptr);
+                }
+            }
+        }
+
+        instanceCount--;
+        if (instanceCount == 0) {
+            std::cout << "Cleaning up ImpostorMaterial static resources" << std::endl;
+            cleanupResources();
+        }
+    }
+
+    void ImpostorMaterial::createDescriptorSetLayoutIfNeeded(Device& device) {
+        if (!descriptorSetLayout) {
+            descriptorSetLayout = DescriptorSetLayout::Builder(device)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+                .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+                .addBinding(2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
+                .build();
+
+            // one material per atlas state, shared by all streamed tiles, a few sets are plenty
+            descriptorPool = DescriptorPool::Builder(device)
+                .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+                .setMaxSets(8 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 16 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 8 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+                .build();
+        }
+    }
+
+    void ImpostorMaterial::createAtlasImage(const std::vector<unsigned char>& pixels, uint32_t size, VkFormat format, VkImage& image, VkDeviceMemory& imageMemory) {
+        VkDeviceSize imageSize = VkDeviceSize(size) * size * 4;
+        if (pixels.size() < imageSize) {
+            throw std::runtime_error("Impostor atlas data is smaller than the atlas");
+        }
+
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        device.createBuffer(
+            imageSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingBufferMemory);
+
+        void* data;
+        vkMapMemory(device.device(), stagingBufferMemory, 0, imageSize, 0, &data);
+        memcpy(data, pixels.data(), static_cast<size_t>(imageSize));
+        vkUnmapMemory(device.device(), stagingBufferMemory);
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = size;
+        imageInfo.extent.height = size;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+        device.createImageWithInfo(
+            imageInfo,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            image,
+            imageMemory);
+
+        device.transitionImageLayout(image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        device.copyBufferToImage(stagingBuffer, image, size, size, 1);
+        device.transitionImageLayout(image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        auto destructionQueue = Engine::getDestructionQueue();
+        if (destructionQueue) {
+            destructionQueue->pushBuffer(stagingBuffer, stagingBufferMemory);
+        } else {
+            vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
+            vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+        }
+    }
+
+    void ImpostorMaterial::createTextureSampler() {
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        // frames are packed edge to edge, never sample past a slot
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.anisotropyEnable = VK_FALSE;
+        samplerInfo.maxAnisotropy = 1.0f;
+        samplerInfo.borderColor = VK_BORDER_COLOR_INT_TRANSPARENT_BLACK;
+        samplerInfo.unnormalizedCoordinates = VK_FALSE;
+        samplerInfo.compareEnable = VK_FALSE;
+        samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.mipLodBias = 0.0f;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = 0.0f;
+
+        if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create impostor sampler!");
+        }
+    }
+
+    void ImpostorMaterial::createDescriptorSets() {
+        paramsBuffer = std::make_unique<Buffer>(device,
+            sizeof(ImpostorData),
+            1,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        paramsBuffer->map();
+        paramsBuffer->writeToBuffer(&impostorData);
+        paramsBuffer->unmap();
+
+        VkDescriptorImageInfo albedoInfo{};
+        albedoInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        albedoInfo.imageView = albedoImageView;
+        albedoInfo.sampler = textureSampler;
+
+        VkDescriptorImageInfo normalInfo{};
+        normalInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        normalInfo.imageView = normalImageView;
+        normalInfo.sampler = textureSampler;
+
+        auto paramsInfo = paramsBuffer->descriptorInfo();
+
+        for (int i = 0; i < descriptorSets.size(); i++) {
+            bool built = DescriptorWriter(*descriptorSetLayout, *descriptorPool)
+                .writeImage(0, &albedoInfo)
+                .writeImage(1, &normalInfo)
+                .writeBuffer(2, &paramsInfo)
+                .build(descriptorSets[i]);
+            if (!built) {
+                throw std::runtime_error("Failed to allocate impostor descriptor set");
+            }
+        }
+    }
+
+    void ImpostorMaterial::cleanupResources() {
+        auto destructionQueue = Engine::getDestructionQueue();
+
+        if (descriptorPool) {
+            if (destructionQueue) {
+                destructionQueue->pushDescriptorPool(descriptorPool->getPool());
+            } else {
+                descriptorPool->resetPool();
+            }
+            descriptorPool.reset();
+        }
+
+        if (descriptorSetLayout && descriptorSetLayout->getDescriptorSetLayout() != VK_NULL_HANDLE) {
+            if (destructionQueue) {
+                destructionQueue->pushDescriptorSetLayout(descriptorSetLayout->getDescriptorSetLayout());
+            }
+            descriptorSetLayout.reset();
+        }
+    }
+
+    DescriptorSet ImpostorMaterial::getDescriptorSet(int frameIndex) const {
+        DescriptorSet descriptorSet{};
+        descriptorSet.binding = 1;
+        descriptorSet.handle = descriptorSets[frameIndex];
+        descriptorSet.layout = descriptorSetLayout->getDescriptorSetLayout();
+
+        return descriptorSet;
+    }
+}
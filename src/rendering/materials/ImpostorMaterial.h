@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Material.h"
+#include "../../vk/vk_descriptors.h"
+#include "../../vk/vk_buffer.h"
+#include "../../vk/vk_swap_chain.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+namespace vk {
+
+	// octahedral impostor atlas shared by every impostor batch, the batches bring their instances as per-instance vertex data
+	class ImpostorMaterial : public Material {
+	   public:
+		// per-instance vertex attributes at binding 1, must match the instance inputs of impostor_shader.vert
+		struct Instance {
+			// xyz = base position in world space, w = uniform scale
+			glm::vec4 positionScale;
+			// xyz = bounding sphere center in object space, w = bounding sphere radius in object space
+			glm::vec4 centerRadius;
+			// xy = top left corner of the atlas slot in uv, z = cos(yaw), w = sin(yaw)
+			glm::vec4 slotOffset;
+		};
+
+		struct ImpostorData {
+			// x = frames per side, y = slot size in atlas uv, z = camera distance from which impostors replace the meshes, w = unused
+			glm::vec4 atlasParams{ 0.0f };
+			// x = ka, y = kd, zw = unused
+			glm::vec4 lightingProperties{ 0.3f, 0.7f, 0.0f, 0.0f };
+		};
+
+		struct AtlasCreationData {
+			// rgba8 each, atlasSize x atlasSize
+			const std::vector<unsigned char>* albedo = nullptr;
+			const std::vector<unsigned char>* normals = nullptr;
+			uint32_t atlasSize = 0;
+			uint32_t framesPerSide = 0;
+			uint32_t slotSize = 0;
+			float impostorDistance = 0.0f;
+		};
+
+		ImpostorMaterial(Device& device, const AtlasCreationData& creationData);
+		~ImpostorMaterial() override;
+
+		DescriptorSet getDescriptorSet(int frameIndex) const override;
+
+		// the fragment shader discards outside the tree silhouette
+		bool isOpaque() const override { return false; }
+
+		static std::unique_ptr<DescriptorPool> descriptorPool;
+		static std::unique_ptr<DescriptorSetLayout> descriptorSetLayout;
+		static int instanceCount;
+
+		static void cleanupResources();
+
+	   private:
+		void createAtlasImage(const std::vector<unsigned char>& pixels, uint32_t size, VkFormat format, VkImage& image, VkDeviceMemory& imageMemory);
+		void createTextureSampler();
+		void createDescriptorSets();
+
+		static void createDescriptorSetLayoutIfNeeded(Device& device);
+
+		VkImage albedoImage = VK_NULL_HANDLE;
+		VkDeviceMemory albedoImageMemory = VK_NULL_HANDLE;
+		VkImageView albedoImageView = VK_NULL_HANDLE;
+
+		VkImage normalImage = VK_NULL_HANDLE;
+		VkDeviceMemory normalImageMemory = VK_NULL_HANDLE;
+		VkImageView normalImageView = VK_NULL_HANDLE;
+
+		VkSampler textureSampler = VK_NULL_HANDLE;
+
+		// atlas and parameters never change after creation, so all frames share them
+		std::unique_ptr<Buffer> paramsBuffer;
+		std::vector<VkDescriptorSet> descriptorSets{ SwapChain::MAX_FRAMES_IN_FLIGHT };
+
+		ImpostorData impostorData;
+	};
+}
@@ -3,11 +3,29 @@
 
 namespace vk {
 
+    uint64_t Material::nextId = 0;
+    uint32_t Material::nextListenerHandle = 0;
+    std::unordered_map<uint32_t, std::function<void(uint64_t)>> Material::destroyListeners;
+
     // Minimal implementation for the base Material class
-    Material::Material(Device& device) : device(device) {
+    Material::Material(Device& device) : device(device), id(nextId++) {
         // Initialize the PipelineConfigInfo with default values
         Pipeline::defaultPipelineConfigInfo(pipelineConfig);
     }
     
-    Material::~Material() {}
+    Material::~Material() {
+        for (auto& [handle, listener] : destroyListeners) {
+            listener(id);
+        }
+    }
+
+    uint32_t Material::addDestroyListener(std::function<void(uint64_t)> listener) {
+        uint32_t handle = nextListenerHandle++;
+        destroyListeners.emplace(handle, std::move(listener));
+        return handle;
+    }
+
+    void Material::removeDestroyListener(uint32_t handle) {
+        destroyListeners.erase(handle);
+    }
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
 
 #include <memory>
 #include <string>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
 #include <vulkan/vulkan.h>
 #include "../../vk/vk_device.h"
 #include "../../vk/vk_pipeline.h"
@@ -29,8 +32,33 @@ namespace vk {
         
         virtual void updateDescriptorSet(int frameIndex) {};
 
+        // slot in the bindless material table, UINT32_MAX if the material uses its own descriptor set
+        virtual uint32_t getBindlessIndex() const { return UINT32_MAX; }
+
+        // opaque materials go into the depth pre-pass, blended or alpha tested ones are shaded with their own depth test
+        virtual bool isOpaque() const {
+            return !pipelineConfig.colorBlendAttachment.blendEnable
+                && pipelineConfig.depthStencilInfo.depthTestEnable
+                && pipelineConfig.depthStencilInfo.depthWriteEnable;
+        }
+
+        // unique for the lifetime of the program, unlike the address
+        uint64_t getId() const { return id; }
+
+        // called with the id of every destroyed material, e.g. to drop what was cached per material
+        // @returns the handle for removeDestroyListener
+        static uint32_t addDestroyListener(std::function<void(uint64_t)> listener);
+        static void removeDestroyListener(uint32_t handle);
+
     protected:
         Device& device;
         PipelineConfigInfo pipelineConfig{};  // Initialize in-place
+
+    private:
+        static uint64_t nextId;
+        uint64_t id;
+
+        static uint32_t nextListenerHandle;
+        static std::unordered_map<uint32_t, std::function<void(uint64_t)>> destroyListeners;
     };
 }
\ No newline at end of file
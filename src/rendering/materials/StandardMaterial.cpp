@@ -2,6 +2,7 @@
 #include "../../asset_utils/AssetLoader.h"
 #include "../../vk/vk_utils.hpp"
 #include "../../Engine.h"
+#include "BindlessRegistry.h"
 
 // Include stb_image without the implementation
 #include "stb_image.h"
@@ -26,11 +27,13 @@ namespace vk {
         createTextureImage(texturePath, textureImage, textureImageMemory);
         textureImageView = createTextureImageView(textureImage);
         createTextureSampler(textureSampler);
-        createDescriptorSets();
+        if (!registerBindless()) {
+            createDescriptorSets();
+        }
 
         // Set default pipeline configuration
         pipelineConfig.vertShaderPath = "texture_shader.vert";
-        pipelineConfig.fragShaderPath = "texture_shader.frag";
+        pipelineConfig.fragShaderPath = bindless ? "texture_shader_bindless.frag" : "texture_shader.frag";
 
         setMaterialData();
     }
@@ -68,11 +71,13 @@ namespace vk {
         createTextureFromImageData(imageData, width, height, channels, textureImage, textureImageMemory);
         textureImageView = createTextureImageView(textureImage);
         createTextureSampler(textureSampler);
-        createDescriptorSets();
+        if (!registerBindless()) {
+            createDescriptorSets();
+        }
 
         // Set default pipeline configuration
         pipelineConfig.vertShaderPath = "texture_shader.vert";
-        pipelineConfig.fragShaderPath = "texture_shader.frag";
+        pipelineConfig.fragShaderPath = bindless ? "texture_shader_bindless.frag" : "texture_shader.frag";
 
         setMaterialData();
     }
@@ -101,6 +106,15 @@ namespace vk {
     }
 
     StandardMaterial::~StandardMaterial() {
+        if (bindless) {
+            BindlessRegistry* registry = BindlessRegistry::get();
+            if (registry) {
+                registry->releaseTexture(bindlessTextureIndex);
+                registry->releaseMaterial(bindlessMaterialIndex);
+            }
+            BindlessRegistry::release();
+        }
+
         auto* destructionQueue = Engine::getDestructionQueue();
         if (destructionQueue) {
             for (int i = 0; i < textureDescriptorSets.size(); i++) {
@@ -423,7 +437,28 @@ namespace vk {
         }
     }
 
+    bool StandardMaterial::registerBindless() {
+        if (!device.supportsBindless()) {
+            return false;
+        }
+
+        BindlessRegistry& registry = BindlessRegistry::acquire(device);
+        bindlessTextureIndex = registry.registerTexture(textureImageView, textureSampler);
+        bindlessMaterialIndex = registry.allocateMaterial();
+        bindless = true;
+        return true;
+    }
+
     void StandardMaterial::updateDescriptorSet(int frameIndex) {
+        if (bindless) {
+            BindlessRegistry::MaterialParams params{};
+            params.lightingProperties = materialData.lightingProperties;
+            params.flags = materialData.flags;
+            params.textureIndices.x = bindlessTextureIndex;
+            BindlessRegistry::get()->writeMaterial(frameIndex, bindlessMaterialIndex, params);
+            return;
+        }
+
         paramsBuffers[frameIndex]->writeToBuffer(&materialData);
         paramsBuffers[frameIndex]->flush();
     }
@@ -477,6 +512,11 @@ namespace vk {
     }
 
     DescriptorSet StandardMaterial::getDescriptorSet(int frameIndex) const {
+        // all bindless materials share one set, so the render systems only rebind it on pipeline changes
+        if (bindless) {
+            return BindlessRegistry::get()->getDescriptorSet(frameIndex);
+        }
+
         DescriptorSet descriptorSet{};
         descriptorSet.binding = 1;
         descriptorSet.handle = textureDescriptorSets[frameIndex];
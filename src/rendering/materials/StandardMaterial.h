@@ -45,6 +45,8 @@ namespace vk {
 
         void updateDescriptorSet(int frameIndex) override;
 
+        uint32_t getBindlessIndex() const override { return bindlessMaterialIndex; }
+
         static std::unique_ptr<DescriptorPool> descriptorPool;
         static std::unique_ptr<DescriptorSetLayout> descriptorSetLayout;
         static int instanceCount;
@@ -58,6 +60,8 @@ namespace vk {
         VkImageView createTextureImageView(VkImage& image);
         void createTextureSampler(VkSampler& sampler);
         void createDescriptorSets();
+        // registers texture and parameters in the shared bindless tables, false if the device lacks descriptor indexing
+        bool registerBindless();
 
         static void createDescriptorSetLayoutIfNeeded(Device& device);
 
@@ -71,5 +75,9 @@ namespace vk {
         std::vector<std::unique_ptr<Buffer>> paramsBuffers{ SwapChain::MAX_FRAMES_IN_FLIGHT };
 
         MaterialData materialData;
+
+        bool bindless = false;
+        uint32_t bindlessTextureIndex = UINT32_MAX;
+        uint32_t bindlessMaterialIndex = UINT32_MAX;
     };
 }
\ No newline at end of file
@@ -2,19 +2,34 @@
 #include "../../vk/vk_device.h"
 #include "../../asset_utils/AssetLoader.h"
 #include "../../Engine.h"
+#include "../../procedural/TextureSynthesizer.h"
 
 #include <stdexcept>
 #include <iostream>
 #include <glm/gtc/noise.hpp>
+#include <glm/gtc/packing.hpp>
 #include <cmath>
 #include <algorithm>
 
 namespace vk {
 
+    // part of the texture cache key, bump when the matching generator below changes
+    namespace {
+        constexpr uint32_t ROCK_TEXTURE_VERSION = 1;
+        constexpr uint32_t GRASS_TEXTURE_VERSION = 1;
+        constexpr uint32_t SNOW_TEXTURE_VERSION = 1;
+
+        // resolution the quadtree of a file heightmap is built for
+        constexpr int DEFAULT_QUADTREE_SIZE = 256;
+    }
+
 	// Static member initialization
 	std::unique_ptr<DescriptorPool> TessellationMaterial::descriptorPool = nullptr;
 	std::unique_ptr<DescriptorSetLayout> TessellationMaterial::descriptorSetLayout = nullptr;
 	int TessellationMaterial::instanceCount = 0;
+	TessellationMaterial::GroundTexture TessellationMaterial::rockTexture{};
+	TessellationMaterial::GroundTexture TessellationMaterial::grassTexture{};
+	TessellationMaterial::GroundTexture TessellationMaterial::snowTexture{};
 
     // Constructor with separate color and heightmap textures and shader paths
     TessellationMaterial::TessellationMaterial(Device& device, const std::string& texturePath, const std::string& heightmapPath,
@@ -24,7 +39,41 @@ namespace vk {
                                            const std::string& tessEvalShaderPath,
                                            uint32_t patchControlPoints)
         : Material(device) {
-        
+        initialize(vertShaderPath, fragShaderPath, tessControlShaderPath, tessEvalShaderPath, patchControlPoints);
+
+        materialData.textureParams.w = true;
+        heightmapMipLevels = createTextureImage(heightmapPath, heightmapImage, heightmapImageMemory);
+        heightmapImageView = createImageView(heightmapImage);
+        createTextureSampler(static_cast<float>(heightmapMipLevels), heightmapSampler);
+
+        // heights are only on the gpu, chunks assume the full height range
+        quadtree = std::make_shared<TerrainQuadtree>(std::vector<float>{}, DEFAULT_QUADTREE_SIZE);
+
+        createDescriptorSets();
+    }
+
+    TessellationMaterial::TessellationMaterial(Device& device, const std::string& texturePath,
+                                           const std::vector<float>& heights, int heightmapSize,
+                                           const std::string& vertShaderPath,
+                                           const std::string& fragShaderPath,
+                                           const std::string& tessControlShaderPath,
+                                           const std::string& tessEvalShaderPath,
+                                           uint32_t patchControlPoints)
+        : Material(device) {
+        initialize(vertShaderPath, fragShaderPath, tessControlShaderPath, tessEvalShaderPath, patchControlPoints);
+
+        materialData.textureParams.w = true;
+        createHeightmapFromHeights(heights, heightmapSize);
+        createTextureSampler(static_cast<float>(heightmapMipLevels), heightmapSampler);
+
+        quadtree = std::make_shared<TerrainQuadtree>(heights, heightmapSize);
+
+        createDescriptorSets();
+    }
+
+    void TessellationMaterial::initialize(const std::string& vertShaderPath, const std::string& fragShaderPath,
+                                          const std::string& tessControlShaderPath, const std::string& tessEvalShaderPath,
+                                          uint32_t patchControlPoints) {
         // Configure for tessellation if tessellation shaders are provided
         if (!tessControlShaderPath.empty() && !tessEvalShaderPath.empty()) {
             Pipeline::defaultTessellationPipelineConfigInfo(pipelineConfig, patchControlPoints);
@@ -42,18 +91,14 @@ namespace vk {
         
         instanceCount++;
         
-        // Generate procedural textures (256x256 resolution)
+        // Generate procedural textures (256x256 resolution), loaded from the generated cache when unchanged
+        // they are the same for every terrain tile, so only the first material uploads them
         const int textureSize = 256;
-        generateRockTexture(textureSize, textureSize);
-        generateGrassTexture(textureSize, textureSize);
-        generateSnowTexture(textureSize, textureSize);
-        
-        materialData.textureParams.w = true;
-        heightmapMipLevels = createTextureImage(heightmapPath, heightmapImage, heightmapImageMemory);
-        heightmapImageView = createImageView(heightmapImage);
-        createTextureSampler(static_cast<float>(heightmapMipLevels), heightmapSampler);
-
-        createDescriptorSets();
+        if (rockTexture.image == VK_NULL_HANDLE) {
+            generateRockTexture(textureSize, textureSize);
+            generateGrassTexture(textureSize, textureSize);
+            generateSnowTexture(textureSize, textureSize);
+        }
     }
 
     TessellationMaterial::~TessellationMaterial() {
@@ -61,54 +106,6 @@ namespace vk {
         
         if (destructionQueue) {
             // schedule resources for safe destruction
-            if (rockTextureSampler != VK_NULL_HANDLE) {
-                destructionQueue->pushSampler(rockTextureSampler);
-                rockTextureSampler = VK_NULL_HANDLE;
-            }
-            
-            if (rockTextureImageView != VK_NULL_HANDLE) {
-                destructionQueue->pushImageView(rockTextureImageView);
-                rockTextureImageView = VK_NULL_HANDLE;
-            }
-            
-            if (rockTextureImage != VK_NULL_HANDLE && rockTextureImageMemory != VK_NULL_HANDLE) {
-                destructionQueue->pushImage(rockTextureImage, rockTextureImageMemory);
-                rockTextureImage = VK_NULL_HANDLE;
-                rockTextureImageMemory = VK_NULL_HANDLE;
-            }
-            
-            if (grassTextureSampler != VK_NULL_HANDLE) {
-                destructionQueue->pushSampler(grassTextureSampler);
-                grassTextureSampler = VK_NULL_HANDLE;
-            }
-            
-            if (grassTextureImageView != VK_NULL_HANDLE) {
-                destructionQueue->pushImageView(grassTextureImageView);
-                grassTextureImageView = VK_NULL_HANDLE;
-            }
-            
-            if (grassTextureImage != VK_NULL_HANDLE && grassTextureImageMemory != VK_NULL_HANDLE) {
-                destructionQueue->pushImage(grassTextureImage, grassTextureImageMemory);
-                grassTextureImage = VK_NULL_HANDLE;
-                grassTextureImageMemory = VK_NULL_HANDLE;
-            }
-            
-            if (snowTextureSampler != VK_NULL_HANDLE) {
-                destructionQueue->pushSampler(snowTextureSampler);
-                snowTextureSampler = VK_NULL_HANDLE;
-            }
-            
-            if (snowTextureImageView != VK_NULL_HANDLE) {
-                destructionQueue->pushImageView(snowTextureImageView);
-                snowTextureImageView = VK_NULL_HANDLE;
-            }
-            
-            if (snowTextureImage != VK_NULL_HANDLE && snowTextureImageMemory != VK_NULL_HANDLE) {
-                destructionQueue->pushImage(snowTextureImage, snowTextureImageMemory);
-                snowTextureImage = VK_NULL_HANDLE;
-                snowTextureImageMemory = VK_NULL_HANDLE;
-            }
-            
             for (int i = 0; i < textureDescriptorSets.size(); i++) {
                 if (textureDescriptorSets[i] != VK_NULL_HANDLE && descriptorPool) {
                     destructionQueue->pushDescriptorSet(textureDescriptorSets[i], descriptorPool->getPool());
@@ -141,54 +138,6 @@ namespace vk {
             }
         } else {
             // fallback to immediate destruction if queue is not available
-            if (rockTextureSampler != VK_NULL_HANDLE) {
-                vkDestroySampler(device.device(), rockTextureSampler, nullptr);
-            }
-            
-            if (rockTextureImageView != VK_NULL_HANDLE) {
-                vkDestroyImageView(device.device(), rockTextureImageView, nullptr);
-            }
-            
-            if (rockTextureImage != VK_NULL_HANDLE) {
-                vkDestroyImage(device.device(), rockTextureImage, nullptr);
-            }
-            
-            if (rockTextureImageMemory != VK_NULL_HANDLE) {
-                vkFreeMemory(device.device(), rockTextureImageMemory, nullptr);
-            }
-            
-            if (grassTextureSampler != VK_NULL_HANDLE) {
-                vkDestroySampler(device.device(), grassTextureSampler, nullptr);
-            }
-            
-            if (grassTextureImageView != VK_NULL_HANDLE) {
-                vkDestroyImageView(device.device(), grassTextureImageView, nullptr);
-            }
-            
-            if (grassTextureImage != VK_NULL_HANDLE) {
-                vkDestroyImage(device.device(), grassTextureImage, nullptr);
-            }
-            
-            if (grassTextureImageMemory != VK_NULL_HANDLE) {
-                vkFreeMemory(device.device(), grassTextureImageMemory, nullptr);
-            }
-            
-            if (snowTextureSampler != VK_NULL_HANDLE) {
-                vkDestroySampler(device.device(), snowTextureSampler, nullptr);
-            }
-            
-            if (snowTextureImageView != VK_NULL_HANDLE) {
-                vkDestroyImageView(device.device(), snowTextureImageView, nullptr);
-            }
-            
-            if (snowTextureImage != VK_NULL_HANDLE) {
-                vkDestroyImage(device.device(), snowTextureImage, nullptr);
-            }
-            
-            if (snowTextureImageMemory != VK_NULL_HANDLE) {
-                vkFreeMemory(device.device(), snowTextureImageMemory, nullptr);
-            }
-            
             if (materialData.textureParams.w) {
                 if (heightmapImageView != VK_NULL_HANDLE) {
                     vkDestroyImageView(device.device(), heightmapImageView, nullptr);
@@ -212,10 +161,43 @@ namespace vk {
         
         // Clean up static resources if this is the last instance
         if (instanceCount == 0) {
+            destroyGroundTexture(rockTexture);
+            destroyGroundTexture(grassTexture);
+            destroyGroundTexture(snowTexture);
             cleanupResources();
         }
     }
 
+    void TessellationMaterial::destroyGroundTexture(GroundTexture& texture) {
+        auto destructionQueue = vk::Engine::getDestructionQueue();
+
+        if (destructionQueue) {
+            if (texture.sampler != VK_NULL_HANDLE) {
+                destructionQueue->pushSampler(texture.sampler);
+            }
+            if (texture.view != VK_NULL_HANDLE) {
+                destructionQueue->pushImageView(texture.view);
+            }
+            if (texture.image != VK_NULL_HANDLE || texture.memory != VK_NULL_HANDLE) {
+                destructionQueue->pushImage(texture.image, texture.memory);
+            }
+        } else {
+            if (texture.sampler != VK_NULL_HANDLE) {
+                vkDestroySampler(device.device(), texture.sampler, nullptr);
+            }
+            if (texture.view != VK_NULL_HANDLE) {
+                vkDestroyImageView(device.device(), texture.view, nullptr);
+            }
+            if (texture.image != VK_NULL_HANDLE) {
+                vkDestroyImage(device.device(), texture.image, nullptr);
+            }
+            if (texture.memory != VK_NULL_HANDLE) {
+                vkFreeMemory(device.device(), texture.memory, nullptr);
+            }
+        }
+        texture = GroundTexture{};
+    }
+
     void TessellationMaterial::cleanupResources() {
         auto destructionQueue = vk::Engine::getDestructionQueue();
         
@@ -243,7 +225,7 @@ namespace vk {
                 .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
                 .addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
                 .addBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-                .addBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT)
+                .addBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT)
                 .build();
 
             descriptorPool = DescriptorPool::Builder(device)
@@ -329,6 +311,136 @@ namespace vk {
         return mipLevels;
     }
 
+    // @return mipLevels
+    uint32_t TessellationMaterial::createTextureFromMipChain(const procedural::TextureSynthesizer::MipChain& chain, VkImage& image, VkDeviceMemory& imageMemory) {
+        VkDeviceSize imageSize = chain.pixels.size();
+
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        device.createBuffer(
+            imageSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingBufferMemory
+        );
+
+        void* data;
+        vkMapMemory(device.device(), stagingBufferMemory, 0, imageSize, 0, &data);
+        memcpy(data, chain.pixels.data(), static_cast<size_t>(imageSize));
+        vkUnmapMemory(device.device(), stagingBufferMemory);
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = chain.width;
+        imageInfo.extent.height = chain.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = chain.mipLevels;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+        device.createImageWithInfo(
+            imageInfo,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            image,
+            imageMemory
+        );
+
+        // the mips come from the cpu, so every level is copied and no blits are needed
+        std::vector<VkDeviceSize> levelOffsets(chain.levelOffsets.begin(), chain.levelOffsets.end());
+        device.copyBufferToImageMipChain(stagingBuffer, image, chain.width, chain.height, levelOffsets);
+
+        auto destructionQueue = vk::Engine::getDestructionQueue();
+        if (destructionQueue) {
+            destructionQueue->pushBuffer(stagingBuffer, stagingBufferMemory);
+        } else {
+            vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
+            vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+        }
+
+        return chain.mipLevels;
+    }
+
+    void TessellationMaterial::createHeightmapFromHeights(const std::vector<float>& heights, int size) {
+        if (size < 1 || heights.size() < size_t(size) * size) {
+            throw std::runtime_error("Heightmap data does not match its size!");
+        }
+
+        // full precision where linear filtering of r32 is supported, otherwise half floats which always filter
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(device.physicalDevice(), VK_FORMAT_R32_SFLOAT, &formatProperties);
+        bool useFloat32 = formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        VkFormat format = useFloat32 ? VK_FORMAT_R32_SFLOAT : VK_FORMAT_R16_SFLOAT;
+
+        // the tessellation shader expects [0, 1] like the unorm textures loaded from disk
+        size_t texelCount = size_t(size) * size;
+        VkDeviceSize imageSize = texelCount * (useFloat32 ? sizeof(float) : sizeof(uint16_t));
+
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        device.createBuffer(
+            imageSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingBufferMemory
+        );
+
+        // written straight into the mapped staging memory, no intermediate image
+        void* data;
+        vkMapMemory(device.device(), stagingBufferMemory, 0, imageSize, 0, &data);
+        if (useFloat32) {
+            float* texels = static_cast<float*>(data);
+            for (size_t i = 0; i < texelCount; i++) {
+                texels[i] = heights[i] * 0.5f + 0.5f;
+            }
+        } else {
+            uint16_t* texels = static_cast<uint16_t*>(data);
+            for (size_t i = 0; i < texelCount; i++) {
+                texels[i] = glm::packHalf1x16(heights[i] * 0.5f + 0.5f);
+            }
+        }
+        vkUnmapMemory(device.device(), stagingBufferMemory);
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = size;
+        imageInfo.extent.height = size;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+        device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, heightmapImage, heightmapImageMemory);
+
+        device.transitionImageLayout(heightmapImage, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        device.copyBufferToImage(stagingBuffer, heightmapImage, size, size, 1);
+        device.transitionImageLayout(heightmapImage, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        auto destructionQueue = vk::Engine::getDestructionQueue();
+        if (destructionQueue) {
+            destructionQueue->pushBuffer(stagingBuffer, stagingBufferMemory);
+        } else {
+            vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
+            vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+        }
+
+        heightmapMipLevels = 1;
+        heightmapImageView = device.createImageView(heightmapImage, format, VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+
     VkImageView TessellationMaterial::createImageView(VkImage image) {
         return device.createImageView(image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
     }
@@ -369,18 +481,18 @@ namespace vk {
 
         VkDescriptorImageInfo rockImageInfo{};
         rockImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        rockImageInfo.imageView = rockTextureImageView;
-        rockImageInfo.sampler = rockTextureSampler;
+        rockImageInfo.imageView = rockTexture.view;
+        rockImageInfo.sampler = rockTexture.sampler;
 
         VkDescriptorImageInfo grassImageInfo{};
         grassImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        grassImageInfo.imageView = grassTextureImageView;
-        grassImageInfo.sampler = grassTextureSampler;
+        grassImageInfo.imageView = grassTexture.view;
+        grassImageInfo.sampler = grassTexture.sampler;
 
         VkDescriptorImageInfo snowImageInfo{};
         snowImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        snowImageInfo.imageView = snowTextureImageView;
-        snowImageInfo.sampler = snowTextureSampler;
+        snowImageInfo.imageView = snowTexture.view;
+        snowImageInfo.sampler = snowTexture.sampler;
 
         VkDescriptorImageInfo heightImageInfo{};
         heightImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -492,124 +604,61 @@ namespace vk {
     }
     
     void TessellationMaterial::generateRockTexture(int width, int height) {
-        std::vector<unsigned char> textureData(width * height * 4);
-
-        // Precompute two layers of fBm to warp the cellular lookup
-        const float fBmScale1 = 3.0f;  // coarse warp
-        const float fBmScale2 = 12.0f; // fine detail
-
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                float nx = static_cast<float>(x) / width;
-                float ny = static_cast<float>(y) / height;
-                glm::vec2 uv = glm::vec2(nx, ny);
-
-                float rawBase = tileableVoronoi(uv, 50);
-                float sharpVal = glm::smoothstep(0.3f, 0.7f, rawBase);
-                glm::vec3 baseColor = glm::mix(glm::vec3(0.20f, 0.18f, 0.17f),
-                    glm::vec3(0.35f, 0.33f, 0.3f), sharpVal);
-
-                float detailFBM = seamlessFbm(uv * 4.0f, 4, 2, 1.2f, 0.5f) * 0.15f;
-
-                glm::vec3 rockRGB = baseColor;
-                rockRGB += glm::vec3(detailFBM);
-
-                unsigned char r = static_cast<unsigned char>(glm::clamp(rockRGB.r, 0.0f, 1.0f) * 255);
-                unsigned char g = static_cast<unsigned char>(glm::clamp(rockRGB.g, 0.0f, 1.0f) * 255);
-                unsigned char b = static_cast<unsigned char>(glm::clamp(rockRGB.b, 0.0f, 1.0f) * 255);
-                unsigned char a = 255;
-
-                int index = (y * width + x) * 4;
-                textureData[index + 0] = r;
-                textureData[index + 1] = g;
-                textureData[index + 2] = b;
-                textureData[index + 3] = a;
-            }
-        }
+        auto chain = procedural::TextureSynthesizer::synthesize("terrain_rock", width, height, ROCK_TEXTURE_VERSION, [this](const glm::vec2& uv) {
+            float rawBase = tileableVoronoi(uv, 50);
+            float sharpVal = glm::smoothstep(0.3f, 0.7f, rawBase);
+            glm::vec3 baseColor = glm::mix(glm::vec3(0.20f, 0.18f, 0.17f),
+                glm::vec3(0.35f, 0.33f, 0.3f), sharpVal);
+
+            float detailFBM = seamlessFbm(uv * 4.0f, 4, 2, 1.2f, 0.5f) * 0.15f;
+
+            return baseColor + glm::vec3(detailFBM);
+        });
 
-        rockTextureMipLevels = createTextureFromImageData(textureData, width, height, 4, rockTextureImage, rockTextureImageMemory);
-        rockTextureImageView = createImageView(rockTextureImage);
-        createTextureSampler(static_cast<float>(rockTextureMipLevels), rockTextureSampler);
+        rockTexture.mipLevels = createTextureFromMipChain(chain, rockTexture.image, rockTexture.memory);
+        rockTexture.view = createImageView(rockTexture.image);
+        createTextureSampler(static_cast<float>(rockTexture.mipLevels), rockTexture.sampler);
     }
     
     void TessellationMaterial::generateGrassTexture(int width, int height) {
-        std::vector<unsigned char> textureData(width * height * 4);
+        auto chain = procedural::TextureSynthesizer::synthesize("terrain_grass", width, height, GRASS_TEXTURE_VERSION, [this](const glm::vec2& guv) {
+            glm::vec2 grassWarp;
+            grassWarp.x = tileableCellular(guv * 2.0f, 8.0f) * 0.08f;
+            grassWarp.y = tileableCellular(guv * 2.0f + glm::vec2(0.5f), 8.0f) * 0.08f;
+            glm::vec2 gUVw = glm::fract(guv + grassWarp);
+
+            float grassCell = tileableCellular(gUVw, 256.0f);
+            float grassMask = glm::smoothstep(0.25f, 0.55f, grassCell);
+
+            glm::vec2 gUVw2 = glm::fract(guv + grassWarp * 1.5f + glm::vec2(0.25f));
+            float insideNoise = tileableCellular(gUVw2, 64.0f) * 0.15f;
+
+            float grassPattern = grassMask * (0.6f + insideNoise * 0.4f);
+
+            glm::vec3 baseGreen = glm::vec3(0.1f, 0.35f, 0.025f);
+            glm::vec3 colorVariation = glm::vec3(grassPattern * 0.15f,
+                grassPattern * 0.25f,
+                grassPattern * 0.1f);
+            return baseGreen + colorVariation;
+        });
         
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                glm::vec2 guv = glm::vec2(static_cast<float>(x) / width, static_cast<float>(y) / height);
-
-                float largeDetail = seamlessFbm(guv * 16.0f, 3, 3, 2.0f, 0.5f);
-                float mediumDetail = seamlessFbm(guv * 32.0f, 2, 3, 2.0f, 0.4f);
-                
-                glm::vec2 grassWarp;
-                grassWarp.x = tileableCellular(guv * 2.0f, 8.0f) * 0.08f;
-                grassWarp.y = tileableCellular(guv * 2.0f + glm::vec2(0.5f), 8.0f) * 0.08f;
-                glm::vec2 gUVw = glm::fract(guv + grassWarp);
-
-                float grassCell = tileableCellular(gUVw, 256.0f);
-                float grassMask = glm::smoothstep(0.25f, 0.55f, grassCell);
-
-                glm::vec2 gUVw2 = glm::fract(guv + grassWarp * 1.5f + glm::vec2(0.25f));
-                float insideNoise = tileableCellular(gUVw2, 64.0f) * 0.15f;
-
-                float grassPattern = grassMask * (0.6f + insideNoise * 0.4f);
-
-                glm::vec3 baseGreen = glm::vec3(0.1f, 0.35f, 0.025f);
-                glm::vec3 colorVariation = glm::vec3(grassPattern * 0.15f,
-                    grassPattern * 0.25f,
-                    grassPattern * 0.1f);
-                glm::vec3 grassRGB = baseGreen + colorVariation;
-
-                unsigned char r = static_cast<unsigned char>(glm::clamp(grassRGB.r, 0.0f, 1.0f) * 255);
-                unsigned char g = static_cast<unsigned char>(glm::clamp(grassRGB.g, 0.0f, 1.0f) * 255);
-                unsigned char b = static_cast<unsigned char>(glm::clamp(grassRGB.b, 0.0f, 1.0f) * 255);
-                unsigned char a = 255;
-                
-                int index = (y * width + x) * 4;
-                textureData[index] = r;
-                textureData[index + 1] = g;
-                textureData[index + 2] = b;
-                textureData[index + 3] = a;
-            }
-        }
-        
-        grassTextureMipLevels = createTextureFromImageData(textureData, width, height, 4, grassTextureImage, grassTextureImageMemory);
-        grassTextureImageView = createImageView(grassTextureImage);
-        createTextureSampler(static_cast<float>(grassTextureMipLevels), grassTextureSampler);
+        grassTexture.mipLevels = createTextureFromMipChain(chain, grassTexture.image, grassTexture.memory);
+        grassTexture.view = createImageView(grassTexture.image);
+        createTextureSampler(static_cast<float>(grassTexture.mipLevels), grassTexture.sampler);
     }
     
     void TessellationMaterial::generateSnowTexture(int width, int height) {
-        std::vector<unsigned char> textureData(width * height * 4);
-        
-        const float noiseScale = 1.5f;
-        
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                float nx = static_cast<float>(x) / width * noiseScale;
-                float ny = static_cast<float>(y) / height * noiseScale;
-                
-                float snowMask = seamlessFbm(glm::vec2(nx, ny) * 2.0f, 6, 3, 2.0f, 0.6f);
-
-                float baseR = 0.90f, baseG = 0.92f, baseB = 1.00f;
-                float blueTint = glm::smoothstep(0.4f, 0.7f, snowMask) * 0.05f;
+        auto chain = procedural::TextureSynthesizer::synthesize("terrain_snow", width, height, SNOW_TEXTURE_VERSION, [this](const glm::vec2& uv) {
+            const float noiseScale = 1.5f;
+            float snowMask = seamlessFbm(uv * noiseScale * 2.0f, 6, 3, 2.0f, 0.6f);
 
-                unsigned char r = static_cast<unsigned char>(glm::clamp(baseR - blueTint, 0.0f, 1.0f) * 255);
-                unsigned char g = static_cast<unsigned char>(glm::clamp(baseG - blueTint, 0.0f, 1.0f) * 255);
-                unsigned char b = static_cast<unsigned char>(glm::clamp(baseB, 0.0f, 1.0f) * 255);
-                unsigned char a = 255;
-                
-                int index = (y * width + x) * 4;
-                textureData[index] = r;
-                textureData[index + 1] = g;
-                textureData[index + 2] = b;
-                textureData[index + 3] = a;
-            }
-        }
+            float blueTint = glm::smoothstep(0.4f, 0.7f, snowMask) * 0.05f;
+            return glm::vec3(0.90f - blueTint, 0.92f - blueTint, 1.00f);
+        });
         
-        snowTextureMipLevels = createTextureFromImageData(textureData, width, height, 4, snowTextureImage, snowTextureImageMemory);
-        snowTextureImageView = createImageView(snowTextureImage);
-        createTextureSampler(static_cast<float>(snowTextureMipLevels), snowTextureSampler);
+        snowTexture.mipLevels = createTextureFromMipChain(chain, snowTexture.image, snowTexture.memory);
+        snowTexture.view = createImageView(snowTexture.image);
+        createTextureSampler(static_cast<float>(snowTexture.mipLevels), snowTexture.sampler);
     }
 
     DescriptorSet TessellationMaterial::getDescriptorSet(int frameIndex) const {
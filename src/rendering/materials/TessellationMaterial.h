@@ -4,8 +4,12 @@
 #include "../../vk/vk_descriptors.h"
 #include "../../vk/vk_buffer.h"
 #include "../../vk/vk_swap_chain.h"
+#include "../../procedural/TextureSynthesizer.h"
+#include "../structures/TerrainQuadtree.h"
 #include <glm/glm.hpp>
 #include <cstdint>	// Required for uint32_t
+#include <memory>
+#include <vector>
 
 namespace vk {
 
@@ -57,12 +61,24 @@ namespace vk {
                        const std::string& tessControlShaderPath = "",
                        const std::string& tessEvalShaderPath = "",
                        uint32_t patchControlPoints = 4);
+
+        // heightmap from normalized heights in [-1, 1] (size x size, row major), uploaded as a float texture
+        TessellationMaterial(Device& device, const std::string& texturePath, const std::vector<float>& heights, int heightmapSize,
+                       const std::string& vertShaderPath = "texture_shader.vert",
+                       const std::string& fragShaderPath = "texture_shader.frag",
+                       const std::string& tessControlShaderPath = "",
+                       const std::string& tessEvalShaderPath = "",
+                       uint32_t patchControlPoints = 4);
         
         ~TessellationMaterial() override;
 
         DescriptorSet getDescriptorSet(int frameIndex) const override;
         
         void setParams(MaterialCreationData creationData);
+
+        // chunk selection over the heightmap, see TerrainRenderSystem
+        const TerrainQuadtree& getQuadtree() const { return *quadtree; }
+        float getHeightScale() const { return materialData.tessParams.w; }
         
         static std::unique_ptr<DescriptorPool> descriptorPool;
         static std::unique_ptr<DescriptorSetLayout> descriptorSetLayout;
@@ -71,9 +87,16 @@ namespace vk {
         static void cleanupResources();
 
     private:
+        // pipeline config, layout and the procedural ground textures shared by both constructors
+        void initialize(const std::string& vertShaderPath, const std::string& fragShaderPath,
+                        const std::string& tessControlShaderPath, const std::string& tessEvalShaderPath,
+                        uint32_t patchControlPoints);
+
         uint32_t createTextureImage(const std::string& texturePath, VkImage& image, VkDeviceMemory& imageMemory);
         uint32_t createTextureFromImageData(const std::vector<unsigned char>& imageData,
                                        int width, int height, int channels, VkImage& image, VkDeviceMemory& imageMemory);
+        uint32_t createTextureFromMipChain(const procedural::TextureSynthesizer::MipChain& chain, VkImage& image, VkDeviceMemory& imageMemory);
+        void createHeightmapFromHeights(const std::vector<float>& heights, int size);
         VkImageView createImageView(VkImage image);
         void createTextureSampler(float maxLod, VkSampler& sampler);
         void createDescriptorSets();
@@ -87,31 +110,25 @@ namespace vk {
         float tileableVoronoi(glm::vec2 uv, float cellCount);
         float tileableCellular(glm::vec2 uv, float cellCount);
         
-        // Generate procedural textures
+        // Generate procedural textures, tiled on worker threads with cpu mips, see procedural::TextureSynthesizer
         void generateRockTexture(int width, int height);
         void generateGrassTexture(int width, int height);
         void generateSnowTexture(int width, int height);
         
-        // Rock texture resources
-        VkImage rockTextureImage = VK_NULL_HANDLE;
-        VkDeviceMemory rockTextureImageMemory = VK_NULL_HANDLE;
-        VkImageView rockTextureImageView = VK_NULL_HANDLE;
-        VkSampler rockTextureSampler = VK_NULL_HANDLE;
-        uint32_t rockTextureMipLevels = 1;
-        
-        // Grass texture resources
-        VkImage grassTextureImage = VK_NULL_HANDLE;
-        VkDeviceMemory grassTextureImageMemory = VK_NULL_HANDLE;
-        VkImageView grassTextureImageView = VK_NULL_HANDLE;
-        VkSampler grassTextureSampler = VK_NULL_HANDLE;
-        uint32_t grassTextureMipLevels = 1;
-        
-        // Snow texture resources
-        VkImage snowTextureImage = VK_NULL_HANDLE;
-        VkDeviceMemory snowTextureImageMemory = VK_NULL_HANDLE;
-        VkImageView snowTextureImageView = VK_NULL_HANDLE;
-        VkSampler snowTextureSampler = VK_NULL_HANDLE;
-        uint32_t snowTextureMipLevels = 1;
+        // procedural ground textures, the same for every terrain tile so all materials share one upload
+        struct GroundTexture {
+            VkImage image = VK_NULL_HANDLE;
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+            VkSampler sampler = VK_NULL_HANDLE;
+            uint32_t mipLevels = 1;
+        };
+        static GroundTexture rockTexture;
+        static GroundTexture grassTexture;
+        static GroundTexture snowTexture;
+
+        // called by the last material
+        void destroyGroundTexture(GroundTexture& texture);
         
         // Heightmap resources (optional)
         VkImage heightmapImage = VK_NULL_HANDLE;
@@ -119,6 +136,9 @@ namespace vk {
         VkImageView heightmapImageView = VK_NULL_HANDLE;
         VkSampler heightmapSampler = VK_NULL_HANDLE;
         uint32_t heightmapMipLevels = 1;
+
+        // height bounds of the heightmap, conservative for heightmaps loaded from a file
+        std::shared_ptr<TerrainQuadtree> quadtree;
         
         std::vector<VkDescriptorSet> textureDescriptorSets{ SwapChain::MAX_FRAMES_IN_FLIGHT };
 
@@ -6,6 +6,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <glm/gtc/noise.hpp>
+#include <glm/gtc/constants.hpp>
 #include <cmath>
 #include <algorithm>
 
@@ -504,9 +505,14 @@ namespace vk {
 
         waterData.flags.y = count;
 
+        // same amplitude as water_shader.tese, bounds the displacement of a patch in every direction
+        float totalAmplitude = 0.0f;
         for (int i = 0; i < count; i++) {
             waterData.waves[i] = params[i];
+            float k = 2.0f * glm::pi<float>() / params[i].w;
+            totalAmplitude += params[i].z / k;
         }
+        waterData.flags.z = totalAmplitude;
     }
 
     void WaterMaterial::cleanupResources() {
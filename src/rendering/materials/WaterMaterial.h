@@ -19,7 +19,7 @@ namespace vk {
 		// w = unused
 		glm::vec4 tessParams = glm::vec4{ 16.0f, 50.0f, 500.0f, 0.0f };
 
-		// xy = textureRepetition, how often the texture repeats across the whole tessellation object
+		// xy = textureRepetition, how often the texture repeats across one block of the finest clipmap ring
 		// zw = unused
 		glm::vec4 textureParams = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
 
@@ -29,7 +29,7 @@ namespace vk {
 		// xyz = default color, w = transparency
 		glm::vec4 color = glm::vec4{ 0.302f, 0.404f, 0.859f, 0.8f };
 		
-		// x = hasTexture, y = waveCount, zw = unused
+		// x = hasTexture, y = waveCount, z = summed wave amplitude (patch culling bounds), w = unused
 		glm::vec4 flags = glm::vec4{1.0f};
 
 		// xy = direction, z = steepness in [0,1], w = wavelength
@@ -46,7 +46,7 @@ namespace vk {
 		// tessellation decreases linearly until maxTessDistance(minimum tessellation level, here: no subdivisions)
 		float maxTessDistance = 500.0f;
 
-		// how often the texture repeats across the whole tessellation object
+		// how often the texture repeats across one block of the finest clipmap ring
 		glm::vec2 textureRepetition = glm::vec2{ 1.0f, 1.0f };
 
 		// ambient lighting factor
@@ -1,14 +1,23 @@
 #pragma once
 
 #include <vector>
+#include <array>
 #include <unordered_map>
 #include <algorithm>
 #include <memory>
 #include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <iterator>
+#include <limits>
 #include <glm/glm.hpp>
 
 #include "../materials/Material.h"
 #include "../structures/Frustum.h"
+#include "../structures/OcclusionCuller.h"
+#include "../structures/RenderQueue.h"
 
 #include "../../vk/vk_pipeline.h"
 #include "../../vk/vk_frame_info.h"
@@ -19,11 +28,25 @@
 
 namespace vk {
 
+    // describes one render pass a render system draws into, used to compile pipelines ahead of the first frame
+    struct PipelinePrewarmPass {
+        RenderPassType type = RenderPassType::DEFAULT_PASS;
+        // main pass after a depth pre-pass
+        bool depthPrepassed = false;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        std::vector<DescriptorSet> systemDescriptorSets;
+    };
+
     // PushConstStages must be defined by Derived
     // Derived must implement:
     //   std::vector<std::weak_ptr<GameObject>> gatherObjects(const FrameInfo&);
     //   void tweakPipelineConfig(PipelineConfigInfo&, const FrameInfo&);
-    //   PushConst buildPushConstant(std::shared_ptr<GameObject>, const FrameInfo&, VkPipelineLayout);
+    //   PushConst buildPushConstant(const std::shared_ptr<GameObject>&, const FrameInfo&, VkPipelineLayout);
+    // Derived may shadow:
+    //   float sortDepth(const GameObject&, const FrameInfo&) const;
+    //   static constexpr bool DepthMajorSort;
+    //   uint32_t cullInstances(GameObject&, const FrameInfo&, const Frustum&, uint32_t& firstInstance);
+    //   void bindInstanceData(const FrameInfo&);
 
     // crtp
     template<typename Derived, typename PushConst>
@@ -36,6 +59,67 @@ namespace vk {
 
         std::unordered_map<std::vector<VkDescriptorSetLayout>, VkPipelineLayout, DescriptorSetLayoutVectorHash> pipelineLayoutCache;
         std::unordered_map<PipelineConfigInfo, PipelineInfo> pipelineCache;
+        uint32_t nextPipelineId = 0;
+
+        static constexpr uint32_t MAX_BOUND_SETS = 8;
+
+        // everything that can change which pipeline a material resolves to, checked before copying and hashing the full config
+        struct MaterialPipelineKey {
+            uint64_t materialId;
+            VkRenderPass renderPass;
+            // descriptor set layouts by set number, compared handle by handle so colliding hashes cannot share a pipeline
+            std::array<VkDescriptorSetLayout, MAX_BOUND_SETS> setLayouts;
+            uint32_t passType;
+            VkPolygonMode polygonMode;
+            VkCullModeFlags cullMode;
+            bool depthPrepassed;
+            bool compactVertices;
+
+            bool operator==(const MaterialPipelineKey& o) const {
+                return materialId == o.materialId
+                    && renderPass == o.renderPass
+                    && setLayouts == o.setLayouts
+                    && passType == o.passType
+                    && polygonMode == o.polygonMode
+                    && cullMode == o.cullMode
+                    && depthPrepassed == o.depthPrepassed
+                    && compactVertices == o.compactVertices;
+            }
+        };
+
+        struct MaterialPipelineKeyHash {
+            size_t operator()(const MaterialPipelineKey& k) const noexcept {
+                size_t h = 0;
+                hashCombine(h, k.materialId);
+                hashCombine(h, k.renderPass);
+                for (VkDescriptorSetLayout layout : k.setLayouts) {
+                    hashCombine(h, layout);
+                }
+                hashCombine(h, k.passType);
+                hashCombine(h, uint32_t(k.polygonMode));
+                hashCombine(h, uint32_t(k.cullMode));
+                hashCombine(h, k.depthPrepassed);
+                hashCombine(h, k.compactVertices);
+                return h;
+            }
+        };
+
+        // pipelineCache values never move, so raw pointers into it stay valid
+        // entries of a material are dropped when it is destroyed, its id is never reused
+        std::unordered_map<MaterialPipelineKey, PipelineInfo*, MaterialPipelineKeyHash> materialPipelineCache;
+        uint32_t materialDestroyListener = 0;
+        // compact ids for material descriptor sets, used in the sort key
+        // assigned per render call so they stay small while streamed materials come and go
+        std::unordered_map<VkDescriptorSet, uint32_t> descriptorIds;
+
+        // per render call scratch, capacities are kept between frames
+        FrameArena frameArena;
+        std::vector<std::shared_ptr<GameObject>> frameObjects;
+
+        template<typename T>
+        static void hashCombine(size_t& seed, const T& v) {
+            seed ^= std::hash<T>()(v) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+        }
 
         // Check if we already have a pipeline layout
         VkPipelineLayout getOrCreatePipelineLayout(std::vector<VkDescriptorSetLayout> setLayouts) {
@@ -66,6 +150,16 @@ namespace vk {
             return layout;
         }
 
+        static std::vector<VkDescriptorSetLayout> sortedSetLayouts(std::vector<DescriptorSet> sets) {
+            std::sort(sets.begin(), sets.end(), [](auto& a, auto& b) { return a.binding < b.binding; });
+            std::vector<VkDescriptorSetLayout> layouts;
+            layouts.reserve(sets.size());
+            for (auto& ds : sets) {
+                layouts.push_back(ds.layout);
+            }
+            return layouts;
+        }
+
         PipelineInfo& getOrCreatePipeline(PipelineConfigInfo config, std::vector<VkDescriptorSetLayout> setLayouts) {
             // create or retrieve pipeline layout
             VkPipelineLayout pl = getOrCreatePipelineLayout(std::move(setLayouts));
@@ -83,16 +177,203 @@ namespace vk {
             PipelineInfo pi;
             pi.pipelineLayout = pl;
             pi.pipeline = std::make_unique<Pipeline>(device, config);
+            pi.id = nextPipelineId++;
 
             // cache and return
             return pipelineCache.emplace(std::move(config), std::move(pi)).first->second;
         }
 
+        // render system tweaks first, then the vertex format of the model and the depth state of the pre-pass / the main pass after it
+        void configurePipeline(PipelineConfigInfo& config, const Material& material, bool compactVertices, const FrameInfo& frameInfo) {
+            static_cast<Derived*>(this)->tweakPipelineConfig(config, frameInfo);
+
+            // models fall back to the full vertex format when their material's vertex shader has no compact variant, see Model::setMaterial
+            if (compactVertices && !Pipeline::compactVertexPipelineConfigInfo(config)) {
+                throw std::runtime_error("Render system replaced the vertex shader with one without a compact variant");
+            }
+
+            if (frameInfo.renderPassType == RenderPassType::DEPTH_PREPASS) {
+                Pipeline::depthPrepassPipelineConfigInfo(config);
+            } else if (frameInfo.renderPassType == RenderPassType::DEFAULT_PASS && frameInfo.depthPrepassed && material.isOpaque()) {
+                Pipeline::depthEqualPipelineConfigInfo(config);
+            }
+        }
+
+        // fast path keyed by material id, the full config is only copied and tweaked the first time
+        PipelineInfo* getOrCreateMaterialPipeline(
+            Material& material,
+            const DescriptorSet& materialSet,
+            const std::array<DescriptorSet, MAX_BOUND_SETS>& systemSets,
+            uint32_t systemSetCount,
+            const std::array<VkDescriptorSetLayout, MAX_BOUND_SETS>& systemLayouts,
+            VkRenderPass renderPass,
+            bool compactVertices,
+            const FrameInfo& frameInfo) {
+
+            const PipelineConfigInfo& baseConfig = material.getPipelineConfigRef();
+
+            if (materialSet.binding >= MAX_BOUND_SETS) {
+                throw std::runtime_error("Material descriptor set binding out of range");
+            }
+            std::array<VkDescriptorSetLayout, MAX_BOUND_SETS> setLayouts = systemLayouts;
+            setLayouts[materialSet.binding] = materialSet.layout;
+
+            MaterialPipelineKey key{
+                material.getId(),
+                renderPass,
+                setLayouts,
+                uint32_t(frameInfo.renderPassType),
+                baseConfig.rasterizationInfo.polygonMode,
+                baseConfig.rasterizationInfo.cullMode,
+                frameInfo.depthPrepassed,
+                compactVertices
+            };
+
+            auto it = materialPipelineCache.find(key);
+            if (it != materialPipelineCache.end()) {
+                return it->second;
+            }
+
+            std::vector<DescriptorSet> allSets(systemSets.begin(), systemSets.begin() + systemSetCount);
+            allSets.push_back(materialSet);
+
+            PipelineConfigInfo cfg = baseConfig;
+            configurePipeline(cfg, material, compactVertices, frameInfo);
+            PipelineInfo& pi = getOrCreatePipeline(cfg, sortedSetLayouts(std::move(allSets)));
+
+            materialPipelineCache.emplace(key, &pi);
+            return &pi;
+        }
+
+        uint32_t getDescriptorId(VkDescriptorSet handle) {
+            auto it = descriptorIds.find(handle);
+            if (it != descriptorIds.end()) {
+                return it->second;
+            }
+            uint32_t id = uint32_t(descriptorIds.size());
+            descriptorIds.emplace(handle, id);
+            return id;
+        }
+
     public:
 
-        BaseRenderSystem(Device& dev, Renderer& renderer, RenderSystemSettings& settings) : device(dev), renderer(renderer), settings(settings) {}
+        // compiles every pipeline variant the currently loaded materials can request (pass x polygon mode)
+        // pipelines are built on worker threads and go through the device-wide VkPipelineCache
+        void prewarmPipelines(const std::vector<PipelinePrewarmPass>& passes, const std::vector<VkPolygonMode>& polygonModes = { VK_POLYGON_MODE_FILL }) {
+            std::vector<PipelineConfigInfo> pending;
+
+            for (const auto& pass : passes) {
+                FrameInfo frameInfo{};
+                frameInfo.renderPassType = pass.type;
+                frameInfo.depthPrepassed = pass.depthPrepassed;
+                frameInfo.systemDescriptorSets = pass.systemDescriptorSets;
+
+                for (auto& weakObj : static_cast<Derived*>(this)->gatherObjects(frameInfo)) {
+                    auto obj = weakObj.lock();
+                    if (!obj || !obj->getModel()) continue;
+
+                    auto material = obj->getModel()->getMaterial();
+                    if (!material) continue;
+                    if (pass.type == RenderPassType::DEPTH_PREPASS && !material->isOpaque()) continue;
+
+                    std::vector<DescriptorSet> allSets = pass.systemDescriptorSets;
+                    allSets.push_back(material->getDescriptorSet(0));
+                    VkPipelineLayout pl = getOrCreatePipelineLayout(sortedSetLayouts(std::move(allSets)));
+
+                    for (VkPolygonMode polygonMode : polygonModes) {
+                        PipelineConfigInfo cfg = material->getPipelineConfig();
+                        cfg.rasterizationInfo.polygonMode = polygonMode;
+                        configurePipeline(cfg, *material, obj->getModel()->hasCompactVertices(), frameInfo);
+                        cfg.renderPass = pass.renderPass;
+                        cfg.pipelineLayout = pl;
+
+                        if (pipelineCache.count(cfg) || std::find(pending.begin(), pending.end(), cfg) != pending.end()) {
+                            continue;
+                        }
+                        pending.push_back(std::move(cfg));
+                    }
+                }
+            }
+
+            if (pending.empty()) {
+                return;
+            }
+
+            std::vector<std::unique_ptr<Pipeline>> compiled(pending.size());
+            std::vector<std::exception_ptr> errors(pending.size());
+            std::atomic<size_t> next{ 0 };
+
+            auto worker = [&]() {
+                for (size_t i = next++; i < pending.size(); i = next++) {
+                    try {
+                        compiled[i] = std::make_unique<Pipeline>(device, pending[i]);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                }
+            };
+
+            size_t threadCount = std::min<size_t>(pending.size(), std::max(1u, std::thread::hardware_concurrency()));
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount - 1);
+            for (size_t t = 1; t < threadCount; t++) {
+                threads.emplace_back(worker);
+            }
+            worker();
+            for (auto& t : threads) {
+                t.join();
+            }
+
+            for (size_t i = 0; i < pending.size(); i++) {
+                if (errors[i]) {
+                    std::rethrow_exception(errors[i]);
+                }
+                PipelineInfo pi;
+                pi.pipelineLayout = pending[i].pipelineLayout;
+                pi.pipeline = std::move(compiled[i]);
+                pi.id = nextPipelineId++;
+                pipelineCache.emplace(std::move(pending[i]), std::move(pi));
+            }
+
+            std::cout << "RenderSystem: Prewarmed " << pending.size() << " pipelines on " << threadCount << " threads" << std::endl;
+        }
+
+        // depth is only the last sort criterion unless Derived sets this (e.g. ordered ui)
+        static constexpr bool DepthMajorSort = false;
+
+        // front to back from the camera by default, by view space depth so draws in front of the camera come first
+        float sortDepth(const GameObject& obj, const FrameInfo& frameInfo) const {
+            glm::vec3 toObject = obj.getPosition() - frameInfo.cameraPosition;
+            if (frameInfo.cameraForward == glm::vec3(0.0f)) {
+                return glm::length(toObject);
+            }
+            return glm::dot(toObject, frameInfo.cameraForward);
+        }
+
+        // instanced objects draw all of their instances unless Derived culls them individually
+        // @returns the number of instances to draw, 0 skips the object
+        uint32_t cullInstances(GameObject& obj, const FrameInfo&, const Frustum&, uint32_t& firstInstance) {
+            firstInstance = 0;
+            return obj.getInstanceCount();
+        }
+
+        // called once before the draws of a render call, e.g. to bind per instance vertex buffers
+        void bindInstanceData(const FrameInfo&) {}
+
+        BaseRenderSystem(Device& dev, Renderer& renderer, RenderSystemSettings& settings) : device(dev), renderer(renderer), settings(settings) {
+            materialDestroyListener = Material::addDestroyListener([this](uint64_t materialId) {
+                for (auto it = materialPipelineCache.begin(); it != materialPipelineCache.end();) {
+                    it = it->first.materialId == materialId ? materialPipelineCache.erase(it) : std::next(it);
+                }
+            });
+        }
+
+        // the material destroy listener points back at this system
+        BaseRenderSystem(const BaseRenderSystem&) = delete;
+        BaseRenderSystem& operator=(const BaseRenderSystem&) = delete;
 
         virtual ~BaseRenderSystem() {
+            Material::removeDestroyListener(materialDestroyListener);
             for (auto& [key, layout] : pipelineLayoutCache) {
                 vkDestroyPipelineLayout(device.device(), layout, nullptr);
             }
@@ -100,130 +381,195 @@ namespace vk {
 
         // @returns num of rendered objects without culling
         int renderGameObjects(FrameInfo& frameInfo, Frustum& frustum) {
-            struct RenderItem {
-                std::shared_ptr<GameObject> obj;
-                PipelineInfo* pipeline;
-                std::vector<VkDescriptorSet> sets;
-                VkPipelineLayout layout;
-
-                // Sort key
-                size_t pipelineId;
-                size_t descriptorHash;
-            };
+            Derived& derived = *static_cast<Derived*>(this);
+            int frameIndex = renderer.getFrameIndex();
+            VkRenderPass renderPass = renderer.getCurrentRenderPass();
 
-            auto objects = static_cast<Derived*>(this)->gatherObjects(frameInfo);
-            std::vector<RenderItem> renderItems;
+            auto objects = derived.gatherObjects(frameInfo);
+
+            // system sets are the same for every draw of this call, sort them by binding once
+            if (frameInfo.systemDescriptorSets.size() >= MAX_BOUND_SETS) {
+                throw std::runtime_error("Too many system descriptor sets");
+            }
+            uint32_t systemSetCount = uint32_t(frameInfo.systemDescriptorSets.size());
+            std::array<DescriptorSet, MAX_BOUND_SETS> systemSets{};
+            std::copy(frameInfo.systemDescriptorSets.begin(), frameInfo.systemDescriptorSets.end(), systemSets.begin());
+            std::sort(systemSets.begin(), systemSets.begin() + systemSetCount, [](auto& a, auto& b) { return a.binding < b.binding; });
+
+            std::array<VkDescriptorSetLayout, MAX_BOUND_SETS> systemLayouts{};
+            for (uint32_t i = 0; i < systemSetCount; i++) {
+                if (systemSets[i].binding >= MAX_BOUND_SETS) {
+                    throw std::runtime_error("System descriptor set binding out of range");
+                }
+                systemLayouts[systemSets[i].binding] = systemSets[i].layout;
+            }
+
+            // render list lives in the arena, no per-object heap allocations once capacities settled
+            frameArena.reset();
+            frameObjects.clear();
+            descriptorIds.clear();
+            DrawRecord* records = frameArena.allocate<DrawRecord>(objects.size());
+            SortEntry* entries = frameArena.allocate<SortEntry>(objects.size());
+            SortEntry* scratch = frameArena.allocate<SortEntry>(objects.size());
+            uint32_t drawCount = 0;
 
             for (auto& weakObj : objects) {
-                if (auto obj = weakObj.lock()) {
+                auto obj = weakObj.lock();
+                if (!obj || !obj->getModel()) {
+                    continue;
+                }
 
-                    if (!obj || !obj->getModel()) {
+                if (frameInfo.renderPassType == RenderPassType::SHADOW_PASS && !obj->castsShadows()) {
+                    continue;
+                }
+
+                // blended and alpha tested materials keep their own depth test in the main pass
+                if (frameInfo.renderPassType == RenderPassType::DEPTH_PREPASS) {
+                    auto material = obj->getModel()->getMaterial();
+                    if (!material || !material->isOpaque()) {
                         continue;
                     }
+                }
 
-                    // frustum culling
-                    if (settings.enableFrustumCulling && obj->enableFrustumCulling()) {
-                        auto model = obj->getModel();
-                        if (model) {
-                            auto [bbMin, bbMax] = model->getAABB();
-                            glm::mat4 M = obj->computeModelMatrix();
-                            if (!frustum.intersectsOBB(bbMin, bbMax, M)) {
-                                continue;
-                            }
-                        }
+                // the depth pre-pass must draw exactly what the main pass draws
+                float maxDrawDistance = obj->getMaxDrawDistance();
+                if (frameInfo.renderPassType != RenderPassType::SHADOW_PASS && maxDrawDistance < std::numeric_limits<float>::max()) {
+                    glm::vec3 toCamera = obj->getPosition() - frameInfo.cameraPosition;
+                    if (glm::dot(toCamera, toCamera) > maxDrawDistance * maxDrawDistance) {
+                        continue;
                     }
+                }
 
-                    auto material = obj->getModel()->getMaterial();
-                    if (!material) continue;
-
-                    material->updateDescriptorSet(renderer.getFrameIndex());
-
-                    std::vector<DescriptorSet> allSets = frameInfo.systemDescriptorSets;
-                    allSets.push_back(material->getDescriptorSet(renderer.getFrameIndex()));
-                    std::sort(allSets.begin(), allSets.end(), [](auto& a, auto& b) { return a.binding < b.binding; });
+                Model& model = *obj->getModel();
+                auto [bbMin, bbMax] = model.getAABB();
+                glm::mat4 M = obj->computeModelMatrix();
 
-                    std::vector<VkDescriptorSetLayout> layouts;
-                    std::vector<VkDescriptorSet>       handles;
+                // frustum culling
+                if (settings.enableFrustumCulling && obj->enableFrustumCulling()) {
+                    if (!frustum.intersectsOBB(bbMin, bbMax, M)) {
+                        continue;
+                    }
+                }
 
-                    layouts.reserve(allSets.size());
-                    handles.reserve(allSets.size());
-                    
-                    for (auto& ds : allSets) {
-                        layouts.push_back(ds.layout);
-                        handles.push_back(ds.handle);
+                // hidden behind terrain or other occluders
+                if (frameInfo.occlusionCuller && obj->enableFrustumCulling()) {
+                    if (!frameInfo.occlusionCuller->isVisible(bbMin, bbMax, M)) {
+                        continue;
                     }
+                }
+
+                uint32_t firstInstance = 0;
+                uint32_t instanceCount = derived.cullInstances(*obj, frameInfo, frustum, firstInstance);
+                if (instanceCount == 0) {
+                    continue;
+                }
 
-                    PipelineConfigInfo cfg = material->getPipelineConfig();
-                    static_cast<Derived*>(this)->tweakPipelineConfig(cfg, frameInfo);
-                    PipelineInfo& pi = getOrCreatePipeline(cfg, layouts);
+                // world space bounding sphere
+                float scale = std::max({ glm::length(glm::vec3(M[0])), glm::length(glm::vec3(M[1])), glm::length(glm::vec3(M[2])) });
+                float radius = 0.5f * glm::length(bbMax - bbMin) * scale;
 
-                    // XOR fold hash
-                    size_t hash = 0;
-                    for (auto h : handles) {
-                        hash ^= std::hash<VkDescriptorSet>{}(h)+0x9e3779b9 + (hash << 6) + (hash >> 2);
+                // skip casters that would only cover a few texels of a coarse shadow cascade
+                if (frameInfo.minCasterRadius > 0.0f && obj->enableFrustumCulling()) {
+                    if (radius < frameInfo.minCasterRadius) {
+                        continue;
                     }
+                }
 
-                    renderItems.push_back(
-                        RenderItem{
-                            obj,
-                            &pi,
-                            std::move(handles),
-                            pi.pipelineLayout,
-                            reinterpret_cast<size_t>(pi.pipeline.get()), // TODO maybe add a getId() in pipeline
-                            hash
-                        }
-                    );
+                // level of detail from the projected sphere diameter (fraction of the screen height) as seen by the main camera,
+                // shadow passes use the same level so the shadow matches the visible mesh
+                // instanced objects have no single distance, they always use the full mesh
+                uint32_t lod = 0;
+                if (model.getLodCount() > 1 && frameInfo.lodProjectionScale > 0.0f && obj->getInstanceCount() == 1) {
+                    glm::vec3 center = glm::vec3(M * glm::vec4(0.5f * (bbMin + bbMax), 1.0f));
+                    float distance = std::max(glm::length(center - frameInfo.cameraPosition), 1e-3f);
+                    lod = model.selectLod(radius * frameInfo.lodProjectionScale / distance, obj->getLod());
+                    obj->setLod(lod);
                 }
+
+                auto material = model.getMaterial();
+                if (!material) continue;
+
+                material->updateDescriptorSet(frameIndex);
+                DescriptorSet materialSet = material->getDescriptorSet(frameIndex);
+
+                PipelineInfo* pi = getOrCreateMaterialPipeline(*material, materialSet, systemSets, systemSetCount, systemLayouts, renderPass, model.hasCompactVertices(), frameInfo);
+                uint32_t descriptorId = getDescriptorId(materialSet.handle);
+                uint16_t depthBucket = RenderKey::depthBucket(derived.sortDepth(*obj, frameInfo));
+
+                records[drawCount] = DrawRecord{ obj.get(), pi, materialSet.handle, materialSet.binding, descriptorId, lod, firstInstance, instanceCount };
+                entries[drawCount] = SortEntry{
+                    RenderKey::make(uint32_t(frameInfo.renderPassType), pi->id, descriptorId, depthBucket, Derived::DepthMajorSort),
+                    drawCount
+                };
+                frameObjects.push_back(std::move(obj));
+                drawCount++;
             }
 
-            std::sort(renderItems.begin(), renderItems.end(),
-                [](const RenderItem& a, const RenderItem& b) {
-                    if (a.pipelineId != b.pipelineId) {
-                        return a.pipelineId < b.pipelineId;
-                    }
-                    return a.descriptorHash < b.descriptorHash;
-                }
-            );
+            const SortEntry* sorted = radixSort(entries, scratch, drawCount);
 
-            vk::Pipeline* lastPipeline = nullptr;
-            size_t lastDescriptorHash = ~0ull;
+            if (drawCount > 0) {
+                derived.bindInstanceData(frameInfo);
+            }
+
+            PipelineInfo* lastPipeline = nullptr;
+            VkPipelineLayout lastLayout = VK_NULL_HANDLE;
+            VkDescriptorSet lastMaterialSet = VK_NULL_HANDLE;
+            std::array<VkDescriptorSet, MAX_BOUND_SETS> handles{};
 
-            for (const auto& item : renderItems) {
-                vk::Pipeline* currentPipeline = item.pipeline->pipeline.get();
+            for (uint32_t i = 0; i < drawCount; i++) {
+                const DrawRecord& record = records[sorted[i].record];
+                VkPipelineLayout layout = record.pipeline->pipelineLayout;
 
-                if (currentPipeline != lastPipeline) {
-                    item.pipeline->pipeline->bind(frameInfo.commandBuffer);
-                    lastPipeline = currentPipeline;
+                if (record.pipeline != lastPipeline) {
+                    record.pipeline->pipeline->bind(frameInfo.commandBuffer);
+                    lastPipeline = record.pipeline;
                 }
 
-                if (item.descriptorHash != lastDescriptorHash) {
+                if (layout != lastLayout || record.materialSet != lastMaterialSet) {
+                    // merge the material set into the sorted system sets by binding
+                    uint32_t setCount = 0;
+                    bool materialPlaced = false;
+                    for (uint32_t s = 0; s < systemSetCount; s++) {
+                        if (!materialPlaced && record.materialBinding < systemSets[s].binding) {
+                            handles[setCount++] = record.materialSet;
+                            materialPlaced = true;
+                        }
+                        handles[setCount++] = systemSets[s].handle;
+                    }
+                    if (!materialPlaced) {
+                        handles[setCount++] = record.materialSet;
+                    }
+
                     vkCmdBindDescriptorSets(
                         frameInfo.commandBuffer,
                         VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        item.layout,
+                        layout,
                         0,
-                        uint32_t(item.sets.size()),
-                        item.sets.data(),
+                        setCount,
+                        handles.data(),
                         0, nullptr
                     );
-                    lastDescriptorHash = item.descriptorHash;
+                    lastLayout = layout;
+                    lastMaterialSet = record.materialSet;
                 }
 
-                PushConst pc = static_cast<Derived*>(this)->buildPushConstant(item.obj, frameInfo, item.layout);
+                PushConst pc = derived.buildPushConstant(frameObjects[sorted[i].record], frameInfo, layout);
                 vkCmdPushConstants(
                     frameInfo.commandBuffer,
-                    item.layout,
+                    layout,
                     Derived::PushConstStages,
                     0,
                     sizeof(PushConst),
                     &pc
                 );
 
-                item.obj->getModel()->bind(frameInfo.commandBuffer);
-                item.obj->getModel()->draw(frameInfo.commandBuffer);
+                auto model = record.object->getModel();
+                model->bind(frameInfo.commandBuffer);
+                model->draw(frameInfo.commandBuffer, record.lod, record.instanceCount, record.firstInstance);
             }
 
-            return renderItems.size();
+            frameObjects.clear();
+            return int(drawCount);
         }
 
     };
@@ -3,26 +3,93 @@
 #include "../../scene/SceneManager.h"
 
 #include <cassert>
+#include <cstddef>
 
 
 namespace vk {
 
     TerrainRenderSystem::TerrainRenderSystem(Device& device, Renderer& renderer, RenderSystemSettings& settings) : BaseRenderSystem(device, renderer, settings) {}
 
-    std::vector<std::weak_ptr<GameObject>> TerrainRenderSystem::gatherObjects(const FrameInfo&) {
+    void TerrainRenderSystem::beginFrame(int frameIndex) {
+        currentFrame = frameIndex;
+        usedChunks = 0;
+
+        uint32_t totalChunks = 0;
+        for (auto& weakObj : SceneManager::getInstance().getTerrainRenderObjects()) {
+            if (auto obj = weakObj.lock()) {
+                if (auto* material = terrainMaterial(*obj)) {
+                    totalChunks += material->getQuadtree().getMaxSelection();
+                }
+            }
+        }
+
+        uint32_t requiredChunks = totalChunks * MAX_PASSES_PER_FRAME;
+        auto& buffer = chunkBuffers[frameIndex];
+        if (requiredChunks > 0) {
+            Buffer::reserveMapped(buffer, device, sizeof(TerrainQuadtree::Instance), requiredChunks, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        }
+    }
+
+    std::vector<std::weak_ptr<GameObject>> TerrainRenderSystem::gatherObjects(const FrameInfo& frameInfo) {
+        // terrain never moves, it only goes into the static shadow cache
+        if (frameInfo.renderPassType == RenderPassType::SHADOW_PASS && frameInfo.shadowCasters == ShadowCasters::DYNAMIC_ONLY) {
+            return {};
+        }
         return SceneManager::getInstance().getTerrainRenderObjects();
     }
 
     void TerrainRenderSystem::tweakPipelineConfig(PipelineConfigInfo& config, const FrameInfo& frameInfo) {
+        // one chunk rect and morph range per instance
+        VkVertexInputBindingDescription chunkBinding{};
+        chunkBinding.binding = 1;
+        chunkBinding.stride = sizeof(TerrainQuadtree::Instance);
+        chunkBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        config.bindingDescriptions.push_back(chunkBinding);
+
+        config.attributeDescriptions.push_back({ 4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(TerrainQuadtree::Instance, rect) });
+        config.attributeDescriptions.push_back({ 5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(TerrainQuadtree::Instance, morph) });
+
         if (frameInfo.renderPassType == RenderPassType::SHADOW_PASS) {
             Pipeline::terrainShadowPipelineConfigInfo(config);
         }
     }
 
-    TerrainPushConstantData TerrainRenderSystem::buildPushConstant(std::shared_ptr<GameObject> obj, const FrameInfo&, VkPipelineLayout) {
+    TerrainPushConstantData TerrainRenderSystem::buildPushConstant(const std::shared_ptr<GameObject>& obj, const FrameInfo&, VkPipelineLayout) {
         TerrainPushConstantData pc;
         pc.modelMatrix = obj->computeModelMatrix();
         pc.normalMatrix = obj->computeNormalMatrix();
         return pc;
     }
-}
\ No newline at end of file
+
+    uint32_t TerrainRenderSystem::cullInstances(GameObject& obj, const FrameInfo& frameInfo, const Frustum& frustum, uint32_t& firstInstance) {
+        auto* material = terrainMaterial(obj);
+        Buffer* buffer = chunkBuffers[currentFrame].get();
+        if (!material || !buffer) {
+            return 0;
+        }
+
+        // shadow passes select around the main camera as well, so shadows match the morphed main pass geometry
+        auto* out = static_cast<TerrainQuadtree::Instance*>(buffer->getMappedMemory());
+        uint32_t capacity = buffer->getInstanceCount() - usedChunks;
+
+        firstInstance = usedChunks;
+        usedChunks += material->getQuadtree().select(frustum, settings.enableFrustumCulling, obj.computeModelMatrix(),
+            material->getHeightScale(), frameInfo.cameraPosition, out + usedChunks, capacity);
+
+        return usedChunks - firstInstance;
+    }
+
+    void TerrainRenderSystem::bindInstanceData(const FrameInfo& frameInfo) {
+        VkBuffer buffers[] = { chunkBuffers[currentFrame]->getBuffer() };
+        VkDeviceSize offsets[] = { 0 };
+        vkCmdBindVertexBuffers(frameInfo.commandBuffer, 1, 1, buffers, offsets);
+    }
+
+    TessellationMaterial* TerrainRenderSystem::terrainMaterial(GameObject& obj) {
+        auto model = obj.getModel();
+        if (!model) {
+            return nullptr;
+        }
+        return dynamic_cast<TessellationMaterial*>(model->getMaterial().get());
+    }
+}
@@ -1,7 +1,11 @@
 #pragma once
 
 #include "BaseRenderSystem.h"
+#include "../ShadowMap.h"
+#include "../structures/TerrainQuadtree.h"
+#include "../../vk/vk_buffer.h"
 #include "../../vk/vk_frame_info.h"
+#include "../../vk/vk_swap_chain.h"
 #include "../materials/TessellationMaterial.h"
 
 namespace vk {
@@ -11,6 +15,7 @@ namespace vk {
         glm::mat4 normalMatrix{ 1.0f };
     };
 
+    // draws each terrain as one instanced chunk model, the chunks of every pass are selected from the quadtree of its material
     class TerrainRenderSystem : public BaseRenderSystem<TerrainRenderSystem, TerrainPushConstantData> {
 
     public:
@@ -20,10 +25,26 @@ namespace vk {
             VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT |
             VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
 
+        // every pass appends its chunks, the depth pre-pass, the main pass and one pass per shadow cascade
+        static constexpr uint32_t MAX_PASSES_PER_FRAME = ShadowMap::MAX_CASCADES + 2;
+
         TerrainRenderSystem(Device& device, Renderer& renderer, RenderSystemSettings& settings);
 
+        // call after the fence of the frame was waited on, resets (and grows) the chunk buffer of this frame
+        void beginFrame(int frameIndex);
+
         std::vector<std::weak_ptr<GameObject>> gatherObjects(const FrameInfo& frameInfo);
         void tweakPipelineConfig(PipelineConfigInfo& config, const FrameInfo& frameInfo);
-        TerrainPushConstantData buildPushConstant(std::shared_ptr<GameObject> obj, const FrameInfo& frameInfo, VkPipelineLayout layout);
+        TerrainPushConstantData buildPushConstant(const std::shared_ptr<GameObject>& obj, const FrameInfo& frameInfo, VkPipelineLayout layout);
+
+        uint32_t cullInstances(GameObject& obj, const FrameInfo& frameInfo, const Frustum& frustum, uint32_t& firstInstance);
+        void bindInstanceData(const FrameInfo& frameInfo);
+
+    private:
+        static TessellationMaterial* terrainMaterial(GameObject& obj);
+
+        std::array<std::unique_ptr<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> chunkBuffers;
+        int currentFrame = 0;
+        uint32_t usedChunks = 0;
     };
-}
\ No newline at end of file
+}
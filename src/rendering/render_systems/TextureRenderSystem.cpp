@@ -7,7 +7,17 @@ namespace vk {
 
     TextureRenderSystem::TextureRenderSystem(Device& device, Renderer& renderer, RenderSystemSettings& settings) : BaseRenderSystem(device, renderer, settings) {}
 
-    std::vector<std::weak_ptr<GameObject>> TextureRenderSystem::gatherObjects(const FrameInfo&) {
+    std::vector<std::weak_ptr<GameObject>> TextureRenderSystem::gatherObjects(const FrameInfo& frameInfo) {
+        if (frameInfo.renderPassType == RenderPassType::SHADOW_PASS) {
+            switch (frameInfo.shadowCasters) {
+                case ShadowCasters::STATIC_ONLY:
+                    return SceneManager::getInstance().getStaticShadowCasters();
+                case ShadowCasters::DYNAMIC_ONLY:
+                    return SceneManager::getInstance().getDynamicShadowCasters();
+                default:
+                    break;
+            }
+        }
         return SceneManager::getInstance().getStandardRenderObjects();
     }
 
@@ -17,10 +27,18 @@ namespace vk {
         }
     }
 
-    SimplePushConstantData TextureRenderSystem::buildPushConstant(std::shared_ptr<GameObject> obj, const FrameInfo&, VkPipelineLayout) {
+    SimplePushConstantData TextureRenderSystem::buildPushConstant(const std::shared_ptr<GameObject>& obj, const FrameInfo&, VkPipelineLayout) {
         SimplePushConstantData pc;
         pc.modelMatrix = obj->computeModelMatrix();
-        pc.normalMatrix = obj->computeNormalMatrix();
+        pc.normalMatrix = glm::mat3x4(obj->computeNormalMatrix());
+
+        // compact vertices store positions within the mesh bounds, their decode is folded into the model matrix
+        const Model& model = *obj->getModel();
+        if (model.hasCompactVertices()) {
+            pc.modelMatrix = pc.modelMatrix * model.getPositionDecodeMatrix();
+        }
+
+        pc.materialIndex = obj->getModel()->getMaterial()->getBindlessIndex();
         return pc;
     }
 }
\ No newline at end of file
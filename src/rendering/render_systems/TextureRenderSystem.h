@@ -7,10 +7,16 @@
 
 namespace vk {
 
+    // matches the push block of texture_shader.vert, 128 bytes so shaders declaring two mat4 still fit
     struct SimplePushConstantData {
         glm::mat4 modelMatrix{ 1.0f };
-        glm::mat4 normalMatrix{ 1.0f };
+        // upper 3x3 of the normal matrix with the column padding of a glsl mat3
+        glm::mat3x4 normalMatrix{ 1.0f };
+        // bindless material table slot, UINT32_MAX for bound materials
+        uint32_t materialIndex = UINT32_MAX;
+        uint32_t padding[3] = {};
     };
+    static_assert(sizeof(SimplePushConstantData) == 128, "push constants are limited to the guaranteed 128 bytes");
 
     class TextureRenderSystem : public BaseRenderSystem<TextureRenderSystem, SimplePushConstantData> {
 
@@ -21,6 +27,6 @@ namespace vk {
 
         std::vector<std::weak_ptr<GameObject>> gatherObjects(const FrameInfo& frameInfo);
         void tweakPipelineConfig(PipelineConfigInfo& config, const FrameInfo& frameInfo);
-        SimplePushConstantData buildPushConstant(std::shared_ptr<GameObject> obj, const FrameInfo& frameInfo, VkPipelineLayout layout);
+        SimplePushConstantData buildPushConstant(const std::shared_ptr<GameObject>& obj, const FrameInfo& frameInfo, VkPipelineLayout layout);
     };
 }
\ No newline at end of file
@@ -1,52 +1,449 @@
 #include "UIRenderSystem.h"
 
 #include "../../scene/SceneManager.h"
+#include "../../ui/UIAtlas.h"
+#include "../../Engine.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
 
 namespace vk {
 
-    UIRenderSystem::UIRenderSystem(Device& device, Renderer& renderer, RenderSystemSettings& settings) : BaseRenderSystem(device, renderer, settings) {}
+    namespace {
+        const DescriptorSet& findSystemSet(const std::vector<DescriptorSet>& sets, uint32_t binding) {
+            for (const auto& set : sets) {
+                if (set.binding == binding) {
+                    return set;
+                }
+            }
+            throw std::runtime_error("UIRenderSystem: Missing system descriptor set");
+        }
+
+        size_t grownCapacity(size_t required) {
+            return std::max<size_t>(256, required + required / 2);
+        }
+    }
+
+    UIRenderSystem::UIRenderSystem(Device& device, Renderer& renderer, RenderSystemSettings& settings) : device(device), renderer(renderer), settings(settings) {
+        atlasSetLayout = DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .build();
+
+        // the atlas set lives as long as the system
+        atlasDescriptorPool = DescriptorPool::Builder(device)
+            .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+            .setMaxSets(1)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
+            .build();
+
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.anisotropyEnable = VK_FALSE;
+        samplerInfo.maxAnisotropy = 1.0f;
+        samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        samplerInfo.unnormalizedCoordinates = VK_FALSE;
+        samplerInfo.compareEnable = VK_FALSE;
+        samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = 0.0f;
+
+        if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &atlasSampler) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create ui atlas sampler");
+        }
+
+        createAtlasTexture();
+    }
+
+    UIRenderSystem::~UIRenderSystem() {
+        destroyAtlasTexture();
+
+        auto destructionQueue = Engine::getDestructionQueue();
+        if (destructionQueue) {
+            if (atlasSampler != VK_NULL_HANDLE) {
+                destructionQueue->pushSampler(atlasSampler);
+            }
+            if (pipelineLayout != VK_NULL_HANDLE) {
+                destructionQueue->pushPipelineLayout(pipelineLayout);
+            }
+        } else {
+            if (atlasSampler != VK_NULL_HANDLE) {
+                vkDestroySampler(device.device(), atlasSampler, nullptr);
+            }
+            if (pipelineLayout != VK_NULL_HANDLE) {
+                vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+            }
+        }
+    }
+
+    void UIRenderSystem::prewarmPipelines(const std::vector<PipelinePrewarmPass>& passes) {
+        for (const auto& pass : passes) {
+            getOrCreatePipeline(pass.renderPass, pass.systemDescriptorSets);
+        }
+    }
+
+    int UIRenderSystem::renderGameObjects(FrameInfo& frameInfo) {
+        updateBatch();
+
+        if (indices.empty()) {
+            return 0;
+        }
+
+        FrameBuffers& frame = frames[renderer.getFrameIndex()];
+        uploadBatch(frame);
+
+        Pipeline& pipeline = getOrCreatePipeline(renderer.getCurrentRenderPass(), frameInfo.systemDescriptorSets);
+        pipeline.bind(frameInfo.commandBuffer);
+
+        // global ubo for the orthographic projection, then the atlas
+        std::array<VkDescriptorSet, 2> sets{
+            findSystemSet(frameInfo.systemDescriptorSets, 0).handle,
+            atlasDescriptorSet
+        };
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            uint32_t(sets.size()),
+            sets.data(),
+            0, nullptr
+        );
+
+        VkBuffer vertexBuffers[] = { frame.vertexBuffer->getBuffer() };
+        VkDeviceSize offsets[] = { 0 };
+        vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(frameInfo.commandBuffer, frame.indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+        vkCmdDrawIndexed(frameInfo.commandBuffer, uint32_t(indices.size()), 1, 0, 0, 0);
+
+        return int(entries.size());
+    }
+
+    void UIRenderSystem::updateBatch() {
+        visible.clear();
+        for (auto& weakObj : SceneManager::getInstance().getUIObjects()) {
+            if (auto obj = weakObj.lock()) {
+                auto component = std::static_pointer_cast<UIComponent>(obj);
+                if (!component->getMesh().vertices.empty()) {
+                    visible.push_back(std::move(component));
+                }
+            }
+        }
+
+        // back to front by z, the id keeps the order stable between frames
+        std::sort(visible.begin(), visible.end(), [](const auto& a, const auto& b) {
+            float za = a->getPosition().z;
+            float zb = b->getPosition().z;
+            return za != zb ? za < zb : a->getId() < b->getId();
+        });
+
+        bool rebuild = visible.size() != entries.size();
+        for (size_t i = 0; i < visible.size() && !rebuild; i++) {
+            const UIMesh& mesh = visible[i]->getMesh();
+            size_t indexCount = mesh.indices.empty() ? mesh.vertices.size() : mesh.indices.size();
+            rebuild = entries[i].id != visible[i]->getId()
+                || entries[i].vertexCount != mesh.vertices.size()
+                || entries[i].indexCount != indexCount;
+        }
+
+        if (rebuild) {
+            batchRevision++;
+            layoutRevision = batchRevision;
+
+            entries.resize(visible.size());
+            uint32_t firstVertex = 0;
+            uint32_t firstIndex = 0;
+            for (size_t i = 0; i < visible.size(); i++) {
+                const UIMesh& mesh = visible[i]->getMesh();
+
+                BatchEntry& entry = entries[i];
+                entry.id = visible[i]->getId();
+                entry.meshRevision = visible[i]->getMeshRevision();
+                entry.modelMatrix = visible[i]->computeModelMatrix();
+                entry.firstVertex = firstVertex;
+                entry.vertexCount = uint32_t(mesh.vertices.size());
+                entry.firstIndex = firstIndex;
+                entry.indexCount = uint32_t(mesh.indices.empty() ? mesh.vertices.size() : mesh.indices.size());
+                entry.changedAt = batchRevision;
+
+                firstVertex += entry.vertexCount;
+                firstIndex += entry.indexCount;
+            }
+
+            vertices.resize(firstVertex);
+            indices.resize(firstIndex);
+            for (size_t i = 0; i < visible.size(); i++) {
+                writeEntry(*visible[i], entries[i]);
+            }
+            visible.clear();
+            return;
+        }
+
+        // same layout, only copy the components that moved or changed their mesh (e.g. a counter that ticked)
+        bool changed = false;
+        for (size_t i = 0; i < visible.size(); i++) {
+            BatchEntry& entry = entries[i];
+            glm::mat4 modelMatrix = visible[i]->computeModelMatrix();
+            uint64_t meshRevision = visible[i]->getMeshRevision();
+            if (modelMatrix == entry.modelMatrix && meshRevision == entry.meshRevision) {
+                continue;
+            }
+
+            if (!changed) {
+                batchRevision++;
+                changed = true;
+            }
+            entry.modelMatrix = modelMatrix;
+            entry.meshRevision = meshRevision;
+            entry.changedAt = batchRevision;
+            writeEntry(*visible[i], entry);
+        }
+        visible.clear();
+    }
+
+    void UIRenderSystem::writeEntry(const UIComponent& component, const BatchEntry& entry) {
+        const UIMesh& mesh = component.getMesh();
+
+        for (uint32_t v = 0; v < entry.vertexCount; v++) {
+            UIVertex vertex = mesh.vertices[v];
+            vertex.position = glm::vec3(entry.modelMatrix * glm::vec4(vertex.position, 1.0f));
+            vertices[entry.firstVertex + v] = vertex;
+        }
+
+        // indices address the shared vertex buffer, the whole batch is one draw without vertex offsets
+        for (uint32_t i = 0; i < entry.indexCount; i++) {
+            uint32_t index = mesh.indices.empty() ? i : mesh.indices[i];
+            indices[entry.firstIndex + i] = entry.firstVertex + index;
+        }
+    }
+
+    void UIRenderSystem::uploadBatch(FrameBuffers& frame) {
+        if (frame.revision == batchRevision) {
+            return;
+        }
 
-    std::vector<std::weak_ptr<GameObject>> UIRenderSystem::gatherObjects(const FrameInfo&) {
-        // grab all the ui weak_ptrs
-        auto uiWeak = SceneManager::getInstance().getUIObjects();
+        bool writeAll = frame.revision < layoutRevision;
 
-        // filter out invalid or non-renderable
-        std::vector<std::shared_ptr<GameObject>> valid;
-        valid.reserve(uiWeak.size());
-        for (auto& wp : uiWeak) {
-            if (auto sp = wp.lock()) {
-                if (sp->getModel() && sp->getModel()->getMaterial()) {
-                    valid.push_back(sp);
+        if (Buffer::reserveMapped(frame.vertexBuffer, device, sizeof(UIVertex), uint32_t(vertices.size()),
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, uint32_t(grownCapacity(vertices.size())))) {
+            writeAll = true;
+        }
+        if (Buffer::reserveMapped(frame.indexBuffer, device, sizeof(uint32_t), uint32_t(indices.size()),
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT, uint32_t(grownCapacity(indices.size())))) {
+            writeAll = true;
+        }
+
+        if (writeAll) {
+            frame.vertexBuffer->writeToBuffer(vertices.data(), sizeof(UIVertex) * vertices.size(), 0);
+            frame.indexBuffer->writeToBuffer(indices.data(), sizeof(uint32_t) * indices.size(), 0);
+        } else {
+            // everything this buffer missed since it was last written
+            for (const BatchEntry& entry : entries) {
+                if (entry.changedAt <= frame.revision) {
+                    continue;
                 }
+                frame.vertexBuffer->writeToBuffer(
+                    &vertices[entry.firstVertex], sizeof(UIVertex) * entry.vertexCount, sizeof(UIVertex) * entry.firstVertex);
+                frame.indexBuffer->writeToBuffer(
+                    &indices[entry.firstIndex], sizeof(uint32_t) * entry.indexCount, sizeof(uint32_t) * entry.firstIndex);
             }
         }
 
-        // sort back-to-front by world-space z
-        std::sort(valid.begin(), valid.end(),
-            [](const std::shared_ptr<GameObject>& a, const std::shared_ptr<GameObject>& b) {
-                return a->getPosition().z < b->getPosition().z;
-            });
+        frame.revision = batchRevision;
+    }
 
-        // convert back to weak_ptr list
-        std::vector<std::weak_ptr<GameObject>> sorted;
-        sorted.reserve(valid.size());
-        for (auto& sp : valid) {
-            sorted.emplace_back(sp);
+    void UIRenderSystem::createAtlasTexture() {
+        // contents come from the first recordAtlasUpdates, the render graph transitions the image from undefined
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = UIAtlas::SIZE;
+        imageInfo.extent.height = UIAtlas::SIZE;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+        device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, atlasImage, atlasImageMemory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = atlasImage;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device.device(), &viewInfo, nullptr, &atlasImageView) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create ui atlas image view");
+        }
+
+        VkDescriptorImageInfo descriptorImageInfo{};
+        descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        descriptorImageInfo.imageView = atlasImageView;
+        descriptorImageInfo.sampler = atlasSampler;
+
+        if (!DescriptorWriter(*atlasSetLayout, *atlasDescriptorPool).writeImage(0, &descriptorImageInfo).build(atlasDescriptorSet)) {
+            throw std::runtime_error("Failed to allocate ui atlas descriptor set");
         }
-        return sorted;
     }
 
-    void UIRenderSystem::tweakPipelineConfig(PipelineConfigInfo&, const FrameInfo&) {
-        // use standard pipeline from material (no tweaking)
+    bool UIRenderSystem::hasAtlasUpdates() const {
+        return !atlasUploaded || UIAtlas::getInstance().hasDirtyRects();
     }
 
-    UIPushConstantData UIRenderSystem::buildPushConstant(std::shared_ptr<GameObject> obj, const FrameInfo&, VkPipelineLayout) {
-        UIPushConstantData pc;
-        pc.modelMatrix = obj->computeModelMatrix();
-        pc.normalMatrix = obj->computeNormalMatrix();
-        // TODO put in texture ubo and not dependent on descriptor set
-        pc.hasTexture = (obj->getModel()->getMaterial()->getDescriptorSet(renderer.getFrameIndex()).handle != VK_NULL_HANDLE);
-        return pc;
+    void UIRenderSystem::recordAtlasUpdates(VkCommandBuffer commandBuffer) {
+        UIAtlas& atlas = UIAtlas::getInstance();
+        std::vector<UIAtlas::Rect> rects = atlas.takeDirtyRects();
+        if (!atlasUploaded) {
+            rects = { { 0, 0, UIAtlas::SIZE, UIAtlas::SIZE } };
+            atlasUploaded = true;
+        }
+        if (rects.empty()) {
+            return;
+        }
+
+        VkDeviceSize stagingSize = 0;
+        for (const UIAtlas::Rect& rect : rects) {
+            stagingSize += VkDeviceSize(rect.width) * rect.height * 4;
+        }
+
+        // released through the destruction queue once the frame finished, see ~Buffer
+        Buffer stagingBuffer{
+            device,
+            1,
+            uint32_t(stagingSize),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        };
+        stagingBuffer.map();
+        unsigned char* staging = static_cast<unsigned char*>(stagingBuffer.getMappedMemory());
+
+        const std::vector<unsigned char>& pixels = atlas.getPixels();
+        std::vector<VkBufferImageCopy> copies;
+        copies.reserve(rects.size());
+        VkDeviceSize offset = 0;
+        for (const UIAtlas::Rect& rect : rects) {
+            // rows of the rect packed tightly one after another
+            size_t rowSize = size_t(rect.width) * 4;
+            for (uint32_t y = 0; y < rect.height; y++) {
+                std::memcpy(staging + offset + y * rowSize, &pixels[((size_t(rect.y) + y) * UIAtlas::SIZE + rect.x) * 4], rowSize);
+            }
+
+            VkBufferImageCopy copy{};
+            copy.bufferOffset = offset;
+            copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copy.imageSubresource.mipLevel = 0;
+            copy.imageSubresource.baseArrayLayer = 0;
+            copy.imageSubresource.layerCount = 1;
+            copy.imageOffset = { int32_t(rect.x), int32_t(rect.y), 0 };
+            copy.imageExtent = { rect.width, rect.height, 1 };
+            copies.push_back(copy);
+
+            offset += VkDeviceSize(rowSize) * rect.height;
+        }
+
+        vkCmdCopyBufferToImage(
+            commandBuffer,
+            stagingBuffer.getBuffer(),
+            atlasImage,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            uint32_t(copies.size()),
+            copies.data());
+    }
+
+    void UIRenderSystem::destroyAtlasTexture() {
+        auto destructionQueue = Engine::getDestructionQueue();
+        if (destructionQueue) {
+            if (atlasDescriptorSet != VK_NULL_HANDLE) {
+                destructionQueue->pushDescriptorSet(atlasDescriptorSet, atlasDescriptorPool->getPool());
+            }
+            if (atlasImageView != VK_NULL_HANDLE) {
+                destructionQueue->pushImageView(atlasImageView);
+            }
+            if (atlasImage != VK_NULL_HANDLE) {
+                destructionQueue->pushImage(atlasImage, atlasImageMemory);
+            }
+        } else {
+            if (atlasImageView != VK_NULL_HANDLE) {
+                vkDestroyImageView(device.device(), atlasImageView, nullptr);
+            }
+            if (atlasImage != VK_NULL_HANDLE) {
+                vkDestroyImage(device.device(), atlasImage, nullptr);
+                vkFreeMemory(device.device(), atlasImageMemory, nullptr);
+            }
+        }
+
+        atlasDescriptorSet = VK_NULL_HANDLE;
+        atlasImageView = VK_NULL_HANDLE;
+        atlasImage = VK_NULL_HANDLE;
+        atlasImageMemory = VK_NULL_HANDLE;
+    }
+
+    Pipeline& UIRenderSystem::getOrCreatePipeline(VkRenderPass renderPass, const std::vector<DescriptorSet>& systemDescriptorSets) {
+        auto it = pipelines.find(renderPass);
+        if (it != pipelines.end()) {
+            return *it->second;
+        }
+
+        if (pipelineLayout == VK_NULL_HANDLE) {
+            std::array<VkDescriptorSetLayout, 2> setLayouts{
+                findSystemSet(systemDescriptorSets, 0).layout,
+                atlasSetLayout->getDescriptorSetLayout()
+            };
+
+            VkPipelineLayoutCreateInfo layoutInfo{};
+            layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            layoutInfo.setLayoutCount = uint32_t(setLayouts.size());
+            layoutInfo.pSetLayouts = setLayouts.data();
+            layoutInfo.pushConstantRangeCount = 0;
+
+            if (vkCreatePipelineLayout(device.device(), &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create pipeline layout");
+            }
+        }
+
+        PipelineConfigInfo config{};
+        Pipeline::defaultPipelineConfigInfo(config);
+        config.vertShaderPath = "ui_batch_shader.vert";
+        config.fragShaderPath = "ui_batch_shader.frag";
+        config.bindingDescriptions = UIVertex::getBindingDescriptions();
+        config.attributeDescriptions = UIVertex::getAttributeDescriptions();
+
+        // 3d hud meshes need the depth test against themselves, the depth buffer is cleared before the ui
+        // less or equal lets coplanar quads later in the batch (back to front) still draw over earlier ones
+        config.rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+        config.depthStencilInfo.depthTestEnable = VK_TRUE;
+        config.depthStencilInfo.depthWriteEnable = VK_TRUE;
+        config.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+        config.colorBlendAttachment.blendEnable = VK_TRUE;
+        config.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        config.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        config.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        config.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        config.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        config.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+        config.renderPass = renderPass;
+        config.pipelineLayout = pipelineLayout;
+
+        auto pipeline = std::make_unique<Pipeline>(device, config);
+        return *pipelines.emplace(renderPass, std::move(pipeline)).first->second;
     }
-}
\ No newline at end of file
+}
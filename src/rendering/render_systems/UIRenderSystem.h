@@ -2,26 +2,104 @@
 
 #include "BaseRenderSystem.h"
 
+#include "../../ui/UIComponent.h"
+#include "../../ui/UIMesh.h"
+#include "../../vk/vk_buffer.h"
 #include "../../vk/vk_frame_info.h"
+#include "../../vk/vk_swap_chain.h"
 
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
-namespace vk {
 
-    struct UIPushConstantData {
-        glm::mat4 modelMatrix;
-        glm::mat4 normalMatrix;
-        int hasTexture;
-    };
+namespace vk {
 
-    class UIRenderSystem : public BaseRenderSystem<UIRenderSystem, UIPushConstantData> {
+    // draws the whole ui with one pipeline, one descriptor set and one indexed draw
+    // meshes are transformed to pixels on the cpu and packed into a persistently mapped buffer per frame in flight,
+    // all images live in the ui atlas
+    // the batch is retained: only components whose mesh or transform changed are copied again,
+    // the buffers are only rewritten completely when components appear, disappear, reorder or change their size
+    class UIRenderSystem {
 
     public:
-        static constexpr VkShaderStageFlags PushConstStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-
         UIRenderSystem(Device& device, Renderer& renderer, RenderSystemSettings& settings);
+        ~UIRenderSystem();
+
+        UIRenderSystem(const UIRenderSystem&) = delete;
+        UIRenderSystem& operator=(const UIRenderSystem&) = delete;
+
+        void prewarmPipelines(const std::vector<PipelinePrewarmPass>& passes);
+
+        // @returns num of drawn ui components
+        int renderGameObjects(FrameInfo& frameInfo);
+
+        // imported into the render graph, the main pass samples it after the upload pass wrote it
+        VkImage getAtlasImage() const { return atlasImage; }
+        // the whole atlas on the first frame, afterwards only when images were added
+        bool hasAtlasUpdates() const;
+        // copies the changed atlas rects, recorded before the render pass with the image in TRANSFER_DST_OPTIMAL
+        void recordAtlasUpdates(VkCommandBuffer commandBuffer);
+
+    private:
+        // range of one component in the batch
+        struct BatchEntry {
+            id_t id = INVALID_OBJECT_ID;
+            uint64_t meshRevision = 0;
+            glm::mat4 modelMatrix{ 1.0f };
+            uint32_t firstVertex = 0;
+            uint32_t vertexCount = 0;
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            // batch revision of the last change
+            uint64_t changedAt = 0;
+        };
+
+        struct FrameBuffers {
+            std::unique_ptr<Buffer> vertexBuffer;
+            std::unique_ptr<Buffer> indexBuffer;
+            // batch revision the buffers hold, 0 if never written
+            uint64_t revision = 0;
+        };
+
+        void updateBatch();
+        // transforms the mesh into the batch arrays at the entry's range
+        void writeEntry(const UIComponent& component, const BatchEntry& entry);
+        void uploadBatch(FrameBuffers& frame);
+
+        void createAtlasTexture();
+        void destroyAtlasTexture();
+
+        Pipeline& getOrCreatePipeline(VkRenderPass renderPass, const std::vector<DescriptorSet>& systemDescriptorSets);
+
+        Device& device;
+        Renderer& renderer;
+        RenderSystemSettings& settings;
+
+        // scratch of the current frame, visible components back to front
+        std::vector<std::shared_ptr<UIComponent>> visible;
+
+        std::vector<BatchEntry> entries;
+        std::vector<UIVertex> vertices;
+        std::vector<uint32_t> indices;
+        uint64_t batchRevision = 1;
+        // batch revision of the last complete rebuild
+        uint64_t layoutRevision = 1;
+
+        std::array<FrameBuffers, SwapChain::MAX_FRAMES_IN_FLIGHT> frames;
+
+        // atlas texture, created once, images added later only copy their rect into it
+        bool atlasUploaded = false;
+        VkImage atlasImage = VK_NULL_HANDLE;
+        VkDeviceMemory atlasImageMemory = VK_NULL_HANDLE;
+        VkImageView atlasImageView = VK_NULL_HANDLE;
+        VkSampler atlasSampler = VK_NULL_HANDLE;
+        VkDescriptorSet atlasDescriptorSet = VK_NULL_HANDLE;
+        std::unique_ptr<DescriptorSetLayout> atlasSetLayout;
+        std::unique_ptr<DescriptorPool> atlasDescriptorPool;
 
-        std::vector<std::weak_ptr<GameObject>> gatherObjects(const FrameInfo& frameInfo);
-        void tweakPipelineConfig(PipelineConfigInfo& config, const FrameInfo& frameInfo);
-        UIPushConstantData buildPushConstant(std::shared_ptr<GameObject> obj, const FrameInfo& frameInfo, VkPipelineLayout layout);
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::unordered_map<VkRenderPass, std::unique_ptr<Pipeline>> pipelines;
     };
-}
\ No newline at end of file
+}
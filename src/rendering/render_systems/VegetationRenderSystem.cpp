@@ -0,0 +1,129 @@
+#include "VegetationRenderSystem.h"
+
+#include "../../scene/SceneManager.h"
+
+#include <cstddef>
+
+
+namespace vk {
+
+    VegetationRenderSystem::VegetationRenderSystem(Device& device, Renderer& renderer, RenderSystemSettings& settings) : BaseRenderSystem(device, renderer, settings) {}
+
+    void VegetationRenderSystem::beginFrame(int frameIndex) {
+        currentFrame = frameIndex;
+        usedInstances = 0;
+
+        uint32_t totalInstances = 0;
+        for (auto& weakObj : SceneManager::getInstance().getVegetationObjects()) {
+            if (auto obj = weakObj.lock()) {
+                totalInstances += obj->getInstanceCount();
+            }
+        }
+
+        uint32_t requiredInstances = totalInstances * MAX_PASSES_PER_FRAME;
+        auto& buffer = instanceBuffers[frameIndex];
+        if (requiredInstances > 0) {
+            Buffer::reserveMapped(buffer, device, sizeof(VegetationBatch::Instance), requiredInstances, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        }
+    }
+
+    std::vector<std::weak_ptr<GameObject>> VegetationRenderSystem::gatherObjects(const FrameInfo& frameInfo) {
+        // vegetation never moves, it belongs to the cached static shadow casters
+        if (frameInfo.renderPassType == RenderPassType::SHADOW_PASS && frameInfo.shadowCasters == ShadowCasters::DYNAMIC_ONLY) {
+            return {};
+        }
+        return SceneManager::getInstance().getVegetationObjects();
+    }
+
+    void VegetationRenderSystem::tweakPipelineConfig(PipelineConfigInfo& config, const FrameInfo& frameInfo) {
+        // material shaders stay, only the vertex stage reads the instance transform
+        config.vertShaderPath = "vegetation_shader.vert";
+
+        VkVertexInputBindingDescription instanceBinding{};
+        instanceBinding.binding = 1;
+        instanceBinding.stride = sizeof(VegetationBatch::Instance);
+        instanceBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        config.bindingDescriptions.push_back(instanceBinding);
+
+        config.attributeDescriptions.push_back({ 4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(VegetationBatch::Instance, positionScale) });
+        config.attributeDescriptions.push_back({ 5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(VegetationBatch::Instance, rotation) });
+
+        if (frameInfo.renderPassType == RenderPassType::SHADOW_PASS) {
+            Pipeline::shadowPipelineConfigInfo(config);
+        }
+    }
+
+    VegetationPushConstantData VegetationRenderSystem::buildPushConstant(const std::shared_ptr<GameObject>& obj, const FrameInfo&, VkPipelineLayout) {
+        VegetationPushConstantData pc;
+        // the instances carry the transform, the model matrix only decodes compact vertex positions
+        pc.modelMatrix = obj->getModel()->getPositionDecodeMatrix();
+
+        // same layout as the texture render system, so the bindless fragment shader works unchanged
+        pc.materialIndex = obj->getModel()->getMaterial()->getBindlessIndex();
+        return pc;
+    }
+
+    uint32_t VegetationRenderSystem::cullInstances(GameObject& obj, const FrameInfo& frameInfo, const Frustum& frustum, uint32_t& firstInstance) {
+        auto* batch = dynamic_cast<VegetationBatch*>(&obj);
+        Buffer* buffer = instanceBuffers[currentFrame].get();
+        if (!batch || !buffer) {
+            return 0;
+        }
+
+        // beyond this distance the impostor of the tree is drawn instead
+        float maxDistance = batch->getMaxInstanceDistance();
+        bool limitDistance = frameInfo.renderPassType != RenderPassType::SHADOW_PASS && maxDistance < std::numeric_limits<float>::max();
+        float maxDistanceSquared = maxDistance * maxDistance;
+
+        const glm::vec3& localCenter = batch->getLocalCenter();
+        auto* out = static_cast<VegetationBatch::Instance*>(buffer->getMappedMemory());
+        uint32_t capacity = buffer->getInstanceCount();
+
+        firstInstance = usedInstances;
+        for (const auto& instance : batch->getInstances()) {
+            if (usedInstances >= capacity) {
+                break;
+            }
+
+            glm::vec3 base = glm::vec3(instance.positionScale);
+            float scale = instance.positionScale.w;
+
+            if (limitDistance) {
+                glm::vec3 toCamera = base - frameInfo.cameraPosition;
+                if (glm::dot(toCamera, toCamera) > maxDistanceSquared) {
+                    continue;
+                }
+            }
+
+            float radius = batch->getLocalRadius() * scale;
+
+            // skip casters that would only cover a few texels of a coarse shadow cascade
+            if (frameInfo.minCasterRadius > 0.0f && radius < frameInfo.minCasterRadius) {
+                continue;
+            }
+
+            // yaw around the base, same rotation as vegetation_shader.vert
+            float c = instance.rotation.x;
+            float s = instance.rotation.y;
+            glm::vec3 center = base + scale * glm::vec3(c * localCenter.x + s * localCenter.z, localCenter.y, -s * localCenter.x + c * localCenter.z);
+
+            if (settings.enableFrustumCulling && !frustum.intersectsSphere(center, radius)) {
+                continue;
+            }
+
+            if (frameInfo.occlusionCuller && !frameInfo.occlusionCuller->isSphereVisible(center, radius)) {
+                continue;
+            }
+
+            out[usedInstances++] = instance;
+        }
+
+        return usedInstances - firstInstance;
+    }
+
+    void VegetationRenderSystem::bindInstanceData(const FrameInfo& frameInfo) {
+        VkBuffer buffers[] = { instanceBuffers[currentFrame]->getBuffer() };
+        VkDeviceSize offsets[] = { 0 };
+        vkCmdBindVertexBuffers(frameInfo.commandBuffer, 1, 1, buffers, offsets);
+    }
+}
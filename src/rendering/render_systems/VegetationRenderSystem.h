@@ -0,0 +1,49 @@
+#pragma once
+
+#include "BaseRenderSystem.h"
+
+#include "../ShadowMap.h"
+#include "../structures/VegetationBatch.h"
+#include "../../vk/vk_buffer.h"
+#include "../../vk/vk_frame_info.h"
+#include "../../vk/vk_swap_chain.h"
+
+
+namespace vk {
+
+    // same layout as SimplePushConstantData, the normal matrix is unused since the instances only rotate around y
+    struct VegetationPushConstantData {
+        glm::mat4 modelMatrix{ 1.0f };
+        glm::mat3x4 normalMatrix{ 1.0f };
+        uint32_t materialIndex = UINT32_MAX;
+        uint32_t padding[3] = {};
+    };
+
+    // draws every vegetation batch with one instanced draw per pass
+    // visible instances are culled on the cpu and compacted into a per frame instance vertex buffer
+    class VegetationRenderSystem : public BaseRenderSystem<VegetationRenderSystem, VegetationPushConstantData> {
+
+    public:
+        static constexpr VkShaderStageFlags PushConstStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        // every pass appends its visible instances, the depth pre-pass, the main pass and one pass per shadow cascade
+        static constexpr uint32_t MAX_PASSES_PER_FRAME = ShadowMap::MAX_CASCADES + 2;
+
+        VegetationRenderSystem(Device& device, Renderer& renderer, RenderSystemSettings& settings);
+
+        // call after the fence of the frame was waited on, resets (and grows) the instance buffer of this frame
+        void beginFrame(int frameIndex);
+
+        std::vector<std::weak_ptr<GameObject>> gatherObjects(const FrameInfo& frameInfo);
+        void tweakPipelineConfig(PipelineConfigInfo& config, const FrameInfo& frameInfo);
+        VegetationPushConstantData buildPushConstant(const std::shared_ptr<GameObject>& obj, const FrameInfo& frameInfo, VkPipelineLayout layout);
+
+        uint32_t cullInstances(GameObject& obj, const FrameInfo& frameInfo, const Frustum& frustum, uint32_t& firstInstance);
+        void bindInstanceData(const FrameInfo& frameInfo);
+
+    private:
+        std::array<std::unique_ptr<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> instanceBuffers;
+        int currentFrame = 0;
+        uint32_t usedInstances = 0;
+    };
+}
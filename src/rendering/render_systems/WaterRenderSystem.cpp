@@ -1,6 +1,7 @@
 #include "WaterRenderSystem.h"
 
 #include "../../scene/SceneManager.h"
+#include "../structures/WaterObject.h"
 
 
 namespace vk {
@@ -15,11 +16,17 @@ namespace vk {
         // use standard pipeline from material (no tweaking)
     }
 
-    WaterPushConstantData WaterRenderSystem::buildPushConstant(std::shared_ptr<GameObject> obj, const FrameInfo& frameInfo, VkPipelineLayout) {
+    WaterPushConstantData WaterRenderSystem::buildPushConstant(const std::shared_ptr<GameObject>& obj, const FrameInfo& frameInfo, VkPipelineLayout) {
         WaterPushConstantData pc;
         pc.modelMatrix = obj->computeModelMatrix();
         pc.normalMatrix = obj->computeNormalMatrix();
+        pc.gridInfo = glm::vec4(0.0f);
         pc.gridInfo.x = obj->getModel()->patchCount;
+        pc.gridInfo.y = 1.0f;
+        if (auto* water = dynamic_cast<WaterObject*>(obj.get())) {
+            pc.gridInfo.y = water->getRingCount();
+        }
+        pc.gridInfo.z = settings.enableFrustumCulling ? 1.0f : 0.0f;
         pc.timeData.x = SceneManager::getInstance().gameTime;
         return pc;
     }
@@ -14,6 +14,7 @@ namespace vk {
         glm::vec4 gridInfo;
     };
 
+    // each water object is a clipmap drawn with one instanced draw, see WaterObject
     class WaterRenderSystem : public BaseRenderSystem<WaterRenderSystem, WaterPushConstantData> {
 
     public:
@@ -27,6 +28,6 @@ namespace vk {
 
         std::vector<std::weak_ptr<GameObject>> gatherObjects(const FrameInfo& frameInfo);
         void tweakPipelineConfig(PipelineConfigInfo& config, const FrameInfo& frameInfo);
-        WaterPushConstantData buildPushConstant(std::shared_ptr<GameObject> obj, const FrameInfo& frameInfo, VkPipelineLayout layout);
+        WaterPushConstantData buildPushConstant(const std::shared_ptr<GameObject>& obj, const FrameInfo& frameInfo, VkPipelineLayout layout);
     };
 }
\ No newline at end of file
@@ -61,6 +61,16 @@ struct Frustum {
         return f;
     }
 
+    // test a sphere in world space
+    bool intersectsSphere(const glm::vec3& center, float radius) const {
+        for (int i = 0; i < 6; ++i) {
+            if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     // test an AABB in world space
     bool intersectsOBB(
         const glm::vec3& bbMin,
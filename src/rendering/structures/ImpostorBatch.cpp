@@ -0,0 +1,32 @@
+#include "ImpostorBatch.h"
+
+namespace vk {
+	ImpostorBatch::ImpostorBatch(Device& device, std::shared_ptr<ImpostorMaterial> material, const std::vector<ImpostorMaterial::Instance>& instances)
+		: count(static_cast<uint32_t>(instances.size())) {
+
+		Model::Builder builder{};
+		const glm::vec2 corners[4] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+		for (const auto& corner : corners) {
+			Model::Vertex vertex{};
+			vertex.position = glm::vec3(corner, 0.0f);
+			vertex.color = glm::vec3(1.0f);
+			vertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+			vertex.uv = corner * 0.5f + 0.5f;
+			builder.vertices.push_back(vertex);
+		}
+		builder.indices = { 0, 1, 2, 2, 3, 0 };
+		builder.boundsMin = glm::vec3(-1.0f, -1.0f, 0.0f);
+		builder.boundsMax = glm::vec3(1.0f, 1.0f, 0.0f);
+
+		modelPtr = std::make_shared<Model>(device, builder);
+		modelPtr->setMaterial(material);
+		modelPtr->createInstanceBuffer(instances.data(), sizeof(ImpostorMaterial::Instance), count);
+
+		for (const auto& instance : instances) {
+			center += glm::vec3(instance.positionScale);
+		}
+		if (count > 0) {
+			center /= static_cast<float>(count);
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../../GameObject.h"
+#include "../materials/ImpostorMaterial.h"
+
+namespace vk {
+	// one camera facing quad per instance of the impostor material, drawn with a single instanced draw
+	class ImpostorBatch : public GameObject {
+
+	public:
+
+		ImpostorBatch(Device& device, std::shared_ptr<ImpostorMaterial> material, const std::vector<ImpostorMaterial::Instance>& instances);
+
+		// instances are already in world space
+		glm::mat4 computeModelMatrix() const override {
+			return glm::mat4(1.0f);
+		}
+
+		glm::mat4 computeNormalMatrix() const override {
+			return glm::mat4(1.0f);
+		}
+
+		glm::vec3 getPosition() const override {
+			return center;
+		}
+
+		std::shared_ptr<Model> getModel() const override {
+			return modelPtr;
+		}
+
+		// the quad is expanded in the vertex shader, its bounds say nothing about the batch
+		bool enableFrustumCulling() const override { return false; }
+
+		bool castsShadows() const override { return false; }
+
+		uint32_t getInstanceCount() const override { return count; }
+
+	private:
+
+		std::shared_ptr<Model> modelPtr;
+		glm::vec3 center{ 0.0f };
+		uint32_t count = 0;
+	};
+}
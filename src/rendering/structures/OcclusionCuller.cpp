@@ -0,0 +1,278 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace vk {
+
+	namespace {
+		// pixels no occluder covered never hide anything
+		constexpr float EMPTY_DEPTH = std::numeric_limits<float>::max();
+		// the screen rectangle of a query is tested on the pyramid level where it spans about this many texels
+		constexpr int QUERY_TEXELS = 4;
+	}
+
+	OccluderMesh OccluderMesh::fromHeightmap(const std::vector<float>& heights, int size, float heightScale, int cells) {
+		OccluderMesh mesh;
+		if (size < 2 || heights.size() < size_t(size) * size) {
+			return mesh;
+		}
+
+		cells = std::clamp(cells, 1, size - 1);
+		float samplesPerCell = static_cast<float>(size - 1) / cells;
+
+		mesh.vertices.reserve(size_t(cells + 1) * (cells + 1));
+		for (int j = 0; j <= cells; j++) {
+			int z0 = std::max(static_cast<int>(std::floor((j - 1) * samplesPerCell)), 0);
+			int z1 = std::min(static_cast<int>(std::ceil((j + 1) * samplesPerCell)), size - 1);
+			for (int i = 0; i <= cells; i++) {
+				int x0 = std::max(static_cast<int>(std::floor((i - 1) * samplesPerCell)), 0);
+				int x1 = std::min(static_cast<int>(std::ceil((i + 1) * samplesPerCell)), size - 1);
+
+				// lowest sample of the cells around the vertex, every cell then lies below all of its samples
+				float lowest = std::numeric_limits<float>::max();
+				for (int sz = z0; sz <= z1; sz++) {
+					for (int sx = x0; sx <= x1; sx++) {
+						lowest = std::min(lowest, heights[size_t(sz) * size + sx]);
+					}
+				}
+
+				mesh.vertices.emplace_back(-1.0f + 2.0f * i / cells, lowest * heightScale, -1.0f + 2.0f * j / cells);
+			}
+		}
+
+		mesh.indices.reserve(size_t(cells) * cells * 6);
+		for (int j = 0; j < cells; j++) {
+			for (int i = 0; i < cells; i++) {
+				uint32_t a = uint32_t(j * (cells + 1) + i);
+				uint32_t b = a + 1;
+				uint32_t c = a + uint32_t(cells + 1);
+				uint32_t d = c + 1;
+				mesh.indices.insert(mesh.indices.end(), { a, c, b, b, c, d });
+			}
+		}
+		return mesh;
+	}
+
+	void OcclusionCuller::beginFrame(const glm::mat4& viewProjection) {
+		this->viewProjection = viewProjection;
+		ready = false;
+		rasterizedTriangles = 0;
+
+		if (pyramid.empty()) {
+			for (uint32_t level = 0; (WIDTH >> level) > 0 || (HEIGHT >> level) > 0; level++) {
+				uint32_t width = std::max(1u, WIDTH >> level);
+				uint32_t height = std::max(1u, HEIGHT >> level);
+				pyramid.emplace_back(size_t(width) * height);
+				if (width == 1 && height == 1) {
+					break;
+				}
+			}
+		}
+		std::fill(pyramid[0].begin(), pyramid[0].end(), EMPTY_DEPTH);
+	}
+
+	void OcclusionCuller::rasterize(const OccluderMesh& mesh, const glm::mat4& modelMatrix) {
+		glm::mat4 mvp = viewProjection * modelMatrix;
+
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			ScreenVertex screen[3];
+			bool clipped = false;
+			for (int v = 0; v < 3; v++) {
+				glm::vec4 clip = mvp * glm::vec4(mesh.vertices[mesh.indices[i + v]], 1.0f);
+				// no near plane clipping, triangles reaching behind the camera are left out
+				if (clip.w <= 0.0f || clip.z < 0.0f) {
+					clipped = true;
+					break;
+				}
+				float inverseW = 1.0f / clip.w;
+				screen[v].x = (clip.x * inverseW * 0.5f + 0.5f) * WIDTH;
+				screen[v].y = (clip.y * inverseW * 0.5f + 0.5f) * HEIGHT;
+				screen[v].z = clip.z * inverseW;
+			}
+			if (!clipped) {
+				rasterizeTriangle(screen[0], screen[1], screen[2]);
+			}
+		}
+	}
+
+	void OcclusionCuller::rasterizeTriangle(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2) {
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if (std::abs(area) < 1e-6f) {
+			return;
+		}
+		// occluders are two sided
+		if (area < 0.0f) {
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		int minX = std::max(static_cast<int>(std::floor(std::min({ v0.x, v1.x, v2.x }))), 0);
+		int maxX = std::min(static_cast<int>(std::ceil(std::max({ v0.x, v1.x, v2.x }))), int(WIDTH) - 1);
+		int minY = std::max(static_cast<int>(std::floor(std::min({ v0.y, v1.y, v2.y }))), 0);
+		int maxY = std::min(static_cast<int>(std::ceil(std::max({ v0.y, v1.y, v2.y }))), int(HEIGHT) - 1);
+		if (minX > maxX || minY > maxY) {
+			return;
+		}
+		rasterizedTriangles++;
+
+		// edge function a * x + b * y + c of the edge opposite to each vertex, positive inside
+		auto edge = [](const ScreenVertex& p, const ScreenVertex& q, float& a, float& b, float& c) {
+			a = -(q.y - p.y);
+			b = q.x - p.x;
+			c = -(a * p.x + b * p.y);
+		};
+		float a0, b0, c0, a1, b1, c1, a2, b2, c2;
+		edge(v1, v2, a0, b0, c0);
+		edge(v2, v0, a1, b1, c1);
+		edge(v0, v1, a2, b2, c2);
+
+		// depth is affine in screen space
+		float inverseArea = 1.0f / area;
+		float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * inverseArea;
+		float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * inverseArea;
+		float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * inverseArea;
+
+		std::vector<float>& depth = pyramid[0];
+
+		for (int y = minY; y <= maxY; y++) {
+			float py = y + 0.5f;
+			float row0 = b0 * py + c0;
+			float row1 = b1 * py + c1;
+			float row2 = b2 * py + c2;
+			float rowZ = zb * py + zc;
+			float* depthRow = depth.data() + size_t(y) * WIDTH;
+
+			int x = minX;
+
+#if defined(__AVX__)
+			// aligned groups of 8 pixels, WIDTH is a multiple of 8 and pixels outside the triangle fail the edge test
+			x = minX & ~7;
+			const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+			const __m256 zero = _mm256_setzero_ps();
+			for (; x <= maxX; x += 8) {
+				__m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets);
+				__m256 w0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a0), px), _mm256_set1_ps(row0));
+				__m256 w1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a1), px), _mm256_set1_ps(row1));
+				__m256 w2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a2), px), _mm256_set1_ps(row2));
+
+				__m256 inside = _mm256_and_ps(
+					_mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GE_OQ), _mm256_cmp_ps(w1, zero, _CMP_GE_OQ)),
+					_mm256_cmp_ps(w2, zero, _CMP_GE_OQ));
+				if (_mm256_movemask_ps(inside) == 0) {
+					continue;
+				}
+
+				__m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(za), px), _mm256_set1_ps(rowZ));
+				__m256 old = _mm256_loadu_ps(depthRow + x);
+				_mm256_storeu_ps(depthRow + x, _mm256_blendv_ps(old, _mm256_min_ps(old, z), inside));
+			}
+#endif
+
+			// scalar tail, and everything when avx is not available
+			for (; x <= maxX; x++) {
+				float px = x + 0.5f;
+				if (a0 * px + row0 >= 0.0f && a1 * px + row1 >= 0.0f && a2 * px + row2 >= 0.0f) {
+					depthRow[x] = std::min(depthRow[x], za * px + rowZ);
+				}
+			}
+		}
+	}
+
+	void OcclusionCuller::finish() {
+		for (size_t level = 1; level < pyramid.size(); level++) {
+			uint32_t srcWidth = std::max(1u, WIDTH >> (level - 1));
+			uint32_t srcHeight = std::max(1u, HEIGHT >> (level - 1));
+			uint32_t width = std::max(1u, WIDTH >> level);
+			uint32_t height = std::max(1u, HEIGHT >> level);
+			const std::vector<float>& src = pyramid[level - 1];
+			std::vector<float>& dst = pyramid[level];
+
+			for (uint32_t y = 0; y < height; y++) {
+				uint32_t y0 = std::min(y * 2, srcHeight - 1);
+				uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+				for (uint32_t x = 0; x < width; x++) {
+					uint32_t x0 = std::min(x * 2, srcWidth - 1);
+					uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+					dst[size_t(y) * width + x] = std::max(
+						std::max(src[size_t(y0) * srcWidth + x0], src[size_t(y0) * srcWidth + x1]),
+						std::max(src[size_t(y1) * srcWidth + x0], src[size_t(y1) * srcWidth + x1]));
+				}
+			}
+		}
+		ready = true;
+	}
+
+	bool OcclusionCuller::isVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& modelMatrix) const {
+		if (!ready) {
+			return true;
+		}
+
+		glm::mat4 mvp = viewProjection * modelMatrix;
+		glm::vec4 corners[8];
+		for (int i = 0; i < 8; i++) {
+			glm::vec3 corner((i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y, (i & 4) ? boundsMax.z : boundsMin.z);
+			corners[i] = mvp * glm::vec4(corner, 1.0f);
+		}
+		return isRectVisible(corners);
+	}
+
+	bool OcclusionCuller::isSphereVisible(const glm::vec3& center, float radius) const {
+		return isVisible(center - glm::vec3(radius), center + glm::vec3(radius), glm::mat4(1.0f));
+	}
+
+	bool OcclusionCuller::isRectVisible(const glm::vec4* clipCorners) const {
+		glm::vec2 screenMin(std::numeric_limits<float>::max());
+		glm::vec2 screenMax(-std::numeric_limits<float>::max());
+		float nearest = std::numeric_limits<float>::max();
+
+		for (int i = 0; i < 8; i++) {
+			const glm::vec4& clip = clipCorners[i];
+			// the box reaches the near plane, it covers the camera
+			if (clip.w <= 0.0f || clip.z < 0.0f) {
+				return true;
+			}
+			float inverseW = 1.0f / clip.w;
+			glm::vec2 screen((clip.x * inverseW * 0.5f + 0.5f) * WIDTH, (clip.y * inverseW * 0.5f + 0.5f) * HEIGHT);
+			screenMin = glm::min(screenMin, screen);
+			screenMax = glm::max(screenMax, screen);
+			nearest = std::min(nearest, clip.z * inverseW);
+		}
+
+		// outside of the screen, that is up to the frustum test
+		if (screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x >= WIDTH || screenMin.y >= HEIGHT) {
+			return true;
+		}
+
+		int x0 = std::max(static_cast<int>(std::floor(screenMin.x)), 0);
+		int y0 = std::max(static_cast<int>(std::floor(screenMin.y)), 0);
+		int x1 = std::min(static_cast<int>(std::floor(screenMax.x)), int(WIDTH) - 1);
+		int y1 = std::min(static_cast<int>(std::floor(screenMax.y)), int(HEIGHT) - 1);
+
+		uint32_t level = 0;
+		int extent = std::max(x1 - x0, y1 - y0) + 1;
+		while ((extent >> level) > QUERY_TEXELS && level + 1 < pyramid.size()) {
+			level++;
+		}
+
+		int width = int(std::max(1u, WIDTH >> level));
+		int height = int(std::max(1u, HEIGHT >> level));
+		const std::vector<float>& depth = pyramid[level];
+
+		// the farthest occluder depth over the rectangle, one texel in front of the box is not enough
+		for (int y = std::min(y0 >> level, height - 1); y <= std::min(y1 >> level, height - 1); y++) {
+			for (int x = std::min(x0 >> level, width - 1); x <= std::min(x1 >> level, width - 1); x++) {
+				if (depth[size_t(y) * width + x] >= nearest) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace vk {
+
+	// triangles that hide everything behind them, must not reach outside the visible surface of their object
+	struct OccluderMesh {
+		std::vector<glm::vec3> vertices;
+		std::vector<uint32_t> indices;
+
+		// coarse grid over a heightmap in the terrain local space (xz in [-1, 1], y = height * heightScale)
+		// every vertex takes the lowest sample around it, so the grid stays below the actual surface
+		// @param heights size x size, row major with z as the row
+		static OccluderMesh fromHeightmap(const std::vector<float>& heights, int size, float heightScale, int cells);
+	};
+
+	// software occlusion culling for the main camera, runs entirely on the cpu
+	// occluders are rasterized into a small depth buffer (nearest depth per pixel), a max depth pyramid over it
+	// answers whether the screen rectangle of a bounding box is completely behind the occluders
+	class OcclusionCuller {
+
+	public:
+
+		static constexpr uint32_t WIDTH = 256;
+		static constexpr uint32_t HEIGHT = 128;
+
+		// clears the depth buffer, call before the occluders of a frame
+		void beginFrame(const glm::mat4& viewProjection);
+
+		void rasterize(const OccluderMesh& mesh, const glm::mat4& modelMatrix);
+
+		// builds the pyramid, call after the last occluder and before the first query
+		void finish();
+
+		// @returns false only if the box is certainly hidden
+		bool isVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& modelMatrix) const;
+		bool isSphereVisible(const glm::vec3& center, float radius) const;
+
+		uint32_t getRasterizedTriangleCount() const { return rasterizedTriangles; }
+
+	private:
+
+		struct ScreenVertex {
+			float x;
+			float y;
+			float z;
+		};
+
+		void rasterizeTriangle(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2);
+		bool isRectVisible(const glm::vec4* clipCorners) const;
+
+		glm::mat4 viewProjection{ 1.0f };
+
+		// level 0 is the depth buffer, every further level keeps the farthest depth of 2 x 2 texels
+		std::vector<std::vector<float>> pyramid;
+		bool ready = false;
+
+		uint32_t rasterizedTriangles = 0;
+	};
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+namespace vk {
+
+	class GameObject;
+	struct PipelineInfo;
+
+	// linear allocator that is reset once per render call
+	// only hands out trivially destructible data, overflow blocks are merged into one block on the next reset
+	class FrameArena {
+	   public:
+		explicit FrameArena(size_t initialCapacity = 64 * 1024) : capacity(initialCapacity), block(new std::byte[initialCapacity]) {}
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		template <typename T>
+		T* allocate(size_t count) {
+			static_assert(std::is_trivially_destructible_v<T>, "FrameArena only holds POD data");
+
+			size_t bytes = count * sizeof(T);
+			size_t offset = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+
+			if (offset + bytes <= capacity) {
+				used = offset + bytes;
+				return reinterpret_cast<T*>(block.get() + offset);
+			}
+
+			// rare: this frame needs more than last frame, grow on reset
+			overflowBytes += bytes + alignof(T);
+			overflowBlocks.emplace_back(new std::byte[bytes + alignof(T)]);
+			void* ptr = overflowBlocks.back().get();
+			size_t space = bytes + alignof(T);
+			return reinterpret_cast<T*>(std::align(alignof(T), bytes, ptr, space));
+		}
+
+		void reset() {
+			if (!overflowBlocks.empty()) {
+				capacity = (capacity + overflowBytes) * 2;
+				block.reset(new std::byte[capacity]);
+				overflowBlocks.clear();
+				overflowBytes = 0;
+			}
+			used = 0;
+		}
+
+	   private:
+		size_t capacity;
+		size_t used = 0;
+		std::unique_ptr<std::byte[]> block;
+
+		size_t overflowBytes = 0;
+		std::vector<std::unique_ptr<std::byte[]>> overflowBlocks;
+	};
+
+	// one draw, everything needed to record it without touching the scene again
+	// the scene is not modified while command buffers are recorded, so raw pointers are safe here
+	struct DrawRecord {
+		GameObject* object;
+		PipelineInfo* pipeline;
+		VkDescriptorSet materialSet;
+		uint32_t materialBinding;
+		uint32_t descriptorId;
+		uint32_t lod;
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+	};
+
+	struct SortEntry {
+		uint64_t key;
+		uint32_t record;
+	};
+
+	// 64-bit render sort key, most significant first:
+	// [63..62] pass | [61..46] pipeline id | [45..30] descriptor set id | [29..14] depth bucket | [13..0] unused
+	// with depthMajor the depth bucket moves in front of pipeline and descriptor ids (ordered ui / transparency)
+	namespace RenderKey {
+		inline uint64_t make(uint32_t pass, uint32_t pipelineId, uint32_t descriptorId, uint16_t depthBucket, bool depthMajor = false) {
+			uint64_t key = uint64_t(pass & 0x3u) << 62;
+			if (depthMajor) {
+				key |= uint64_t(depthBucket) << 46;
+				key |= uint64_t(pipelineId & 0xFFFFu) << 30;
+				key |= uint64_t(descriptorId & 0xFFFFu) << 14;
+			} else {
+				key |= uint64_t(pipelineId & 0xFFFFu) << 46;
+				key |= uint64_t(descriptorId & 0xFFFFu) << 30;
+				key |= uint64_t(depthBucket) << 14;
+			}
+			return key;
+		}
+
+		// order-preserving 16 bit quantization of any float (negative values sort first)
+		inline uint16_t depthBucket(float depth) {
+			uint32_t bits;
+			std::memcpy(&bits, &depth, sizeof(float));
+			bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+			return uint16_t(bits >> 16);
+		}
+	}
+
+	// stable lsd radix sort on the 64-bit key, 8 bits per pass, passes where all keys share a byte are skipped
+	// @returns the buffer holding the sorted result (either entries or scratch)
+	inline SortEntry* radixSort(SortEntry* entries, SortEntry* scratch, size_t count) {
+		if (count < 2) {
+			return entries;
+		}
+
+		SortEntry* src = entries;
+		SortEntry* dst = scratch;
+
+		for (uint32_t shift = 0; shift < 64; shift += 8) {
+			uint32_t histogram[256] = {};
+			for (size_t i = 0; i < count; i++) {
+				histogram[(src[i].key >> shift) & 0xFF]++;
+			}
+
+			if (histogram[(src[0].key >> shift) & 0xFF] == count) {
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t b = 0; b < 256; b++) {
+				uint32_t c = histogram[b];
+				histogram[b] = offset;
+				offset += c;
+			}
+
+			for (size_t i = 0; i < count; i++) {
+				dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+			}
+			std::swap(src, dst);
+		}
+
+		return src;
+	}
+}
@@ -0,0 +1,165 @@
+#include "TerrainQuadtree.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vk {
+
+	namespace {
+		// leaves are used up to this many chunk diagonals from the camera
+		constexpr float LEAF_RANGE_FACTOR = 2.0f;
+		// the top level has nothing to morph into
+		constexpr float NO_MORPH_START = 1e30f;
+		constexpr float NO_MORPH_END = 2e30f;
+	}
+
+	TerrainQuadtree::TerrainQuadtree(const std::vector<float>& heights, int size) {
+		int cells = std::max(size - 1, 1);
+		uint32_t wantedLeaves = static_cast<uint32_t>((cells + CHUNK_PATCHES - 1) / CHUNK_PATCHES);
+		while (leavesPerSide < wantedLeaves && levelCount < MAX_LEVELS) {
+			leavesPerSide *= 2;
+			levelCount++;
+		}
+
+		bool hasHeights = size > 1 && heights.size() >= size_t(size) * size;
+
+		heightBounds.resize(levelCount);
+		maxHeightRange.assign(levelCount, 0.0f);
+
+		// leaves from the samples they cover, one extra sample on each side for the texture filter
+		heightBounds[0].resize(size_t(leavesPerSide) * leavesPerSide, glm::vec2(-1.0f, 1.0f));
+		if (hasHeights) {
+			float samplesPerLeaf = static_cast<float>(size - 1) / leavesPerSide;
+			for (uint32_t z = 0; z < leavesPerSide; z++) {
+				int z0 = std::max(static_cast<int>(std::floor(z * samplesPerLeaf)) - 1, 0);
+				int z1 = std::min(static_cast<int>(std::ceil((z + 1) * samplesPerLeaf)) + 1, size - 1);
+				for (uint32_t x = 0; x < leavesPerSide; x++) {
+					int x0 = std::max(static_cast<int>(std::floor(x * samplesPerLeaf)) - 1, 0);
+					int x1 = std::min(static_cast<int>(std::ceil((x + 1) * samplesPerLeaf)) + 1, size - 1);
+
+					glm::vec2 bounds(1.0f, -1.0f);
+					for (int sz = z0; sz <= z1; sz++) {
+						for (int sx = x0; sx <= x1; sx++) {
+							float h = heights[size_t(sz) * size + sx];
+							bounds.x = std::min(bounds.x, h);
+							bounds.y = std::max(bounds.y, h);
+						}
+					}
+					heightBounds[0][size_t(z) * leavesPerSide + x] = bounds;
+				}
+			}
+		}
+
+		for (uint32_t level = 1; level < levelCount; level++) {
+			uint32_t nodesPerSide = leavesPerSide >> level;
+			uint32_t childrenPerSide = nodesPerSide * 2;
+			const auto& children = heightBounds[level - 1];
+			heightBounds[level].resize(size_t(nodesPerSide) * nodesPerSide);
+
+			for (uint32_t z = 0; z < nodesPerSide; z++) {
+				for (uint32_t x = 0; x < nodesPerSide; x++) {
+					glm::vec2 bounds(1.0f, -1.0f);
+					for (uint32_t child = 0; child < 4; child++) {
+						const glm::vec2& c = children[size_t(z * 2 + (child >> 1)) * childrenPerSide + x * 2 + (child & 1)];
+						bounds.x = std::min(bounds.x, c.x);
+						bounds.y = std::max(bounds.y, c.y);
+					}
+					heightBounds[level][size_t(z) * nodesPerSide + x] = bounds;
+				}
+			}
+		}
+
+		for (uint32_t level = 0; level < levelCount; level++) {
+			for (const glm::vec2& bounds : heightBounds[level]) {
+				maxHeightRange[level] = std::max(maxHeightRange[level], bounds.y - bounds.x);
+			}
+		}
+	}
+
+	uint32_t TerrainQuadtree::select(const Frustum& frustum, bool frustumCulling, const glm::mat4& modelMatrix, float heightScale,
+		const glm::vec3& cameraPosition, Instance* out, uint32_t capacity) const {
+		Selection selection{};
+		selection.frustum = &frustum;
+		selection.frustumCulling = frustumCulling;
+		selection.modelMatrix = modelMatrix;
+		selection.heightScale = std::abs(heightScale);
+		selection.cameraPosition = cameraPosition;
+		selection.out = out;
+		selection.capacity = capacity;
+
+		// a chunk of level l is split while the camera is closer than ranges[l - 1] to it
+		// ranges[l] >= ranges[l - 1] + 2 * diagonal[l] keeps neighbours at most one level apart
+		// and makes the morph of each level finish before the next level can border it
+		float previousRange = 0.0f;
+		for (uint32_t level = 0; level < levelCount; level++) {
+			float chunkSize = 2.0f / static_cast<float>(leavesPerSide >> level);
+			glm::vec3 horizontal = glm::vec3(modelMatrix[0]) * chunkSize + glm::vec3(modelMatrix[2]) * chunkSize;
+			float height = maxHeightRange[level] * selection.heightScale;
+			float diagonal = std::sqrt(horizontal.x * horizontal.x + horizontal.z * horizontal.z + height * height);
+
+			if (level == 0) {
+				selection.ranges[0] = LEAF_RANGE_FACTOR * diagonal;
+				selection.morphStart[0] = 0.5f * selection.ranges[0];
+			} else {
+				selection.ranges[level] = std::max(2.0f * previousRange, previousRange + 2.0f * diagonal);
+				selection.morphStart[level] = previousRange + diagonal;
+			}
+			previousRange = selection.ranges[level];
+		}
+
+		selectNode(selection, levelCount - 1, 0, 0);
+		return selection.count;
+	}
+
+	void TerrainQuadtree::selectNode(Selection& selection, uint32_t level, uint32_t x, uint32_t z) const {
+		glm::vec3 boundsMin, boundsMax;
+		worldBounds(selection, level, x, z, boundsMin, boundsMax);
+
+		if (selection.frustumCulling && !selection.frustum->intersectsOBB(boundsMin, boundsMax, glm::mat4(1.0f))) {
+			return;
+		}
+
+		if (level > 0) {
+			glm::vec3 closest = glm::clamp(selection.cameraPosition, boundsMin, boundsMax);
+			float range = selection.ranges[level - 1];
+			glm::vec3 toCamera = closest - selection.cameraPosition;
+			if (glm::dot(toCamera, toCamera) < range * range) {
+				for (uint32_t child = 0; child < 4; child++) {
+					selectNode(selection, level - 1, x * 2 + (child & 1), z * 2 + (child >> 1));
+				}
+				return;
+			}
+		}
+
+		if (selection.count >= selection.capacity) {
+			return;
+		}
+
+		float chunkSize = 2.0f / static_cast<float>(leavesPerSide >> level);
+		Instance& instance = selection.out[selection.count++];
+		instance.rect = glm::vec4(-1.0f + x * chunkSize, -1.0f + z * chunkSize, chunkSize, chunkSize / CHUNK_PATCHES);
+		if (level + 1 < levelCount) {
+			instance.morph = glm::vec4(selection.morphStart[level], selection.ranges[level], 0.0f, 0.0f);
+		} else {
+			instance.morph = glm::vec4(NO_MORPH_START, NO_MORPH_END, 0.0f, 0.0f);
+		}
+	}
+
+	void TerrainQuadtree::worldBounds(const Selection& selection, uint32_t level, uint32_t x, uint32_t z, glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+		uint32_t nodesPerSide = leavesPerSide >> level;
+		float chunkSize = 2.0f / static_cast<float>(nodesPerSide);
+		glm::vec2 localMin(-1.0f + x * chunkSize, -1.0f + z * chunkSize);
+
+		glm::vec3 a = glm::vec3(selection.modelMatrix * glm::vec4(localMin.x, 0.0f, localMin.y, 1.0f));
+		glm::vec3 b = glm::vec3(selection.modelMatrix * glm::vec4(localMin.x + chunkSize, 0.0f, localMin.y + chunkSize, 1.0f));
+
+		// small margin for half float heightmaps
+		const glm::vec2& heights = heightBounds[level][size_t(z) * nodesPerSide + x];
+		float margin = 0.01f * selection.heightScale;
+
+		boundsMin = glm::min(a, b);
+		boundsMax = glm::max(a, b);
+		boundsMin.y += heights.x * selection.heightScale - margin;
+		boundsMax.y += heights.y * selection.heightScale + margin;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Frustum.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace vk {
+	// cdlod quadtree over the terrain heightmap, chunks are chosen per pass by frustum and camera distance
+	// every chunk is the same grid of CHUNK_PATCHES x CHUNK_PATCHES quad patches drawn instanced,
+	// its odd vertices morph onto the next coarser grid before the parent chunk takes over, so levels meet without cracks
+	class TerrainQuadtree {
+
+	public:
+
+		// quad patches per chunk side, see Model::createTerrainModel
+		static constexpr uint32_t CHUNK_PATCHES = 8;
+		static constexpr uint32_t MAX_LEVELS = 10;
+
+		// per instance vertex data, must match the instance attributes in terrain_shader.vert
+		struct Instance {
+			// xy = min corner in terrain local xz [-1, 1], z = chunk size, w = patch size
+			glm::vec4 rect;
+			// x = morph start, y = morph end as world space camera distance, zw = unused
+			glm::vec4 morph;
+		};
+
+		// @param heights normalized heights in [-1, 1] (size x size, row major with z as the row), empty assumes the full range everywhere
+		// @param size heightmap resolution, the leaf chunks are about as fine as its samples
+		TerrainQuadtree(const std::vector<float>& heights, int size);
+
+		// selects the chunks of one pass, lod ranges are derived from the chunk sizes in world space
+		// the terrain is never rotated, heights are applied along world up scaled by heightScale
+		// @returns the number of instances written to out
+		uint32_t select(const Frustum& frustum, bool frustumCulling, const glm::mat4& modelMatrix, float heightScale,
+			const glm::vec3& cameraPosition, Instance* out, uint32_t capacity) const;
+
+		uint32_t getLevelCount() const { return levelCount; }
+
+		// every selected chunk covers at least one leaf
+		uint32_t getMaxSelection() const { return leavesPerSide * leavesPerSide; }
+
+	private:
+
+		// lod ranges of one select call, level 0 are the leaves
+		struct Selection {
+			const Frustum* frustum;
+			bool frustumCulling;
+			glm::mat4 modelMatrix;
+			float heightScale;
+			glm::vec3 cameraPosition;
+			float ranges[MAX_LEVELS];
+			float morphStart[MAX_LEVELS];
+			Instance* out;
+			uint32_t capacity;
+			uint32_t count;
+		};
+
+		void selectNode(Selection& selection, uint32_t level, uint32_t x, uint32_t z) const;
+		void worldBounds(const Selection& selection, uint32_t level, uint32_t x, uint32_t z, glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+
+		uint32_t levelCount = 1;
+		uint32_t leavesPerSide = 1;
+
+		// x = min, y = max normalized height per node, indexed z * nodesPerSide + x
+		std::vector<std::vector<glm::vec2>> heightBounds;
+		// largest max - min of a node per level
+		std::vector<float> maxHeightRange;
+	};
+}
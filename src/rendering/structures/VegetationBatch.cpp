@@ -0,0 +1,18 @@
+#include "VegetationBatch.h"
+
+namespace vk {
+	VegetationBatch::VegetationBatch(std::shared_ptr<Model> model, std::vector<Instance> instances, float maxInstanceDistance)
+		: modelPtr(model), instances(std::move(instances)), maxInstanceDistance(maxInstanceDistance) {
+
+		auto [bbMin, bbMax] = modelPtr->getAABB();
+		localCenter = 0.5f * (bbMin + bbMax);
+		localRadius = 0.5f * glm::length(bbMax - bbMin);
+
+		for (const auto& instance : this->instances) {
+			center += glm::vec3(instance.positionScale);
+		}
+		if (!this->instances.empty()) {
+			center /= static_cast<float>(this->instances.size());
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../../GameObject.h"
+
+#include <limits>
+#include <vector>
+
+namespace vk {
+	// many placements of one shared vegetation mesh, drawn instanced by the vegetation render system
+	// instances are culled one by one there, so the batch itself is never frustum culled
+	class VegetationBatch : public GameObject {
+
+	public:
+
+		// per instance vertex data, must match the instance attributes in vegetation_shader.vert
+		struct Instance {
+			// xyz = base position in world space, w = uniform scale
+			glm::vec4 positionScale;
+			// x = cos(yaw), y = sin(yaw), zw = unused
+			glm::vec4 rotation;
+		};
+
+		// @param maxInstanceDistance instances further away from the camera are left to impostors in the main pass
+		VegetationBatch(std::shared_ptr<Model> model, std::vector<Instance> instances, float maxInstanceDistance = std::numeric_limits<float>::max());
+
+		// instances carry their own transforms
+		glm::mat4 computeModelMatrix() const override {
+			return glm::mat4(1.0f);
+		}
+
+		glm::mat4 computeNormalMatrix() const override {
+			return glm::mat4(1.0f);
+		}
+
+		glm::vec3 getPosition() const override {
+			return center;
+		}
+
+		std::shared_ptr<Model> getModel() const override {
+			return modelPtr;
+		}
+
+		bool enableFrustumCulling() const override { return false; }
+
+		uint32_t getInstanceCount() const override { return static_cast<uint32_t>(instances.size()); }
+
+		const std::vector<Instance>& getInstances() const { return instances; }
+
+		// bounding sphere of the mesh in object space, scaled per instance
+		const glm::vec3& getLocalCenter() const { return localCenter; }
+		float getLocalRadius() const { return localRadius; }
+
+		float getMaxInstanceDistance() const { return maxInstanceDistance; }
+
+	private:
+
+		std::shared_ptr<Model> modelPtr;
+		std::vector<Instance> instances;
+		float maxInstanceDistance;
+
+		glm::vec3 center{ 0.0f };
+		glm::vec3 localCenter{ 0.0f };
+		float localRadius = 0.0f;
+	};
+}
@@ -2,10 +2,14 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 
 namespace vk {
 	WaterObject::WaterObject(std::shared_ptr<Model> m, WaterCreationSettings waterCreationSettings) : modelPtr(m) {
-		transformMat = glm::translate(glm::mat4(1.0f), waterCreationSettings.position) * glm::scale(glm::mat4(1.0f), glm::vec3(waterCreationSettings.waterScale, 1.0f, waterCreationSettings.waterScale));
+		// the shader snaps the clipmap center with 1 << (rings - 1)
+		rings = std::clamp(waterCreationSettings.rings, 1, 16);
+		glm::vec3 position{ 0.0f, waterCreationSettings.position.y, 0.0f };
+		transformMat = glm::translate(glm::mat4(1.0f), position) * glm::scale(glm::mat4(1.0f), glm::vec3(waterCreationSettings.waterScale, 1.0f, waterCreationSettings.waterScale));
 	}
 
 	glm::mat4 WaterObject::computeNormalMatrix() const {
@@ -3,13 +3,19 @@
 #include "../../GameObject.h"
 
 namespace vk {
+	// camera centered water clipmap drawn in one instanced draw, see water_shader.vert
+	// ring 0 is a square of 4 x 4 blocks, every further ring surrounds the previous one with 12 blocks of twice the size
 	class WaterObject : public GameObject {
 
 	public:
 
 		struct WaterCreationSettings {
-			float waterScale = 2000.0f;
+			// half the side length of one block of the finest ring
+			float waterScale = 50.0f;
+			// the clipmap follows the camera horizontally, only y is used as the water level
 			glm::vec3 position = glm::vec3{ 0.0f, -10.0f, 0.0f };
+			// the water reaches 4 * waterScale * 2^(rings - 1) from the camera
+			int rings = 5;
 		};
 
 		WaterObject(std::shared_ptr<Model> m, WaterCreationSettings waterCreationSettings);
@@ -30,9 +36,22 @@ namespace vk {
 
 		void toggleWireframeModeIfSupported(bool toWireframe) override;
 
+		// the clipmap is always around the camera, patches are culled in water_shader.tesc instead
+		bool enableFrustumCulling() const override { return false; }
+
+		// one instance per block
+		uint32_t getInstanceCount() const override {
+			return 16 + 12 * uint32_t(rings - 1);
+		}
+
+		int getRingCount() const {
+			return rings;
+		}
+
 	private:
 
 		std::shared_ptr<Model> modelPtr;
 		glm::mat4 transformMat;
+		int rings;
 	};
-}
\ No newline at end of file
+}
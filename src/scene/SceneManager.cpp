@@ -103,6 +103,21 @@ vk::id_t SceneManager::addSpectralObject(std::unique_ptr<vk::GameObject> spectra
 
 	if (result.second) {
 		this->idToClass.emplace(id, SPECTRAL_OBJECT);
+		this->staticSceneVersion++;
+		return id;
+	} else {
+		return vk::INVALID_OBJECT_ID;
+	}
+}
+
+vk::id_t SceneManager::addVegetationObject(std::unique_ptr<vk::VegetationBatch> vegetationObject) {
+	vk::id_t id = vegetationObject->getId();
+
+	std::pair result = this->scene->vegetationObjects.emplace(id, std::move(vegetationObject));
+
+	if (result.second) {
+		this->idToClass.emplace(id, VEGETATION_OBJECT);
+		this->staticSceneVersion++;
 		return id;
 	} else {
 		return vk::INVALID_OBJECT_ID;
@@ -191,6 +206,7 @@ vk::id_t SceneManager::addTerrainObject(std::unique_ptr<physics::ManagedPhysicsE
 	if (result.second) {
 		result.first->second->addPhysicsBody();
 		this->idToClass.emplace(id, TERRAIN_OBJECT);
+		this->staticSceneVersion++;
 		this->bodyIDToObjectId.emplace(bodyID, id);
 		this->physicsSceneIsChanged = true;
 		return id;
@@ -199,6 +215,45 @@ vk::id_t SceneManager::addTerrainObject(std::unique_ptr<physics::ManagedPhysicsE
 	return vk::INVALID_OBJECT_ID;
 }
 
+std::vector<vk::id_t> SceneManager::addTerrainObjects(std::vector<std::unique_ptr<physics::ManagedPhysicsEntity>> terrainObjects, JPH::BodyInterface& bodyInterface) {
+	std::vector<vk::id_t> ids;
+	std::vector<JPH::BodyID> bodyIDs;
+	ids.reserve(terrainObjects.size());
+	bodyIDs.reserve(terrainObjects.size());
+
+	for (auto& terrainObject : terrainObjects) {
+		vk::id_t id = terrainObject->getId();
+		JPH::BodyID bodyID = terrainObject->getBodyID();
+
+		if (scene->passivePhysicsObjects.find(id) != scene->passivePhysicsObjects.end()) {
+			ids.push_back(vk::INVALID_OBJECT_ID);
+			continue;
+		}
+
+		std::pair result = this->scene->terrainObjects.emplace(id, std::move(terrainObject));
+
+		if (result.second) {
+			this->idToClass.emplace(id, TERRAIN_OBJECT);
+			this->bodyIDToObjectId.emplace(bodyID, id);
+			bodyIDs.push_back(bodyID);
+			ids.push_back(id);
+		} else {
+			ids.push_back(vk::INVALID_OBJECT_ID);
+		}
+	}
+
+	if (!bodyIDs.empty()) {
+		// one broad phase insertion for all bodies instead of one per body
+		JPH::BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(bodyIDs.data(), int(bodyIDs.size()));
+		bodyInterface.AddBodiesFinalize(bodyIDs.data(), int(bodyIDs.size()), addState, JPH::EActivation::DontActivate);
+
+		this->staticSceneVersion++;
+		this->physicsSceneIsChanged = true;
+	}
+
+	return ids;
+}
+
 bool SceneManager::addToStaleQueue(vk::id_t id) {
 	SceneClass sceneClass;
 
@@ -241,6 +296,13 @@ void SceneManager::removeStaleObjects() {
 			case SPECTRAL_OBJECT:
 				scene->spectralObjects.erase(id);
 				this->idToClass.erase(id);
+				this->staticSceneVersion++;
+				continue;
+
+			case VEGETATION_OBJECT:
+				scene->vegetationObjects.erase(id);
+				this->idToClass.erase(id);
+				this->staticSceneVersion++;
 				continue;
 
 			case UI_COMPONENT:
@@ -291,6 +353,7 @@ void SceneManager::removeStaleObjects() {
 				scene->terrainObjects.erase(id);
 
 				this->idToClass.erase(id);
+				this->staticSceneVersion++;
 				this->bodyIDToObjectId.erase(bodyID);
 				this->physicsSceneIsChanged = true;
 				continue;
@@ -343,8 +406,19 @@ std::unique_ptr<std::pair<SceneClass, std::shared_ptr<vk::GameObject>>> SceneMan
 		std::shared_ptr<vk::GameObject> spectralObject = std::move(itSpectralObjects->second);
 
 		scene->spectralObjects.erase(id);
+		this->staticSceneVersion++;
 
 		return std::make_unique<std::pair<SceneClass, std::shared_ptr<vk::GameObject>>>(make_pair(sceneClass, spectralObject));
+	} else if (sceneClass == VEGETATION_OBJECT) {
+		this->idToClass.erase(id);
+
+		auto itVegetationObjects = scene->vegetationObjects.find(id);
+		std::shared_ptr<vk::GameObject> vegetationObject = std::move(itVegetationObjects->second);
+
+		scene->vegetationObjects.erase(id);
+		this->staticSceneVersion++;
+
+		return std::make_unique<std::pair<SceneClass, std::shared_ptr<vk::GameObject>>>(make_pair(sceneClass, vegetationObject));
 	} else if (sceneClass == UI_COMPONENT) {
 		this->idToClass.erase(id);
 
@@ -422,6 +496,7 @@ std::unique_ptr<std::pair<SceneClass, std::shared_ptr<vk::GameObject>>> SceneMan
 
 		scene->terrainObjects.erase(id);
 		this->physicsSceneIsChanged = true;
+		this->staticSceneVersion++;
 
 		return std::make_unique<std::pair<SceneClass, std::shared_ptr<vk::GameObject>>>(make_pair(sceneClass, terrainObject));
 	} else if (sceneClass == WATER) {
@@ -523,6 +598,17 @@ std::vector<std::weak_ptr<physics::Enemy>> SceneManager::getActiveEnemies() cons
 	return enemies;
 }
 
+std::vector<std::weak_ptr<physics::ManagedPhysicsEntity>> SceneManager::getActivePhysicsEntities() const {
+	std::vector<std::weak_ptr<physics::ManagedPhysicsEntity>> entities = {};
+	entities.reserve(this->scene->physicsObjects.size());
+
+	for (auto& it : this->scene->physicsObjects) {
+		entities.push_back(it.second);
+	}
+
+	return entities;
+}
+
 std::vector<std::weak_ptr<vk::GameObject>> SceneManager::getLights() {
 	std::vector<std::weak_ptr<vk::GameObject>> lights = {};
 
@@ -591,6 +677,8 @@ std::pair<SceneClass, vk::GameObject*> SceneManager::getObject(vk::id_t id) {
 		return std::pair<SceneClass, vk::GameObject*>(std::make_pair(sceneClass, this->scene->physicsObjects.at(id).get()));
 	} else if (sceneClass == SPECTRAL_OBJECT) {
 		return std::pair<SceneClass, vk::GameObject*>(std::make_pair(sceneClass, this->scene->spectralObjects.at(id).get()));
+	} else if (sceneClass == VEGETATION_OBJECT) {
+		return std::pair<SceneClass, vk::GameObject*>(std::make_pair(sceneClass, this->scene->vegetationObjects.at(id).get()));
 	} else if (sceneClass == TERRAIN_OBJECT) {
 		return std::pair<SceneClass, vk::GameObject*>(std::make_pair(sceneClass, this->scene->terrainObjects.at(id).get()));
 	} else if (sceneClass == WATER) {
@@ -642,6 +730,44 @@ std::vector<std::weak_ptr<vk::GameObject>> SceneManager::getStandardRenderObject
 	return renderObjects;
 }
 
+std::vector<std::weak_ptr<vk::GameObject>> SceneManager::getStaticShadowCasters() {
+	std::vector<std::weak_ptr<vk::GameObject>> renderObjects = {};
+
+	for (auto& it : this->scene->spectralObjects) {
+		std::weak_ptr<vk::GameObject> object = it.second;
+		renderObjects.push_back(object);
+	}
+
+	return renderObjects;
+}
+
+std::vector<std::weak_ptr<vk::GameObject>> SceneManager::getDynamicShadowCasters() {
+	std::vector<std::weak_ptr<vk::GameObject>> renderObjects = {};
+
+	for (auto& it : this->scene->physicsObjects) {
+		std::weak_ptr<vk::GameObject> object = it.second;
+		renderObjects.push_back(object);
+	}
+
+	for (auto& it : this->scene->enemies) {
+		std::weak_ptr<vk::GameObject> object = it.second;
+		renderObjects.push_back(object);
+	}
+
+	return renderObjects;
+}
+
+std::vector<std::weak_ptr<vk::GameObject>> SceneManager::getVegetationObjects() {
+	std::vector<std::weak_ptr<vk::GameObject>> vegetationObjects = {};
+
+	for (auto& it : this->scene->vegetationObjects) {
+		std::weak_ptr<vk::GameObject> object = it.second;
+		vegetationObjects.push_back(object);
+	}
+
+	return vegetationObjects;
+}
+
 std::vector<std::weak_ptr<vk::GameObject>> SceneManager::getTerrainRenderObjects() {
 	std::vector<std::weak_ptr<vk::GameObject>> terrainObjects = {};
 
@@ -653,6 +779,23 @@ std::vector<std::weak_ptr<vk::GameObject>> SceneManager::getTerrainRenderObjects
 	return terrainObjects;
 }
 
+std::vector<std::weak_ptr<vk::GameObject>> SceneManager::getOccluders() {
+	std::vector<std::weak_ptr<vk::GameObject>> occluders = {};
+
+	for (auto& it : this->scene->terrainObjects) {
+		if (it.second->getOccluder()) {
+			occluders.push_back(it.second);
+		}
+	}
+	for (auto& it : this->scene->spectralObjects) {
+		if (it.second->getOccluder()) {
+			occluders.push_back(it.second);
+		}
+	}
+
+	return occluders;
+}
+
 void SceneManager::clearUIObjects() {
 	// remove each UI object's entry from the idToClass map
 	for (auto& uiPair : this->scene->uiObjects) {
@@ -693,4 +836,14 @@ void SceneManager::clearVegetationObjects() {
 		this->scene->spectralObjects.erase(id);
 		this->idToClass.erase(id);
 	}
+
+	for (const auto& [id, object] : this->scene->vegetationObjects) {
+		vegetationIds.push_back(id);
+		this->idToClass.erase(id);
+	}
+	this->scene->vegetationObjects.clear();
+
+	if (!vegetationIds.empty()) {
+		this->staticSceneVersion++;
+	}
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "../simulation/objects/actors/Player.h"
 #include "../simulation/objects/actors/enemies/Enemy.h"
 #include "../rendering/structures/WaterObject.h"
+#include "../rendering/structures/VegetationBatch.h"
 #include "../lighting/PointLight.h"
 #include "../lighting/Sun.h"
 #include "../ui/UIComponent.h"
@@ -23,7 +24,8 @@ enum SceneClass {
 	UI_COMPONENT,
 	PHYSICS_OBJECT,
 	SPECTRAL_OBJECT,
-	TERRAIN_OBJECT
+	TERRAIN_OBJECT,
+	VEGETATION_OBJECT
 };
 
 // TODO simplify GameObject and SceneManager
@@ -54,6 +56,9 @@ struct Scene {
 	// non actor physics objects (e.g. terrain, drops, bullets, ...)
 	std::unordered_map<vk::id_t, std::shared_ptr<physics::ManagedPhysicsEntity>> physicsObjects = {};
 
+	// instanced vegetation batches, rendered by the vegetation render system and cached by the shadow map like spectral objects
+	std::unordered_map<vk::id_t, std::shared_ptr<vk::GameObject>> vegetationObjects = {};
+
 	// objects that use terrain shaders
 	std::unordered_map<vk::id_t, std::shared_ptr<physics::ManagedPhysicsEntity>> terrainObjects = {};
 
@@ -102,6 +107,9 @@ class SceneManager {
 	// @return false if object could not be added because it already exists
 	vk::id_t addSpectralObject(std::unique_ptr<vk::GameObject> spectralObject);
 
+	// @return false if object could not be added because it already exists
+	vk::id_t addVegetationObject(std::unique_ptr<vk::VegetationBatch> vegetationObject);
+
 	// @return false if object could not be added because it already exists
 	vk::id_t addUIObject(std::unique_ptr<vk::UIComponent> uiObject);
 
@@ -114,6 +122,10 @@ class SceneManager {
 	// @return false if object could not be added because it already exists
 	vk::id_t addTerrainObject(std::unique_ptr<physics::ManagedPhysicsEntity> terrainObject);
 
+	// adds the bodies of all terrain objects to the simulation in one batch, e.g. streamed world tiles
+	// @return the ids of the added objects, INVALID_OBJECT_ID for objects that already existed
+	std::vector<vk::id_t> addTerrainObjects(std::vector<std::unique_ptr<physics::ManagedPhysicsEntity>> terrainObjects, JPH::BodyInterface& bodyInterface);
+
 	// @return false if light could not be added because it already exists
 	vk::id_t addLight(std::unique_ptr<lighting::PointLight> light);
 
@@ -144,6 +156,9 @@ class SceneManager {
 	// only change returned enemies with a lock (otherwise not thread safe)
 	std::vector<std::weak_ptr<physics::Enemy>> getActiveEnemies() const;
 
+	// non actor physics objects in the simulation (e.g. grenades, drops), same locking rules as enemies
+	std::vector<std::weak_ptr<physics::ManagedPhysicsEntity>> getActivePhysicsEntities() const;
+
 	std::vector<std::weak_ptr<vk::GameObject>> getLights();
 
 	std::vector<std::weak_ptr<vk::GameObject>> getUIObjects();
@@ -165,9 +180,24 @@ class SceneManager {
 	// Get standard render objects (non-tessellated)
 	std::vector<std::weak_ptr<vk::GameObject>> getStandardRenderObjects();
 
+	// standard render objects that never move (spectral objects, e.g. vegetation), cached by the shadow map
+	std::vector<std::weak_ptr<vk::GameObject>> getStaticShadowCasters();
+
+	// standard render objects that can move (physics objects, enemies), rendered into the shadow map every frame
+	std::vector<std::weak_ptr<vk::GameObject>> getDynamicShadowCasters();
+
+	// instanced vegetation batches, all of them are static shadow casters
+	std::vector<std::weak_ptr<vk::GameObject>> getVegetationObjects();
+
 	// Get terrain render objects
 	std::vector<std::weak_ptr<vk::GameObject>> getTerrainRenderObjects();
 
+	// terrain and static objects with an occluder mesh, see GameObject::getOccluder
+	std::vector<std::weak_ptr<vk::GameObject>> getOccluders();
+
+	// changes whenever static shadow casters (spectral, vegetation or terrain objects) are added or removed
+	uint64_t getStaticSceneVersion() const { return staticSceneVersion; }
+
 	void clearUIObjects();
 
 	// Clear vegetation objects from the scene
@@ -191,6 +221,8 @@ class SceneManager {
 	// for optimize broad phase -> optimize broad phase before simulation step if bodies in physics system changed
 	bool physicsSceneIsChanged = false;
 
+	uint64_t staticSceneVersion = 0;
+
 	std::unique_ptr<Scene> scene;
 
 	// enables simple self-removal from manager when game objects should despawn according to their own logic
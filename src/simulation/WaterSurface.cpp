@@ -0,0 +1,163 @@
+#include "WaterSurface.h"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Math/Vec4.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace physics {
+
+	namespace {
+		// same limit and constants as water_shader.tese
+		constexpr size_t MAX_WAVES = 32;
+		constexpr float PI = 3.1415926f;
+		constexpr float GRAVITY = 9.81f;
+	}
+
+	WaterSurface::WaterSurface(float waterLevel, const std::vector<glm::vec4>& waveParams) : waterLevel(waterLevel) {
+		size_t count = std::min(waveParams.size(), MAX_WAVES);
+		waves.reserve(count);
+
+		for (size_t i = 0; i < count; i++) {
+			const glm::vec4& params = waveParams[i];
+
+			Wave wave;
+			wave.direction = glm::normalize(glm::vec2(params.x, params.y));
+			wave.steepness = params.z;
+			wave.k = 2.0f * PI / params.w;
+			wave.c = std::sqrt(GRAVITY / wave.k);
+			wave.a = wave.steepness / wave.k;
+			waves.push_back(wave);
+
+			maxAmplitude += wave.a;
+		}
+	}
+
+	void WaterSurface::displace4(const float* x, const float* z, float time, float* outX, float* outY, float* outZ, glm::vec3* outNormals) const {
+		using JPH::Vec4;
+
+		Vec4 px(x[0], x[1], x[2], x[3]);
+		Vec4 py = Vec4::sReplicate(waterLevel);
+		Vec4 pz(z[0], z[1], z[2], z[3]);
+
+		Vec4 tangentX = Vec4::sReplicate(1.0f);
+		Vec4 tangentY = Vec4::sZero();
+		Vec4 tangentZ = Vec4::sZero();
+		Vec4 binormalX = Vec4::sZero();
+		Vec4 binormalY = Vec4::sZero();
+		Vec4 binormalZ = Vec4::sReplicate(1.0f);
+
+		for (const Wave& wave : waves) {
+			float dx = wave.direction.x;
+			float dz = wave.direction.y;
+
+			// the shader updates p per wave, so later waves see the points moved by earlier ones
+			Vec4 phase = (px * dx + pz * dz) * wave.k - Vec4::sReplicate(wave.k * wave.c * time);
+			Vec4 sinPhase, cosPhase;
+			phase.SinCos(sinPhase, cosPhase);
+
+			px += cosPhase * (dx * wave.a);
+			py += sinPhase * wave.a;
+			pz += cosPhase * (dz * wave.a);
+
+			Vec4 steepSin = sinPhase * wave.steepness;
+			Vec4 steepCos = cosPhase * wave.steepness;
+			tangentX -= steepSin * (dx * dx);
+			tangentY += steepCos * dx;
+			tangentZ -= steepSin * (dx * dz);
+			binormalX -= steepSin * (dx * dz);
+			binormalY += steepCos * dz;
+			binormalZ -= steepSin * (dz * dz);
+		}
+
+		for (int lane = 0; lane < 4; lane++) {
+			outX[lane] = px[lane];
+			outY[lane] = py[lane];
+			outZ[lane] = pz[lane];
+		}
+
+		if (outNormals) {
+			// normalize(cross(binormal, tangent))
+			Vec4 nx = binormalY * tangentZ - binormalZ * tangentY;
+			Vec4 ny = binormalZ * tangentX - binormalX * tangentZ;
+			Vec4 nz = binormalX * tangentY - binormalY * tangentX;
+			Vec4 inverseLength = Vec4::sReplicate(1.0f) / (nx * nx + ny * ny + nz * nz).Sqrt();
+			nx *= inverseLength;
+			ny *= inverseLength;
+			nz *= inverseLength;
+
+			for (int lane = 0; lane < 4; lane++) {
+				outNormals[lane] = glm::vec3(nx[lane], ny[lane], nz[lane]);
+			}
+		}
+	}
+
+	void WaterSurface::displace(const glm::vec2* gridPositions, size_t count, float time, glm::vec3* outPositions, glm::vec3* outNormals) const {
+		for (size_t first = 0; first < count; first += 4) {
+			size_t lanes = std::min<size_t>(4, count - first);
+
+			// the last point fills the unused lanes
+			float x[4], z[4];
+			for (size_t lane = 0; lane < 4; lane++) {
+				const glm::vec2& p = gridPositions[first + std::min(lane, lanes - 1)];
+				x[lane] = p.x;
+				z[lane] = p.y;
+			}
+
+			float outX[4], outY[4], outZ[4];
+			glm::vec3 normals[4];
+			displace4(x, z, time, outX, outY, outZ, outNormals ? normals : nullptr);
+
+			for (size_t lane = 0; lane < lanes; lane++) {
+				outPositions[first + lane] = glm::vec3(outX[lane], outY[lane], outZ[lane]);
+				if (outNormals) {
+					outNormals[first + lane] = normals[lane];
+				}
+			}
+		}
+	}
+
+	void WaterSurface::sampleHeights(const glm::vec2* positions, size_t count, float time, float* outHeights, glm::vec3* outNormals) const {
+		for (size_t first = 0; first < count; first += 4) {
+			size_t lanes = std::min<size_t>(4, count - first);
+
+			float targetX[4], targetZ[4];
+			for (size_t lane = 0; lane < 4; lane++) {
+				const glm::vec2& p = positions[first + std::min(lane, lanes - 1)];
+				targetX[lane] = p.x;
+				targetZ[lane] = p.y;
+			}
+
+			// the horizontal displacement is a contraction for a summed steepness below 1, start at the target itself
+			float x[4], z[4];
+			std::copy(targetX, targetX + 4, x);
+			std::copy(targetZ, targetZ + 4, z);
+
+			float outX[4], outY[4], outZ[4];
+			for (int i = 0; i < INVERSE_ITERATIONS; i++) {
+				displace4(x, z, time, outX, outY, outZ, nullptr);
+				for (int lane = 0; lane < 4; lane++) {
+					x[lane] -= outX[lane] - targetX[lane];
+					z[lane] -= outZ[lane] - targetZ[lane];
+				}
+			}
+
+			glm::vec3 normals[4];
+			displace4(x, z, time, outX, outY, outZ, outNormals ? normals : nullptr);
+
+			for (size_t lane = 0; lane < lanes; lane++) {
+				outHeights[first + lane] = outY[lane];
+				if (outNormals) {
+					outNormals[first + lane] = normals[lane];
+				}
+			}
+		}
+	}
+
+	float WaterSurface::heightAt(const glm::vec2& position, float time) const {
+		float height;
+		sampleHeights(&position, 1, time, &height);
+		return height;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace physics {
+
+	// cpu copy of the gerstner waves of water_shader.tese, so gameplay can ask where the water surface is
+	// evaluates four points at once with jolt's vector math, with the same operations in the same order as the shader,
+	// results agree with the rendered surface up to the precision of sin / cos on the gpu
+	class WaterSurface {
+	   public:
+		// @param waterLevel height of the undisplaced surface
+		// @param waves xy = direction, z = steepness in [0,1], w = wavelength, same as WaterMaterial::setWaves
+		WaterSurface(float waterLevel, const std::vector<glm::vec4>& waves);
+
+		// displaced surface points of the undisplaced points (x, waterLevel, z), exactly what the shader computes per vertex
+		// @param outNormals optional, may be nullptr
+		void displace(const glm::vec2* gridPositions, size_t count, float time, glm::vec3* outPositions, glm::vec3* outNormals = nullptr) const;
+
+		// surface height straight above / below world positions, the waves also move points sideways,
+		// so the undisplaced point that ends up at each position is found with a few fixed point iterations first
+		// @param outNormals optional, may be nullptr
+		void sampleHeights(const glm::vec2* positions, size_t count, float time, float* outHeights, glm::vec3* outNormals = nullptr) const;
+
+		float heightAt(const glm::vec2& position, float time) const;
+
+		float getWaterLevel() const {
+			return waterLevel;
+		}
+
+		// bounds the displacement from the undisplaced surface in every direction
+		float getMaxAmplitude() const {
+			return maxAmplitude;
+		}
+
+	   private:
+		struct Wave {
+			glm::vec2 direction;
+			float steepness;
+			// wave number
+			float k;
+			// wave speed
+			float c;
+			// amplitude
+			float a;
+		};
+
+		// four points per call, lanes past count are ignored by the callers
+		void displace4(const float* x, const float* z, float time, float* outX, float* outY, float* outZ, glm::vec3* outNormals) const;
+
+		static constexpr int INVERSE_ITERATIONS = 4;
+
+		float waterLevel;
+		float maxAmplitude = 0.0f;
+		std::vector<Wave> waves;
+	};
+}
@@ -1,4 +1,6 @@
 #include "Terrain.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <numeric>
 
@@ -31,82 +33,64 @@ namespace physics {
 	
 	Terrain::Terrain(PhysicsSystem& physics_system, std::shared_ptr<vk::Model> model,
 	                 glm::vec3 position, glm::vec3 scale, std::vector<float>&& heightfieldData)
+		: Terrain(physics_system, model, position, scale, std::move(heightfieldData), ShapeRefC()) {}
+
+	Terrain::Terrain(PhysicsSystem& physics_system, std::shared_ptr<vk::Model> model,
+	                 glm::vec3 position, glm::vec3 scale, std::vector<float>&& heightfieldData, ShapeRefC heightfieldShape)
 		: ManagedPhysicsEntity(physics_system), model(model), useHeightfield(true), heightfieldSamples(std::move(heightfieldData)) {
-		std::cout << "Creating heightfield-based terrain with provided height data (3D collision)" << std::endl;
-		
-		// create a temporary array with the correct size
-		float* heightData = this->heightfieldSamples.data();
+		if (heightfieldShape.GetPtr() == nullptr) {
+			std::cout << "Creating heightfield-based terrain with provided height data (3D collision)" << std::endl;
+			heightfieldShape = createHeightfieldShape(this->heightfieldSamples, scale);
+		}
+
+		this->scale = glm::vec3{ scale.x, 1.0f, scale.z };
+
+		// the model matrix scales xz only, heights are scaled by the material like scale.y does for the shape
+		int samplesPerSide = static_cast<int>(std::sqrt(this->heightfieldSamples.size()));
+		occluder = vk::OccluderMesh::fromHeightmap(this->heightfieldSamples, samplesPerSide, scale.y, OCCLUDER_CELLS);
 
+		body_settings = BodyCreationSettings{
+			heightfieldShape,
+			GLMToRVec3(position),
+			Quat::sIdentity(),
+			EMotionType::Static,
+			physics::Layers::NON_MOVING};
+
+		// Create physics body
+		this->bodyID = physics_system.GetBodyInterface().CreateBody(body_settings)->GetID();
+	}
+
+	ShapeRefC Terrain::createHeightfieldShape(const std::vector<float>& heightfieldData, glm::vec3 scale) {
 		// calculate the number of samples in each dimension
-		int numSamplesPerSide = static_cast<int>(sqrt(this->heightfieldSamples.size()));
-		std::cout << "Creating heightfield with " << numSamplesPerSide << "x" << numSamplesPerSide << " samples" << std::endl;
-		
-		// Copy our height samples directly into the array
-		for (int i = 0; i < numSamplesPerSide * numSamplesPerSide; i++) {
-			if (i < heightfieldSamples.size()) {
-				heightData[i] = heightfieldSamples[i];
-			} else {
-				heightData[i] = 0.0f;  // Default height if we run out of samples
-			}
-		}
-		
-		// Print some debug info
-		std::cout << "Height samples min/max: ";
-		if (!heightfieldSamples.empty()) {
-			float min = heightfieldSamples[0];
-			float max = heightfieldSamples[0];
-			for (const auto& h : heightfieldSamples) {
-				min = std::min(min, h);
-				max = std::max(max, h);
-			}
-			std::cout << min << " / " << max << std::endl;
-		} else {
-			std::cout << "No samples!" << std::endl;
-		}
-		
+		int numSamplesPerSide = static_cast<int>(sqrt(heightfieldData.size()));
+
+		// pad with flat samples if the data does not fill the square
+		std::vector<float> heightData(size_t(numSamplesPerSide) * numSamplesPerSide, 0.0f);
+		std::copy_n(heightfieldData.begin(), std::min(heightData.size(), heightfieldData.size()), heightData.begin());
+
 		float width = scale.x * 2.0f;								// mesh spans [-scale.x, +scale.x]
 		float depth = scale.z * 2.0f;								// mesh spans [-scale.z, +scale.z]
 		float cellSizeX = width / (numSamplesPerSide - 1);			// divide by sample - 1 cells to get size of single cell
 		float cellSizeZ = depth / (numSamplesPerSide - 1);
 		RVec3 shapeOffset = RVec3(-scale.x, 0.0f, -scale.z);		// samples go from -scale.x -> +scale.x
-		
+
 		HeightFieldShapeSettings heightfield_settings(
-			heightData,
+			heightData.data(),
 			shapeOffset,
 			Vec3(cellSizeX,	scale.y, cellSizeZ),
 			numSamplesPerSide);
 
-		this->scale = glm::vec3{ scale.x, 1.0f, scale.z };
-			
 		// Create the shape
 		ShapeSettings::ShapeResult heightfield_result = heightfield_settings.Create();
-		
-		// Create the body settings
+
 		if (heightfield_result.HasError()) {
 			std::cout << "Error creating heightfield shape: " << heightfield_result.GetError() << std::endl;
 			// Fallback to a box shape
 			BoxShapeSettings fallback_settings(GLMToRVec3(scale * glm::vec3{ 1.0, 0.5, 1.0 }));
-			ShapeSettings::ShapeResult fallback_result = fallback_settings.Create();
-			body_settings = BodyCreationSettings{
-				fallback_result.Get(),
-				GLMToRVec3(position),
-				Quat::sIdentity(),
-				EMotionType::Static,
-				physics::Layers::NON_MOVING};
-		}
-		else {
-			std::cout << "Successfully created heightfield shape" << std::endl;
-			// Use the heightfield shape
-			body_settings = BodyCreationSettings{
-				heightfield_result.Get(),
-				GLMToRVec3(position),
-				Quat::sIdentity(),
-				EMotionType::Static,
-				physics::Layers::NON_MOVING};
+			return fallback_settings.Create().Get();
 		}
-		
-		// Create physics body
-		this->bodyID = physics_system.GetBodyInterface().CreateBody(body_settings)->GetID();
+
+		return heightfield_result.Get();
 	}
 	
 	Terrain::~Terrain() {}
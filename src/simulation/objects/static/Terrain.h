@@ -10,6 +10,7 @@
 #include <Jolt/Physics/Collision/Shape/HeightFieldShape.h>
 
 #include "../../PhysicsConversions.h"
+#include "../../../rendering/structures/OcclusionCuller.h"
 #include "../../CollisionSettings.h"
 #include <random>
 
@@ -27,6 +28,15 @@ namespace physics {
 		// Constructor with externally provided heightmap data
 		Terrain(PhysicsSystem& physics_system, std::shared_ptr<vk::Model> model,
 		        glm::vec3 position, glm::vec3 scale, std::vector<float>&& heightfieldData);
+
+		// with a heightfield shape that was already created, e.g. on a worker thread by createHeightfieldShape
+		Terrain(PhysicsSystem& physics_system, std::shared_ptr<vk::Model> model,
+		        glm::vec3 position, glm::vec3 scale, std::vector<float>&& heightfieldData, ShapeRefC heightfieldShape);
+
+		// heightfield spanning [-scale.x, scale.x] x [-scale.z, scale.z] around the body, heights are scaled by scale.y
+		// does not touch the physics system, so it can run on any thread
+		// falls back to a box if jolt rejects the heightfield
+		static ShapeRefC createHeightfieldShape(const std::vector<float>& heightfieldData, glm::vec3 scale);
 		
 		virtual ~Terrain();
 
@@ -39,12 +49,20 @@ namespace physics {
 		std::shared_ptr<vk::Model> getModel() const override;
 
 		void toggleWireframeModeIfSupported(bool toWireframe) override;
+
+		const vk::OccluderMesh* getOccluder() const override {
+			return occluder.indices.empty() ? nullptr : &occluder;
+		}
 		
 		std::shared_ptr<vk::Model> model;
 		glm::vec3 scale;
 
 		bool useHeightfield = false;
 		std::vector<float> heightfieldSamples;
+
+		// coarse grid below the heightfield for the occlusion culling
+		vk::OccluderMesh occluder;
+		static constexpr int OCCLUDER_CELLS = 16;
 		
 		// For Perlin noise generation
 		std::vector<int> p; // Permutation table for Perlin noise
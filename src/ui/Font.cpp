@@ -1,60 +1,114 @@
 #include "Font.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace vk {
 
+	const std::array<Font::Glyph, Font::LAST_CHAR - Font::FIRST_CHAR + 1> &Font::getGlyphs() {
+		static const std::array<Glyph, LAST_CHAR - FIRST_CHAR + 1> glyphs = [] {
+			// Raw vertex layout: x,y,z + 4-byte color = 16 bytes per vertex
+			struct RawVert {
+				float x, y, z;
+				unsigned char r, g, b, a;
+			};
+
+			std::array<Glyph, LAST_CHAR - FIRST_CHAR + 1> result{};
+			std::vector<char> buffer(4096);
+			for (char c = FIRST_CHAR; c <= LAST_CHAR; c++) {
+				char text[2] = {c, '\0'};
+				Glyph &glyph = result[c - FIRST_CHAR];
+				glyph.advance = float(stb_easy_font_width(text));
+
+				int quadCount = stb_easy_font_print(0.0f, 0.0f, text, nullptr, buffer.data(), int(buffer.size()));
+				if (quadCount <= 0) {
+					continue;
+				}
+
+				// quads sit on whole font pixels, their bounds are the lit area of the glyph
+				const RawVert *vbuf = reinterpret_cast<const RawVert *>(buffer.data());
+				glm::vec2 minPos(vbuf[0].x, vbuf[0].y);
+				glm::vec2 maxPos = minPos;
+				for (int v = 0; v < quadCount * 4; v++) {
+					minPos = glm::min(minPos, glm::vec2(vbuf[v].x, vbuf[v].y));
+					maxPos = glm::max(maxPos, glm::vec2(vbuf[v].x, vbuf[v].y));
+				}
+
+				uint32_t width = uint32_t(maxPos.x - minPos.x) * TEXELS_PER_PIXEL;
+				uint32_t height = uint32_t(maxPos.y - minPos.y) * TEXELS_PER_PIXEL;
+
+				// grey + alpha, the atlas turns it into white with coverage in alpha
+				std::vector<unsigned char> pixels(size_t(width) * height * 2, 0);
+				for (size_t i = 0; i < pixels.size(); i += 2) {
+					pixels[i] = 255;
+				}
+				for (int q = 0; q < quadCount; q++) {
+					const RawVert &v0 = vbuf[q * 4 + 0];
+					const RawVert &v2 = vbuf[q * 4 + 2];
+					uint32_t x0 = uint32_t(v0.x - minPos.x) * TEXELS_PER_PIXEL;
+					uint32_t y0 = uint32_t(v0.y - minPos.y) * TEXELS_PER_PIXEL;
+					uint32_t x1 = uint32_t(v2.x - minPos.x) * TEXELS_PER_PIXEL;
+					uint32_t y1 = uint32_t(v2.y - minPos.y) * TEXELS_PER_PIXEL;
+					for (uint32_t y = y0; y < y1; y++) {
+						for (uint32_t x = x0; x < x1; x++) {
+							pixels[(size_t(y) * width + x) * 2 + 1] = 255;
+						}
+					}
+				}
+
+				glyph.region = UIAtlas::getInstance().add("font:stb_easy_font#" + std::to_string(int(c)), pixels.data(), width, height, 2);
+				glyph.offset = minPos;
+				glyph.size = maxPos - minPos;
+				glyph.visible = true;
+			}
+			return result;
+		}();
+		return glyphs;
+	}
+
 	int Font::getTextWidth(const std::string &text, float scale) const {
 		// stb_easy_font reports width in pixels at scale=1
 		return stb_easy_font_width(const_cast<char *>(text.c_str())) * scale;
 	}
 
 	void Font::buildTextMesh(const std::string &text,
-		std::vector<Model::Vertex> &outVertices,
+		std::vector<UIVertex> &outVertices,
 		std::vector<uint32_t> &outIndices,
 		float scale) const {
-		int max_buffer_size = static_cast<int>(text.size()) * 270 + 100;
-		std::vector<char> buffer(max_buffer_size);
-		// Generate quad segments (4 vertices each)
-		int quadCount = stb_easy_font_print(
-			0.0f, 0.0f,
-			const_cast<char *>(text.c_str()),
-			nullptr,
-			buffer.data(), max_buffer_size);
+		const auto &glyphs = getGlyphs();
 
 		outVertices.clear();
 		outIndices.clear();
-		if (quadCount <= 0)
-			return;
-		// Each quad -> two triangles -> 6 vertices
-		outVertices.reserve(static_cast<size_t>(quadCount) * 6);
-
-		// Raw vertex layout: x,y,z + 4-byte color = 16 bytes per vertex
-		struct RawVert {
-			float x, y, z;
-			unsigned char r, g, b, a;
-		};
-		RawVert *vbuf = reinterpret_cast<RawVert *>(buffer.data());
-		// Triangulate quads (invert winding after Y flip to preserve front-facing order)
-		for (int q = 0; q < quadCount; ++q) {
-			int base = q * 4;
-			auto makeVert = [&](int idx) {
-				RawVert &rv = vbuf[idx];
-				Model::Vertex vert{};
+		outVertices.reserve(text.size() * 4);
+		outIndices.reserve(text.size() * 6);
+
+		glm::vec2 pen(0.0f);
+		for (char c : text) {
+			if (c == '\n') {
+				pen.x = 0.0f;
+				pen.y += LINE_HEIGHT;
+				continue;
+			}
+			if (c < FIRST_CHAR || c > LAST_CHAR) {
+				continue;
+			}
+
+			const Glyph &glyph = glyphs[c - FIRST_CHAR];
+			if (glyph.visible) {
+				glm::vec2 p0 = (pen + glyph.offset) * scale;
+				glm::vec2 p1 = p0 + glyph.size * scale;
+
+				uint32_t base = uint32_t(outVertices.size());
 				// Flip Y axis to correct upside-down text
-				vert.position = glm::vec3(rv.x * scale, -rv.y * scale, 0.0f);
-				vert.color = glm::vec3(1.0f);
-				vert.normal = glm::vec3(0.0f, 0.0f, 1.0f);
-				vert.uv = glm::vec2(0.0f);
-				return vert;
-			};
-			// Triangle 1 (reverse winding)
-			outVertices.push_back(makeVert(base + 0));
-			outVertices.push_back(makeVert(base + 2));
-			outVertices.push_back(makeVert(base + 1));
-			// Triangle 2 (reverse winding)
-			outVertices.push_back(makeVert(base + 0));
-			outVertices.push_back(makeVert(base + 3));
-			outVertices.push_back(makeVert(base + 2));
+				outVertices.push_back({glm::vec3(p0.x, -p0.y, 0.0f), glm::vec3(1.0f), glyph.region.uvMin});
+				outVertices.push_back({glm::vec3(p1.x, -p0.y, 0.0f), glm::vec3(1.0f), glm::vec2(glyph.region.uvMax.x, glyph.region.uvMin.y)});
+				outVertices.push_back({glm::vec3(p1.x, -p1.y, 0.0f), glm::vec3(1.0f), glyph.region.uvMax});
+				outVertices.push_back({glm::vec3(p0.x, -p1.y, 0.0f), glm::vec3(1.0f), glm::vec2(glyph.region.uvMin.x, glyph.region.uvMax.y)});
+
+				outIndices.insert(outIndices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+			}
+			pen.x += glyph.advance;
 		}
 	}
 
-}  // namespace vk
\ No newline at end of file
+}  // namespace vk
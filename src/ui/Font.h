@@ -1,7 +1,9 @@
 #pragma once
 
-#include "../vk/vk_model.h"
+#include "UIAtlas.h"
+#include "UIMesh.h"
 
+#include <array>
 #include <string>
 #include <vector>
 #include <cstring>
@@ -10,17 +12,40 @@
 
 namespace vk {
 
+	// the stb_easy_font glyphs rasterized once into the ui atlas, text is one textured quad per glyph
 	class Font {
 	   public:
+		// atlas texels per font pixel, matches the scale text components draw with so glyphs map 1:1 to screen pixels
+		static constexpr uint32_t TEXELS_PER_PIXEL = 2;
+		// line height of stb_easy_font
+		static constexpr float LINE_HEIGHT = 12.0f;
+
 		Font() = default;
 		~Font() = default;
 
 		int getTextWidth(const std::string &text, float scale = 1.0f) const;
 
+		// 4 vertices and 6 indices per visible glyph, spaces and unknown characters only advance
 		void buildTextMesh(const std::string &text,
-			std::vector<Model::Vertex> &outVertices,
+			std::vector<UIVertex> &outVertices,
 			std::vector<uint32_t> &outIndices,
 			float scale = 1.0f) const;
+
+	   private:
+		struct Glyph {
+			UIAtlas::Region region;
+			// lit area relative to the pen position in font pixels, y down
+			glm::vec2 offset{0.0f};
+			glm::vec2 size{0.0f};
+			float advance = 0.0f;
+			bool visible = false;
+		};
+
+		static constexpr char FIRST_CHAR = 32;
+		static constexpr char LAST_CHAR = 126;
+
+		// shared by all fonts, built on first use
+		static const std::array<Glyph, LAST_CHAR - FIRST_CHAR + 1> &getGlyphs();
 	};
 
-}  // namespace vk
\ No newline at end of file
+}  // namespace vk
@@ -3,8 +3,7 @@
 
 namespace vk {
 
-	TextComponent::TextComponent(Device &device,
-		Font &font,
+	TextComponent::TextComponent(Font &font,
 		const std::string &initialText,
 		const std::string &name,
 		bool controllable,
@@ -17,7 +16,7 @@ namespace vk {
 		bool isDebugMenuComponent,
 		GLFWwindow *window)
 		: UIComponent(UIComponentCreationSettings{
-			  /*model*/ nullptr,
+			  /*modelPath*/ "",
 			  /*name*/ name,
 			  /*controllable*/ controllable,
 			  /*window*/ window,
@@ -26,13 +25,10 @@ namespace vk {
 			  /*centerHorizontal*/ centerHorizontal,
 			  /*centerVertical*/ centerVertical,
 			  /*isDebugMenuComponent*/ isDebugMenuComponent}),
-		  device(device),
 		  font(font),
 		  textStr(initialText),
 		  horizontalOffset(horizontalOffset),
 		  verticalOffset(verticalOffset) {
-		std::vector<unsigned char> white = {255, 255, 255, 255};
-		material = std::make_shared<UIMaterial>(device, white, 1, 1, 4);
 		rebuildMesh();
 	}
 
@@ -48,16 +44,17 @@ namespace vk {
 	}
 
 	void TextComponent::rebuildMesh() {
-		std::vector<Model::Vertex> verts;
-		std::vector<uint32_t> inds;
-		font.buildTextMesh(textStr, verts, inds, 2.0f);
+		UIMesh textMesh;
+		font.buildTextMesh(textStr, textMesh.vertices, textMesh.indices, 2.0f);
 
-		if (verts.size() < 3) {
-			setModel(nullptr);
+		if (textMesh.vertices.size() < 3) {
+			setMesh(UIMesh{});
 			textSize = {0, 0};
 			return;
 		}
 
+		const std::vector<UIVertex> &verts = textMesh.vertices;
+
 		float minX = verts[0].position.x, maxX = minX;
 		float minY = verts[0].position.y, maxY = minY;
 		for (auto &v : verts) {
@@ -68,20 +65,7 @@ namespace vk {
 		}
 		textSize = {maxX - minX, maxY - minY};
 
-		if (!mdl) {
-			Model::Builder b;
-			b.vertices = verts;
-			b.indices = inds;
-			b.isUI = true;
-			b.dynamic = isTextDynamic;
-
-			mdl = std::make_shared<Model>(device, b);
-			mdl->setMaterial(material);
-			setModel(mdl);
-		}
-		else {
-			mdl->updateMesh(verts, inds);
-		}
+		setMesh(std::move(textMesh));
 	}
 
 	glm::mat4 TextComponent::computeModelMatrix() const {
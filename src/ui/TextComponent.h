@@ -2,8 +2,6 @@
 
 #include "UIComponent.h"
 #include "Font.h"
-#include "../vk/vk_model.h"
-#include "../rendering/materials/UIMaterial.h"
 
 #include <memory>
 #include <string>
@@ -14,8 +12,7 @@ namespace vk {
 
 	class TextComponent : public UIComponent {
 	   public:
-		TextComponent(Device &device,
-			Font &font,
+		TextComponent(Font &font,
 			const std::string &initialText,
 			const std::string &name,
 			bool controllable = false,
@@ -37,16 +34,11 @@ namespace vk {
 	   private:
 		void rebuildMesh();
 
-		Device &device;
 		Font &font;
 		std::string textStr;
-		std::shared_ptr<Material> material;
-		std::shared_ptr<Model> mdl;
 		glm::vec2 textSize{0.0f, 0.0f};
 		float horizontalOffset = 0.0f;
 		float verticalOffset = 0.0f;
-
-		bool isTextDynamic = true; // TODO more nuance and settings
 	};
 
 }  // namespace vk
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "UIAtlas.h"
+#include "../asset_utils/AssetLoader.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace vk {
+
+	UIAtlas& UIAtlas::getInstance() {
+		static UIAtlas instance;
+		return instance;
+	}
+
+	UIAtlas::UIAtlas() : pixels(size_t(SIZE) * SIZE * 4, 0) {
+		// a small white block instead of a single texel, so filtering never mixes in the padding of other images
+		std::vector<unsigned char> white(4 * 4 * 4, 255);
+		Region region = add("white", white.data(), 4, 4, 4);
+		whiteUV = 0.5f * (region.uvMin + region.uvMax);
+	}
+
+	glm::uvec2 UIAtlas::allocate(uint32_t width, uint32_t height) {
+		if (width > SIZE || height > SIZE) {
+			throw std::runtime_error("UIAtlas: Image does not fit into the atlas");
+		}
+
+		if (shelfX + width > SIZE) {
+			shelfX = 0;
+			shelfY += shelfHeight;
+			shelfHeight = 0;
+		}
+		if (shelfY + height > SIZE) {
+			throw std::runtime_error("UIAtlas: Atlas is full");
+		}
+
+		glm::uvec2 position(shelfX, shelfY);
+		shelfX += width;
+		shelfHeight = std::max(shelfHeight, height);
+		return position;
+	}
+
+	UIAtlas::Region UIAtlas::add(const std::string& key, const unsigned char* imagePixels, uint32_t width, uint32_t height, uint32_t channels) {
+		auto it = regions.find(key);
+		if (it != regions.end()) {
+			return it->second;
+		}
+		if (width == 0 || height == 0 || channels == 0 || channels > 4) {
+			throw std::runtime_error("UIAtlas: Invalid image " + key);
+		}
+
+		glm::uvec2 origin = allocate(width + 2 * PADDING, height + 2 * PADDING);
+
+		// padding texels repeat the nearest edge texel of the image
+		for (uint32_t y = 0; y < height + 2 * PADDING; y++) {
+			uint32_t sourceY = uint32_t(std::clamp(int(y) - int(PADDING), 0, int(height) - 1));
+			for (uint32_t x = 0; x < width + 2 * PADDING; x++) {
+				uint32_t sourceX = uint32_t(std::clamp(int(x) - int(PADDING), 0, int(width) - 1));
+				const unsigned char* source = imagePixels + (size_t(sourceY) * width + sourceX) * channels;
+				unsigned char* target = &pixels[((size_t(origin.y) + y) * SIZE + origin.x + x) * 4];
+
+				if (channels <= 2) {
+					// grey or grey + alpha
+					target[0] = target[1] = target[2] = source[0];
+					target[3] = channels == 2 ? source[1] : 255;
+				} else {
+					target[0] = source[0];
+					target[1] = source[1];
+					target[2] = source[2];
+					target[3] = channels == 4 ? source[3] : 255;
+				}
+			}
+		}
+
+		Region region;
+		region.uvMin = glm::vec2(origin + glm::uvec2(PADDING)) / float(SIZE);
+		region.uvMax = glm::vec2(origin + glm::uvec2(PADDING) + glm::uvec2(width, height)) / float(SIZE);
+		regions.emplace(key, region);
+		dirtyRects.push_back({ origin.x, origin.y, width + 2 * PADDING, height + 2 * PADDING });
+		return region;
+	}
+
+	std::vector<UIAtlas::Rect> UIAtlas::takeDirtyRects() {
+		std::vector<Rect> rects;
+		rects.swap(dirtyRects);
+		return rects;
+	}
+
+	UIAtlas::Region UIAtlas::addFile(const std::string& path) {
+		auto it = regions.find(path);
+		if (it != regions.end()) {
+			return it->second;
+		}
+
+		AssetLoader::TextureData texture = AssetLoader::getInstance().loadTexture(path);
+		return add(path, texture.pixels.data(), uint32_t(texture.width), uint32_t(texture.height), uint32_t(texture.channels));
+	}
+}
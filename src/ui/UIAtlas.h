@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vk {
+
+	// every ui image packed into one rgba8 texture, so the whole ui draws with a single descriptor set
+	// cpu side only, the ui render system uploads the rects that changed before the frame's render pass
+	class UIAtlas {
+	   public:
+		static constexpr uint32_t SIZE = 1024;
+		// copies of the edge texels around every image, keeps linear filtering from reaching into the neighbours
+		static constexpr uint32_t PADDING = 1;
+
+		// texels of one added image including its padding
+		struct Rect {
+			uint32_t x = 0;
+			uint32_t y = 0;
+			uint32_t width = 0;
+			uint32_t height = 0;
+		};
+
+		struct Region {
+			glm::vec2 uvMin{0.0f};
+			glm::vec2 uvMax{0.0f};
+
+			// uv of the original image to uv in the atlas, ui images do not repeat
+			glm::vec2 map(const glm::vec2& uv) const {
+				return uvMin + glm::clamp(uv, glm::vec2(0.0f), glm::vec2(1.0f)) * (uvMax - uvMin);
+			}
+		};
+
+		static UIAtlas& getInstance();
+
+		// images with the same key are only stored once, e.g. the file path
+		// @param pixels width x height with 1 to 4 channels, converted to rgba
+		Region add(const std::string& key, const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t channels);
+
+		// loaded through the asset loader, keyed by the path
+		Region addFile(const std::string& path);
+
+		// uv of a texel that is always white, for vertex colored geometry without a texture
+		glm::vec2 getWhiteUV() const {
+			return whiteUV;
+		}
+
+		const std::vector<unsigned char>& getPixels() const {
+			return pixels;
+		}
+
+		bool hasDirtyRects() const {
+			return !dirtyRects.empty();
+		}
+
+		// rects written since the last call, the caller uploads them
+		std::vector<Rect> takeDirtyRects();
+
+	   private:
+		UIAtlas();
+		~UIAtlas() = default;
+		UIAtlas(const UIAtlas&) = delete;
+		UIAtlas& operator=(const UIAtlas&) = delete;
+
+		// top left texel of a free padded width x height rect
+		glm::uvec2 allocate(uint32_t width, uint32_t height);
+
+		std::vector<unsigned char> pixels;
+		std::unordered_map<std::string, Region> regions;
+		glm::vec2 whiteUV{0.0f};
+		std::vector<Rect> dirtyRects;
+
+		// shelf packing: images go left to right into rows as high as their tallest image
+		uint32_t shelfX = 0;
+		uint32_t shelfY = 0;
+		uint32_t shelfHeight = 0;
+	};
+}
@@ -6,8 +6,7 @@
 namespace vk {
 
 	UIComponent::UIComponent(UIComponentCreationSettings settings)
-		: model(std::move(settings.model)),
-		  name(std::move(settings.name)),
+		: name(std::move(settings.name)),
 		  controllable(settings.controllable),
 		  window(settings.window),
 		  anchorRight(settings.anchorRight),
@@ -15,6 +14,10 @@ namespace vk {
 		  centerHorizontal(settings.centerHorizontal),
 		  centerVertical(settings.centerVertical),
 		  isDebugMenuComponent(settings.isDebugMenuComponent) {
+		if (!settings.modelPath.empty()) {
+			setMesh(UIMesh::loadFromFile(settings.modelPath));
+		}
+
 		loadData();
 
 		if ((anchorRight || anchorBottom) && window) {
@@ -135,7 +138,7 @@ namespace vk {
 	}
 
 	std::shared_ptr<Model> UIComponent::getModel() const {
-		return model;
+		return nullptr;
 	}
 
 	void UIComponent::updatePosition(float dt, glm::vec3 dir) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../GameObject.h"
+#include "UIMesh.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -18,7 +19,8 @@ namespace vk {
 
 	class UIComponentCreationSettings {
 	   public:
-		std::shared_ptr<Model> model;
+		// gltf file with the geometry, empty for components that build their own mesh (e.g. text)
+		std::string modelPath;
 		std::string name;
 		bool controllable = false;
 		GLFWwindow* window = nullptr;
@@ -42,8 +44,18 @@ namespace vk {
 		glm::mat4 computeModelMatrix() const override;
 		glm::mat4 computeNormalMatrix() const override;
 		glm::vec3 getPosition() const override;
+		// ui components have no model of their own, the ui render system batches their meshes
 		std::shared_ptr<Model> getModel() const override;
 
+		const UIMesh& getMesh() const {
+			return mesh;
+		}
+
+		// increases whenever the mesh changes, so the ui batch only copies changed components
+		uint64_t getMeshRevision() const {
+			return meshRevision;
+		}
+
 		bool enableFrustumCulling() const override { return false; }
 
 		bool isControllable() const {
@@ -65,8 +77,9 @@ namespace vk {
 		bool getCenterVertical() const {
 			return centerVertical;
 		}
-		void setModel(std::shared_ptr<Model> m) {
-			model = std::move(m);
+		void setMesh(UIMesh m) {
+			mesh = std::move(m);
+			meshRevision++;
 		}
 		bool anchorRight = false;
 		bool anchorBottom = false;
@@ -76,7 +89,8 @@ namespace vk {
 		void saveData(const Transform& t) const;
 		void invalidateCache();
 
-		std::shared_ptr<Model> model;
+		UIMesh mesh;
+		uint64_t meshRevision = 0;
 		std::string name;
 		bool controllable;
 		GLFWwindow* window = nullptr;
@@ -0,0 +1,71 @@
+#include "UIMesh.h"
+#include "UIAtlas.h"
+#include "../vk/vk_model.h"
+
+#include <cstddef>
+
+namespace vk {
+
+	std::vector<VkVertexInputBindingDescription> UIVertex::getBindingDescriptions() {
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = sizeof(UIVertex);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescriptions;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> UIVertex::getAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+		attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(UIVertex, position)});
+		attributeDescriptions.push_back({1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(UIVertex, color)});
+		attributeDescriptions.push_back({2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(UIVertex, uv)});
+		return attributeDescriptions;
+	}
+
+	namespace {
+		// same texture lookup as Model::createUIMaterialFromGltf, models without a base color texture use the white texel
+		UIAtlas::Region loadBaseColorRegion(const std::string& filename, const tinygltf::Model& gltfModel, int materialIndex) {
+			UIAtlas& atlas = UIAtlas::getInstance();
+			UIAtlas::Region white;
+			white.uvMin = white.uvMax = atlas.getWhiteUV();
+
+			if (materialIndex < 0 || materialIndex >= int(gltfModel.materials.size())) {
+				return white;
+			}
+
+			int textureIndex = gltfModel.materials[materialIndex].pbrMetallicRoughness.baseColorTexture.index;
+			if (textureIndex < 0 || textureIndex >= int(gltfModel.textures.size())) {
+				return white;
+			}
+
+			int imageIndex = gltfModel.textures[textureIndex].source;
+			if (imageIndex < 0 || imageIndex >= int(gltfModel.images.size())) {
+				return white;
+			}
+
+			const tinygltf::Image& image = gltfModel.images[imageIndex];
+			if (!image.uri.empty()) {
+				return atlas.addFile(image.uri);
+			}
+			if (!image.image.empty()) {
+				return atlas.add(filename + "#" + std::to_string(imageIndex), image.image.data(), uint32_t(image.width), uint32_t(image.height), uint32_t(image.component));
+			}
+			return white;
+		}
+	}
+
+	UIMesh UIMesh::loadFromFile(const std::string& filename) {
+		Model::Builder builder;
+		builder.loadModel(filename);
+
+		UIAtlas::Region region = loadBaseColorRegion(filename, builder.gltfModelData, builder.textureMaterialIndex);
+
+		UIMesh mesh;
+		mesh.vertices.reserve(builder.vertices.size());
+		for (const Model::Vertex& vertex : builder.vertices) {
+			mesh.vertices.push_back({vertex.position, vertex.color, region.map(vertex.uv)});
+		}
+		mesh.indices = std::move(builder.indices);
+		return mesh;
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vk {
+
+	// one vertex of the ui batch, positions are in pixels and uvs point into the ui atlas
+	struct UIVertex {
+		glm::vec3 position;
+		glm::vec3 color;
+		glm::vec2 uv;
+
+		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+	};
+
+	// cpu geometry of one ui component, copied into the shared ui buffers by the ui render system
+	struct UIMesh {
+		std::vector<UIVertex> vertices;
+		// empty for non indexed triangle lists
+		std::vector<uint32_t> indices;
+
+		// first mesh of a gltf file, its base color texture is added to the ui atlas
+		static UIMesh loadFromFile(const std::string& filename);
+	};
+}
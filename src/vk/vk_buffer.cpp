@@ -9,6 +9,7 @@
 #include "../Engine.h"
 
 // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -71,6 +72,27 @@ namespace vk {
 		}
 	}
 	
+	bool Buffer::reserveMapped(
+		std::unique_ptr<Buffer>& buffer,
+		Device& device,
+		VkDeviceSize instanceSize,
+		uint32_t requiredCount,
+		VkBufferUsageFlags usageFlags,
+		uint32_t allocateCount) {
+		if (buffer && buffer->getInstanceCount() >= requiredCount) {
+			return false;
+		}
+
+		buffer = std::make_unique<Buffer>(
+			device,
+			instanceSize,
+			std::max(requiredCount, allocateCount),
+			usageFlags,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		buffer->map();
+		return true;
+	}
+
 	void Buffer::scheduleDestroy(DestructionQueue& destructionQueue) {
 		unmap();
 		destructionQueue.pushBuffer(buffer, memory);
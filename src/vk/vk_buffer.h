@@ -3,6 +3,8 @@
 #include "vk_device.h"
 #include "vk_destruction_queue.h"
 
+#include <memory>
+
 namespace vk {
 
 	class Buffer {
@@ -18,6 +20,18 @@ namespace vk {
 		
 		void scheduleDestroy(DestructionQueue& destructionQueue);
 
+		// replaces buffer by a larger persistently mapped host visible one if it holds fewer than requiredCount instances,
+		// frames in flight keep reading the old buffer, ~Buffer only destroys it through the destruction queue
+		// @param allocateCount instances of the new buffer, e.g. with room to grow, at least requiredCount
+		// @returns true if the buffer was replaced, its contents are undefined then
+		static bool reserveMapped(
+			std::unique_ptr<Buffer>& buffer,
+			Device& device,
+			VkDeviceSize instanceSize,
+			uint32_t requiredCount,
+			VkBufferUsageFlags usageFlags,
+			uint32_t allocateCount = 0);
+
 		Buffer(const Buffer&) = delete;
 		Buffer& operator=(const Buffer&) = delete;
 
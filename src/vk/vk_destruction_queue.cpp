@@ -77,6 +77,18 @@ void DestructionQueue::pushPipeline(VkPipeline pipeline) {
     }
 }
 
+void DestructionQueue::pushShaderModule(VkShaderModule shaderModule) {
+    if (shaderModule != VK_NULL_HANDLE) {
+        // during resize operations, add to immediate deletion queue
+        if (device.getWindow().framebufferResized) {
+            immediateDeletionQueue.shaderModules.push_back(shaderModule);
+        } else {
+            uint32_t frameIndex = swapChain->getCurrentFrame();
+            frameDeletionQueues[frameIndex].shaderModules.push_back(shaderModule);
+        }
+    }
+}
+
 void DestructionQueue::pushPipelineLayout(VkPipelineLayout pipelineLayout) {
     if (pipelineLayout != VK_NULL_HANDLE) {
         // during resize operations, add to immediate deletion queue
@@ -229,6 +241,16 @@ void DestructionQueue::cleanupDeletionQueue(DeletionQueue& queue) {
 	}
 	queue.pipelines.clear();
 	
+	if (queue.shaderModules.size() > 0) {
+		std::cout << "DestructionQueue: Destroying " << queue.shaderModules.size() << " shader modules" << std::endl;
+		for (auto shaderModule : queue.shaderModules) {
+			if (shaderModule != VK_NULL_HANDLE) {
+				vkDestroyShaderModule(device.device(), shaderModule, nullptr);
+			}
+		}
+	}
+	queue.shaderModules.clear();
+	
 	if (queue.samplers.size() > 0) {
 		std::cout << "DestructionQueue: Destroying " << queue.samplers.size() << " samplers" << std::endl;
 		for (auto sampler : queue.samplers) {
@@ -374,6 +396,7 @@ void DestructionQueue::logResourceCounts() {
 	size_t totalImageViews = 0;
 	size_t totalSamplers = 0;
 	size_t totalPipelines = 0;
+	size_t totalShaderModules = 0;
 	size_t totalPipelineLayouts = 0;
 	size_t totalDescriptorSetLayouts = 0;
 	size_t totalDescriptorPools = 0;
@@ -389,6 +412,7 @@ void DestructionQueue::logResourceCounts() {
 		totalImageViews += queue.imageViews.size();
 		totalSamplers += queue.samplers.size();
 		totalPipelines += queue.pipelines.size();
+		totalShaderModules += queue.shaderModules.size();
 		totalPipelineLayouts += queue.pipelineLayouts.size();
 		totalDescriptorSetLayouts += queue.descriptorSetLayouts.size();
 		totalDescriptorPools += queue.descriptorPools.size();
@@ -403,6 +427,7 @@ void DestructionQueue::logResourceCounts() {
 	totalImageViews += immediateDeletionQueue.imageViews.size();
 	totalSamplers += immediateDeletionQueue.samplers.size();
 	totalPipelines += immediateDeletionQueue.pipelines.size();
+	totalShaderModules += immediateDeletionQueue.shaderModules.size();
 	totalPipelineLayouts += immediateDeletionQueue.pipelineLayouts.size();
 	totalDescriptorSetLayouts += immediateDeletionQueue.descriptorSetLayouts.size();
 	totalDescriptorPools += immediateDeletionQueue.descriptorPools.size();
@@ -411,7 +436,7 @@ void DestructionQueue::logResourceCounts() {
 	totalRenderPasses += immediateDeletionQueue.renderPasses.size();
 	
 	if (totalBuffers > 0 || totalImages > 0 || totalImageViews > 0 || totalSamplers > 0 ||
-		totalPipelines > 0 || totalPipelineLayouts > 0 || totalDescriptorSetLayouts > 0 ||
+		totalPipelines > 0 || totalShaderModules > 0 || totalPipelineLayouts > 0 || totalDescriptorSetLayouts > 0 ||
 		totalDescriptorPools > 0 || totalDescriptorSets > 0 || totalFramebuffers > 0 ||
 		totalRenderPasses > 0) {
 		
@@ -421,6 +446,7 @@ void DestructionQueue::logResourceCounts() {
 			<< ", ImageViews: " << totalImageViews
 			<< ", Samplers: " << totalSamplers
 			<< ", Pipelines: " << totalPipelines
+			<< ", ShaderModules: " << totalShaderModules
 			<< ", PipelineLayouts: " << totalPipelineLayouts
 			<< ", DescriptorSetLayouts: " << totalDescriptorSetLayouts
 			<< ", DescriptorPools: " << totalDescriptorPools
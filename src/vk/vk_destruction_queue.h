@@ -15,6 +15,7 @@ struct DeletionQueue {
     std::vector<VkImageView> imageViews;
     std::vector<VkSampler> samplers;
     std::vector<VkPipeline> pipelines;
+    std::vector<VkShaderModule> shaderModules;
     std::vector<VkPipelineLayout> pipelineLayouts;
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
     std::vector<VkDescriptorPool> descriptorPools;
@@ -35,6 +36,7 @@ public:
     void pushImageView(VkImageView imageView);
     void pushSampler(VkSampler sampler);
     void pushPipeline(VkPipeline pipeline);
+    void pushShaderModule(VkShaderModule shaderModule);
     void pushPipelineLayout(VkPipelineLayout pipelineLayout);
     void pushDescriptorSetLayout(VkDescriptorSetLayout descriptorSetLayout);
     void pushDescriptorPool(VkDescriptorPool descriptorPool);
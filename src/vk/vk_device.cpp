@@ -1,6 +1,7 @@
 #include "vk_device.h"
 
 #include "../Engine.h"
+#include "../asset_utils/AssetLoader.h"
 
 // std headers
 #include <cstring>
@@ -11,6 +12,7 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <filesystem>
 #ifndef VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME
 #define VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME "VK_KHR_portability_subset"
 #endif
@@ -366,6 +368,7 @@ namespace vk {
 		createLogicalDevice();
 		createImmediateCommandPool();
 		vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+		createPipelineCache();
 	}
 
 	Device::~Device() {
@@ -396,6 +399,12 @@ namespace vk {
 				destructionQueue->cleanup();
 			}
 			
+			if (m_pipelineCache != VK_NULL_HANDLE) {
+				savePipelineCache();
+				vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+				m_pipelineCache = VK_NULL_HANDLE;
+			}
+
 			vkDestroyDevice(m_device, nullptr);
 			std::cout << "Device: Logical device destroyed" << std::endl;
 			
@@ -435,7 +444,8 @@ namespace vk {
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "No Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		// 1.2 for core descriptor indexing (bindless materials), devices without it fall back to per-material sets
+		appInfo.apiVersion = VK_API_VERSION_1_2;
 
 		VkInstanceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -531,8 +541,39 @@ namespace vk {
 		deviceFeatures.tessellationShader = VK_TRUE;
 		deviceFeatures.fillModeNonSolid = VK_TRUE;
 
+		// descriptor indexing features needed for the bindless texture / material tables
+		VkPhysicalDeviceProperties physicalProperties{};
+		vkGetPhysicalDeviceProperties(physicalDevice_, &physicalProperties);
+
+		VkPhysicalDeviceVulkan12Features supported12{};
+		supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		if (physicalProperties.apiVersion >= VK_API_VERSION_1_2) {
+			VkPhysicalDeviceFeatures2 supportedFeatures{};
+			supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			supportedFeatures.pNext = &supported12;
+			vkGetPhysicalDeviceFeatures2(physicalDevice_, &supportedFeatures);
+		}
+
+		bindlessSupported = supported12.runtimeDescriptorArray
+			&& supported12.shaderSampledImageArrayNonUniformIndexing
+			&& supported12.descriptorBindingPartiallyBound
+			&& supported12.descriptorBindingSampledImageUpdateAfterBind
+			&& supported12.descriptorBindingUpdateUnusedWhilePending;
+
+		VkPhysicalDeviceVulkan12Features enabled12{};
+		enabled12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		if (bindlessSupported) {
+			enabled12.runtimeDescriptorArray = VK_TRUE;
+			enabled12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			enabled12.descriptorBindingPartiallyBound = VK_TRUE;
+			enabled12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			enabled12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		}
+		std::cout << "Device: Bindless materials " << (bindlessSupported ? "enabled" : "not supported") << std::endl;
+
 		VkDeviceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = bindlessSupported ? &enabled12 : nullptr;
 
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -576,6 +617,91 @@ namespace vk {
 		}
 	}
 
+	static const char* PIPELINE_CACHE_FILE = "pipeline_cache.bin";
+
+	bool Device::isPipelineCacheCompatible(const std::vector<char>& data) const {
+		// layout of VkPipelineCacheHeaderVersionOne, parsed by hand because the blob may be unaligned or truncated
+		struct CacheHeader {
+			uint32_t headerSize;
+			uint32_t headerVersion;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		};
+
+		if (data.size() < sizeof(CacheHeader)) {
+			return false;
+		}
+
+		CacheHeader header{};
+		std::memcpy(&header, data.data(), sizeof(CacheHeader));
+
+		return header.headerSize >= sizeof(CacheHeader)
+			&& header.headerSize <= data.size()
+			&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header.vendorID == properties.vendorID
+			&& header.deviceID == properties.deviceID
+			&& std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	void Device::createPipelineCache() {
+		AssetLoader& assetLoader = AssetLoader::getInstance();
+		std::string cachePath = assetLoader.resolvePath(std::string("generated:") + PIPELINE_CACHE_FILE, true);
+
+		std::vector<char> initialData;
+		if (std::filesystem::exists(cachePath)) {
+			try {
+				initialData = assetLoader.readFile(cachePath);
+			} catch (const std::exception& e) {
+				std::cerr << "Device: Could not read pipeline cache: " << e.what() << std::endl;
+			}
+
+			// a cache from another driver / gpu is rejected (or worse) by the driver, so start empty instead
+			if (!initialData.empty() && !isPipelineCacheCompatible(initialData)) {
+				std::cout << "Device: Discarding incompatible pipeline cache" << std::endl;
+				initialData.clear();
+			}
+		}
+
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = initialData.size();
+		cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+		if (vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_pipelineCache) != VK_SUCCESS) {
+			// retry without the stored data before giving up
+			cacheInfo.initialDataSize = 0;
+			cacheInfo.pInitialData = nullptr;
+			if (vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_pipelineCache) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create pipeline cache!");
+			}
+		}
+
+		std::cout << "Device: Created pipeline cache (" << initialData.size() << " bytes loaded)" << std::endl;
+	}
+
+	void Device::savePipelineCache() {
+		if (m_pipelineCache == VK_NULL_HANDLE) {
+			return;
+		}
+
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+			return;
+		}
+
+		std::vector<char> data(dataSize);
+		if (vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+			std::cerr << "Device: Failed to retrieve pipeline cache data" << std::endl;
+			return;
+		}
+		data.resize(dataSize);
+
+		if (!AssetLoader::getInstance().saveBinaryFile(PIPELINE_CACHE_FILE, data).empty()) {
+			std::cout << "Device: Saved pipeline cache (" << dataSize << " bytes)" << std::endl;
+		}
+	}
+
 	void Device::createCommandPool(VkCommandPool& out_pool) {
 		QueueFamilyIndices queueFamilyIndices = findPhysicalQueueFamilies();
 
@@ -897,6 +1023,51 @@ namespace vk {
 		endImmediateCommands(commandBuffer);
 	}
 
+	void Device::copyBufferToImageMipChain(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, const std::vector<VkDeviceSize>& levelOffsets) {
+		uint32_t mipLevels = static_cast<uint32_t>(levelOffsets.size());
+		VkCommandBuffer commandBuffer = beginImmediateCommands();
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		std::vector<VkBufferImageCopy> regions(mipLevels);
+		for (uint32_t level = 0; level < mipLevels; level++) {
+			VkBufferImageCopy& region = regions[level];
+			region.bufferOffset = levelOffsets[level];
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = {0, 0, 0};
+			region.imageExtent = {std::max(1u, width >> level), std::max(1u, height >> level), 1};
+		}
+		vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, regions.data());
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		endImmediateCommands(commandBuffer);
+	}
+
 	void Device::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, uint32_t layerCount) {
 		if (mipLevels <= 1) {
 			transitionImageLayout(
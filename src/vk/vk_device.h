@@ -60,6 +60,17 @@ namespace vk {
 		VkQueue presentQueue() {
 			return m_presentQueue;
 		}
+
+		// device-wide pipeline cache, persisted to generated:pipeline_cache.bin
+		VkPipelineCache pipelineCache() {
+			return m_pipelineCache;
+		}
+		void savePipelineCache();
+
+		// descriptor indexing (runtime arrays, partially bound, update after bind) is available
+		bool supportsBindless() const {
+			return bindlessSupported;
+		}
 		
 		Window& getWindow() {
 			return window;
@@ -87,6 +98,8 @@ namespace vk {
 		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &bufferMemory);
 		void createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory);
 		void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
+		// uploads a complete mip chain (one tightly packed level per offset) and leaves the image shader readable
+		void copyBufferToImageMipChain(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, const std::vector<VkDeviceSize>& levelOffsets);
 		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);	 // Add copyBuffer declaration
 
 		VkPhysicalDeviceProperties properties;	// Add properties member
@@ -103,6 +116,8 @@ namespace vk {
 		void pickPhysicalDevice();
 		void createLogicalDevice();
 		void createImmediateCommandPool();
+		void createPipelineCache();
+		bool isPipelineCacheCompatible(const std::vector<char> &data) const;
 
 		// helper functions
 		bool isDeviceSuitable(VkPhysicalDevice device);
@@ -124,6 +139,8 @@ namespace vk {
 		VkSurfaceKHR m_surface;
 		VkQueue m_graphicsQueue;
 		VkQueue m_presentQueue;
+		VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+		bool bindlessSupported = false;
 
 		const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
 		std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
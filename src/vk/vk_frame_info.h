@@ -7,6 +7,8 @@
 
 namespace vk {
 
+	class OcclusionCuller;
+
 	struct ShadowUbo {
 		glm::mat4 lightSpaceMatrix{1.0f};
 		// x: shadow map size, y: PCF samples, z: bias, w: shadow strength
@@ -22,11 +24,22 @@ namespace vk {
 		glm::vec4 sunDirection{0.0f, -1.0f, 0.0f, 1.0f};
 		glm::vec4 sunColor{1.0f, 1.0f, 1.0f, 0.0f};
 		glm::vec4 cameraPosition = glm::vec4{0.0f};
+		// x = terrain tessellation scale (lowered for distant shadow cascades), yzw = unused
+		glm::vec4 lodParams = glm::vec4{1.0f, 0.0f, 0.0f, 0.0f};
 	};
 
 	enum RenderPassType {
 		DEFAULT_PASS,
-		SHADOW_PASS
+		SHADOW_PASS,
+		// depth only, opaque objects of the main camera before the shaded main pass
+		DEPTH_PREPASS
+	};
+
+	// which casters a shadow pass draws, static casters are cached by the shadow map
+	enum class ShadowCasters {
+		ALL,
+		STATIC_ONLY,
+		DYNAMIC_ONLY
 	};
 
 	struct FrameInfo {
@@ -34,6 +47,20 @@ namespace vk {
 		VkCommandBuffer commandBuffer;
 		std::vector<DescriptorSet> systemDescriptorSets;
 		RenderPassType renderPassType = DEFAULT_PASS;
+		// used for depth sorting of draws, also set for the shadow pass
+		glm::vec3 cameraPosition{0.0f};
+		// view direction of the main camera, draws are sorted by their depth along it
+		glm::vec3 cameraForward{0.0f};
+		// objects with a smaller world space bounding radius are not drawn (coarse shadow cascades)
+		float minCasterRadius = 0.0f;
+		// projection[1][1] of the main camera for screen size lod selection, 0 draws every model at full detail
+		float lodProjectionScale = 0.0f;
+		// only read in the shadow pass
+		ShadowCasters shadowCasters = ShadowCasters::ALL;
+		// main pass only: opaque objects are already in the depth buffer and are shaded with an equal depth test
+		bool depthPrepassed = false;
+		// occluder depth of the main camera, only set in the main pass with occlusion culling enabled
+		const OcclusionCuller* occlusionCuller = nullptr;
 		// TODO use this for debug rendering with jolt debug renderer (implement DebugRenderer.h)
 		bool isDebugPhysics = false;
 	};
@@ -0,0 +1,324 @@
+#include "vk_mesh_simplifier.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+namespace vk {
+
+	namespace {
+
+		// symmetric 4x4 matrix, upper triangle only
+		struct Quadric {
+			double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+			double a11 = 0, a12 = 0, a13 = 0;
+			double a22 = 0, a23 = 0;
+			double a33 = 0;
+
+			static Quadric fromPlane(const glm::dvec3& n, double d, double weight) {
+				Quadric q;
+				q.a00 = weight * n.x * n.x;
+				q.a01 = weight * n.x * n.y;
+				q.a02 = weight * n.x * n.z;
+				q.a03 = weight * n.x * d;
+				q.a11 = weight * n.y * n.y;
+				q.a12 = weight * n.y * n.z;
+				q.a13 = weight * n.y * d;
+				q.a22 = weight * n.z * n.z;
+				q.a23 = weight * n.z * d;
+				q.a33 = weight * d * d;
+				return q;
+			}
+
+			Quadric& operator+=(const Quadric& o) {
+				a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+				a11 += o.a11; a12 += o.a12; a13 += o.a13;
+				a22 += o.a22; a23 += o.a23;
+				a33 += o.a33;
+				return *this;
+			}
+
+			// sum of squared distances of p to all accumulated planes
+			double error(const glm::vec3& p) const {
+				double x = p.x, y = p.y, z = p.z;
+				return a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+					+ a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+					+ a22 * z * z + 2.0 * a23 * z
+					+ a33;
+			}
+		};
+
+		struct Collapse {
+			double cost;
+			uint32_t from;
+			uint32_t to;
+			uint32_t fromVersion;
+			uint32_t toVersion;
+
+			bool operator>(const Collapse& o) const { return cost > o.cost; }
+		};
+
+		// boundary edges are kept in place by an additional plane perpendicular to the face
+		constexpr double BOUNDARY_WEIGHT = 4.0;
+		// collapses that turn a triangle further than ~78 degrees are rejected
+		constexpr float MIN_NORMAL_DOT = 0.2f;
+
+		inline uint64_t edgeKey(uint32_t a, uint32_t b) {
+			return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+		}
+	}
+
+	MeshSimplifier::MeshSimplifier(const std::vector<glm::vec3>& positions, const std::vector<Attributes>& attributes)
+		: positions(positions), attributes(attributes) {
+		positionGroup.resize(positions.size());
+
+		std::unordered_map<glm::vec3, uint32_t> groupOfPosition;
+		groupOfPosition.reserve(positions.size());
+
+		for (uint32_t v = 0; v < positions.size(); v++) {
+			auto [it, inserted] = groupOfPosition.try_emplace(positions[v], uint32_t(groupVertices.size()));
+			if (inserted) {
+				groupVertices.emplace_back();
+			}
+			positionGroup[v] = it->second;
+			groupVertices[it->second].push_back(v);
+		}
+	}
+
+	std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<uint32_t>& indices, size_t targetTriangles, float maxError) const {
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount <= targetTriangles) {
+			return indices;
+		}
+
+		size_t groupCount = groupVertices.size();
+
+		// corners reference vertices (for attributes) and position groups (for topology)
+		std::vector<std::array<uint32_t, 3>> triVertices(triangleCount);
+		std::vector<std::array<uint32_t, 3>> triGroups(triangleCount);
+		std::vector<bool> triRemoved(triangleCount, false);
+		std::vector<std::vector<uint32_t>> groupTriangles(groupCount);
+		std::vector<Quadric> quadrics(groupCount);
+
+		auto groupPosition = [&](uint32_t g) -> const glm::vec3& { return positions[groupVertices[g][0]]; };
+
+		std::unordered_map<uint64_t, uint32_t> edgeUse;
+		edgeUse.reserve(triangleCount * 3);
+
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			for (int c = 0; c < 3; c++) {
+				triVertices[t][c] = indices[t * 3 + c];
+				triGroups[t][c] = positionGroup[triVertices[t][c]];
+			}
+
+			auto& g = triGroups[t];
+			if (g[0] == g[1] || g[1] == g[2] || g[0] == g[2]) {
+				triRemoved[t] = true;
+				continue;
+			}
+
+			for (int c = 0; c < 3; c++) {
+				groupTriangles[g[c]].push_back(t);
+				edgeUse[edgeKey(g[c], g[(c + 1) % 3])]++;
+			}
+
+			glm::dvec3 p0 = groupPosition(g[0]);
+			glm::dvec3 n = glm::cross(glm::dvec3(groupPosition(g[1])) - p0, glm::dvec3(groupPosition(g[2])) - p0);
+			double length = glm::length(n);
+			if (length < 1e-12) {
+				continue;
+			}
+			n /= length;
+
+			Quadric q = Quadric::fromPlane(n, -glm::dot(n, p0), 1.0);
+			for (int c = 0; c < 3; c++) {
+				quadrics[g[c]] += q;
+			}
+		}
+
+		// open edges (leaf cards, cut branch ends) only belong to one triangle
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			if (triRemoved[t]) {
+				continue;
+			}
+			auto& g = triGroups[t];
+			glm::dvec3 p0 = groupPosition(g[0]);
+			glm::dvec3 faceNormal = glm::cross(glm::dvec3(groupPosition(g[1])) - p0, glm::dvec3(groupPosition(g[2])) - p0);
+
+			for (int c = 0; c < 3; c++) {
+				uint32_t a = g[c];
+				uint32_t b = g[(c + 1) % 3];
+				if (edgeUse[edgeKey(a, b)] != 1) {
+					continue;
+				}
+				glm::dvec3 pa = groupPosition(a);
+				glm::dvec3 n = glm::cross(glm::dvec3(groupPosition(b)) - pa, faceNormal);
+				double length = glm::length(n);
+				if (length < 1e-12) {
+					continue;
+				}
+				n /= length;
+
+				Quadric q = Quadric::fromPlane(n, -glm::dot(n, pa), BOUNDARY_WEIGHT);
+				quadrics[a] += q;
+				quadrics[b] += q;
+			}
+		}
+
+		std::vector<uint32_t> version(groupCount, 0);
+		std::vector<bool> groupRemoved(groupCount, false);
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+		auto pushCollapse = [&](uint32_t a, uint32_t b) {
+			Quadric q = quadrics[a];
+			q += quadrics[b];
+			double toB = q.error(groupPosition(b));
+			double toA = q.error(groupPosition(a));
+			if (toB <= toA) {
+				heap.push({ toB, a, b, version[a], version[b] });
+			} else {
+				heap.push({ toA, b, a, version[b], version[a] });
+			}
+		};
+
+		for (const auto& [key, count] : edgeUse) {
+			pushCollapse(uint32_t(key >> 32), uint32_t(key & 0xFFFFFFFFu));
+		}
+
+		auto neighbors = [&](uint32_t g, std::vector<uint32_t>& out) {
+			out.clear();
+			for (uint32_t t : groupTriangles[g]) {
+				if (triRemoved[t]) {
+					continue;
+				}
+				for (uint32_t other : triGroups[t]) {
+					if (other != g) {
+						out.push_back(other);
+					}
+				}
+			}
+			std::sort(out.begin(), out.end());
+			out.erase(std::unique(out.begin(), out.end()), out.end());
+		};
+
+		// attributes of a corner that moves onto another position group, picks the closest seam variant
+		auto closestVariant = [&](uint32_t group, uint32_t vertex) {
+			const auto& variants = groupVertices[group];
+			uint32_t best = variants[0];
+			float bestDistance = std::numeric_limits<float>::max();
+			for (uint32_t candidate : variants) {
+				glm::vec3 dn = attributes[candidate].normal - attributes[vertex].normal;
+				glm::vec2 duv = attributes[candidate].uv - attributes[vertex].uv;
+				float distance = glm::dot(dn, dn) + glm::dot(duv, duv);
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = candidate;
+				}
+			}
+			return best;
+		};
+
+		double maxCost = double(maxError) * double(maxError);
+		size_t liveTriangles = std::count(triRemoved.begin(), triRemoved.end(), false);
+		std::vector<uint32_t> fromNeighbors, toNeighbors;
+
+		while (liveTriangles > targetTriangles && !heap.empty()) {
+			Collapse collapse = heap.top();
+			heap.pop();
+
+			uint32_t from = collapse.from;
+			uint32_t to = collapse.to;
+			if (groupRemoved[from] || groupRemoved[to] || version[from] != collapse.fromVersion || version[to] != collapse.toVersion) {
+				continue;
+			}
+			if (collapse.cost > maxCost) {
+				break;
+			}
+
+			// link condition, more than two shared neighbors would pinch the surface
+			neighbors(from, fromNeighbors);
+			neighbors(to, toNeighbors);
+			size_t shared = 0;
+			for (uint32_t n : fromNeighbors) {
+				shared += std::binary_search(toNeighbors.begin(), toNeighbors.end(), n);
+			}
+			if (shared > 2) {
+				continue;
+			}
+
+			// reject collapses that fold triangles over
+			const glm::vec3& target = groupPosition(to);
+			bool flips = false;
+			for (uint32_t t : groupTriangles[from]) {
+				auto& g = triGroups[t];
+				if (triRemoved[t] || g[0] == to || g[1] == to || g[2] == to) {
+					continue;
+				}
+				std::array<glm::vec3, 3> p = { groupPosition(g[0]), groupPosition(g[1]), groupPosition(g[2]) };
+				glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				for (int c = 0; c < 3; c++) {
+					if (g[c] == from) {
+						p[c] = target;
+					}
+				}
+				glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+				float lengths = glm::length(before) * glm::length(after);
+				if (lengths <= 0.0f || glm::dot(before, after) < MIN_NORMAL_DOT * lengths) {
+					flips = true;
+					break;
+				}
+			}
+			if (flips) {
+				continue;
+			}
+
+			for (uint32_t t : groupTriangles[from]) {
+				if (triRemoved[t]) {
+					continue;
+				}
+				auto& g = triGroups[t];
+				for (int c = 0; c < 3; c++) {
+					if (g[c] == from) {
+						g[c] = to;
+						triVertices[t][c] = closestVariant(to, triVertices[t][c]);
+					}
+				}
+				if (g[0] == g[1] || g[1] == g[2] || g[0] == g[2]) {
+					triRemoved[t] = true;
+					liveTriangles--;
+				} else {
+					groupTriangles[to].push_back(t);
+				}
+			}
+
+			quadrics[to] += quadrics[from];
+			groupRemoved[from] = true;
+			groupTriangles[from].clear();
+			version[to]++;
+
+			auto& toTriangles = groupTriangles[to];
+			toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(), [&](uint32_t t) { return triRemoved[t]; }), toTriangles.end());
+
+			neighbors(to, toNeighbors);
+			for (uint32_t n : toNeighbors) {
+				pushCollapse(to, n);
+			}
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(liveTriangles * 3);
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			if (!triRemoved[t]) {
+				result.insert(result.end(), triVertices[t].begin(), triVertices[t].end());
+			}
+		}
+		return result;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace vk {
+
+	// quadric error metric edge collapse (garland & heckbert) on an indexed triangle list
+	// vertices are never moved or created, collapses always snap onto an existing vertex,
+	// so every level can index into the vertex buffer of the full resolution mesh
+	class MeshSimplifier {
+	   public:
+		struct Attributes {
+			glm::vec3 normal;
+			glm::vec2 uv;
+		};
+
+		MeshSimplifier(const std::vector<glm::vec3>& positions, const std::vector<Attributes>& attributes);
+
+		// @param indices triangle list to simplify, usually the previous (finer) level
+		// @param targetTriangles stop once the mesh has this many triangles or less
+		// @param maxError stop once the cheapest collapse moves the surface further than this (object space units)
+		// @returns the simplified triangle list, may have more triangles than requested if maxError was hit
+		std::vector<uint32_t> simplify(const std::vector<uint32_t>& indices, size_t targetTriangles, float maxError) const;
+
+	   private:
+		const std::vector<glm::vec3>& positions;
+		const std::vector<Attributes>& attributes;
+
+		// vertices sharing a position (uv / normal seams) collapse together
+		std::vector<uint32_t> positionGroup;
+		std::vector<std::vector<uint32_t>> groupVertices;
+	};
+}
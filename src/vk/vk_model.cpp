@@ -2,11 +2,13 @@
 #include "vk_utils.hpp"
 #include "vk_buffer.h"
 #include "vk_descriptors.h"
+#include "vk_mesh_simplifier.h"
 
 #include "../asset_utils/AssetLoader.h"
 #include "../rendering/materials/StandardMaterial.h"
 #include "../rendering/materials/UIMaterial.h"
 #include "../rendering/materials/TessellationMaterial.h"
+#include "../procedural/HeightmapGenerator.h"
 
 #include <random>
 #include <algorithm>
@@ -18,8 +20,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/hash.hpp>
 #include <glm/gtc/noise.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include <cassert>
+#include <cstring>
 #include <unordered_map>
 #include <memory>
 #include <iostream>
@@ -40,6 +44,56 @@ namespace std {
 }
 
 namespace vk {
+
+	namespace {
+		// meshes below this are cheap enough at full resolution
+		constexpr size_t MIN_LOD_TRIANGLES = 256;
+		// per level: triangle budget relative to the full mesh, max simplification error relative to the bounding box diagonal
+		// and the screen size below which the next coarser level takes over
+		constexpr float LOD_TRIANGLE_RATIOS[Model::MAX_LODS] = { 1.0f, 0.5f, 0.25f, 0.1f };
+		constexpr float LOD_MAX_ERRORS[Model::MAX_LODS] = { 0.0f, 0.01f, 0.03f, 0.08f };
+		constexpr float LOD_SCREEN_SIZES[Model::MAX_LODS] = { 0.25f, 0.1f, 0.04f, 0.0f };
+		// relative margin around the thresholds before a model switches back and forth
+		constexpr float LOD_HYSTERESIS = 0.15f;
+
+		uint16_t quantizeUnorm16(float value) {
+			return uint16_t(std::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+		}
+
+		uint8_t quantizeUnorm8(float value) {
+			return uint8_t(std::round(glm::clamp(value, 0.0f, 1.0f) * 255.0f));
+		}
+
+		int16_t quantizeSnorm16(float value) {
+			return int16_t(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+		}
+
+		// octahedral mapping of a unit vector onto [-1, 1]^2, decoded in the *_compact.vert shaders
+		glm::vec2 octEncode(glm::vec3 n) {
+			float length = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+			if (length < 1e-6f) {
+				return glm::vec2(0.0f, 0.0f);
+			}
+			n /= length;
+			glm::vec2 p(n.x, n.y);
+			if (n.z < 0.0f) {
+				p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * glm::vec2(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+			}
+			return p;
+		}
+
+		// same as octDecode in the *_compact.vert shaders
+		glm::vec3 octDecode(glm::vec2 e) {
+			glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+			if (n.z < 0.0f) {
+				glm::vec2 p = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+				n.x = p.x;
+				n.y = p.y;
+			}
+			return glm::normalize(n);
+		}
+	}
+
 	Model::Model(Device& device, const Builder& builder) : device(device), m_boundsMin(builder.boundsMin), m_boundsMax(builder.boundsMax), m_dynamic(builder.dynamic) {
 
 		m_memFlags = m_dynamic
@@ -50,8 +104,20 @@ namespace vk {
 			updateMesh(builder.vertices, builder.indices);
 		}
 		else {
-			createVertexBuffer(builder.vertices);
-			createIndexBuffer(builder.indices);
+			std::vector<CompactVertex> compact;
+			if (builder.compactVertices && packCompactVertices(builder.vertices, compact, positionDecode)) {
+				compactVertices = true;
+				createVertexBuffer(compact.data(), sizeof(CompactVertex), static_cast<uint32_t>(compact.size()));
+			}
+			else {
+				createVertexBuffer(builder.vertices);
+			}
+			if (builder.generateLods) {
+				createIndexBuffer(generateLodIndices(builder));
+			}
+			else {
+				createIndexBuffer(builder.indices);
+			}
 		}
 		
 		if (builder.textureMaterialIndex >= 0) {
@@ -62,6 +128,18 @@ namespace vk {
 			else {
 				createStandardMaterialFromGltf(builder.gltfModelData, builder.textureMaterialIndex);
 			}
+			matchVertexFormatToMaterial();
+		}
+	}
+
+	void Model::setMaterial(std::shared_ptr<Material> material) {
+		this->material = material;
+		matchVertexFormatToMaterial();
+	}
+
+	void Model::matchVertexFormatToMaterial() {
+		if (compactVertices && material && Pipeline::compactVertexShaderPath(material->getPipelineConfig().vertShaderPath).empty()) {
+			unpackCompactVertices();
 		}
 	}
 
@@ -76,7 +154,102 @@ namespace vk {
 				indexBuffer->scheduleDestroy(*destructionQueue);
 				indexBuffer.reset();
 			}
+			if (instanceBuffer) {
+				instanceBuffer->scheduleDestroy(*destructionQueue);
+				instanceBuffer.reset();
+			}
+		}
+	}
+
+	void Model::createInstanceBuffer(const void* instances, uint32_t instanceSize, uint32_t count) {
+		if (count == 0) {
+			return;
+		}
+		// written once, small enough to be read from host memory
+		instanceBuffer = std::make_unique<Buffer>(
+			device,
+			instanceSize,
+			count,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		instanceBuffer->map();
+		instanceBuffer->writeToBuffer(const_cast<void*>(instances));
+		instanceBuffer->unmap();
+	}
+
+	std::vector<uint32_t> Model::generateLodIndices(const Builder& builder) {
+		lods.clear();
+
+		size_t triangleCount = builder.indices.size() / 3;
+		if (triangleCount < MIN_LOD_TRIANGLES) {
+			return builder.indices;
+		}
+
+		std::vector<glm::vec3> positions;
+		std::vector<MeshSimplifier::Attributes> attributes;
+		positions.reserve(builder.vertices.size());
+		attributes.reserve(builder.vertices.size());
+		glm::vec3 mn{ std::numeric_limits<float>::max() };
+		glm::vec3 mx{ -std::numeric_limits<float>::max() };
+		for (const auto& vertex : builder.vertices) {
+			positions.push_back(vertex.position);
+			attributes.push_back({ vertex.normal, vertex.uv });
+			mn = glm::min(mn, vertex.position);
+			mx = glm::max(mx, vertex.position);
+		}
+		float extent = glm::length(mx - mn);
+
+		MeshSimplifier simplifier(positions, attributes);
+
+		std::vector<uint32_t> allIndices = builder.indices;
+		std::vector<uint32_t> previous = builder.indices;
+		lods.push_back({ 0, uint32_t(builder.indices.size()), LOD_SCREEN_SIZES[0] });
+
+		// every level is simplified from the previous one, so coarse levels only pay for what is left
+		for (uint32_t level = 1; level < MAX_LODS; level++) {
+			size_t targetTriangles = size_t(float(triangleCount) * LOD_TRIANGLE_RATIOS[level]);
+			std::vector<uint32_t> simplified = simplifier.simplify(previous, targetTriangles, extent * LOD_MAX_ERRORS[level]);
+
+			// the error bound stopped the simplifier early, another level would barely save anything
+			if (simplified.empty() || simplified.size() * 5 > previous.size() * 4) {
+				break;
+			}
+
+			lods.push_back({ uint32_t(allIndices.size()), uint32_t(simplified.size()), LOD_SCREEN_SIZES[level] });
+			allIndices.insert(allIndices.end(), simplified.begin(), simplified.end());
+			previous = std::move(simplified);
+		}
+
+		if (lods.size() == 1) {
+			lods.clear();
+			return builder.indices;
+		}
+
+		// the coarsest level has no further level to switch to
+		lods.back().minScreenSize = 0.0f;
+
+		std::cout << "Generated " << lods.size() << " LODs with";
+		for (const auto& lod : lods) {
+			std::cout << " " << lod.indexCount / 3;
+		}
+		std::cout << " triangles" << std::endl;
+
+		return allIndices;
+	}
+
+	uint32_t Model::selectLod(float screenSize, uint32_t currentLod) const {
+		if (lods.empty()) {
+			return 0;
+		}
+
+		uint32_t lod = std::min(currentLod, uint32_t(lods.size() - 1));
+		while (lod + 1 < lods.size() && screenSize < lods[lod].minScreenSize * (1.0f - LOD_HYSTERESIS)) {
+			lod++;
 		}
+		while (lod > 0 && screenSize > lods[lod - 1].minScreenSize * (1.0f + LOD_HYSTERESIS)) {
+			lod--;
+		}
+		return lod;
 	}
 
 	static size_t nextPowerOfTwo(size_t v) {
@@ -89,6 +262,9 @@ namespace vk {
 
 	void Model::updateMesh(const std::vector<Vertex>& newVerts, const std::vector<uint32_t>& newIdx)
 	{
+		// dynamic meshes change every update, simplifying them is not worth it
+		lods.clear();
+
 		// if no buffers yet or too small, reallocate with headroom
 		if (!hasVertexBuffer || newVerts.size() > vertexCapacityElements) {
 			vertexBuffer.reset();
@@ -130,19 +306,24 @@ namespace vk {
 	std::unique_ptr<Model> Model::createModelFromFile(Device& device, const std::string& filename, bool isUI) {
 		Builder builder{};
 		builder.isUI = isUI;
+		builder.generateLods = !isUI;
+		builder.compactVertices = !isUI;
 		builder.loadModel(filename);
 		return std::make_unique<Model>(device, builder);
 	}
 
 	void Model::createVertexBuffer(const std::vector<Vertex>& vertices) {
-		vertexCount = static_cast<uint32_t>(vertices.size());
+		createVertexBuffer(vertices.data(), sizeof(Vertex), static_cast<uint32_t>(vertices.size()));
+	}
+
+	void Model::createVertexBuffer(const void* vertices, uint32_t vertexSize, uint32_t count) {
+		vertexCount = count;
 		hasVertexBuffer = vertexCount > 0;
 		if (!hasVertexBuffer) {
 			return;
 		}
 		assert(vertexCount >= 3 && "Vertex count must be at least 3");
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
+		VkDeviceSize bufferSize = VkDeviceSize(vertexSize) * vertexCount;
 
 		Buffer stagingBuffer{
 			device,
@@ -153,7 +334,7 @@ namespace vk {
 		};
 
 		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)vertices.data());
+		stagingBuffer.writeToBuffer(const_cast<void*>(vertices));
 
 		vertexBuffer = std::make_unique<Buffer>(
 			device,
@@ -167,6 +348,84 @@ namespace vk {
 		vertexCapacityElements = vertexCount;
 	}
 
+	bool Model::packCompactVertices(const std::vector<Vertex>& vertices, std::vector<CompactVertex>& compact, glm::mat4& decode) {
+		if (vertices.empty()) {
+			return false;
+		}
+
+		glm::vec3 mn = vertices[0].position;
+		glm::vec3 mx = mn;
+		for (const Vertex& v : vertices) {
+			// tiled uvs and hdr vertex colors do not fit into unorm
+			if (glm::any(glm::lessThan(v.uv, glm::vec2(0.0f))) || glm::any(glm::greaterThan(v.uv, glm::vec2(1.0f))) ||
+				glm::any(glm::lessThan(v.color, glm::vec3(0.0f))) || glm::any(glm::greaterThan(v.color, glm::vec3(1.0f)))) {
+				return false;
+			}
+			mn = glm::min(mn, v.position);
+			mx = glm::max(mx, v.position);
+		}
+
+		// flat meshes still need an invertible decode
+		glm::vec3 extent = glm::max(mx - mn, glm::vec3(1e-6f));
+		decode = glm::scale(glm::translate(glm::mat4(1.0f), mn), extent);
+
+		compact.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++) {
+			const Vertex& v = vertices[i];
+			CompactVertex& c = compact[i];
+
+			glm::vec3 p = (v.position - mn) / extent;
+			c.position[0] = quantizeUnorm16(p.x);
+			c.position[1] = quantizeUnorm16(p.y);
+			c.position[2] = quantizeUnorm16(p.z);
+			c.position[3] = 0;
+
+			glm::vec2 n = octEncode(v.normal);
+			c.normal[0] = quantizeSnorm16(n.x);
+			c.normal[1] = quantizeSnorm16(n.y);
+
+			c.color[0] = quantizeUnorm8(v.color.r);
+			c.color[1] = quantizeUnorm8(v.color.g);
+			c.color[2] = quantizeUnorm8(v.color.b);
+			c.color[3] = 255;
+
+			c.uv[0] = quantizeUnorm16(v.uv.x);
+			c.uv[1] = quantizeUnorm16(v.uv.y);
+		}
+		return true;
+	}
+
+	void Model::unpackCompactVertices() {
+		// static vertex buffers are host visible and coherent, see createVertexBuffer
+		std::vector<CompactVertex> compact(vertexCount);
+		vertexBuffer->map();
+		std::memcpy(compact.data(), vertexBuffer->getMappedMemory(), sizeof(CompactVertex) * compact.size());
+		vertexBuffer->unmap();
+
+		std::vector<Vertex> vertices(compact.size());
+		for (size_t i = 0; i < compact.size(); i++) {
+			const CompactVertex& c = compact[i];
+			Vertex& v = vertices[i];
+
+			glm::vec3 p = glm::vec3(c.position[0], c.position[1], c.position[2]) / 65535.0f;
+			v.position = glm::vec3(positionDecode * glm::vec4(p, 1.0f));
+			v.color = glm::vec3(c.color[0], c.color[1], c.color[2]) / 255.0f;
+			v.normal = octDecode(glm::max(glm::vec2(c.normal[0], c.normal[1]) / 32767.0f, glm::vec2(-1.0f)));
+			v.uv = glm::vec2(c.uv[0], c.uv[1]) / 65535.0f;
+		}
+
+		// the old buffer may still be read by frames in flight
+		auto destructionQueue = Engine::getDestructionQueue();
+		if (destructionQueue) {
+			vertexBuffer->scheduleDestroy(*destructionQueue);
+		}
+		vertexBuffer.reset();
+
+		createVertexBuffer(vertices);
+		compactVertices = false;
+		positionDecode = glm::mat4(1.0f);
+	}
+
 	void Model::createIndexBuffer(const std::vector<uint32_t>& indices) {
 		indexCount = static_cast<uint32_t>(indices.size());
 		hasIndexBuffer = indexCount > 0;
@@ -232,12 +491,17 @@ namespace vk {
 		indexCapacityElements = elementCount;
 	}
 
-	void Model::draw(VkCommandBuffer commandBuffer) {
+	void Model::draw(VkCommandBuffer commandBuffer, uint32_t lod, uint32_t instanceCount, uint32_t firstInstance) {
+		if (hasIndexBuffer && !lods.empty()) {
+			const LodRange& range = lods[std::min(lod, uint32_t(lods.size() - 1))];
+			vkCmdDrawIndexed(commandBuffer, range.indexCount, instanceCount, range.firstIndex, 0, firstInstance);
+			return;
+		}
 		if (hasIndexBuffer) {
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+			vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
 			return;
 		} else {
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+			vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
 		}
 	}
 
@@ -249,6 +513,12 @@ namespace vk {
 			vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
 		}
 
+		if (instanceBuffer) {
+			VkBuffer buffers[] = { instanceBuffer->getBuffer() };
+			VkDeviceSize offsets[] = { 0 };
+			vkCmdBindVertexBuffers(commandBuffer, 1, 1, buffers, offsets);
+		}
+
 		if (hasIndexBuffer) {
 			// If model has more than 2^32 vertices, change the index type to uint64_t and the indexType to VK_INDEX_TYPE_UINT64
 			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
@@ -282,6 +552,28 @@ namespace vk {
 		return attributeDescriptions;
 	}
 
+	static_assert(sizeof(Model::CompactVertex) == 20, "the compact vertex layout has to stay tightly packed");
+
+	std::vector<VkVertexInputBindingDescription> Model::CompactVertex::getBindingDescriptions() {
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = sizeof(CompactVertex);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescriptions;
+	}
+
+	// same locations as Vertex, the shaders unpack the normalized formats
+	std::vector<VkVertexInputAttributeDescription> Model::CompactVertex::getAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+		attributeDescriptions.push_back({0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, position)});
+		attributeDescriptions.push_back({1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(CompactVertex, color)});
+		attributeDescriptions.push_back({2, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, normal)});
+		attributeDescriptions.push_back({3, 0, VK_FORMAT_R16G16_UNORM, offsetof(CompactVertex, uv)});
+
+		return attributeDescriptions;
+	}
+
 	void Model::Builder::loadModel(const std::string& filename) {
 		vertices.clear();
 		indices.clear();
@@ -685,105 +977,59 @@ namespace vk {
 		const std::string& heightTexturePath,
 		int seed,
 		bool useTessellation, // TODO test this flag
-		TessellationMaterial::MaterialCreationData creationData) {
-		// Create a vector to store the heightmap data
-		std::vector<float> heightData(gridSize * gridSize);
-		std::vector<unsigned char> imageData(gridSize * gridSize * 4);	// RGBA format (this only enables png for now)
+		TessellationMaterial::MaterialCreationData creationData,
+		bool exportHeightmap) {
+		// Ensure gridSize is at least 2x2
+		if (gridSize < 2)
+			gridSize = 2;
 
 		if (seed == -1) {
 			std::random_device rd;
 			seed = rd();
 		}
 
-		// generate heightmap using Perlin noise
-		for (int z = 0; z < gridSize; z++) {
-			for (int x = 0; x < gridSize; x++) {
-				float nx = x * noiseScale / gridSize;
-				float nz = z * noiseScale / gridSize;
-
-				// multiple octaves for more natural terrain
-				float h = 0.0f;
-				float amplitude = 1.0f;
-				float frequency = 1.0f;
-				float maxValue = 0.0f;
-
-				for (int i = 0; i < 4; i++) {  // 4 octaves
-					h += glm::perlin(glm::vec3(nx * frequency, nz * frequency, static_cast<float>(seed))) * amplitude;
-					maxValue += amplitude;
-					amplitude *= 0.5f;
-					frequency *= 2.0f;
-				}
-
-				// normalize to [-1, 1]
-				h /= maxValue;
-
-				// store in heightmap
-				int index = z * gridSize + x;
-				heightData[index] = h;
+		// 4 octaves of perlin noise in [-1, 1], shared by the height texture and the physics heightfield
+		// a fixed seed loads the heights from the generation cache after the first start
+		std::vector<float> heightData = procedural::HeightmapGenerator::generateCached(gridSize, noiseScale, seed);
 
-				// Convert height to grayscale for the image (0-255)
-				unsigned char value = static_cast<unsigned char>((h * 0.5f + 0.5f) * 255);
-				imageData[index * 4] = value;	   // R
-				imageData[index * 4 + 1] = value;  // G
-				imageData[index * 4 + 2] = value;  // B
-				imageData[index * 4 + 3] = 255;	   // A (fully opaque)
+		if (exportHeightmap) {
+			std::string texturePath = procedural::HeightmapGenerator::exportPng(heightData, gridSize, "terrain/temp_heightmap.png");
+			if (texturePath.empty()) {
+				std::cerr << "Failed to save heightmap texture!" << std::endl;
+			} else {
+				std::cout << "Exported heightmap texture: " << texturePath << std::endl;
 			}
 		}
 
-		// save the heightmap
-		std::string heightmapPath = "terrain/temp_heightmap.png";
-		std::string texturePath = AssetLoader::getInstance().saveTexture(
-			heightmapPath,
-			imageData.data(),
-			gridSize,
-			gridSize,
-			4  // RGBA format
-		);
-
-		if (texturePath.empty()) {
-			std::cerr << "Failed to save heightmap texture!" << std::endl;
-		} else {
-			std::cout << "Generated heightmap texture: " << texturePath << std::endl;
-		}
+		auto model = createTerrainModel(device, heightData, gridSize, tileTexturePath, useTessellation, creationData);
+		return {std::move(model), heightData};
+	}
 
-		// Create a grid model
+	std::unique_ptr<Model> Model::createTerrainModel(
+		Device& device,
+		const std::vector<float>& heights,
+		int gridSize,
+		const std::string& tileTexturePath,
+		bool useTessellation,
+		TessellationMaterial::MaterialCreationData creationData) {
+		// one cdlod chunk, drawn instanced with a world rect per selected quadtree node (see TerrainQuadtree)
+		// positions are grid coordinates, the vertex shader places and morphs them inside the chunk rect
 		Builder builder{};
 
-		// Ensure gridSize is at least 2x2
-		if (gridSize < 2)
-			gridSize = 2;
-
-		// calculate the number of vertices and indices
-		int numVertices = gridSize * gridSize;
-		int numIndices = (gridSize - 1) * (gridSize - 1) * 4;  // 4 control points per grid cell
+		const int chunkPatches = static_cast<int>(TerrainQuadtree::CHUNK_PATCHES);
+		const int chunkVertices = chunkPatches + 1;
 
 		std::vector<Model::Vertex> vertices;
-		vertices.reserve(numVertices);
-
-		// size of the grid (from -1 to 1 in both x and z)
-		const float size = 1.0f;
-
-		float step = (2.0f * size) / (gridSize - 1);
-
-		// generate vertices
-		for (int z = 0; z < gridSize; z++) {
-			for (int x = 0; x < gridSize; x++) {
-				float xPos = -size + x * step;
-				float zPos = -size + z * step;
-
-				// offset applied in shader based on heightmap
-				glm::vec3 position = {xPos, 0.0f, zPos};
+		vertices.reserve(chunkVertices * chunkVertices);
 
+		for (int z = 0; z < chunkVertices; z++) {
+			for (int x = 0; x < chunkVertices; x++) {
+				glm::vec3 position = {static_cast<float>(x), 0.0f, static_cast<float>(z)};
 				glm::vec3 color = {1.0f, 1.0f, 1.0f};
-
-				// Calculate normal based on neighboring heights
-				glm::vec3 normal = {0.0f, 1.0f, 0.0f};	// Default to up
-
-				// UV coordinates (tiled)
-				// Map UV from 0 to gridSize to create tiling effect
+				glm::vec3 normal = {0.0f, 1.0f, 0.0f};
 				glm::vec2 uv = {
-					static_cast<float>(x) / (gridSize - 1),
-					static_cast<float>(z) / (gridSize - 1)
+					static_cast<float>(x) / chunkPatches,
+					static_cast<float>(z) / chunkPatches
 				};
 
 				vertices.push_back({position, color, normal, uv});
@@ -791,14 +1037,13 @@ namespace vk {
 		}
 
 		std::vector<uint32_t> indices;
-		indices.reserve(numIndices);
+		indices.reserve(chunkPatches * chunkPatches * 4);  // 4 control points per patch
 
-		// Generate indices for grid cells
-		for (int z = 0; z < gridSize - 1; z++) {
-			for (int x = 0; x < gridSize - 1; x++) {
-				uint32_t topLeft = z * gridSize + x;
+		for (int z = 0; z < chunkPatches; z++) {
+			for (int x = 0; x < chunkPatches; x++) {
+				uint32_t topLeft = z * chunkVertices + x;
 				uint32_t topRight = topLeft + 1;
-				uint32_t bottomLeft = (z + 1) * gridSize + x;
+				uint32_t bottomLeft = (z + 1) * chunkVertices + x;
 				uint32_t bottomRight = bottomLeft + 1;
 
 				indices.push_back(bottomLeft);
@@ -808,7 +1053,7 @@ namespace vk {
 			}
 		}
 
-		std::cout << "Created terrain model with " << vertices.size() << " vertices and "
+		std::cout << "Created terrain chunk with " << vertices.size() << " vertices and "
 				  << indices.size() << " indices" << std::endl;
 
 		builder.vertices = std::move(vertices);
@@ -822,7 +1067,8 @@ namespace vk {
 		auto material = std::make_shared<TessellationMaterial>(
 			device,
 			tileTexturePath,
-			texturePath,
+			heights,
+			gridSize,
 			"terrain_shader.vert",
 			"terrain_shader.frag",
 			"terrain_tess_control.tesc",
@@ -835,7 +1081,7 @@ namespace vk {
 
 		model->setMaterial(material);
 
-		return {std::move(model), heightData};
+		return model;
 	}
 
 	std::unique_ptr<Model> Model::createGridModel(Device& device, int gridSize) {
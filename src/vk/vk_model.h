@@ -32,6 +32,21 @@ namespace vk {
 			}
 		};
 
+		// quantized layout of static meshes, 20 instead of 44 bytes, read by the *_compact.vert shaders
+		// positions are unorm within the mesh bounds, the decode to model space is folded into the model matrix, see getPositionDecodeMatrix
+		struct CompactVertex {
+			// unorm, w unused
+			uint16_t position[4];
+			// snorm, octahedral encoded
+			int16_t normal[2];
+			// unorm, a unused
+			uint8_t color[4];
+			// unorm
+			uint16_t uv[2];
+			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+		};
+
 		struct Builder {
 			std::vector<Vertex> vertices;
 			std::vector<uint32_t> indices;
@@ -46,15 +61,30 @@ namespace vk {
 			glm::vec3 boundsMax{ -std::numeric_limits<float>::max() };
 
 			bool isUI = false;
+			// simplified levels of detail for static indexed triangle meshes, see Model::LodRange
+			bool generateLods = false;
+			// store static meshes as CompactVertex, meshes with colors or uvs outside of [0, 1] keep the full format
+			bool compactVertices = false;
 			void loadModel(const std::string& filename);
 		};
 
+		// index range of one level of detail, all levels share the vertex buffer and live in one index buffer
+		struct LodRange {
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			// projected bounding sphere diameter (fraction of the screen height) below which the next coarser level is used
+			float minScreenSize = 0.0f;
+		};
+
+		static constexpr uint32_t MAX_LODS = 4;
+
 		Model(Device& device, const Model::Builder& builder);
 		~Model();
 		Model(const Model&) = delete;
 		void operator=(const Model&) = delete;
 
-		void setMaterial(std::shared_ptr<Material> material) { this->material = material; }
+		// switches compact vertices back to the full format if the material's vertex shader has no compact variant
+		void setMaterial(std::shared_ptr<Material> material);
 		std::shared_ptr<Material> getMaterial() const { return material; }
 
 		DescriptorSet getMaterialDescriptorSet(int frameIndex) const {
@@ -66,9 +96,11 @@ namespace vk {
 		static std::unique_ptr<Model> createGridModel(Device& device, int gridSize);
 		static std::unique_ptr<Model> createGridModelWithoutGeometry(Device& device, int samplesPerSide);
 
+		// one block of the water clipmap, (samplesPerSide - 1)^2 patches without vertex data
 		static std::unique_ptr<Model> createWaterModel(Device& device, int samplesPerSide, std::vector<glm::vec4> waves);
 
 		// Generate a heightmap texture and return both the model with the heightmap and the height data
+		// the heights are uploaded directly, exportHeightmap additionally writes them to terrain/temp_heightmap.png for debugging
 		static std::pair<std::unique_ptr<Model>, std::vector<float>> createTerrainModel(
 			Device& device,
 			int gridSize,
@@ -78,13 +110,35 @@ namespace vk {
 			const std::string& heightTexturePath = "none",
 			int seed = -1, // if -1: use random
 			bool useTessellation = true,
+			TessellationMaterial::MaterialCreationData creationData = {},
+			bool exportHeightmap = false);
+
+		// terrain chunk model and material for heights that were already generated, e.g. one streamed world tile
+		// @param heights gridSize x gridSize heights in [-1, 1]
+		static std::unique_ptr<Model> createTerrainModel(
+			Device& device,
+			const std::vector<float>& heights,
+			int gridSize,
+			const std::string& tileTexturePath,
+			bool useTessellation = true,
 			TessellationMaterial::MaterialCreationData creationData = {});
 
+		// per-instance vertex data bound at binding 1 together with the mesh, e.g. the impostors of one batch
+		void createInstanceBuffer(const void* instances, uint32_t instanceSize, uint32_t count);
+
 		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
+		void draw(VkCommandBuffer commandBuffer, uint32_t lod = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+		uint32_t getLodCount() const { return lods.empty() ? 1 : uint32_t(lods.size()); }
+		// @param currentLod level used last frame, switching needs a margin around the thresholds to avoid popping back and forth
+		uint32_t selectLod(float screenSize, uint32_t currentLod) const;
 
 		std::pair<glm::vec3, glm::vec3> getAABB() const { return { m_boundsMin, m_boundsMax }; }
 
+		bool hasCompactVertices() const { return compactVertices; }
+		// maps the unorm positions of compact vertices to model space, identity for the full format
+		const glm::mat4& getPositionDecodeMatrix() const { return positionDecode; }
+
 		void updateMesh(const std::vector<Vertex>& newVerts, const std::vector<uint32_t>& newIdx);
 
 		uint32_t patchCount = 0;
@@ -92,29 +146,47 @@ namespace vk {
 
 	   private:
 		void createVertexBuffer(const std::vector<Vertex>& vertices);
+		void createVertexBuffer(const void* vertices, uint32_t vertexSize, uint32_t count);
 		void createIndexBuffer(const std::vector<uint32_t>& indices);
 
 		void createVertexBuffer(size_t elementCount);
 		void createIndexBuffer(size_t elementCount);
 
+		// @returns false if the mesh does not fit the compact format
+		static bool packCompactVertices(const std::vector<Vertex>& vertices, std::vector<CompactVertex>& compact, glm::mat4& decode);
+		// reads the compact vertex buffer back and replaces it with the decoded full format
+		void unpackCompactVertices();
+		void matchVertexFormatToMaterial();
+
+		// appends the simplified levels to the full resolution indices and fills lods
+		std::vector<uint32_t> generateLodIndices(const Builder& builder);
+
 		void createStandardMaterialFromGltf(const tinygltf::Model& gltfModel, int materialIndex);
 		void createUIMaterialFromGltf(const tinygltf::Model& gltfModel, int materialIndex);
 
 		Device& device;
 		std::unique_ptr<Buffer> vertexBuffer;
 		std::unique_ptr<Buffer> indexBuffer;
+		std::unique_ptr<Buffer> instanceBuffer;
 		uint32_t vertexCount = 0;
 		uint32_t indexCount = 0;
 		bool hasVertexBuffer = false;
 		bool hasIndexBuffer = false;
 
 		bool m_dynamic = false;
+
+		bool compactVertices = false;
+		glm::mat4 positionDecode{ 1.0f };
+
 		VkMemoryPropertyFlags m_memFlags = 0;
 
 		// buffer capacities
 		size_t vertexCapacityElements = 0;
 		size_t indexCapacityElements = 0;
 
+		// empty if the model has a single level
+		std::vector<LodRange> lods;
+
 		std::shared_ptr<Material> material;
 
 		glm::vec3 m_boundsMin{ std::numeric_limits<float>::max() };
@@ -1,5 +1,6 @@
 #include "vk_pipeline.h"
 #include "vk_model.h"
+#include "vk_shader_module_cache.h"
 #include "../asset_utils/AssetLoader.h"
 #include "../Engine.h"
 
@@ -7,13 +8,57 @@
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
+#include <algorithm>
 
 namespace vk {
 
+	PipelineConfigInfo& PipelineConfigInfo::operator=(PipelineConfigInfo const& o) {
+		if (this == &o) {
+			return *this;
+		}
+
+		bindingDescriptions = o.bindingDescriptions;
+		attributeDescriptions = o.attributeDescriptions;
+		viewportInfo = o.viewportInfo;
+		inputAssemblyInfo = o.inputAssemblyInfo;
+		rasterizationInfo = o.rasterizationInfo;
+		multisampleInfo = o.multisampleInfo;
+		colorBlendAttachment = o.colorBlendAttachment;
+		colorBlendInfo = o.colorBlendInfo;
+		depthStencilInfo = o.depthStencilInfo;
+		dynamicStateEnables = o.dynamicStateEnables;
+		dynamicStateInfo = o.dynamicStateInfo;
+		pipelineLayout = o.pipelineLayout;
+		renderPass = o.renderPass;
+		subpass = o.subpass;
+		vertShaderPath = o.vertShaderPath;
+		fragShaderPath = o.fragShaderPath;
+		useTessellation = o.useTessellation;
+		tessControlShaderPath = o.tessControlShaderPath;
+		tessEvalShaderPath = o.tessEvalShaderPath;
+		tessellationInfo = o.tessellationInfo;
+		patchControlPoints = o.patchControlPoints;
+
+		// pointers to external arrays stay as they are
+		if (o.colorBlendInfo.pAttachments == &o.colorBlendAttachment) {
+			colorBlendInfo.pAttachments = &colorBlendAttachment;
+		}
+		if (o.dynamicStateInfo.pDynamicStates == o.dynamicStateEnables.data()) {
+			dynamicStateInfo.pDynamicStates = dynamicStateEnables.data();
+		}
+		return *this;
+	}
+
 	Pipeline::Pipeline(Device& device,
 		const PipelineConfigInfo& configInfo)
 		: device{device} {
-		createPipeline(configInfo);
+		try {
+			createPipeline(configInfo);
+		} catch (...) {
+			// the destructor does not run for a throwing constructor, the modules acquired so far would never be released
+			releaseShaderModules();
+			throw;
+		}
 	}
 	
 	Pipeline::~Pipeline() {
@@ -35,27 +80,7 @@ namespace vk {
 			}
 		}
 		
-		// shader modules can be destroyed immediately as they're not used during rendering
-		if (vertShaderModule != VK_NULL_HANDLE) {
-			vkDestroyShaderModule(device.device(), vertShaderModule, nullptr);
-			vertShaderModule = VK_NULL_HANDLE;
-		}
-		
-		if (fragShaderModule != VK_NULL_HANDLE) {
-			vkDestroyShaderModule(device.device(), fragShaderModule, nullptr);
-			fragShaderModule = VK_NULL_HANDLE;
-		}
-		
-		// clean up tessellation shader modules if they exist
-		if (tessControlShaderModule != VK_NULL_HANDLE) {
-			vkDestroyShaderModule(device.device(), tessControlShaderModule, nullptr);
-			tessControlShaderModule = VK_NULL_HANDLE;
-		}
-		
-		if (tessEvalShaderModule != VK_NULL_HANDLE) {
-			vkDestroyShaderModule(device.device(), tessEvalShaderModule, nullptr);
-			tessEvalShaderModule = VK_NULL_HANDLE;
-		}
+		releaseShaderModules();
 		
 		std::cout << "Pipeline: Destruction sequence complete" << std::endl;
 	}
@@ -126,25 +151,24 @@ namespace vk {
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		if (vkCreateGraphicsPipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+		if (vkCreateGraphicsPipelines(device.device(), device.pipelineCache(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create pipeline!");
 		}
 	}
 
-	void Pipeline::createShaderModule(const std::string& filepath, VkShaderModule* shaderModule) {
-
-		const std::vector<char>& code = AssetLoader::getInstance().loadShader(filepath);
-
-		VkShaderModuleCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-		if (vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to create shader module!");
+	void Pipeline::releaseShaderModules() {
+		// shader modules are shared between pipelines, the cache frees them once unused
+		ShaderModuleCache& shaderModuleCache = ShaderModuleCache::getInstance();
+		for (VkShaderModule* shaderModule : { &vertShaderModule, &fragShaderModule, &tessControlShaderModule, &tessEvalShaderModule }) {
+			shaderModuleCache.release(device, *shaderModule);
+			*shaderModule = VK_NULL_HANDLE;
 		}
 	}
 
+	void Pipeline::createShaderModule(const std::string& filepath, VkShaderModule* shaderModule) {
+		*shaderModule = ShaderModuleCache::getInstance().acquire(device, filepath);
+	}
+
 	void Pipeline::bind(VkCommandBuffer commandBuffer) {
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 	}
@@ -283,4 +307,57 @@ namespace vk {
 		configInfo.rasterizationInfo.depthBiasConstantFactor = 0.005f; // constant depth bias
 		configInfo.rasterizationInfo.depthBiasSlopeFactor = 1.0f; // slope-based depth bias
 	}
+
+	void Pipeline::depthPrepassPipelineConfigInfo(PipelineConfigInfo& configInfo) {
+		// same depth-only fragment shader as the shadow pass, the vertex stages stay so the depth matches the main pass exactly
+		configInfo.fragShaderPath = "shadow_pass.frag";
+
+		// drawn inside the main render pass, the color attachment stays but is not written
+		configInfo.colorBlendAttachment.blendEnable = VK_FALSE;
+		configInfo.colorBlendAttachment.colorWriteMask = 0;
+
+		configInfo.depthStencilInfo.depthTestEnable = VK_TRUE;
+		configInfo.depthStencilInfo.depthWriteEnable = VK_TRUE;
+		configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+	}
+
+	void Pipeline::depthEqualPipelineConfigInfo(PipelineConfigInfo& configInfo) {
+		// the depth pre-pass already wrote the nearest depth, only the visible fragment of each pixel is shaded
+		configInfo.depthStencilInfo.depthTestEnable = VK_TRUE;
+		configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+		configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+	}
+
+	std::string Pipeline::compactVertexShaderPath(const std::string& vertShaderPath) {
+		if (vertShaderPath == "texture_shader.vert") {
+			return "texture_shader_compact.vert";
+		}
+		if (vertShaderPath == "vegetation_shader.vert") {
+			return "vegetation_shader_compact.vert";
+		}
+		return "";
+	}
+
+	bool Pipeline::compactVertexPipelineConfigInfo(PipelineConfigInfo& configInfo) {
+		std::string compactPath = compactVertexShaderPath(configInfo.vertShaderPath);
+		if (compactPath.empty()) {
+			return false;
+		}
+		configInfo.vertShaderPath = compactPath;
+
+		configInfo.bindingDescriptions.erase(
+			std::remove_if(configInfo.bindingDescriptions.begin(), configInfo.bindingDescriptions.end(),
+				[](const VkVertexInputBindingDescription& binding) { return binding.binding == 0; }),
+			configInfo.bindingDescriptions.end());
+		configInfo.attributeDescriptions.erase(
+			std::remove_if(configInfo.attributeDescriptions.begin(), configInfo.attributeDescriptions.end(),
+				[](const VkVertexInputAttributeDescription& attribute) { return attribute.binding == 0; }),
+			configInfo.attributeDescriptions.end());
+
+		auto bindings = Model::CompactVertex::getBindingDescriptions();
+		auto attributes = Model::CompactVertex::getAttributeDescriptions();
+		configInfo.bindingDescriptions.insert(configInfo.bindingDescriptions.begin(), bindings.begin(), bindings.end());
+		configInfo.attributeDescriptions.insert(configInfo.attributeDescriptions.begin(), attributes.begin(), attributes.end());
+		return true;
+	}
 }
\ No newline at end of file
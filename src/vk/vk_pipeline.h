@@ -12,8 +12,9 @@ namespace vk {
     struct PipelineConfigInfo {
 
         PipelineConfigInfo() = default;
-        PipelineConfigInfo(PipelineConfigInfo const&) = default;
-        PipelineConfigInfo& operator=(PipelineConfigInfo const&) = default;
+        // colorBlendInfo and dynamicStateInfo point into the config itself, copies point into the copy
+        PipelineConfigInfo(PipelineConfigInfo const& o) { *this = o; }
+        PipelineConfigInfo& operator=(PipelineConfigInfo const& o);
 
         std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
@@ -52,6 +53,7 @@ namespace vk {
                 && rasterizationInfo.polygonMode == o.rasterizationInfo.polygonMode
                 && depthStencilInfo.depthWriteEnable == o.depthStencilInfo.depthWriteEnable
                 && depthStencilInfo.depthCompareOp == o.depthStencilInfo.depthCompareOp
+                && colorBlendAttachment.colorWriteMask == o.colorBlendAttachment.colorWriteMask
                 && renderPass == o.renderPass
                 && subpass == o.subpass;
         }
@@ -74,25 +76,35 @@ namespace vk {
         // modify an existing config
         static void shadowPipelineConfigInfo(PipelineConfigInfo& configInfo);
         static void terrainShadowPipelineConfigInfo(PipelineConfigInfo& configInfo);
+        static void depthPrepassPipelineConfigInfo(PipelineConfigInfo& configInfo);
+        static void depthEqualPipelineConfigInfo(PipelineConfigInfo& configInfo);
+        // the *_compact.vert variant of a vertex shader, empty if there is none
+        static std::string compactVertexShaderPath(const std::string& vertShaderPath);
+        // reads Model::CompactVertex from binding 0 with the matching *_compact.vert shader, other bindings stay
+        // @returns false and leaves the config untouched if the vertex shader has no compact variant
+        static bool compactVertexPipelineConfigInfo(PipelineConfigInfo& configInfo);
 
     private:
 
         void createPipeline(const PipelineConfigInfo& configInfo);
 
         void createShaderModule(const std::string& filepath, VkShaderModule* shaderModule);
+        void releaseShaderModules();
 
         VkPipelineShaderStageCreateInfo makeStageInfo(VkShaderStageFlagBits stage, VkShaderModule shaderModule);
 
         Device& device;
-        VkPipeline graphicsPipeline;
-        VkShaderModule vertShaderModule;
-        VkShaderModule fragShaderModule;
+        VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+        VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+        VkShaderModule fragShaderModule = VK_NULL_HANDLE;
         VkShaderModule tessControlShaderModule = VK_NULL_HANDLE;
         VkShaderModule tessEvalShaderModule = VK_NULL_HANDLE;
     };
 
     struct PipelineInfo {
         std::unique_ptr<Pipeline> pipeline;
+        // small sequential id per render system, used in the draw sort key
+        uint32_t id = 0;
         VkPipelineLayout pipelineLayout; // store handle to pipeline layout but manage in own map to be able to share layout among pipelines with the same descriptor sets without recreating it
     };
 }
@@ -118,6 +130,7 @@ namespace std {
             hc(h, c.rasterizationInfo.polygonMode);
             hc(h, c.depthStencilInfo.depthWriteEnable);
             hc(h, c.depthStencilInfo.depthCompareOp);
+            hc(h, c.colorBlendAttachment.colorWriteMask);
             hc(h, (uint64_t)c.renderPass);
             hc(h, c.subpass);
             return h;
@@ -0,0 +1,88 @@
+#include "vk_shader_module_cache.h"
+#include "../asset_utils/AssetLoader.h"
+#include "../Engine.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <iostream>
+
+namespace vk {
+
+	ShaderModuleCache& ShaderModuleCache::getInstance() {
+		static ShaderModuleCache instance;
+		return instance;
+	}
+
+	const std::vector<uint32_t>& ShaderModuleCache::getBytecode(Entry& entry, const std::string& shaderName) {
+		if (entry.code.empty()) {
+			std::vector<char> bytes = AssetLoader::getInstance().loadShader(shaderName);
+			if (bytes.empty() || bytes.size() % sizeof(uint32_t) != 0) {
+				throw std::runtime_error("ShaderModuleCache: Invalid SPIR-V size for shader: " + shaderName);
+			}
+
+			// store as words so pCode is always correctly aligned
+			entry.code.resize(bytes.size() / sizeof(uint32_t));
+			std::memcpy(entry.code.data(), bytes.data(), bytes.size());
+		}
+		return entry.code;
+	}
+
+	VkShaderModule ShaderModuleCache::acquire(Device& device, const std::string& shaderName) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Entry& entry = entries[shaderName];
+		if (entry.module != VK_NULL_HANDLE) {
+			entry.refCount++;
+			return entry.module;
+		}
+
+		const std::vector<uint32_t>& code = getBytecode(entry, shaderName);
+
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.size() * sizeof(uint32_t);
+		createInfo.pCode = code.data();
+
+		if (vkCreateShaderModule(device.device(), &createInfo, nullptr, &entry.module) != VK_SUCCESS) {
+			entry.module = VK_NULL_HANDLE;
+			throw std::runtime_error("Failed to create shader module!");
+		}
+
+		entry.refCount = 1;
+		moduleToName[entry.module] = shaderName;
+		return entry.module;
+	}
+
+	void ShaderModuleCache::release(Device& device, VkShaderModule shaderModule) {
+		if (shaderModule == VK_NULL_HANDLE) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto nameIt = moduleToName.find(shaderModule);
+		if (nameIt == moduleToName.end()) {
+			std::cout << "ShaderModuleCache: Warning - releasing unknown shader module" << std::endl;
+			return;
+		}
+
+		Entry& entry = entries[nameIt->second];
+		if (entry.refCount > 1) {
+			entry.refCount--;
+			return;
+		}
+
+		// last user is gone, keep the bytecode but free the module
+		auto destructionQueue = Engine::getDestructionQueue();
+		if (destructionQueue) {
+			destructionQueue->pushShaderModule(shaderModule);
+		} else {
+			vkDestroyShaderModule(device.device(), shaderModule, nullptr);
+		}
+
+		entry.module = VK_NULL_HANDLE;
+		entry.refCount = 0;
+		moduleToName.erase(nameIt);
+	}
+
+}
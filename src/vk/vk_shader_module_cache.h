@@ -0,0 +1,42 @@
+#pragma once
+
+#include "vk_device.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+namespace vk {
+
+	// shares VkShaderModules between pipelines, keyed by the shader name passed to AssetLoader::loadShader
+	// SPIR-V bytecode stays in memory after the first load, so recreating a released module needs no file io
+	// modules are refcounted and handed to the destruction queue once the last pipeline using them is gone
+	class ShaderModuleCache {
+	   public:
+		static ShaderModuleCache& getInstance();
+
+		// thread-safe, may be called from pipeline prewarm workers
+		VkShaderModule acquire(Device& device, const std::string& shaderName);
+		void release(Device& device, VkShaderModule shaderModule);
+
+	   private:
+		ShaderModuleCache() = default;
+		~ShaderModuleCache() = default;
+		ShaderModuleCache(const ShaderModuleCache&) = delete;
+		ShaderModuleCache& operator=(const ShaderModuleCache&) = delete;
+
+		struct Entry {
+			std::vector<uint32_t> code;
+			VkShaderModule module = VK_NULL_HANDLE;
+			uint32_t refCount = 0;
+		};
+
+		const std::vector<uint32_t>& getBytecode(Entry& entry, const std::string& shaderName);
+
+		std::mutex mutex;
+		std::unordered_map<std::string, Entry> entries;
+		std::unordered_map<VkShaderModule, std::string> moduleToName;
+	};
+}